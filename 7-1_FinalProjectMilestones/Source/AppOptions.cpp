@@ -0,0 +1,225 @@
+///////////////////////////////////////////////////////////////////////////////
+// appoptions.cpp
+// ============
+// the options of the application read from the command line, which set up the
+// 3D scene and the window for the interactive and the benchmark runs alike
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AppOptions.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+// declaration of global variables
+namespace
+{
+	// the vsync mode given for an unknown vsync argument
+	const int g_InvalidVsyncMode = 2;
+}
+
+/***********************************************************
+ *  SetDefaults()
+ *
+ *  This method is used for setting the options to their
+ *  defaults, which draw the built-in 3D scene once with
+ *  every optimization turned on.
+ ***********************************************************/
+void AppOptions::SetDefaults(OPTIONS& options)
+{
+	options.tileCount = 1;
+	options.pointLightCount = 0;
+	options.sceneFilename.clear();
+	options.exportFilename.clear();
+	options.streamCellSize = 0.0f;
+	options.streamRadius = 100.0f;
+	options.streamBudget = 256;
+	options.bOnDemand = false;
+	options.bHotReload = false;
+	options.maxFps = 0.0f;
+	options.outputWidth = 0;
+	options.outputHeight = 0;
+	options.renderScale = 1.0f;
+	options.dynamicResolutionFps = 0.0f;
+	options.vsyncMode = -1;
+	options.bFrustumCulling = true;
+	options.bOcclusionCulling = true;
+	options.bStaticBatching = true;
+	options.bGpuCulling = true;
+	options.bDepthPrepass = true;
+	options.bShaderVariants = true;
+	options.bShaderCache = true;
+	options.bShadows = true;
+	options.bSunLight = false;
+	options.bJobSystem = true;
+}
+
+/***********************************************************
+ *  ReadArgument()
+ *
+ *  This method is used for reading one option of the command
+ *  line:
+ *    --tiles <n>        number of copies of the 3D scene
+ *    --point-lights <n> number of point lights over the scene
+ *    --scene <file>     load a binary scene file instead
+ *    --export-scene <file> write the scene to a binary file
+ *    --stream-cells <size> stream the scene file in cells
+ *    --stream-radius <d> distance of the streamed cells
+ *    --stream-budget <MB> memory of the streamed cells
+ *    --on-demand        draw the window only when it changes
+ *    --hot-reload       reload the edited asset files
+ *    --max-fps <n>      most frames per second of the window
+ *    --output-size <w>x<h> size of the rendered view
+ *    --render-scale <s> internal resolution of the 3D scene
+ *    --dynamic-resolution <fps> lower the scale to hold a rate
+ *    --vsync <mode>     off, on or adaptive window vsync
+ *    --no-culling       draw the objects outside of the view
+ *    --no-occlusion     draw the objects hidden behind others
+ *    --no-static-batch  draw without the baked static batches
+ *    --no-gpu-culling   cull the static batches on the CPU
+ *    --no-depth-prepass shade without drawing the depth first
+ *    --no-shader-variants draw with the uber shader program
+ *    --no-shader-cache  compile the shader programs every launch
+ *    --no-shadows       light the scene without shadow maps
+ *    --sun              add a sun with cascaded shadow maps
+ *    --no-jobs          run the scene work on one thread
+ ***********************************************************/
+bool AppOptions::ReadArgument(int argc, char* argv[], int& argumentIndex, OPTIONS& options)
+{
+	std::string argument = argv[argumentIndex];
+	bool bHasValue = (argumentIndex + 1 < argc);
+
+	if ((argument == "--tiles") && (bHasValue == true))
+	{
+		options.tileCount = atoi(argv[++argumentIndex]);
+	}
+	else if ((argument == "--point-lights") && (bHasValue == true))
+	{
+		options.pointLightCount = atoi(argv[++argumentIndex]);
+	}
+	else if ((argument == "--scene") && (bHasValue == true))
+	{
+		options.sceneFilename = argv[++argumentIndex];
+	}
+	else if ((argument == "--export-scene") && (bHasValue == true))
+	{
+		options.exportFilename = argv[++argumentIndex];
+	}
+	else if ((argument == "--stream-cells") && (bHasValue == true))
+	{
+		options.streamCellSize = (float)atof(argv[++argumentIndex]);
+	}
+	else if ((argument == "--stream-radius") && (bHasValue == true))
+	{
+		options.streamRadius = (float)atof(argv[++argumentIndex]);
+	}
+	else if ((argument == "--stream-budget") && (bHasValue == true))
+	{
+		options.streamBudget = atoi(argv[++argumentIndex]);
+	}
+	else if (argument == "--on-demand")
+	{
+		options.bOnDemand = true;
+	}
+	else if (argument == "--hot-reload")
+	{
+		options.bHotReload = true;
+	}
+	else if ((argument == "--max-fps") && (bHasValue == true))
+	{
+		options.maxFps = (float)atof(argv[++argumentIndex]);
+	}
+	else if ((argument == "--output-size") && (bHasValue == true))
+	{
+		if (sscanf(argv[++argumentIndex], "%dx%d", &options.outputWidth, &options.outputHeight) != 2)
+		{
+			options.outputWidth = -1;
+		}
+	}
+	else if ((argument == "--render-scale") && (bHasValue == true))
+	{
+		options.renderScale = (float)atof(argv[++argumentIndex]);
+	}
+	else if ((argument == "--dynamic-resolution") && (bHasValue == true))
+	{
+		options.dynamicResolutionFps = (float)atof(argv[++argumentIndex]);
+	}
+	else if ((argument == "--vsync") && (bHasValue == true))
+	{
+		std::string mode = argv[++argumentIndex];
+		options.vsyncMode = (mode == "off") ? 0 : (mode == "on") ? 1 :
+			(mode == "adaptive") ? -1 : g_InvalidVsyncMode;
+	}
+	else if (argument == "--no-culling")
+	{
+		options.bFrustumCulling = false;
+	}
+	else if (argument == "--no-occlusion")
+	{
+		options.bOcclusionCulling = false;
+	}
+	else if (argument == "--no-static-batch")
+	{
+		options.bStaticBatching = false;
+	}
+	else if (argument == "--no-gpu-culling")
+	{
+		options.bGpuCulling = false;
+	}
+	else if (argument == "--no-depth-prepass")
+	{
+		options.bDepthPrepass = false;
+	}
+	else if (argument == "--no-shader-variants")
+	{
+		options.bShaderVariants = false;
+	}
+	else if (argument == "--no-shader-cache")
+	{
+		options.bShaderCache = false;
+	}
+	else if (argument == "--no-shadows")
+	{
+		options.bShadows = false;
+	}
+	else if (argument == "--sun")
+	{
+		options.bSunLight = true;
+	}
+	else if (argument == "--no-jobs")
+	{
+		options.bJobSystem = false;
+	}
+	else
+	{
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  CheckOptions()
+ *
+ *  This method is used for checking whether the options
+ *  that were read are inside of their ranges.
+ ***********************************************************/
+bool AppOptions::CheckOptions(const OPTIONS& options)
+{
+	return((options.tileCount > 0) && (options.pointLightCount >= 0) &&
+		(options.streamCellSize >= 0.0f) && (options.streamRadius >= 0.0f) && (options.streamBudget > 0) &&
+		(options.maxFps >= 0.0f) && (options.vsyncMode != g_InvalidVsyncMode) &&
+		(options.outputWidth >= 0) && (options.outputHeight >= 0) &&
+		(options.renderScale > 0.0f) && (options.renderScale <= 2.0f) &&
+		(options.dynamicResolutionFps >= 0.0f));
+}
+
+/***********************************************************
+ *  GetUsage()
+ *
+ *  This method is used for getting the command line usage of
+ *  the options.
+ ***********************************************************/
+const char* AppOptions::GetUsage()
+{
+	return("[--tiles n] [--point-lights n] [--scene file] [--export-scene file] [--stream-cells size] [--stream-radius d] [--stream-budget MB] [--on-demand] [--hot-reload] [--max-fps n] [--output-size WxH] [--render-scale s] [--dynamic-resolution fps] [--vsync off|on|adaptive] [--no-culling] [--no-occlusion] [--no-static-batch] [--no-gpu-culling] [--no-depth-prepass] [--no-shader-variants] [--no-shader-cache] [--no-shadows] [--sun] [--no-jobs]");
+}
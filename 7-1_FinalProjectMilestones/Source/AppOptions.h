@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+// appoptions.h
+// ============
+// the options of the application read from the command line, which set up the
+// 3D scene and the window for the interactive and the benchmark runs alike
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+
+/***********************************************************
+ *  AppOptions
+ *
+ *  This class contains the code for setting the options of
+ *  the application to their defaults, reading them one
+ *  command line argument at a time and checking their
+ *  ranges.  The benchmark run settings are kept apart in the
+ *  Benchmark class, which reads the whole command line.
+ ***********************************************************/
+class AppOptions
+{
+public:
+	// the options of the application
+	struct OPTIONS
+	{
+		// number of copies of the 3D scene placed in a grid
+		int tileCount;
+		// number of point lights spread over the 3D scene
+		int pointLightCount;
+		// binary scene file loaded instead of the built-in 3D
+		// scene, empty for the built-in scene
+		std::string sceneFilename;
+		// size of the cells of the scene file streamed around the
+		// camera, 0 for loading all of its objects
+		float streamCellSize;
+		// radius around the camera of the streamed cells
+		float streamRadius;
+		// memory budget of the streamed cells in megabytes
+		int streamBudget;
+		// when not empty, the prepared 3D scene is written into
+		// this binary scene file and the application exits
+		std::string exportFilename;
+		// true when the window is only drawn again after input or
+		// a change of the 3D scene, instead of continuously
+		bool bOnDemand;
+		// true when the edited texture, shader and scene files are
+		// reloaded into the window while it runs
+		bool bHotReload;
+		// most frames per second drawn into the window, 0 for no
+		// limit other than the vsync
+		float maxFps;
+		// size of the rendered view in pixels, 0 for the size of
+		// the window
+		int outputWidth;
+		int outputHeight;
+		// internal resolution of the 3D scene as a part of the
+		// view size, which is the largest one with dynamic
+		// resolution
+		float renderScale;
+		// frame rate that the dynamic resolution holds by lowering
+		// the render scale, 0 for a fixed render scale
+		float dynamicResolutionFps;
+		// swap interval of the window - 0 off, 1 on, -1 adaptive,
+		// which tears instead of waiting for a late frame
+		int vsyncMode;
+		// false when the objects outside of the view are drawn
+		bool bFrustumCulling;
+		// false when the objects hidden behind others are drawn
+		bool bOcclusionCulling;
+		// false when the static objects are drawn like the moving
+		// ones instead of from the baked static batches
+		bool bStaticBatching;
+		// false when the static batches are culled on the CPU
+		bool bGpuCulling;
+		// false when the opaque objects are shaded without
+		// drawing their depth first
+		bool bDepthPrepass;
+		// false when the uber shader program draws everything
+		// instead of its specialized variants
+		bool bShaderVariants;
+		// false when the shader programs are compiled at every
+		// launch instead of loading their binaries
+		bool bShaderCache;
+		// false when the light sources cast no shadows
+		bool bShadows;
+		// true when a sun lights the 3D scene from above, with
+		// cascaded shadow maps over the view
+		bool bSunLight;
+		// false when the scene work runs on the rendering thread
+		// only
+		bool bJobSystem;
+	};
+
+	// set the options to their defaults
+	static void SetDefaults(OPTIONS& options);
+	// read the option at an argument of the command line and
+	// move the index past its value, which returns false when
+	// the argument is not an option or its value is missing
+	static bool ReadArgument(int argc, char* argv[], int& argumentIndex, OPTIONS& options);
+	// check whether the options are inside of their ranges
+	static bool CheckOptions(const OPTIONS& options);
+	// get the command line usage of the options
+	static const char* GetUsage();
+};
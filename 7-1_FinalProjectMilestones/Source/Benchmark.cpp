@@ -0,0 +1,309 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.cpp
+// ============
+// measure the rendering performance of the 3D scene along a scripted camera
+// path - used for repeatable performance runs
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	// default settings of a benchmark run
+	const int g_DefaultFrameCount = 600;
+	const int g_DefaultWarmupFrames = 60;
+
+	// number of rendered frames that may be queued on the GPU
+	const int g_FramesInFlight = 2;
+
+	const float g_PI = 3.14159265f;
+
+	/***********************************************************
+	 *  GetPercentile()
+	 *
+	 *  This function is used for getting a percentile (0 to
+	 *  100) of sorted samples.
+	 ***********************************************************/
+	float GetPercentile(const std::vector<float>& sortedSamples, float percentile)
+	{
+		if (sortedSamples.empty() == true)
+		{
+			return(0.0f);
+		}
+
+		size_t rank = (size_t)((percentile / 100.0f) * (sortedSamples.size() - 1) + 0.5f);
+		return(sortedSamples[rank]);
+	}
+}
+
+/***********************************************************
+ *  Benchmark()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Benchmark::Benchmark(const SETTINGS& settings, const AppOptions::OPTIONS& options,
+	glm::vec3 sceneMin, glm::vec3 sceneMax)
+{
+	m_settings = settings;
+	m_options = options;
+
+	// the camera circles the whole of the tiled scene
+	m_sceneCenter = (sceneMin + sceneMax) * 0.5f;
+	glm::vec2 extent = glm::vec2(sceneMax.x - sceneMin.x, sceneMax.z - sceneMin.z);
+	m_pathRadius = glm::length(extent) * 0.5f + 6.0f;
+
+	m_frameTimes.reserve(settings.frameCount);
+	m_frameFences.resize(g_FramesInFlight, (GLsync)0);
+	m_nextFence = 0;
+}
+
+/***********************************************************
+ *  ~Benchmark()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+Benchmark::~Benchmark()
+{
+	for (size_t i = 0; i < m_frameFences.size(); i++)
+	{
+		if (m_frameFences[i] != 0)
+		{
+			glDeleteSync(m_frameFences[i]);
+		}
+	}
+	m_frameFences.clear();
+}
+
+/***********************************************************
+ *  ParseArguments()
+ *
+ *  This method is used for reading the command line.  The
+ *  benchmark settings are read here, and the other arguments
+ *  are read as options of the application:
+ *    --benchmark        run the benchmark
+ *    --frames <n>       number of timed frames
+ *    --warmup <n>       number of untimed frames first
+ *    --max-p95 <ms>     fail above this 95th percentile
+ *  An unknown argument or a value out of range prints the
+ *  usage and returns false.
+ ***********************************************************/
+bool Benchmark::ParseArguments(int argc, char* argv[], SETTINGS& settings, AppOptions::OPTIONS& options)
+{
+	settings.bEnabled = false;
+	settings.frameCount = g_DefaultFrameCount;
+	settings.warmupFrames = g_DefaultWarmupFrames;
+	settings.maxP95 = 0.0f;
+	AppOptions::SetDefaults(options);
+
+	bool bValid = true;
+	for (int i = 1; (i < argc) && (bValid == true); i++)
+	{
+		std::string argument = argv[i];
+		bool bHasValue = (i + 1 < argc);
+
+		if (argument == "--benchmark")
+		{
+			settings.bEnabled = true;
+		}
+		else if ((argument == "--frames") && (bHasValue == true))
+		{
+			settings.frameCount = atoi(argv[++i]);
+		}
+		else if ((argument == "--warmup") && (bHasValue == true))
+		{
+			settings.warmupFrames = atoi(argv[++i]);
+		}
+		else if ((argument == "--max-p95") && (bHasValue == true))
+		{
+			settings.maxP95 = (float)atof(argv[++i]);
+		}
+		else if (AppOptions::ReadArgument(argc, argv, i, options) == false)
+		{
+			std::cout << "Unknown argument or missing value: " << argument << std::endl;
+			bValid = false;
+		}
+	}
+
+	if ((bValid == false) ||
+		(settings.frameCount <= 0) || (settings.warmupFrames < 0) || (settings.maxP95 < 0.0f) ||
+		(AppOptions::CheckOptions(options) == false))
+	{
+		std::cout << "usage: [--benchmark [--frames n] [--warmup n] [--max-p95 ms]] [--cook-textures] "
+			<< AppOptions::GetUsage() << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetCameraPose()
+ *
+ *  This method is used for getting the camera position and
+ *  the point it looks at for a frame.  The camera makes one
+ *  circle around the scene over the timed frames while
+ *  moving in and out, so every run sees the same views.
+ ***********************************************************/
+void Benchmark::GetCameraPose(int frame, glm::vec3& position, glm::vec3& target) const
+{
+	float angle = 2.0f * g_PI * (float)frame / (float)m_settings.frameCount;
+	float radius = m_pathRadius * (0.8f + 0.2f * sinf(2.0f * angle));
+
+	position = m_sceneCenter + glm::vec3(
+		sinf(angle) * radius,
+		4.0f + 0.25f * radius,
+		cosf(angle) * radius);
+	target = m_sceneCenter;
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the timing once the
+ *  warmup frames have been rendered.
+ ***********************************************************/
+void Benchmark::Start()
+{
+	glFinish();
+	m_frameTimes.clear();
+	m_startTime = std::chrono::steady_clock::now();
+	m_lastFrameTime = m_startTime;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for recording the time of a finished
+ *  frame.  Without a swap chain the driver would queue many
+ *  frames, so the CPU waits for the frame g_FramesInFlight
+ *  frames back, which makes the frame times follow the GPU.
+ ***********************************************************/
+void Benchmark::EndFrame()
+{
+	GLsync& fence = m_frameFences[m_nextFence];
+	if (fence != 0)
+	{
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(fence);
+	}
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_nextFence = (m_nextFence + 1) % g_FramesInFlight;
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	std::chrono::duration<float, std::milli> frameTime = now - m_lastFrameTime;
+	m_frameTimes.push_back(frameTime.count());
+	m_lastFrameTime = now;
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used for waiting for the GPU to finish the
+ *  timed frames and calculating the results.
+ ***********************************************************/
+Benchmark::RESULTS Benchmark::Finish()
+{
+	glFinish();
+	std::chrono::duration<double> total = std::chrono::steady_clock::now() - m_startTime;
+
+	std::vector<float> sortedTimes = m_frameTimes;
+	std::sort(sortedTimes.begin(), sortedTimes.end());
+
+	double sum = 0.0;
+	for (size_t i = 0; i < sortedTimes.size(); i++)
+	{
+		sum += sortedTimes[i];
+	}
+
+	RESULTS results;
+	results.frameCount = sortedTimes.size();
+	results.totalSeconds = total.count();
+	results.framesPerSecond = (total.count() > 0.0) ? (float)(results.frameCount / total.count()) : 0.0f;
+	results.average = (results.frameCount > 0) ? (float)(sum / results.frameCount) : 0.0f;
+	results.p50 = GetPercentile(sortedTimes, 50.0f);
+	results.p95 = GetPercentile(sortedTimes, 95.0f);
+	results.p99 = GetPercentile(sortedTimes, 99.0f);
+	results.maximum = sortedTimes.empty() ? 0.0f : sortedTimes.back();
+	results.renderScale = m_options.renderScale;
+
+	return(results);
+}
+
+/***********************************************************
+ *  Report()
+ *
+ *  This method is used for outputting the results, followed
+ *  by one line of key=value pairs for scripts to read.
+ ***********************************************************/
+bool Benchmark::Report(const RESULTS& results, int objectCount, int visibleCount, int drawCalls) const
+{
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "\n--- BENCHMARK RESULTS ---\n";
+	std::cout << "frames:        " << results.frameCount << " (" << m_settings.warmupFrames << " warmup)\n";
+	std::cout << "scene tiles:   " << m_options.tileCount << " (" << objectCount << " objects, "
+		<< visibleCount << " visible in the last frame, " << drawCalls << " draws)\n";
+	std::cout << "point lights:  " << m_options.pointLightCount << "\n";
+	std::cout << "scene file:    " << (m_options.sceneFilename.empty() ? "built-in" : m_options.sceneFilename) << "\n";
+	if (m_options.streamCellSize > 0.0f)
+	{
+		std::cout << "streaming:     cells of " << m_options.streamCellSize << ", radius " << m_options.streamRadius
+			<< ", budget " << m_options.streamBudget << " MB\n";
+	}
+	std::cout << "resolution:    " << m_options.outputWidth << "x" << m_options.outputHeight
+		<< ", render scale " << results.renderScale;
+	if (m_options.dynamicResolutionFps > 0.0f)
+	{
+		std::cout << " (average, dynamic at " << m_options.dynamicResolutionFps << " fps)";
+	}
+	std::cout << "\n";
+	std::cout << "culling:       frustum " << (m_options.bFrustumCulling ? "on" : "off")
+		<< ", occlusion " << (m_options.bOcclusionCulling ? "on" : "off")
+		<< ", static batching " << (m_options.bStaticBatching ? "on" : "off")
+		<< ", gpu culling " << (m_options.bGpuCulling ? "on" : "off")
+		<< ", depth prepass " << (m_options.bDepthPrepass ? "on" : "off")
+		<< ", shader variants " << (m_options.bShaderVariants ? "on" : "off")
+		<< ", shadows " << (m_options.bShadows ? "on" : "off")
+		<< ", sun " << (m_options.bSunLight ? "on" : "off")
+		<< ", jobs " << (m_options.bJobSystem ? "on" : "off") << "\n";
+	std::cout << "total seconds: " << results.totalSeconds << "\n";
+	std::cout << "frames/second: " << results.framesPerSecond << "\n";
+	std::cout << "frame ms:      avg " << results.average << ", p50 " << results.p50
+		<< ", p95 " << results.p95 << ", p99 " << results.p99 << ", max " << results.maximum << "\n";
+	std::cout << "BENCHMARK frames=" << results.frameCount << " tiles=" << m_options.tileCount
+		<< " lights=" << m_options.pointLightCount
+		<< " stream_cells=" << m_options.streamCellSize
+		<< " width=" << m_options.outputWidth << " height=" << m_options.outputHeight
+		<< " render_scale=" << results.renderScale
+		<< " dynamic_fps=" << m_options.dynamicResolutionFps
+		<< " objects=" << objectCount << " visible=" << visibleCount << " draws=" << drawCalls
+		<< " culling=" << (m_options.bFrustumCulling ? 1 : 0)
+		<< " occlusion=" << (m_options.bOcclusionCulling ? 1 : 0)
+		<< " static_batch=" << (m_options.bStaticBatching ? 1 : 0)
+		<< " gpu_culling=" << (m_options.bGpuCulling ? 1 : 0)
+		<< " depth_prepass=" << (m_options.bDepthPrepass ? 1 : 0)
+		<< " shader_variants=" << (m_options.bShaderVariants ? 1 : 0)
+		<< " shadows=" << (m_options.bShadows ? 1 : 0)
+		<< " sun=" << (m_options.bSunLight ? 1 : 0)
+		<< " jobs=" << (m_options.bJobSystem ? 1 : 0)
+		<< " fps=" << results.framesPerSecond << " avg_ms=" << results.average
+		<< " p50_ms=" << results.p50 << " p95_ms=" << results.p95
+		<< " p99_ms=" << results.p99 << " max_ms=" << results.maximum << std::endl;
+	std::cout << std::defaultfloat;
+
+	if ((m_settings.maxP95 > 0.0f) && (results.p95 > m_settings.maxP95))
+	{
+		std::cout << "BENCHMARK FAILED: p95 frame time " << results.p95
+			<< " ms is above the limit of " << m_settings.maxP95 << " ms" << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.h
+// ============
+// measure the rendering performance of the 3D scene along a scripted camera
+// path - used for repeatable performance runs
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "AppOptions.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  Benchmark
+ *
+ *  This class contains the code for reading the command line
+ *  into the benchmark settings and the application options,
+ *  moving the camera along a path that only depends on the
+ *  frame number, timing the rendered frames and reporting
+ *  the results.
+ ***********************************************************/
+class Benchmark
+{
+public:
+	// the settings of a benchmark run
+	struct SETTINGS
+	{
+		// true when the benchmark runs instead of the window
+		bool bEnabled;
+		// number of timed frames
+		int frameCount;
+		// number of frames rendered before the timing starts
+		int warmupFrames;
+		// the run fails when the 95th percentile frame time in
+		// milliseconds is above this, 0 for no limit
+		float maxP95;
+	};
+
+	// the measured results of a benchmark run
+	struct RESULTS
+	{
+		int frameCount;
+		double totalSeconds;
+		float framesPerSecond;
+		float average;
+		float p50;
+		float p95;
+		float p99;
+		float maximum;
+		// render scale averaged over the timed frames, which the
+		// caller sets when the dynamic resolution changes it
+		float renderScale;
+	};
+
+	// constructor - the options are the ones the 3D scene was
+	// set up with, which the report shows
+	Benchmark(const SETTINGS& settings, const AppOptions::OPTIONS& options,
+		glm::vec3 sceneMin, glm::vec3 sceneMax);
+	// destructor
+	~Benchmark();
+
+	// read the benchmark settings and the application options
+	// from the command line, which returns false when an
+	// argument is unknown or a value is not valid
+	static bool ParseArguments(int argc, char* argv[], SETTINGS& settings, AppOptions::OPTIONS& options);
+
+	// get the camera position and look at target for a frame
+	void GetCameraPose(int frame, glm::vec3& position, glm::vec3& target) const;
+
+	// mark the start of the timed frames
+	void Start();
+	// mark the end of a timed frame
+	void EndFrame();
+	// wait for the rendering to finish and calculate the results
+	RESULTS Finish();
+
+	// output the results, which returns false when the frame
+	// time limit of the settings was exceeded
+	bool Report(const RESULTS& results, int objectCount, int visibleCount, int drawCalls) const;
+
+private:
+	SETTINGS m_settings;
+	AppOptions::OPTIONS m_options;
+	glm::vec3 m_sceneCenter;
+	// distance of the camera path from the scene center
+	float m_pathRadius;
+
+	std::chrono::steady_clock::time_point m_startTime;
+	std::chrono::steady_clock::time_point m_lastFrameTime;
+	// frame times in milliseconds
+	std::vector<float> m_frameTimes;
+	// fences of the frames in flight, which keep the CPU from
+	// running ahead of the GPU without a swap chain to limit it
+	std::vector<GLsync> m_frameFences;
+	int m_nextFence;
+};
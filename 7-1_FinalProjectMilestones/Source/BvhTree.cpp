@@ -0,0 +1,455 @@
+///////////////////////////////////////////////////////////////////////////////
+// bvhtree.cpp
+// ============
+// bounding volume hierarchy over the boxes of the objects in the 3D scene -
+// used for culling, picking and range queries
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BvhTree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// declaration of global variables
+namespace
+{
+	// the most items kept in one leaf of the tree
+	const int g_MaxLeafItems = 4;
+}
+
+/***********************************************************
+ *  BvhTree()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BvhTree::BvhTree()
+{
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the items.
+ ***********************************************************/
+void BvhTree::Clear()
+{
+	m_nodes.clear();
+	m_leafItems.clear();
+	m_itemMins.clear();
+	m_itemMaxs.clear();
+	m_itemLeaves.clear();
+}
+
+/***********************************************************
+ *  GetItemCount()
+ *
+ *  This method is used for getting the number of items in
+ *  the tree.
+ ***********************************************************/
+int BvhTree::GetItemCount() const
+{
+	return(m_itemMins.size());
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree over the passed
+ *  in item boxes.  Each node is split at the median of the
+ *  item centers along its longest axis, which keeps the tree
+ *  balanced at a depth of about log2(n / g_MaxLeafItems).
+ ***********************************************************/
+void BvhTree::Build(const std::vector<glm::vec3>& itemMins, const std::vector<glm::vec3>& itemMaxs)
+{
+	Clear();
+
+	m_itemMins = itemMins;
+	m_itemMaxs = itemMaxs;
+	m_itemLeaves.resize(itemMins.size(), -1);
+	m_leafItems.resize(itemMins.size());
+	for (size_t i = 0; i < m_leafItems.size(); i++)
+	{
+		m_leafItems[i] = i;
+	}
+
+	if (m_leafItems.empty() == true)
+	{
+		return;
+	}
+
+	// a tree of n leaves has 2n - 1 nodes
+	m_nodes.reserve(2 * (m_leafItems.size() / g_MaxLeafItems + 1));
+	BVH_NODE root;
+	root.parent = -1;
+	root.first = 0;
+	root.count = 0;
+	m_nodes.push_back(root);
+	BuildNode(0, 0, m_leafItems.size());
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for building the subtree under a
+ *  node for the items from first to first + count.
+ ***********************************************************/
+void BvhTree::BuildNode(int nodeIndex, int first, int count)
+{
+	if (count <= g_MaxLeafItems)
+	{
+		m_nodes[nodeIndex].first = first;
+		m_nodes[nodeIndex].count = count;
+		for (int i = first; i < first + count; i++)
+		{
+			m_itemLeaves[m_leafItems[i]] = nodeIndex;
+		}
+		UpdateNodeBounds(nodeIndex);
+		return;
+	}
+
+	// find the longest axis of the box around the item centers
+	glm::vec3 centerMin = (m_itemMins[m_leafItems[first]] + m_itemMaxs[m_leafItems[first]]) * 0.5f;
+	glm::vec3 centerMax = centerMin;
+	for (int i = first + 1; i < first + count; i++)
+	{
+		glm::vec3 center = (m_itemMins[m_leafItems[i]] + m_itemMaxs[m_leafItems[i]]) * 0.5f;
+		centerMin = glm::min(centerMin, center);
+		centerMax = glm::max(centerMax, center);
+	}
+	glm::vec3 extent = centerMax - centerMin;
+	int axis = 0;
+	if (extent.y > extent[axis])
+	{
+		axis = 1;
+	}
+	if (extent.z > extent[axis])
+	{
+		axis = 2;
+	}
+
+	// split the items into two halves at the median center
+	int half = count / 2;
+	std::nth_element(m_leafItems.begin() + first, m_leafItems.begin() + first + half,
+		m_leafItems.begin() + first + count,
+		[this, axis](int itemA, int itemB)
+		{
+			return((m_itemMins[itemA][axis] + m_itemMaxs[itemA][axis]) <
+				(m_itemMins[itemB][axis] + m_itemMaxs[itemB][axis]));
+		});
+
+	int childIndex = m_nodes.size();
+	BVH_NODE child;
+	child.parent = nodeIndex;
+	child.first = 0;
+	child.count = 0;
+	m_nodes.push_back(child);
+	m_nodes.push_back(child);
+	m_nodes[nodeIndex].first = childIndex;
+	m_nodes[nodeIndex].count = 0;
+
+	BuildNode(childIndex, first, half);
+	BuildNode(childIndex + 1, first + half, count - half);
+	UpdateNodeBounds(nodeIndex);
+}
+
+/***********************************************************
+ *  UpdateNodeBounds()
+ *
+ *  This method is used for calculating the box of a node
+ *  from the boxes of its items or of its two children.
+ ***********************************************************/
+void BvhTree::UpdateNodeBounds(int nodeIndex)
+{
+	BVH_NODE& node = m_nodes[nodeIndex];
+
+	if (node.count > 0)
+	{
+		node.boundsMin = m_itemMins[m_leafItems[node.first]];
+		node.boundsMax = m_itemMaxs[m_leafItems[node.first]];
+		for (int i = node.first + 1; i < node.first + node.count; i++)
+		{
+			node.boundsMin = glm::min(node.boundsMin, m_itemMins[m_leafItems[i]]);
+			node.boundsMax = glm::max(node.boundsMax, m_itemMaxs[m_leafItems[i]]);
+		}
+	}
+	else
+	{
+		const BVH_NODE& left = m_nodes[node.first];
+		const BVH_NODE& right = m_nodes[node.first + 1];
+		node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+		node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+	}
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for changing the box of one item.
+ *  The boxes of its leaf and of every node above it are
+ *  recalculated, which stops early once a node is unchanged.
+ *  The tree structure is kept, so objects that move far away
+ *  make the tree looser until it is built again.
+ ***********************************************************/
+void BvhTree::Refit(int itemIndex, const glm::vec3& itemMin, const glm::vec3& itemMax)
+{
+	if ((itemIndex < 0) || (itemIndex >= (int)m_itemMins.size()))
+	{
+		return;
+	}
+
+	m_itemMins[itemIndex] = itemMin;
+	m_itemMaxs[itemIndex] = itemMax;
+
+	int nodeIndex = m_itemLeaves[itemIndex];
+	while (nodeIndex >= 0)
+	{
+		glm::vec3 oldMin = m_nodes[nodeIndex].boundsMin;
+		glm::vec3 oldMax = m_nodes[nodeIndex].boundsMax;
+		UpdateNodeBounds(nodeIndex);
+		if ((oldMin == m_nodes[nodeIndex].boundsMin) && (oldMax == m_nodes[nodeIndex].boundsMax))
+		{
+			break;
+		}
+		nodeIndex = m_nodes[nodeIndex].parent;
+	}
+}
+
+/***********************************************************
+ *  AddSubtreeItems()
+ *
+ *  This method is used for adding all of the items under a
+ *  node to the list without testing them.
+ ***********************************************************/
+void BvhTree::AddSubtreeItems(int nodeIndex, std::vector<int>& items) const
+{
+	// the items of a subtree are stored together, from the
+	// first item of its leftmost leaf to the last of its
+	// rightmost leaf
+	int leftmost = nodeIndex;
+	while (m_nodes[leftmost].count == 0)
+	{
+		leftmost = m_nodes[leftmost].first;
+	}
+	int rightmost = nodeIndex;
+	while (m_nodes[rightmost].count == 0)
+	{
+		rightmost = m_nodes[rightmost].first + 1;
+	}
+
+	int first = m_nodes[leftmost].first;
+	int end = m_nodes[rightmost].first + m_nodes[rightmost].count;
+	items.insert(items.end(), m_leafItems.begin() + first, m_leafItems.begin() + end);
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for finding the items inside the
+ *  frustum.  A node outside of the frustum skips its whole
+ *  subtree, and a node fully inside adds its whole subtree
+ *  without testing it further.
+ ***********************************************************/
+void BvhTree::QueryFrustum(const Frustum& frustum, std::vector<int>& items) const
+{
+	if (m_nodes.empty() == true)
+	{
+		return;
+	}
+
+	m_stack.clear();
+	m_stack.push_back(0);
+	while (m_stack.empty() == false)
+	{
+		int nodeIndex = m_stack.back();
+		m_stack.pop_back();
+		const BVH_NODE& node = m_nodes[nodeIndex];
+
+		Frustum::BOX_CLASS boxClass = frustum.ClassifyBox(node.boundsMin, node.boundsMax);
+		if (boxClass == Frustum::BOX_OUTSIDE)
+		{
+			continue;
+		}
+		if (boxClass == Frustum::BOX_INSIDE)
+		{
+			AddSubtreeItems(nodeIndex, items);
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				int item = m_leafItems[i];
+				if (frustum.IsBoxVisible(m_itemMins[item], m_itemMaxs[item]) == true)
+				{
+					items.push_back(item);
+				}
+			}
+		}
+		else
+		{
+			m_stack.push_back(node.first + 1);
+			m_stack.push_back(node.first);
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryBox()
+ *
+ *  This method is used for finding the items whose boxes
+ *  overlap the passed in box.
+ ***********************************************************/
+void BvhTree::QueryBox(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<int>& items) const
+{
+	if (m_nodes.empty() == true)
+	{
+		return;
+	}
+
+	m_stack.clear();
+	m_stack.push_back(0);
+	while (m_stack.empty() == false)
+	{
+		const BVH_NODE& node = m_nodes[m_stack.back()];
+		m_stack.pop_back();
+
+		if ((node.boundsMin.x > boxMax.x) || (node.boundsMax.x < boxMin.x) ||
+			(node.boundsMin.y > boxMax.y) || (node.boundsMax.y < boxMin.y) ||
+			(node.boundsMin.z > boxMax.z) || (node.boundsMax.z < boxMin.z))
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				int item = m_leafItems[i];
+				const glm::vec3& itemMin = m_itemMins[item];
+				const glm::vec3& itemMax = m_itemMaxs[item];
+				if ((itemMin.x <= boxMax.x) && (itemMax.x >= boxMin.x) &&
+					(itemMin.y <= boxMax.y) && (itemMax.y >= boxMin.y) &&
+					(itemMin.z <= boxMax.z) && (itemMax.z >= boxMin.z))
+				{
+					items.push_back(item);
+				}
+			}
+		}
+		else
+		{
+			m_stack.push_back(node.first + 1);
+			m_stack.push_back(node.first);
+		}
+	}
+}
+
+/***********************************************************
+ *  IntersectRayBox()
+ *
+ *  This method is used for checking whether a ray hits a box
+ *  with the slab method - the ray is clipped against the
+ *  pair of planes of each axis in turn.
+ ***********************************************************/
+bool BvhTree::IntersectRayBox(const glm::vec3& origin, const glm::vec3& inverseDirection,
+	const glm::vec3& boxMin, const glm::vec3& boxMax, float maxDistance, float& distance)
+{
+	float nearDistance = 0.0f;
+	float farDistance = maxDistance;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float t0 = (boxMin[axis] - origin[axis]) * inverseDirection[axis];
+		float t1 = (boxMax[axis] - origin[axis]) * inverseDirection[axis];
+		if (t0 > t1)
+		{
+			std::swap(t0, t1);
+		}
+		// a ray in the plane of a slab gives NaN, which fails
+		// neither of these tests and keeps the range
+		nearDistance = (t0 > nearDistance) ? t0 : nearDistance;
+		farDistance = (t1 < farDistance) ? t1 : farDistance;
+		if (nearDistance > farDistance)
+		{
+			return(false);
+		}
+	}
+
+	distance = nearDistance;
+	return(true);
+}
+
+/***********************************************************
+ *  Raycast()
+ *
+ *  This method is used for finding the nearest item whose
+ *  box is hit by the ray.  The nearer child is visited
+ *  first, and nodes further than the nearest hit so far are
+ *  skipped.
+ ***********************************************************/
+int BvhTree::Raycast(const glm::vec3& origin, const glm::vec3& direction,
+	float maxDistance, float& hitDistance) const
+{
+	int hitItem = -1;
+	hitDistance = maxDistance;
+
+	if (m_nodes.empty() == true)
+	{
+		return(hitItem);
+	}
+
+	const float infinity = std::numeric_limits<float>::infinity();
+	glm::vec3 inverseDirection = glm::vec3(
+		(direction.x != 0.0f) ? 1.0f / direction.x : infinity,
+		(direction.y != 0.0f) ? 1.0f / direction.y : infinity,
+		(direction.z != 0.0f) ? 1.0f / direction.z : infinity);
+
+	float distance = 0.0f;
+	m_stack.clear();
+	m_stack.push_back(0);
+	while (m_stack.empty() == false)
+	{
+		const BVH_NODE& node = m_nodes[m_stack.back()];
+		m_stack.pop_back();
+
+		if (IntersectRayBox(origin, inverseDirection, node.boundsMin, node.boundsMax, hitDistance, distance) == false)
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				int item = m_leafItems[i];
+				if (IntersectRayBox(origin, inverseDirection, m_itemMins[item], m_itemMaxs[item], hitDistance, distance) == true)
+				{
+					hitItem = item;
+					hitDistance = distance;
+				}
+			}
+		}
+		else
+		{
+			// push the further child first so the nearer child is
+			// visited first and shortens the ray for the other
+			const BVH_NODE& left = m_nodes[node.first];
+			const BVH_NODE& right = m_nodes[node.first + 1];
+			float leftDistance = glm::dot((left.boundsMin + left.boundsMax) * 0.5f - origin, direction);
+			float rightDistance = glm::dot((right.boundsMin + right.boundsMax) * 0.5f - origin, direction);
+			if (leftDistance < rightDistance)
+			{
+				m_stack.push_back(node.first + 1);
+				m_stack.push_back(node.first);
+			}
+			else
+			{
+				m_stack.push_back(node.first);
+				m_stack.push_back(node.first + 1);
+			}
+		}
+	}
+
+	return(hitItem);
+}
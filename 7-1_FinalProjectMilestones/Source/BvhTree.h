@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+// bvhtree.h
+// ============
+// bounding volume hierarchy over the boxes of the objects in the 3D scene -
+// used for culling, picking and range queries
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Frustum.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  BvhTree
+ *
+ *  This class contains the code for building a binary tree
+ *  of boxes over indexed items, refitting it when the box of
+ *  an item changes, and querying it with a frustum, a ray or
+ *  a box.  The nodes are stored in one array with the two
+ *  children of a node next to each other.
+ ***********************************************************/
+class BvhTree
+{
+public:
+	// constructor
+	BvhTree();
+
+	// build the tree over the passed in item boxes, where the
+	// position in the arrays is the item index
+	void Build(const std::vector<glm::vec3>& itemMins, const std::vector<glm::vec3>& itemMaxs);
+	// change the box of one item and grow or shrink the boxes
+	// of the nodes above it
+	void Refit(int itemIndex, const glm::vec3& itemMin, const glm::vec3& itemMax);
+	// remove all of the items
+	void Clear();
+
+	// get the number of items in the tree
+	int GetItemCount() const;
+
+	// add the items whose boxes are at least partly inside the
+	// frustum to the list
+	void QueryFrustum(const Frustum& frustum, std::vector<int>& items) const;
+	// add the items whose boxes overlap the box to the list
+	void QueryBox(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<int>& items) const;
+	// find the nearest item whose box is hit by the ray, which
+	// returns -1 when none is hit within the maximum distance
+	int Raycast(const glm::vec3& origin, const glm::vec3& direction,
+		float maxDistance, float& hitDistance) const;
+
+private:
+	// one node of the tree
+	struct BVH_NODE
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// for a leaf, the first entry in m_leafItems, otherwise
+		// the index of the first of the two children
+		int first;
+		// number of items of a leaf, 0 for an inner node
+		int count;
+		int parent;
+	};
+
+	std::vector<BVH_NODE> m_nodes;
+	// item indices, grouped by the leaf that holds them
+	std::vector<int> m_leafItems;
+	// boxes of the items, indexed by the item index
+	std::vector<glm::vec3> m_itemMins;
+	std::vector<glm::vec3> m_itemMaxs;
+	// leaf node holding each item, indexed by the item index
+	std::vector<int> m_itemLeaves;
+	// reused stack of the nodes still to visit in a query
+	mutable std::vector<int> m_stack;
+
+	// split the items from first to first + count into the
+	// subtree under the node
+	void BuildNode(int nodeIndex, int first, int count);
+	// calculate the box of a node from its items or children
+	void UpdateNodeBounds(int nodeIndex);
+	// add all of the items under a node to the list
+	void AddSubtreeItems(int nodeIndex, std::vector<int>& items) const;
+
+	// check whether a ray hits a box, with the distance at the
+	// point the ray enters the box
+	static bool IntersectRayBox(const glm::vec3& origin, const glm::vec3& inverseDirection,
+		const glm::vec3& boxMin, const glm::vec3& boxMax, float maxDistance, float& distance);
+};
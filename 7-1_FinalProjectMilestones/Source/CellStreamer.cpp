@@ -0,0 +1,517 @@
+///////////////////////////////////////////////////////////////////////////////
+// cellstreamer.cpp
+// ============
+// split a large world into grid cells and stream the cells near the camera in
+// and out on a background thread, within a fixed memory budget
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CellStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// a resident cell is only unloaded once it is this much
+	// farther than the load radius, so that a camera moving along
+	// the edge of the radius does not load and unload it again
+	const float g_UnloadMargin = 1.25f;
+
+	// the most cells queued for loading at once - the nearest
+	// cells are chosen again on every update, so a short queue
+	// follows the camera better
+	const int g_MaxQueuedLoads = 4;
+
+	// how much of the newly measured camera velocity is used
+	// on each update
+	const float g_VelocitySmoothing = 0.2f;
+
+	/***********************************************************
+	 *  GetSegmentDistance()
+	 *
+	 *  This function is used for getting the distance from a
+	 *  point to the line segment between two points.
+	 ***********************************************************/
+	float GetSegmentDistance(glm::vec2 point, glm::vec2 start, glm::vec2 end)
+	{
+		glm::vec2 segment = end - start;
+		float lengthSquared = glm::dot(segment, segment);
+		float t = 0.0f;
+		if (lengthSquared > 0.0f)
+		{
+			t = glm::clamp(glm::dot(point - start, segment) / lengthSquared, 0.0f, 1.0f);
+		}
+
+		return(glm::length(point - (start + segment * t)));
+	}
+
+	/***********************************************************
+	 *  GetSeconds()
+	 *
+	 *  This function is used for getting a steady time in
+	 *  seconds.
+	 ***********************************************************/
+	double GetSeconds()
+	{
+		std::chrono::duration<double> time = std::chrono::steady_clock::now().time_since_epoch();
+		return(time.count());
+	}
+}
+
+/***********************************************************
+ *  CellStreamer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CellStreamer::CellStreamer()
+{
+	m_columns = 0;
+	m_rows = 0;
+	m_cellSize = 1.0f;
+	m_worldMin = glm::vec3(0.0f);
+	m_worldMax = glm::vec3(0.0f);
+	m_loadRadius = 0.0f;
+	m_prefetchSeconds = 0.0f;
+	m_lastCameraPosition = glm::vec3(0.0f);
+	m_cameraVelocity = glm::vec3(0.0f);
+	m_lastUpdateTime = 0.0;
+	m_bFirstUpdate = true;
+	m_loadingCount = 0;
+	m_bStopping = false;
+}
+
+/***********************************************************
+ *  ~CellStreamer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+CellStreamer::~CellStreamer()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  BuildCells()
+ *
+ *  This method is used for covering the positions of the
+ *  objects of the world with a grid of square cells, and
+ *  grouping the object indices by the cell under them.  The
+ *  objects are counted first, so the groups are filled in
+ *  place without growing any list.
+ ***********************************************************/
+int CellStreamer::BuildCells(int objectCount, float cellSize, const POSITION_FUNCTION& getPosition)
+{
+	m_cellSize = std::max(cellSize, 0.001f);
+	m_worldMin = glm::vec3(0.0f);
+	m_worldMax = glm::vec3(0.0f);
+	for (int i = 0; i < objectCount; i++)
+	{
+		glm::vec3 position = getPosition(i);
+		m_worldMin = (i == 0) ? position : glm::min(m_worldMin, position);
+		m_worldMax = (i == 0) ? position : glm::max(m_worldMax, position);
+	}
+
+	m_columns = std::max((int)ceilf((m_worldMax.x - m_worldMin.x) / m_cellSize), 1);
+	m_rows = std::max((int)ceilf((m_worldMax.z - m_worldMin.z) / m_cellSize), 1);
+
+	m_cells.resize(m_columns * m_rows);
+	for (int row = 0; row < m_rows; row++)
+	{
+		for (int column = 0; column < m_columns; column++)
+		{
+			CELL& cell = m_cells[row * m_columns + column];
+			cell.areaMin = glm::vec2(m_worldMin.x + column * m_cellSize, m_worldMin.z + row * m_cellSize);
+			cell.areaMax = cell.areaMin + glm::vec2(m_cellSize);
+			cell.boundsMin = glm::vec3(0.0f);
+			cell.boundsMax = glm::vec3(0.0f);
+			cell.firstObject = 0;
+			cell.objectCount = 0;
+			cell.slot = -1;
+			cell.state = CELL_UNLOADED;
+		}
+	}
+
+	// the cell of each object, with the objects on the far edge
+	// of the grid kept in its last cells
+	std::vector<int> objectCells(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		glm::vec3 position = getPosition(i);
+		int column = std::min((int)((position.x - m_worldMin.x) / m_cellSize), m_columns - 1);
+		int row = std::min((int)((position.z - m_worldMin.z) / m_cellSize), m_rows - 1);
+		objectCells[i] = row * m_columns + column;
+		m_cells[objectCells[i]].objectCount++;
+	}
+
+	int maxCellObjects = 0;
+	int firstObject = 0;
+	for (size_t i = 0; i < m_cells.size(); i++)
+	{
+		m_cells[i].firstObject = firstObject;
+		firstObject += m_cells[i].objectCount;
+		maxCellObjects = std::max(maxCellObjects, m_cells[i].objectCount);
+		// counted again while the groups are filled
+		m_cells[i].objectCount = 0;
+	}
+
+	m_cellObjects.resize(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		CELL& cell = m_cells[objectCells[i]];
+		m_cellObjects[cell.firstObject + cell.objectCount] = i;
+		cell.objectCount++;
+	}
+
+	return(maxCellObjects);
+}
+
+/***********************************************************
+ *  SetResidency()
+ *
+ *  This method is used for setting the number of slots for
+ *  the resident cells, how far around the camera the cells
+ *  are loaded, and how far ahead of the camera movement the
+ *  cells are prefetched, in seconds of the movement.
+ ***********************************************************/
+void CellStreamer::SetResidency(int slotCount, float loadRadius, float prefetchSeconds)
+{
+	m_freeSlots.clear();
+	for (int i = slotCount - 1; i >= 0; i--)
+	{
+		m_freeSlots.push_back(i);
+	}
+	m_loadRadius = std::max(loadRadius, 0.0f);
+	m_prefetchSeconds = std::max(prefetchSeconds, 0.0f);
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the streaming thread,
+ *  which runs the passed in function for every cell that
+ *  is loaded.
+ ***********************************************************/
+void CellStreamer::Start(const LOAD_FUNCTION& loadFunction)
+{
+	Stop();
+
+	m_loadFunction = loadFunction;
+	m_bStopping = false;
+	m_worker = std::thread(&CellStreamer::WorkerLoop, this);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for stopping the streaming thread.
+ *  The cell being loaded is finished first, and the cells
+ *  still waiting are dropped.
+ ***********************************************************/
+void CellStreamer::Stop()
+{
+	if (m_worker.joinable() == false)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+		m_jobs.clear();
+	}
+	m_jobReady.notify_all();
+	m_worker.join();
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for updating the resident cells for
+ *  the camera position.  The cells loaded since the last
+ *  update become resident, the cells that are out of reach
+ *  are unloaded, and the nearest cells within the radius of
+ *  the path of the camera over the prefetch time are queued
+ *  for loading.  When every slot is used, a farther resident
+ *  cell gives up its slot for a nearer one.
+ ***********************************************************/
+bool CellStreamer::Update(glm::vec3 cameraPosition)
+{
+	bool bChanged = false;
+
+	// follow the camera movement
+	double now = GetSeconds();
+	if (m_bFirstUpdate == true)
+	{
+		m_bFirstUpdate = false;
+	}
+	else if (now > m_lastUpdateTime)
+	{
+		glm::vec3 velocity = (cameraPosition - m_lastCameraPosition) / (float)(now - m_lastUpdateTime);
+		m_cameraVelocity += (velocity - m_cameraVelocity) * g_VelocitySmoothing;
+	}
+	m_lastCameraPosition = cameraPosition;
+	m_lastUpdateTime = now;
+
+	// the loaded cells are resident from now on
+	std::vector<LOADED_CELL> loadedCells;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		loadedCells.swap(m_loadedCells);
+	}
+	m_arrivedCells.clear();
+	for (size_t i = 0; i < loadedCells.size(); i++)
+	{
+		CELL& cell = m_cells[loadedCells[i].cellIndex];
+		cell.boundsMin = loadedCells[i].boundsMin;
+		cell.boundsMax = loadedCells[i].boundsMax;
+		cell.state = CELL_RESIDENT;
+		m_residentCells.push_back(loadedCells[i].cellIndex);
+		m_arrivedCells.push_back(loadedCells[i].cellIndex);
+		m_loadingCount--;
+		bChanged = true;
+	}
+
+	glm::vec2 camera = glm::vec2(cameraPosition.x, cameraPosition.z);
+	glm::vec2 predicted = camera + glm::vec2(m_cameraVelocity.x, m_cameraVelocity.z) * m_prefetchSeconds;
+	// the cells are reached from their centers, so the radius is
+	// grown by half of the diagonal of a cell
+	float halfDiagonal = m_cellSize * sqrtf(0.5f);
+
+	// unload the resident cells that are out of reach
+	for (int i = (int)m_residentCells.size() - 1; i >= 0; i--)
+	{
+		const CELL& cell = m_cells[m_residentCells[i]];
+		glm::vec2 center = (cell.areaMin + cell.areaMax) * 0.5f;
+		if (GetSegmentDistance(center, camera, predicted) > m_loadRadius * g_UnloadMargin + halfDiagonal)
+		{
+			UnloadCell(m_residentCells[i]);
+			bChanged = true;
+		}
+	}
+
+	if ((m_cells.empty() == true) || (m_loadingCount >= g_MaxQueuedLoads))
+	{
+		return(bChanged);
+	}
+
+	// the cells within the radius of the camera path, nearest to
+	// the camera first
+	glm::vec2 regionMin = glm::min(camera, predicted) - glm::vec2(m_loadRadius);
+	glm::vec2 regionMax = glm::max(camera, predicted) + glm::vec2(m_loadRadius);
+	int firstColumn = std::max((int)floorf((regionMin.x - m_worldMin.x) / m_cellSize), 0);
+	int lastColumn = std::min((int)floorf((regionMax.x - m_worldMin.x) / m_cellSize), m_columns - 1);
+	int firstRow = std::max((int)floorf((regionMin.y - m_worldMin.z) / m_cellSize), 0);
+	int lastRow = std::min((int)floorf((regionMax.y - m_worldMin.z) / m_cellSize), m_rows - 1);
+
+	std::vector<std::pair<float, int> > candidates;
+	for (int row = firstRow; row <= lastRow; row++)
+	{
+		for (int column = firstColumn; column <= lastColumn; column++)
+		{
+			int cellIndex = row * m_columns + column;
+			const CELL& cell = m_cells[cellIndex];
+			if ((cell.state != CELL_UNLOADED) || (cell.objectCount == 0))
+			{
+				continue;
+			}
+
+			glm::vec2 center = (cell.areaMin + cell.areaMax) * 0.5f;
+			if (GetSegmentDistance(center, camera, predicted) <= m_loadRadius + halfDiagonal)
+			{
+				candidates.push_back(std::make_pair(GetCellDistance(cell, camera), cellIndex));
+			}
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	for (size_t i = 0; (i < candidates.size()) && (m_loadingCount < g_MaxQueuedLoads); i++)
+	{
+		// take a free slot, or the slot of the farthest resident
+		// cell when it is farther than this one
+		if (m_freeSlots.empty() == true)
+		{
+			int farthestCell = -1;
+			float farthestDistance = candidates[i].first;
+			for (size_t j = 0; j < m_residentCells.size(); j++)
+			{
+				float distance = GetCellDistance(m_cells[m_residentCells[j]], camera);
+				if (distance > farthestDistance)
+				{
+					farthestCell = m_residentCells[j];
+					farthestDistance = distance;
+				}
+			}
+
+			if (farthestCell < 0)
+			{
+				break;
+			}
+			UnloadCell(farthestCell);
+			bChanged = true;
+		}
+
+		CELL& cell = m_cells[candidates[i].second];
+		cell.slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+		cell.state = CELL_LOADING;
+		m_loadingCount++;
+
+		LOAD_JOB job;
+		job.cellIndex = candidates[i].second;
+		job.firstObject = cell.firstObject;
+		job.objectCount = cell.objectCount;
+		job.slot = cell.slot;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.push_back(job);
+		}
+		m_jobReady.notify_one();
+	}
+
+	return(bChanged);
+}
+
+/***********************************************************
+ *  UnloadCell()
+ *
+ *  This method is used for marking a resident cell unloaded
+ *  and giving its slot back.
+ ***********************************************************/
+void CellStreamer::UnloadCell(int cellIndex)
+{
+	CELL& cell = m_cells[cellIndex];
+
+	std::vector<int>::iterator found = std::find(m_residentCells.begin(), m_residentCells.end(), cellIndex);
+	if (found != m_residentCells.end())
+	{
+		*found = m_residentCells.back();
+		m_residentCells.pop_back();
+	}
+
+	m_freeSlots.push_back(cell.slot);
+	cell.slot = -1;
+	cell.state = CELL_UNLOADED;
+}
+
+/***********************************************************
+ *  GetCellDistance()
+ *
+ *  This method is used for getting the distance from a
+ *  point to the nearest point of the area of a cell, which
+ *  is 0 inside of the cell.
+ ***********************************************************/
+float CellStreamer::GetCellDistance(const CELL& cell, glm::vec2 point) const
+{
+	glm::vec2 nearest = glm::min(glm::max(point, cell.areaMin), cell.areaMax);
+	return(glm::length(point - nearest));
+}
+
+/***********************************************************
+ *  GetResidentCells()
+ *
+ *  This method is used for getting the indices of the cells
+ *  whose objects are loaded into their slots.
+ ***********************************************************/
+const std::vector<int>& CellStreamer::GetResidentCells() const
+{
+	return(m_residentCells);
+}
+
+/***********************************************************
+ *  GetArrivedCells()
+ *
+ *  This method is used for getting the indices of the cells
+ *  that were marked resident by the last update.  Their slots
+ *  may have held the objects of other cells before.
+ ***********************************************************/
+const std::vector<int>& CellStreamer::GetArrivedCells() const
+{
+	return(m_arrivedCells);
+}
+
+/***********************************************************
+ *  GetCell()
+ *
+ *  This method is used for getting a cell by index.
+ ***********************************************************/
+const CellStreamer::CELL& CellStreamer::GetCell(int cellIndex) const
+{
+	return(m_cells[cellIndex]);
+}
+
+/***********************************************************
+ *  GetCellCount()
+ *
+ *  This method is used for getting the number of cells of
+ *  the grid.
+ ***********************************************************/
+int CellStreamer::GetCellCount() const
+{
+	return(m_cells.size());
+}
+
+/***********************************************************
+ *  GetPendingCount()
+ *
+ *  This method is used for getting the number of cells that
+ *  are queued or loading and not resident yet.
+ ***********************************************************/
+int CellStreamer::GetPendingCount()
+{
+	return(m_loadingCount);
+}
+
+/***********************************************************
+ *  GetWorldBounds()
+ *
+ *  This method is used for getting a box around the
+ *  positions of all of the objects of the world.
+ ***********************************************************/
+void CellStreamer::GetWorldBounds(glm::vec3& minXYZ, glm::vec3& maxXYZ) const
+{
+	minXYZ = m_worldMin;
+	maxXYZ = m_worldMax;
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used as the main loop of the streaming
+ *  thread, loading the queued cells into their slots until
+ *  the streamer is stopped.
+ ***********************************************************/
+void CellStreamer::WorkerLoop()
+{
+	while (true)
+	{
+		LOAD_JOB job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobReady.wait(lock, [this] { return((m_bStopping == true) || (m_jobs.empty() == false)); });
+
+			if (m_bStopping == true)
+			{
+				return;
+			}
+
+			job = m_jobs.front();
+			m_jobs.pop_front();
+		}
+
+		// load outside of the lock so that the updates never wait
+		LOADED_CELL loaded;
+		loaded.cellIndex = job.cellIndex;
+		loaded.boundsMin = glm::vec3(0.0f);
+		loaded.boundsMax = glm::vec3(0.0f);
+		m_loadFunction(&m_cellObjects[job.firstObject], job.objectCount, job.slot,
+			loaded.boundsMin, loaded.boundsMax);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_loadedCells.push_back(loaded);
+		}
+	}
+}
@@ -0,0 +1,163 @@
+///////////////////////////////////////////////////////////////////////////////
+// cellstreamer.h
+// ============
+// split a large world into grid cells and stream the cells near the camera in
+// and out on a background thread, within a fixed memory budget
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  CellStreamer
+ *
+ *  This class contains the code for deciding which cells of
+ *  a world grid are resident.  The objects of the world are
+ *  grouped by the cell under their position, and every frame
+ *  the cells around the camera and along its movement are
+ *  requested, nearest first.  A resident cell owns one of a
+ *  fixed number of slots, which bounds the memory used no
+ *  matter how large the world is.  The objects of a cell are
+ *  loaded into its slot by a load function run on the
+ *  streaming thread - no OpenGL calls are made there.
+ ***********************************************************/
+class CellStreamer
+{
+public:
+	// constructor
+	CellStreamer();
+	// destructor
+	~CellStreamer();
+
+	// the residency of a cell
+	enum CELL_STATE
+	{
+		CELL_UNLOADED = 0,
+		CELL_LOADING,
+		CELL_RESIDENT
+	};
+
+	// one cell of the world grid
+	struct CELL
+	{
+		// the area of the grid covered by the cell
+		glm::vec2 areaMin;
+		glm::vec2 areaMax;
+		// box around the loaded objects, valid while resident
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// the objects of the cell in the cell object list
+		int firstObject;
+		int objectCount;
+		// slot holding the loaded objects, -1 when unloaded
+		int slot;
+		CELL_STATE state;
+	};
+
+	// load the passed in objects of a cell into a slot, setting
+	// the box around them - runs on the streaming thread
+	typedef std::function<void(const int* objectIndices, int objectCount, int slot,
+		glm::vec3& boundsMin, glm::vec3& boundsMax)> LOAD_FUNCTION;
+	// get the position of an object of the world
+	typedef std::function<glm::vec3(int objectIndex)> POSITION_FUNCTION;
+
+	// group the objects of the world into square cells of the
+	// passed in size, returning the most objects in any cell
+	int BuildCells(int objectCount, float cellSize, const POSITION_FUNCTION& getPosition);
+	// set the number of slots, the cells within the radius of
+	// the camera, and how many seconds of the camera movement
+	// ahead are also loaded - before the first update
+	void SetResidency(int slotCount, float loadRadius, float prefetchSeconds);
+	// start the streaming thread with the load function
+	void Start(const LOAD_FUNCTION& loadFunction);
+	// stop the streaming thread, waiting for its current load
+	void Stop();
+
+	// mark the loaded cells resident, unload the cells that are
+	// no longer needed and request the cells around the camera
+	// - returns true when the resident cells changed
+	bool Update(glm::vec3 cameraPosition);
+
+	// get the resident cells, which stay the same until the
+	// next update
+	const std::vector<int>& GetResidentCells() const;
+	// get the cells that became resident at the last update,
+	// whose slots now hold other objects
+	const std::vector<int>& GetArrivedCells() const;
+	// get a cell by index
+	const CELL& GetCell(int cellIndex) const;
+	// get the number of cells of the grid
+	int GetCellCount() const;
+	// get the number of cells loading or waiting to load
+	int GetPendingCount();
+	// get the box around the positions of all of the objects
+	void GetWorldBounds(glm::vec3& minXYZ, glm::vec3& maxXYZ) const;
+
+private:
+	// a cell waiting to be loaded by the streaming thread
+	struct LOAD_JOB
+	{
+		int cellIndex;
+		int firstObject;
+		int objectCount;
+		int slot;
+	};
+	// a cell loaded by the streaming thread
+	struct LOADED_CELL
+	{
+		int cellIndex;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	// the grid of cells, row by row
+	std::vector<CELL> m_cells;
+	int m_columns;
+	int m_rows;
+	float m_cellSize;
+	glm::vec3 m_worldMin;
+	glm::vec3 m_worldMax;
+	// the object indices of all of the cells, grouped by cell
+	std::vector<int> m_cellObjects;
+
+	// slots not owned by any cell
+	std::vector<int> m_freeSlots;
+	// the cells marked resident by the last update
+	std::vector<int> m_residentCells;
+	// the cells loaded since the update before the last one
+	std::vector<int> m_arrivedCells;
+	float m_loadRadius;
+	float m_prefetchSeconds;
+	// the camera at the last update and its smoothed velocity
+	glm::vec3 m_lastCameraPosition;
+	glm::vec3 m_cameraVelocity;
+	double m_lastUpdateTime;
+	bool m_bFirstUpdate;
+	// number of loads queued and not marked resident yet
+	int m_loadingCount;
+
+	LOAD_FUNCTION m_loadFunction;
+	std::thread m_worker;
+	// cells waiting to be loaded and cells loaded, guarded by
+	// m_mutex
+	std::deque<LOAD_JOB> m_jobs;
+	std::vector<LOADED_CELL> m_loadedCells;
+	bool m_bStopping;
+	std::mutex m_mutex;
+	std::condition_variable m_jobReady;
+
+	// main loop of the streaming thread
+	void WorkerLoop();
+	// get the distance from a point to the area of a cell
+	float GetCellDistance(const CELL& cell, glm::vec2 point) const;
+	// unload a resident cell and free its slot
+	void UnloadCell(int cellIndex);
+};
@@ -0,0 +1,305 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlights.cpp
+// ============
+// bin the point lights of the 3D scene into clusters of the view in a compute
+// shader, so that each pixel only lights itself with the lights near it
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ClusteredLights.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	// these need to match the local size and CLUSTER_STRIDE in
+	// the light binning shader and the fragment shader
+	const int g_WorkGroupSize = 64;
+	const int g_ClusterStride = 64;
+
+	// size of the clusters in pixels and number of depth slices
+	const int g_TileSize = 64;
+	const int g_DepthSlices = 16;
+
+	// binding points of the shader storage buffers, after the
+	// ones of the GPU culling
+	const GLuint g_PointLightBinding = 4;
+	const GLuint g_ClusterLightBinding = 5;
+
+	// names of the shader storage blocks, in the order of the
+	// binding points
+	const char* g_StorageBlockNames[] = {
+		"PointLightBlock",
+		"ClusterLightBlock" };
+	const int g_StorageBlockCount = 2;
+}
+
+/***********************************************************
+ *  ClusteredLights()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ClusteredLights::ClusteredLights(ResourcePool* pResourcePool)
+{
+	m_lightCount = 0;
+	m_clusterCapacity = 0;
+	m_program = 0;
+	m_pResourcePool = pResourcePool;
+	m_lightBuffer = 0;
+	m_clusterBuffer = 0;
+	m_pClusterBuffer = NULL;
+}
+
+/***********************************************************
+ *  ~ClusteredLights()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ClusteredLights::~ClusteredLights()
+{
+	Clear();
+	if (m_clusterBuffer != 0)
+	{
+		m_pResourcePool->ReleaseBuffer(m_clusterBuffer);
+		m_clusterBuffer = 0;
+	}
+	if (NULL != m_pClusterBuffer)
+	{
+		delete m_pClusterBuffer;
+		m_pClusterBuffer = NULL;
+	}
+	// the program belongs to the shader cache
+	m_program = 0;
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the OpenGL
+ *  context has the compute shaders and shader storage
+ *  buffers that the binning needs.
+ ***********************************************************/
+bool ClusteredLights::IsSupported()
+{
+	return((GLEW_VERSION_4_3 == GL_TRUE) ||
+		((GLEW_ARB_compute_shader == GL_TRUE) &&
+		 (GLEW_ARB_shader_storage_buffer_object == GL_TRUE)));
+}
+
+/***********************************************************
+ *  BindProgramBlocks()
+ *
+ *  This method is used for connecting the shader storage
+ *  blocks of the point lights and the cluster light lists
+ *  declared in the passed in shader program to their binding
+ *  points.  Blocks that the program does not declare are
+ *  skipped.
+ ***********************************************************/
+void ClusteredLights::BindProgramBlocks(GLuint programID)
+{
+	if (IsSupported() == false)
+	{
+		return;
+	}
+
+	for (int i = 0; i < g_StorageBlockCount; i++)
+	{
+		GLuint blockIndex = glGetProgramResourceIndex(programID, GL_SHADER_STORAGE_BLOCK, g_StorageBlockNames[i]);
+		if (blockIndex != GL_INVALID_INDEX)
+		{
+			glShaderStorageBlockBinding(programID, blockIndex, g_PointLightBinding + i);
+		}
+	}
+}
+
+/***********************************************************
+ *  LoadShader()
+ *
+ *  This method is used for getting the light binning
+ *  compute shader from the shader cache, and for connecting
+ *  its blocks.
+ ***********************************************************/
+bool ClusteredLights::LoadShader(ShaderCache* pShaderCache, const char* filename)
+{
+	GLuint program = pShaderCache->GetComputeProgram(filename, "");
+	if (program == 0)
+	{
+		std::cout << "Could not build the light binning shader " << filename << std::endl;
+		return(false);
+	}
+
+	m_program = program;
+
+	// the shader reads the view from the camera block and the
+	// cluster values from the cluster block
+	UniformBuffer::BindProgramBlocks(m_program);
+	BindProgramBlocks(m_program);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the point lights
+ *  and their buffer.
+ ***********************************************************/
+void ClusteredLights::Clear()
+{
+	if (m_lightBuffer != 0)
+	{
+		m_pResourcePool->ReleaseBuffer(m_lightBuffer);
+		m_lightBuffer = 0;
+	}
+	m_lights.clear();
+	m_lightCount = 0;
+}
+
+/***********************************************************
+ *  AddLight()
+ *
+ *  This method is used for adding a point light, which is
+ *  drawn once Upload() has been called.
+ ***********************************************************/
+int ClusteredLights::AddLight(const POINT_LIGHT_ENTRY& light)
+{
+	m_lights.push_back(light);
+	return(m_lights.size() - 1);
+}
+
+/***********************************************************
+ *  GetLightCount()
+ *
+ *  This method is used for getting the number of added
+ *  point lights.
+ ***********************************************************/
+int ClusteredLights::GetLightCount() const
+{
+	return(m_lights.size());
+}
+
+/***********************************************************
+ *  GetLight()
+ *
+ *  This method is used for getting an added point light by
+ *  its index.
+ ***********************************************************/
+const ClusteredLights::POINT_LIGHT_ENTRY& ClusteredLights::GetLight(int index) const
+{
+	return(m_lights[index]);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for uploading the point lights into
+ *  the shader storage buffer.  The lights are kept, so more
+ *  of them can be added and uploaded again, which reuses the
+ *  buffer from the pool while the lights fit in its size.
+ ***********************************************************/
+void ClusteredLights::Upload()
+{
+	if (m_lightBuffer != 0)
+	{
+		m_pResourcePool->ReleaseBuffer(m_lightBuffer);
+		m_lightBuffer = 0;
+	}
+	m_lightCount = m_lights.size();
+	if (m_lightCount == 0)
+	{
+		return;
+	}
+
+	m_lightBuffer = m_pResourcePool->AcquireBuffer(sizeof(POINT_LIGHT_ENTRY) * m_lightCount, GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_lightBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(POINT_LIGHT_ENTRY) * m_lightCount, m_lights.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  IsReady()
+ *
+ *  This method is used for checking whether the binning
+ *  shader is loaded and the lights are uploaded.
+ ***********************************************************/
+bool ClusteredLights::IsReady() const
+{
+	return((m_program != 0) && (m_lightBuffer != 0));
+}
+
+/***********************************************************
+ *  Bin()
+ *
+ *  This method is used for running the binning shader over
+ *  the clusters of the current viewport.  The clusters are
+ *  the screen tiles split into depth slices that grow with
+ *  the distance, between the near and far distances of the
+ *  perspective projection.  The shader program of the draws
+ *  is bound again afterwards.
+ ***********************************************************/
+void ClusteredLights::Bin(const glm::mat4& projection)
+{
+	if (IsReady() == false)
+	{
+		return;
+	}
+
+	GLint viewport[4] = { 0, 0, 0, 0 };
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((viewport[2] <= 0) || (viewport[3] <= 0))
+	{
+		return;
+	}
+
+	CLUSTER_BLOCK cluster;
+	cluster.inverseProjection = glm::inverse(projection);
+	cluster.viewSize = glm::vec2((float)viewport[2], (float)viewport[3]);
+	cluster.nearDistance = projection[3][2] / (projection[2][2] - 1.0f);
+	cluster.farDistance = projection[3][2] / (projection[2][2] + 1.0f);
+	float depthRange = logf(cluster.farDistance / cluster.nearDistance);
+	cluster.sliceScale = g_DepthSlices / depthRange;
+	cluster.sliceBias = -g_DepthSlices * logf(cluster.nearDistance) / depthRange;
+	cluster.tileSize = g_TileSize;
+	cluster.lightCount = m_lightCount;
+	cluster.tilesX = (viewport[2] + g_TileSize - 1) / g_TileSize;
+	cluster.tilesY = (viewport[3] + g_TileSize - 1) / g_TileSize;
+	cluster.slices = g_DepthSlices;
+	cluster.padding = 0;
+
+	if (NULL == m_pClusterBuffer)
+	{
+		m_pClusterBuffer = new UniformBuffer(sizeof(CLUSTER_BLOCK), UniformBuffer::CLUSTER_BINDING, true);
+	}
+	m_pClusterBuffer->Update(&cluster, sizeof(cluster));
+
+	// the light lists only grow with the viewport
+	int clusterCount = cluster.tilesX * cluster.tilesY * cluster.slices;
+	if (clusterCount > m_clusterCapacity)
+	{
+		if (m_clusterBuffer != 0)
+		{
+			m_pResourcePool->ReleaseBuffer(m_clusterBuffer);
+		}
+		GLsizeiptr capacity = 0;
+		m_clusterBuffer = m_pResourcePool->AcquireBuffer(
+			sizeof(GLuint) * g_ClusterStride * clusterCount, GL_DYNAMIC_DRAW, &capacity);
+		m_clusterCapacity = capacity / (sizeof(GLuint) * g_ClusterStride);
+	}
+
+	GLint drawProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &drawProgram);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_PointLightBinding, m_lightBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_ClusterLightBinding, m_clusterBuffer);
+
+	glUseProgram(m_program);
+	glDispatchCompute((clusterCount + g_WorkGroupSize - 1) / g_WorkGroupSize, 1, 1);
+
+	// the fragment shader reads the light lists written above
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	glUseProgram(drawProgram);
+}
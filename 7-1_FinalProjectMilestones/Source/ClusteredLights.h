@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlights.h
+// ============
+// bin the point lights of the 3D scene into clusters of the view in a compute
+// shader, so that each pixel only lights itself with the lights near it
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ResourcePool.h"
+#include "ShaderCache.h"
+#include "UniformBuffer.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ClusteredLights
+ *
+ *  This class contains the code for keeping the point lights
+ *  in a shader storage buffer, and for splitting the view
+ *  into screen tiles and depth slices whose lists of the
+ *  lights reaching them are built on the GPU every frame.
+ *  The fragment shader finds the cluster of its pixel and
+ *  only loops over the lights in that list.
+ ***********************************************************/
+class ClusteredLights
+{
+public:
+	// constructor
+	ClusteredLights(ResourcePool* pResourcePool);
+	// destructor
+	~ClusteredLights();
+
+	// one point light as laid out in the std430 point light
+	// buffer of the shaders - 32 bytes
+	struct POINT_LIGHT_ENTRY
+	{
+		glm::vec3 position;
+		// the light fades out to nothing at this distance
+		float radius;
+		glm::vec3 color;
+		float specularIntensity;
+	};
+
+	// the per-frame cluster values as laid out in the std140
+	// cluster block of the shaders - 112 bytes
+	struct CLUSTER_BLOCK
+	{
+		glm::mat4 inverseProjection;
+		glm::vec2 viewSize;
+		// the depth slice is log(depth) * sliceScale + sliceBias
+		float sliceScale;
+		float sliceBias;
+		float nearDistance;
+		float farDistance;
+		GLint tileSize;
+		GLint lightCount;
+		GLint tilesX;
+		GLint tilesY;
+		GLint slices;
+		GLint padding;
+	};
+
+	// check whether the OpenGL context has compute shaders and
+	// shader storage buffers
+	static bool IsSupported();
+	// connect the light buffers of a shader program to their
+	// binding points
+	static void BindProgramBlocks(GLuint programID);
+
+	// get the light binning shader of a file from the shader cache
+	bool LoadShader(ShaderCache* pShaderCache, const char* filename);
+
+	// remove all of the point lights
+	void Clear();
+	// add a point light, returning its index
+	int AddLight(const POINT_LIGHT_ENTRY& light);
+	// get the number of point lights
+	int GetLightCount() const;
+	// get a point light by index
+	const POINT_LIGHT_ENTRY& GetLight(int index) const;
+	// upload the point lights into the shader storage buffer
+	void Upload();
+
+	// get whether there are uploaded lights and a shader
+	bool IsReady() const;
+	// build the light list of every cluster of the view
+	void Bin(const glm::mat4& projection);
+
+private:
+	// the point lights before they are uploaded
+	std::vector<POINT_LIGHT_ENTRY> m_lights;
+	int m_lightCount;
+	// number of clusters the cluster buffer has room for
+	int m_clusterCapacity;
+
+	GLuint m_program;
+	// gives out the shader storage buffers
+	ResourcePool* m_pResourcePool;
+	GLuint m_lightBuffer;
+	GLuint m_clusterBuffer;
+	// per-frame values read by the binning and the lighting
+	UniformBuffer* m_pClusterBuffer;
+};
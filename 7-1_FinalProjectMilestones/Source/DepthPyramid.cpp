@@ -0,0 +1,381 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthpyramid.cpp
+// ============
+// reduce the depth buffer of a rendered frame into a pyramid of the farthest
+// depths, which the GPU culling tests the boxes of the objects against
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DepthPyramid.h"
+
+#include <algorithm>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// this needs to match the local size in the reduction shader
+	const int g_WorkGroupSize = 8;
+
+	// image units that the levels are read from and written to
+	const GLuint g_SourceImageUnit = 0;
+	const GLuint g_TargetImageUnit = 1;
+
+	/***********************************************************
+	 *  NextPowerOfTwo()
+	 *
+	 *  This function is used for rounding a size up to the next
+	 *  power of two.
+	 ***********************************************************/
+	int NextPowerOfTwo(int size)
+	{
+		int powerOfTwo = 1;
+		while (powerOfTwo < size)
+		{
+			powerOfTwo *= 2;
+		}
+		return(powerOfTwo);
+	}
+}
+
+/***********************************************************
+ *  DepthPyramid()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DepthPyramid::DepthPyramid(ResourcePool* pResourcePool)
+{
+	m_pResourcePool = pResourcePool;
+	m_program = 0;
+	m_depthTexture = 0;
+	m_depthWidth = 0;
+	m_depthHeight = 0;
+	m_pyramidTexture = 0;
+	m_pyramidWidth = 0;
+	m_pyramidHeight = 0;
+	m_levelCount = 0;
+	m_viewProjection = glm::mat4(1.0f);
+	m_viewWidth = 0;
+	m_viewHeight = 0;
+	m_bValid = false;
+	m_fromViewDepthLocation = -1;
+	m_sourceSizeLocation = -1;
+}
+
+/***********************************************************
+ *  ~DepthPyramid()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DepthPyramid::~DepthPyramid()
+{
+	Destroy();
+	// the program belongs to the shader cache
+	m_program = 0;
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the OpenGL
+ *  context has the compute shaders and the image loads and
+ *  stores that the reduction needs.
+ ***********************************************************/
+bool DepthPyramid::IsSupported()
+{
+	return((GLEW_VERSION_4_3 == GL_TRUE) ||
+		((GLEW_ARB_compute_shader == GL_TRUE) &&
+		 (GLEW_ARB_shader_image_load_store == GL_TRUE)));
+}
+
+/***********************************************************
+ *  LoadShader()
+ *
+ *  This method is used for getting the reduction compute
+ *  shader from the shader cache, and for finding its
+ *  uniforms.
+ ***********************************************************/
+bool DepthPyramid::LoadShader(ShaderCache* pShaderCache, const char* filename)
+{
+	GLuint program = pShaderCache->GetComputeProgram(filename, "");
+	if (program == 0)
+	{
+		std::cout << "Could not build the depth pyramid shader " << filename << std::endl;
+		return(false);
+	}
+
+	m_program = program;
+	m_fromViewDepthLocation = glGetUniformLocation(m_program, "bFromViewDepth");
+	m_sourceSizeLocation = glGetUniformLocation(m_program, "sourceSize");
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReserveTextures()
+ *
+ *  This method is used for getting the depth copy and the
+ *  pyramid textures from the resource pool when the view is
+ *  larger than they are.  They never shrink, so a view whose
+ *  resolution changes every frame does not create them
+ *  again.
+ ***********************************************************/
+bool DepthPyramid::ReserveTextures(int viewWidth, int viewHeight)
+{
+	if ((viewWidth > m_depthWidth) || (viewHeight > m_depthHeight))
+	{
+		if (m_depthTexture != 0)
+		{
+			m_pResourcePool->ReleaseTexture(m_depthTexture);
+		}
+		m_depthWidth = std::max(viewWidth, m_depthWidth);
+		m_depthHeight = std::max(viewHeight, m_depthHeight);
+
+		ResourcePool::TEXTURE_DESC desc;
+		desc.target = GL_TEXTURE_2D;
+		desc.internalFormat = GL_DEPTH_COMPONENT24;
+		desc.width = m_depthWidth;
+		desc.height = m_depthHeight;
+		desc.depth = 1;
+		desc.levelCount = 1;
+		desc.byteSize = (GLsizeiptr)m_depthWidth * m_depthHeight * 4;
+
+		bool bReused = false;
+		m_depthTexture = m_pResourcePool->AcquireTexture(desc, bReused);
+		if (m_depthTexture == 0)
+		{
+			m_depthWidth = 0;
+			m_depthHeight = 0;
+			return(false);
+		}
+
+		glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+		if (bReused == false)
+		{
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, m_depthWidth, m_depthHeight, 0,
+				GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+	}
+
+	int pyramidWidth = NextPowerOfTwo((viewWidth + 1) / 2);
+	int pyramidHeight = NextPowerOfTwo((viewHeight + 1) / 2);
+	if ((pyramidWidth > m_pyramidWidth) || (pyramidHeight > m_pyramidHeight))
+	{
+		if (m_pyramidTexture != 0)
+		{
+			m_pResourcePool->ReleaseTexture(m_pyramidTexture);
+		}
+		m_pyramidWidth = std::max(pyramidWidth, m_pyramidWidth);
+		m_pyramidHeight = std::max(pyramidHeight, m_pyramidHeight);
+		m_levelCount = 1;
+		while (std::max(m_pyramidWidth, m_pyramidHeight) >> m_levelCount)
+		{
+			m_levelCount++;
+		}
+
+		ResourcePool::TEXTURE_DESC desc;
+		desc.target = GL_TEXTURE_2D;
+		desc.internalFormat = GL_R32F;
+		desc.width = m_pyramidWidth;
+		desc.height = m_pyramidHeight;
+		desc.depth = 1;
+		desc.levelCount = m_levelCount;
+		desc.byteSize = ((GLsizeiptr)m_pyramidWidth * m_pyramidHeight * 4 * 4) / 3;
+
+		bool bReused = false;
+		m_pyramidTexture = m_pResourcePool->AcquireTexture(desc, bReused);
+		if (m_pyramidTexture == 0)
+		{
+			m_pyramidWidth = 0;
+			m_pyramidHeight = 0;
+			m_levelCount = 0;
+			return(false);
+		}
+
+		glBindTexture(GL_TEXTURE_2D, m_pyramidTexture);
+		if (bReused == false)
+		{
+			for (int level = 0; level < m_levelCount; level++)
+			{
+				glTexImage2D(GL_TEXTURE_2D, level, GL_R32F,
+					std::max(m_pyramidWidth >> level, 1), std::max(m_pyramidHeight >> level, 1), 0,
+					GL_RED, GL_FLOAT, NULL);
+			}
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_levelCount - 1);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for copying the depth of the view out
+ *  of the bound framebuffer, whose depth buffer may belong to
+ *  the window and cannot be read by a shader, and for
+ *  reducing it level by level.  The first level reads the
+ *  copy and the others read the level before them.  The
+ *  framebuffer, program and texture bindings of the draws are
+ *  put back afterwards.
+ ***********************************************************/
+void DepthPyramid::Build(const glm::mat4& viewProjection)
+{
+	GLint viewport[4] = { 0, 0, 0, 0 };
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((m_program == 0) || (viewport[2] <= 0) || (viewport[3] <= 0))
+	{
+		m_bValid = false;
+		return;
+	}
+
+	GLint drawFramebuffer = 0;
+	GLint readFramebuffer = 0;
+	GLint drawProgram = 0;
+	GLint boundTexture = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+	glGetIntegerv(GL_CURRENT_PROGRAM, &drawProgram);
+	glActiveTexture(GL_TEXTURE0);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+
+	m_bValid = ReserveTextures(viewport[2], viewport[3]);
+	if (m_bValid == true)
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, drawFramebuffer);
+		glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+		glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, viewport[0], viewport[1], viewport[2], viewport[3]);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+
+		glUseProgram(m_program);
+		int sourceWidth = viewport[2];
+		int sourceHeight = viewport[3];
+		for (int level = 0; level < m_levelCount; level++)
+		{
+			int levelWidth = std::max(m_pyramidWidth >> level, 1);
+			int levelHeight = std::max(m_pyramidHeight >> level, 1);
+
+			glUniform1i(m_fromViewDepthLocation, (level == 0) ? 1 : 0);
+			glUniform2i(m_sourceSizeLocation, sourceWidth, sourceHeight);
+			glBindImageTexture(g_SourceImageUnit, m_pyramidTexture, std::max(level - 1, 0),
+				GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			glBindImageTexture(g_TargetImageUnit, m_pyramidTexture, level,
+				GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			glDispatchCompute((levelWidth + g_WorkGroupSize - 1) / g_WorkGroupSize,
+				(levelHeight + g_WorkGroupSize - 1) / g_WorkGroupSize, 1);
+
+			// the next level reads the texels written above
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+			sourceWidth = levelWidth;
+			sourceHeight = levelHeight;
+		}
+
+		// the culling shader fetches the levels as a texture
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+		m_viewProjection = viewProjection;
+		m_viewWidth = viewport[2];
+		m_viewHeight = viewport[3];
+	}
+
+	glBindTexture(GL_TEXTURE_2D, boundTexture);
+	glUseProgram(drawProgram);
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting the last pyramid, such
+ *  as when the objects that it was built with are replaced.
+ ***********************************************************/
+void DepthPyramid::Invalidate()
+{
+	m_bValid = false;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for giving the textures back to the
+ *  resource pool.
+ ***********************************************************/
+void DepthPyramid::Destroy()
+{
+	if (m_depthTexture != 0)
+	{
+		m_pResourcePool->ReleaseTexture(m_depthTexture);
+		m_depthTexture = 0;
+	}
+	if (m_pyramidTexture != 0)
+	{
+		m_pResourcePool->ReleaseTexture(m_pyramidTexture);
+		m_pyramidTexture = 0;
+	}
+
+	m_depthWidth = 0;
+	m_depthHeight = 0;
+	m_pyramidWidth = 0;
+	m_pyramidHeight = 0;
+	m_levelCount = 0;
+	m_bValid = false;
+}
+
+/***********************************************************
+ *  IsValid()
+ *
+ *  This method is used for checking whether a pyramid has
+ *  been built since the last time it was invalidated.
+ ***********************************************************/
+bool DepthPyramid::IsValid() const
+{
+	return(m_bValid);
+}
+
+/***********************************************************
+ *  GetTexture()
+ *
+ *  This method is used for getting the texture holding the
+ *  levels of the pyramid.
+ ***********************************************************/
+GLuint DepthPyramid::GetTexture() const
+{
+	return(m_pyramidTexture);
+}
+
+/***********************************************************
+ *  GetLevelCount()
+ *
+ *  This method is used for getting the number of levels of
+ *  the pyramid.
+ ***********************************************************/
+int DepthPyramid::GetLevelCount() const
+{
+	return(m_levelCount);
+}
+
+/***********************************************************
+ *  GetViewProjection()
+ *
+ *  This method is used for getting the view projection of
+ *  the frame that the pyramid was built from.
+ ***********************************************************/
+const glm::mat4& DepthPyramid::GetViewProjection() const
+{
+	return(m_viewProjection);
+}
+
+/***********************************************************
+ *  GetViewSize()
+ *
+ *  This method is used for getting the size in pixels of the
+ *  view that the pyramid was built from.
+ ***********************************************************/
+glm::vec2 DepthPyramid::GetViewSize() const
+{
+	return(glm::vec2((float)m_viewWidth, (float)m_viewHeight));
+}
@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthpyramid.h
+// ============
+// reduce the depth buffer of a rendered frame into a pyramid of the farthest
+// depths, which the GPU culling tests the boxes of the objects against
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ResourcePool.h"
+#include "ShaderCache.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  DepthPyramid
+ *
+ *  This class contains the code for copying the depth of the
+ *  rendered view into a texture and for reducing it in a
+ *  compute shader into a chain of levels, where each texel
+ *  holds the farthest depth of the texels below it.  The
+ *  first level holds 2x2 pixels of the view per texel, and
+ *  its size is rounded up to a power of two so that a texel
+ *  of every level covers an exact block of pixels.  An object
+ *  whose box is behind the farthest depth of the texels that
+ *  it covers was hidden in the frame the pyramid was built
+ *  from.
+ ***********************************************************/
+class DepthPyramid
+{
+public:
+	// constructor
+	DepthPyramid(ResourcePool* pResourcePool);
+	// destructor
+	~DepthPyramid();
+
+	// check whether the OpenGL context has the compute shaders
+	// and image stores that the reduction needs
+	static bool IsSupported();
+
+	// get the reduction shader of a file from the shader cache
+	bool LoadShader(ShaderCache* pShaderCache, const char* filename);
+
+	// build the pyramid from the depth buffer of the bound
+	// framebuffer inside of the viewport, which was rendered
+	// with the passed in view projection
+	void Build(const glm::mat4& viewProjection);
+	// forget the last pyramid, so that nothing is culled with
+	// it until the next one is built
+	void Invalidate();
+	// free the textures
+	void Destroy();
+
+	// get whether a pyramid has been built
+	bool IsValid() const;
+	// get the texture holding the levels of the pyramid
+	GLuint GetTexture() const;
+	// get the number of levels of the pyramid
+	int GetLevelCount() const;
+	// get the view projection and the size in pixels of the
+	// view that the pyramid was built from
+	const glm::mat4& GetViewProjection() const;
+	glm::vec2 GetViewSize() const;
+
+private:
+	// gives out the textures
+	ResourcePool* m_pResourcePool;
+	GLuint m_program;
+	// copy of the depth buffer, at least as large as the view
+	GLuint m_depthTexture;
+	int m_depthWidth;
+	int m_depthHeight;
+	// the levels of the farthest depths
+	GLuint m_pyramidTexture;
+	int m_pyramidWidth;
+	int m_pyramidHeight;
+	int m_levelCount;
+	// the view that the pyramid was built from
+	glm::mat4 m_viewProjection;
+	int m_viewWidth;
+	int m_viewHeight;
+	bool m_bValid;
+
+	// uniform locations of the reduction shader
+	GLint m_fromViewDepthLocation;
+	GLint m_sourceSizeLocation;
+
+	// get the textures for a view of the passed in size, which
+	// only grow
+	bool ReserveTextures(int viewWidth, int viewHeight);
+};
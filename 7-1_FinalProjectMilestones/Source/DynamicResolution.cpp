@@ -0,0 +1,217 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.cpp
+// ============
+// choose the internal resolution of the 3D scene from its measured GPU time,
+// so that the frame rate is held while the image is upscaled to the window
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// number of frames whose queries can be in flight
+	const int g_QueryCount = 4;
+	// weight of the newest GPU time in the smoothed time
+	const float g_Smoothing = 0.2f;
+	// the part of the frame budget that the GPU time may take,
+	// which leaves room for the CPU work and the upscale, and the
+	// part below which the scale is raised again - the scale is
+	// aimed at the middle of the band between them
+	const float g_UpperLoad = 0.9f;
+	const float g_LowerLoad = 0.7f;
+	// results read after a change before the scale can change
+	// again, so the smoothed time reflects the new scale
+	const int g_SettleSamples = 8;
+	// the most that the scale changes at once, and the least
+	// worth a change
+	const float g_MaxScaleStep = 0.1f;
+	const float g_MinScaleStep = 0.01f;
+}
+
+/***********************************************************
+ *  DynamicResolution()
+ *
+ *  The constructor for the class, which needs the OpenGL
+ *  context to be current.
+ ***********************************************************/
+DynamicResolution::DynamicResolution()
+{
+	m_queries.resize(g_QueryCount, 0);
+	m_queryIssued.resize(g_QueryCount, false);
+	glGenQueries(g_QueryCount, m_queries.data());
+	m_currentQuery = -1;
+	m_nextQuery = 0;
+	m_targetFps = 0.0f;
+	m_minScale = 1.0f;
+	m_maxScale = 1.0f;
+	m_scale = 1.0f;
+	m_gpuMilliseconds = 0.0f;
+	m_bHasSample = false;
+	m_samplesSinceChange = 0;
+}
+
+/***********************************************************
+ *  ~DynamicResolution()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DynamicResolution::~DynamicResolution()
+{
+	glDeleteQueries((GLsizei)m_queries.size(), m_queries.data());
+	m_queries.clear();
+	m_queryIssued.clear();
+}
+
+/***********************************************************
+ *  SetTarget()
+ *
+ *  This method is used for setting the frame rate to hold
+ *  and the range of the render scale.  Without a frame rate
+ *  the largest scale is always used.
+ ***********************************************************/
+void DynamicResolution::SetTarget(float targetFps, float minScale, float maxScale)
+{
+	m_targetFps = targetFps;
+	m_maxScale = maxScale;
+	m_minScale = std::min(minScale, maxScale);
+	m_scale = m_maxScale;
+	m_samplesSinceChange = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting the timing of the GPU
+ *  work of a frame.  A frame is not timed when its query
+ *  still waits for the result of an earlier frame.
+ ***********************************************************/
+void DynamicResolution::BeginFrame()
+{
+	ReadResults();
+
+	m_currentQuery = -1;
+	if (m_queryIssued[m_nextQuery] == false)
+	{
+		m_currentQuery = m_nextQuery;
+		glBeginQuery(GL_TIME_ELAPSED, m_queries[m_currentQuery]);
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for ending the timing of the GPU work
+ *  of a frame.
+ ***********************************************************/
+void DynamicResolution::EndFrame()
+{
+	if (m_currentQuery >= 0)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		m_queryIssued[m_currentQuery] = true;
+		m_nextQuery = (m_currentQuery + 1) % g_QueryCount;
+		m_currentQuery = -1;
+	}
+}
+
+/***********************************************************
+ *  ReadResults()
+ *
+ *  This method is used for reading the results of the
+ *  queries in the order they were issued, stopping at the
+ *  first one that is not ready.
+ ***********************************************************/
+void DynamicResolution::ReadResults()
+{
+	for (int i = 0; i < g_QueryCount; i++)
+	{
+		int query = (m_nextQuery + i) % g_QueryCount;
+		if (m_queryIssued[query] == false)
+		{
+			continue;
+		}
+
+		GLint available = 0;
+		glGetQueryObjectiv(m_queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == 0)
+		{
+			break;
+		}
+
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(m_queries[query], GL_QUERY_RESULT, &elapsed);
+		m_queryIssued[query] = false;
+		AddSample((float)(elapsed / 1.0e6));
+	}
+}
+
+/***********************************************************
+ *  AddSample()
+ *
+ *  This method is used for adding the GPU time of a frame to
+ *  the smoothed time, and for changing the scale when the
+ *  time is above or well below the frame budget.
+ ***********************************************************/
+void DynamicResolution::AddSample(float gpuMilliseconds)
+{
+	if (m_bHasSample == false)
+	{
+		m_gpuMilliseconds = gpuMilliseconds;
+		m_bHasSample = true;
+	}
+	else
+	{
+		m_gpuMilliseconds += (gpuMilliseconds - m_gpuMilliseconds) * g_Smoothing;
+	}
+	m_samplesSinceChange++;
+
+	if ((m_targetFps <= 0.0f) || (m_samplesSinceChange < g_SettleSamples))
+	{
+		return;
+	}
+
+	float budget = 1000.0f / m_targetFps;
+	if ((m_gpuMilliseconds <= budget * g_UpperLoad) &&
+		(m_gpuMilliseconds >= budget * g_LowerLoad))
+	{
+		return;
+	}
+
+	// the time is proportional to the pixels, the scale squared
+	float aimMilliseconds = budget * (g_UpperLoad + g_LowerLoad) * 0.5f;
+	float scale = m_scale * sqrtf(aimMilliseconds / std::max(m_gpuMilliseconds, 0.01f));
+	scale = std::min(std::max(scale, m_scale - g_MaxScaleStep), m_scale + g_MaxScaleStep);
+	scale = std::min(std::max(scale, m_minScale), m_maxScale);
+
+	if (fabsf(scale - m_scale) >= g_MinScaleStep)
+	{
+		m_scale = scale;
+		m_samplesSinceChange = 0;
+	}
+}
+
+/***********************************************************
+ *  GetScale()
+ *
+ *  This method is used for getting the render scale of the
+ *  next frame.
+ ***********************************************************/
+float DynamicResolution::GetScale() const
+{
+	return(m_scale);
+}
+
+/***********************************************************
+ *  GetGpuMilliseconds()
+ *
+ *  This method is used for getting the smoothed GPU time of
+ *  the scene render.
+ ***********************************************************/
+float DynamicResolution::GetGpuMilliseconds() const
+{
+	return(m_gpuMilliseconds);
+}
@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.h
+// ============
+// choose the internal resolution of the 3D scene from its measured GPU time,
+// so that the frame rate is held while the image is upscaled to the window
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  DynamicResolution
+ *
+ *  This class contains the code for timing the GPU work of
+ *  the scene render with elapsed time queries, which are read
+ *  a few frames later so that the CPU never waits for them,
+ *  and for lowering or raising the render scale until the
+ *  smoothed GPU time sits inside a band below the frame
+ *  budget of the target frame rate.  The GPU time grows with
+ *  the number of pixels, so the scale is changed by the
+ *  square root of the time ratio.
+ ***********************************************************/
+class DynamicResolution
+{
+public:
+	// constructor
+	DynamicResolution();
+	// destructor
+	~DynamicResolution();
+
+	// set the frame rate to hold, 0 for a fixed scale, and the
+	// range of the render scale, which starts at the largest
+	void SetTarget(float targetFps, float minScale, float maxScale);
+
+	// mark the start and the end of the GPU work to time
+	void BeginFrame();
+	void EndFrame();
+
+	// get the render scale of the next frame
+	float GetScale() const;
+	// get the smoothed GPU time of the scene render in
+	// milliseconds, 0 before the first result
+	float GetGpuMilliseconds() const;
+
+private:
+	// elapsed time queries of the last frames, used in turn
+	std::vector<GLuint> m_queries;
+	// true for the queries waiting for their results
+	std::vector<bool> m_queryIssued;
+	// the query of the current frame, -1 when it is not timed
+	int m_currentQuery;
+	int m_nextQuery;
+
+	float m_targetFps;
+	float m_minScale;
+	float m_maxScale;
+	float m_scale;
+	float m_gpuMilliseconds;
+	bool m_bHasSample;
+	// results read since the scale last changed
+	int m_samplesSinceChange;
+
+	// read the results of the queries that are ready
+	void ReadResults();
+	// add a GPU time and change the scale when it is outside of
+	// the band
+	void AddSample(float gpuMilliseconds);
+};
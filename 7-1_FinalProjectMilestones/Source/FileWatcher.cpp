@@ -0,0 +1,165 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.cpp
+// ============
+// watch a list of asset files and report the ones that were saved again, so
+// that they can be reloaded while the application runs
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FileWatcher.h"
+
+#include <sys/stat.h>
+
+// declaration of global variables
+namespace
+{
+	// time between the checks of the watched files, and so the
+	// time that a saved file needs to stay the same before it is
+	// reported
+	const std::chrono::milliseconds g_PollInterval(250);
+}
+
+/***********************************************************
+ *  FileWatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FileWatcher::FileWatcher()
+{
+	m_nextPollTime = std::chrono::steady_clock::now() + g_PollInterval;
+}
+
+/***********************************************************
+ *  ~FileWatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FileWatcher::~FileWatcher()
+{
+	m_files.clear();
+	m_fileIndices.clear();
+}
+
+/***********************************************************
+ *  WatchFile()
+ *
+ *  This method is used for adding a file to the watched
+ *  files.  Its current status is the one that later changes
+ *  are found against, so a file that is missing now is
+ *  reported once it is created.
+ ***********************************************************/
+int FileWatcher::WatchFile(const std::string& filename)
+{
+	std::unordered_map<std::string, int>::const_iterator found = m_fileIndices.find(filename);
+	if (found != m_fileIndices.end())
+	{
+		return(found->second);
+	}
+
+	WATCHED_FILE file;
+	file.filename = filename;
+	file.bChanging = false;
+	ReadFileStatus(filename, file.bExists, file.modifiedTime, file.size);
+
+	int fileIndex = m_files.size();
+	m_files.push_back(file);
+	m_fileIndices[filename] = fileIndex;
+
+	return(fileIndex);
+}
+
+/***********************************************************
+ *  Poll()
+ *
+ *  This method is used for checking the status of the
+ *  watched files when the poll interval has passed since the
+ *  last check.  A file whose status changed is remembered
+ *  as changing, and is reported by the next check that finds
+ *  the same status again.  A file that was deleted is not
+ *  reported until it is back.
+ ***********************************************************/
+bool FileWatcher::Poll(std::vector<int>& changedFiles)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (now < m_nextPollTime)
+	{
+		return(false);
+	}
+	m_nextPollTime = now + g_PollInterval;
+
+	bool bChanged = false;
+	for (size_t i = 0; i < m_files.size(); i++)
+	{
+		WATCHED_FILE& file = m_files[i];
+		bool bExists = false;
+		time_t modifiedTime = 0;
+		long long size = 0;
+		ReadFileStatus(file.filename, bExists, modifiedTime, size);
+
+		if ((bExists != file.bExists) ||
+			(modifiedTime != file.modifiedTime) ||
+			(size != file.size))
+		{
+			file.bExists = bExists;
+			file.modifiedTime = modifiedTime;
+			file.size = size;
+			file.bChanging = true;
+		}
+		else if (file.bChanging == true)
+		{
+			file.bChanging = false;
+			if (file.bExists == true)
+			{
+				changedFiles.push_back(i);
+				bChanged = true;
+			}
+		}
+	}
+
+	return(bChanged);
+}
+
+/***********************************************************
+ *  GetFilename()
+ *
+ *  This method is used for getting the name of a watched
+ *  file by its index.
+ ***********************************************************/
+const std::string& FileWatcher::GetFilename(int fileIndex) const
+{
+	return(m_files[fileIndex].filename);
+}
+
+/***********************************************************
+ *  GetFileCount()
+ *
+ *  This method is used for getting the number of watched
+ *  files.
+ ***********************************************************/
+int FileWatcher::GetFileCount() const
+{
+	return(m_files.size());
+}
+
+/***********************************************************
+ *  ReadFileStatus()
+ *
+ *  This method is used for reading the modification time
+ *  and the size of a file, which are both 0 when the file
+ *  is missing.
+ ***********************************************************/
+void FileWatcher::ReadFileStatus(const std::string& filename,
+	bool& bExists, time_t& modifiedTime, long long& size)
+{
+	struct stat fileStatus;
+	if (stat(filename.c_str(), &fileStatus) != 0)
+	{
+		bExists = false;
+		modifiedTime = 0;
+		size = 0;
+		return;
+	}
+
+	bExists = true;
+	modifiedTime = fileStatus.st_mtime;
+	size = fileStatus.st_size;
+}
@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.h
+// ============
+// watch a list of asset files and report the ones that were saved again, so
+// that they can be reloaded while the application runs
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  FileWatcher
+ *
+ *  This class contains the code for checking the modification
+ *  time and the size of the watched files a few times per
+ *  second.  A file is only reported once it has stopped
+ *  changing between two checks, so a file that is still being
+ *  written by an editor is not read half saved.  The checks
+ *  only read the file status, so watching a few hundred files
+ *  costs nothing noticeable per frame.
+ ***********************************************************/
+class FileWatcher
+{
+public:
+	// constructor
+	FileWatcher();
+	// destructor
+	~FileWatcher();
+
+	// start watching a file, returning its index - a file that
+	// is already watched keeps its index
+	int WatchFile(const std::string& filename);
+	// check the files once the poll interval has passed, adding
+	// the indices of the changed files to the passed in list and
+	// returning true when there are any
+	bool Poll(std::vector<int>& changedFiles);
+
+	// get the name of a watched file
+	const std::string& GetFilename(int fileIndex) const;
+	// get the number of watched files
+	int GetFileCount() const;
+
+private:
+	// one watched file and its status at the last check
+	struct WATCHED_FILE
+	{
+		std::string filename;
+		bool bExists;
+		time_t modifiedTime;
+		long long size;
+		// true when the status changed at the last check, so the
+		// file is reported when the next check finds it the same
+		bool bChanging;
+	};
+
+	// the watched files, indexed by their file indices
+	std::vector<WATCHED_FILE> m_files;
+	// file indices of the watched files by name
+	std::unordered_map<std::string, int> m_fileIndices;
+	// time of the next check
+	std::chrono::steady_clock::time_point m_nextPollTime;
+
+	// read the status of a file into its watched values
+	static void ReadFileStatus(const std::string& filename,
+		bool& bExists, time_t& modifiedTime, long long& size);
+};
@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.cpp
+// ============
+// hand out the short lived CPU memory of a frame from one block, which is
+// reset at the start of every frame instead of freeing each allocation
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameArena.h"
+
+/***********************************************************
+ *  FrameArena()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameArena::FrameArena(size_t blockSize)
+{
+	m_blockSize = blockSize;
+	m_pBlock = new char[m_blockSize];
+	m_used = 0;
+	m_overflowUsed = 0;
+	m_highWater = 0;
+}
+
+/***********************************************************
+ *  ~FrameArena()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameArena::~FrameArena()
+{
+	Reset();
+	delete[] m_pBlock;
+	m_pBlock = NULL;
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for starting the next frame.  When the
+ *  last frame took extra blocks, they are freed and the main
+ *  block is replaced by one that holds everything it used.
+ ***********************************************************/
+void FrameArena::Reset()
+{
+	if (m_overflowBlocks.empty() == false)
+	{
+		for (size_t i = 0; i < m_overflowBlocks.size(); i++)
+		{
+			delete[] m_overflowBlocks[i];
+		}
+		m_overflowBlocks.clear();
+
+		delete[] m_pBlock;
+		m_blockSize = m_highWater;
+		m_pBlock = new char[m_blockSize];
+	}
+
+	m_used = 0;
+	m_overflowUsed = 0;
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for getting room for the passed in
+ *  number of bytes.  The alignment needs to be a power of
+ *  two.  The room is valid until the next Reset().
+ ***********************************************************/
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	size_t offset = (m_used + alignment - 1) & ~(alignment - 1);
+	if (offset + size <= m_blockSize)
+	{
+		m_used = offset + size;
+		if (m_used + m_overflowUsed > m_highWater)
+		{
+			m_highWater = m_used + m_overflowUsed;
+		}
+		return(m_pBlock + offset);
+	}
+
+	// new[] is aligned for any of the plain types, and the room
+	// for the alignment is counted so the grown block fits it
+	char* pOverflow = new char[size];
+	m_overflowBlocks.push_back(pOverflow);
+	m_overflowUsed += size + alignment;
+	if (m_used + m_overflowUsed > m_highWater)
+	{
+		m_highWater = m_used + m_overflowUsed;
+	}
+
+	return(pOverflow);
+}
+
+/***********************************************************
+ *  GetBlockSize()
+ *
+ *  This method is used for getting the size of the block.
+ ***********************************************************/
+size_t FrameArena::GetBlockSize() const
+{
+	return(m_blockSize);
+}
+
+/***********************************************************
+ *  GetHighWater()
+ *
+ *  This method is used for getting the most bytes used by
+ *  any frame.
+ ***********************************************************/
+size_t FrameArena::GetHighWater() const
+{
+	return(m_highWater);
+}
@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.h
+// ============
+// hand out the short lived CPU memory of a frame from one block, which is
+// reset at the start of every frame instead of freeing each allocation
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/***********************************************************
+ *  FrameArena
+ *
+ *  This class contains the code for a linear allocator that
+ *  moves a pointer through one block.  A frame that needs
+ *  more than the block holds takes extra blocks, and the next
+ *  reset grows the block to the most that any frame has used,
+ *  so the memory stays the same once the scene has been seen
+ *  from every side.  Nothing is constructed or destroyed, so
+ *  only plain data belongs in the arena.
+ ***********************************************************/
+class FrameArena
+{
+public:
+	// constructor
+	FrameArena(size_t blockSize);
+	// destructor
+	~FrameArena();
+
+	// forget all of the allocations of the last frame
+	void Reset();
+	// get room for the passed in number of bytes, at an address
+	// that is a multiple of the alignment
+	void* Allocate(size_t size, size_t alignment);
+	// get room for the passed in number of values
+	template <typename T>
+	T* Allocate(size_t count)
+	{
+		return((T*)Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// get the size of the block
+	size_t GetBlockSize() const;
+	// get the most bytes used by any frame
+	size_t GetHighWater() const;
+
+private:
+	char* m_pBlock;
+	size_t m_blockSize;
+	size_t m_used;
+	// blocks taken by the frame after the main block was full
+	std::vector<char*> m_overflowBlocks;
+	size_t m_overflowUsed;
+	size_t m_highWater;
+};
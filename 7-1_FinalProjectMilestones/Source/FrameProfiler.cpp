@@ -0,0 +1,464 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.cpp
+// ============
+// measure the CPU and GPU time of the phases of each rendered frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// number of frames in flight before their GPU times are
+	// read, which keeps the reads from stalling the CPU
+	const int g_FrameLatency = 4;
+	// number of samples kept for each scope
+	const int g_HistorySize = 240;
+	// name of the outermost scope of each frame
+	const char* g_FrameScopeName = "Frame";
+}
+
+/***********************************************************
+ *  FrameProfiler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameProfiler::FrameProfiler()
+{
+	m_frames.resize(g_FrameLatency);
+	for (int i = 0; i < g_FrameLatency; i++)
+	{
+		m_frames[i].queriesUsed = 0;
+		m_frames[i].bPending = false;
+		m_frames[i].bTraced = false;
+	}
+	m_currentFrame = 0;
+	m_traceFramesToRecord = 0;
+	m_traceFramesPending = 0;
+
+	// the GPU clock is matched to the CPU clock once, so that
+	// both timelines line up in the trace file
+	m_startTime = std::chrono::steady_clock::now();
+	m_gpuStartTime = 0;
+	glGetInteger64v(GL_TIMESTAMP, &m_gpuStartTime);
+}
+
+/***********************************************************
+ *  ~FrameProfiler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameProfiler::~FrameProfiler()
+{
+	for (size_t i = 0; i < m_frames.size(); i++)
+	{
+		if (m_frames[i].queries.empty() == false)
+		{
+			glDeleteQueries(m_frames[i].queries.size(), m_frames[i].queries.data());
+		}
+	}
+	m_frames.clear();
+}
+
+/***********************************************************
+ *  GetCpuTime()
+ *
+ *  This method is used for getting the CPU time in
+ *  microseconds since the profiler was created.
+ ***********************************************************/
+double FrameProfiler::GetCpuTime() const
+{
+	std::chrono::duration<double, std::micro> elapsed =
+		std::chrono::steady_clock::now() - m_startTime;
+	return(elapsed.count());
+}
+
+/***********************************************************
+ *  RecordTimestamp()
+ *
+ *  This method is used for recording the GPU timestamp at
+ *  this point of the command stream into the next query of
+ *  the passed in frame.
+ ***********************************************************/
+int FrameProfiler::RecordTimestamp(FRAME_RECORD& frame)
+{
+	if (frame.queriesUsed == (int)frame.queries.size())
+	{
+		GLuint query = 0;
+		glGenQueries(1, &query);
+		frame.queries.push_back(query);
+	}
+
+	glQueryCounter(frame.queries[frame.queriesUsed], GL_TIMESTAMP);
+	frame.queriesUsed++;
+
+	return(frame.queriesUsed - 1);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting the recording of a new
+ *  frame.  The frame that used the same record g_FrameLatency
+ *  frames ago is resolved first.
+ ***********************************************************/
+void FrameProfiler::BeginFrame()
+{
+	m_currentFrame = (m_currentFrame + 1) % g_FrameLatency;
+	FRAME_RECORD& frame = m_frames[m_currentFrame];
+
+	if (frame.bPending == true)
+	{
+		ResolveFrame(frame);
+	}
+
+	frame.scopes.clear();
+	frame.queriesUsed = 0;
+	frame.bPending = false;
+	frame.bTraced = (m_traceFramesToRecord > 0);
+	if (frame.bTraced == true)
+	{
+		m_traceFramesToRecord--;
+		m_traceFramesPending++;
+	}
+	m_openScopes.clear();
+
+	BeginScope(g_FrameScopeName);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for finishing the recording of the
+ *  current frame.  Scopes that were left open are closed.
+ ***********************************************************/
+void FrameProfiler::EndFrame()
+{
+	while (m_openScopes.empty() == false)
+	{
+		EndScope();
+	}
+
+	m_frames[m_currentFrame].bPending = true;
+}
+
+/***********************************************************
+ *  BeginScope()
+ *
+ *  This method is used for starting a named scope in the
+ *  current frame.
+ ***********************************************************/
+void FrameProfiler::BeginScope(const char* name)
+{
+	FRAME_RECORD& frame = m_frames[m_currentFrame];
+	SCOPE_RECORD scope;
+
+	scope.name = name;
+	scope.depth = m_openScopes.size();
+	scope.queryStart = RecordTimestamp(frame);
+	scope.queryEnd = -1;
+	scope.cpuEnd = 0.0;
+	scope.cpuStart = GetCpuTime();
+
+	m_openScopes.push_back(frame.scopes.size());
+	frame.scopes.push_back(scope);
+}
+
+/***********************************************************
+ *  EndScope()
+ *
+ *  This method is used for ending the innermost open scope.
+ ***********************************************************/
+void FrameProfiler::EndScope()
+{
+	if (m_openScopes.empty() == true)
+	{
+		return;
+	}
+
+	FRAME_RECORD& frame = m_frames[m_currentFrame];
+	SCOPE_RECORD& scope = frame.scopes[m_openScopes.back()];
+	m_openScopes.pop_back();
+
+	scope.cpuEnd = GetCpuTime();
+	scope.queryEnd = RecordTimestamp(frame);
+}
+
+/***********************************************************
+ *  ResolveFrame()
+ *
+ *  This method is used for reading the GPU times of a frame
+ *  recorded g_FrameLatency frames ago and adding the samples
+ *  of its scopes to the history.  The results are normally
+ *  available by now, otherwise this waits for them.
+ ***********************************************************/
+void FrameProfiler::ResolveFrame(FRAME_RECORD& frame)
+{
+	std::vector<GLuint64> timestamps(frame.queriesUsed);
+	for (int i = 0; i < frame.queriesUsed; i++)
+	{
+		glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+	}
+
+	for (size_t i = 0; i < frame.scopes.size(); i++)
+	{
+		const SCOPE_RECORD& scope = frame.scopes[i];
+
+		// timestamps are in nanoseconds
+		double gpuStart = (double)((GLint64)timestamps[scope.queryStart] - m_gpuStartTime) / 1000.0;
+		double gpuEnd = (double)((GLint64)timestamps[scope.queryEnd] - m_gpuStartTime) / 1000.0;
+		double cpuDuration = scope.cpuEnd - scope.cpuStart;
+		double gpuDuration = gpuEnd - gpuStart;
+
+		AddSample(scope.name, (float)(cpuDuration / 1000.0), (float)(gpuDuration / 1000.0));
+
+		if (frame.bTraced == true)
+		{
+			TRACE_EVENT cpuEvent;
+			cpuEvent.name = scope.name;
+			cpuEvent.threadID = 1;
+			cpuEvent.start = scope.cpuStart;
+			cpuEvent.duration = cpuDuration;
+			m_traceEvents.push_back(cpuEvent);
+
+			TRACE_EVENT gpuEvent;
+			gpuEvent.name = scope.name;
+			gpuEvent.threadID = 2;
+			gpuEvent.start = gpuStart;
+			gpuEvent.duration = gpuDuration;
+			m_traceEvents.push_back(gpuEvent);
+		}
+	}
+
+	if (frame.bTraced == true)
+	{
+		frame.bTraced = false;
+		m_traceFramesPending--;
+		if ((m_traceFramesPending == 0) && (m_traceFramesToRecord == 0))
+		{
+			WriteTrace();
+		}
+	}
+
+	frame.bPending = false;
+}
+
+/***********************************************************
+ *  AddSample()
+ *
+ *  This method is used for adding the CPU and GPU times of
+ *  a scope in milliseconds to its history.
+ ***********************************************************/
+void FrameProfiler::AddSample(const char* name, float cpuTime, float gpuTime)
+{
+	int historyIndex = 0;
+	std::unordered_map<std::string, int>::const_iterator found = m_historyIndices.find(name);
+
+	if (found == m_historyIndices.end())
+	{
+		SCOPE_HISTORY history;
+		history.name = name;
+		history.cpuSamples.resize(g_HistorySize);
+		history.gpuSamples.resize(g_HistorySize);
+		history.nextSample = 0;
+		history.sampleCount = 0;
+
+		historyIndex = m_history.size();
+		m_history.push_back(history);
+		m_historyIndices[history.name] = historyIndex;
+	}
+	else
+	{
+		historyIndex = found->second;
+	}
+
+	SCOPE_HISTORY& history = m_history[historyIndex];
+	history.cpuSamples[history.nextSample] = cpuTime;
+	history.gpuSamples[history.nextSample] = gpuTime;
+	history.nextSample = (history.nextSample + 1) % g_HistorySize;
+	history.sampleCount = std::min(history.sampleCount + 1, g_HistorySize);
+}
+
+/***********************************************************
+ *  GetPercentile()
+ *
+ *  This method is used for getting the passed in percentile
+ *  (0 to 100) of the samples.
+ ***********************************************************/
+float FrameProfiler::GetPercentile(std::vector<float> samples, float percentile)
+{
+	if (samples.empty() == true)
+	{
+		return(0.0f);
+	}
+
+	size_t rank = (size_t)((percentile / 100.0f) * (samples.size() - 1) + 0.5f);
+	std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+
+	return(samples[rank]);
+}
+
+/***********************************************************
+ *  GetScopeStats()
+ *
+ *  This method is used for getting the average and the
+ *  50th, 95th and 99th percentiles of the kept samples of the
+ *  scope with the passed in name.
+ ***********************************************************/
+bool FrameProfiler::GetScopeStats(const std::string& name, SCOPE_STATS& stats) const
+{
+	std::unordered_map<std::string, int>::const_iterator found = m_historyIndices.find(name);
+	if (found == m_historyIndices.end())
+	{
+		return(false);
+	}
+
+	const SCOPE_HISTORY& history = m_history[found->second];
+	std::vector<float> cpuSamples(history.cpuSamples.begin(), history.cpuSamples.begin() + history.sampleCount);
+	std::vector<float> gpuSamples(history.gpuSamples.begin(), history.gpuSamples.begin() + history.sampleCount);
+
+	float cpuTotal = 0.0f;
+	float gpuTotal = 0.0f;
+	for (int i = 0; i < history.sampleCount; i++)
+	{
+		cpuTotal += cpuSamples[i];
+		gpuTotal += gpuSamples[i];
+	}
+
+	stats.name = history.name;
+	stats.sampleCount = history.sampleCount;
+	stats.cpuAverage = (history.sampleCount > 0) ? (cpuTotal / history.sampleCount) : 0.0f;
+	stats.cpuP50 = GetPercentile(cpuSamples, 50.0f);
+	stats.cpuP95 = GetPercentile(cpuSamples, 95.0f);
+	stats.cpuP99 = GetPercentile(cpuSamples, 99.0f);
+	stats.gpuAverage = (history.sampleCount > 0) ? (gpuTotal / history.sampleCount) : 0.0f;
+	stats.gpuP50 = GetPercentile(gpuSamples, 50.0f);
+	stats.gpuP95 = GetPercentile(gpuSamples, 95.0f);
+	stats.gpuP99 = GetPercentile(gpuSamples, 99.0f);
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReportStats()
+ *
+ *  This method is used for outputting the rolling statistics
+ *  of all of the scopes in milliseconds.
+ ***********************************************************/
+void FrameProfiler::ReportStats() const
+{
+	std::cout << "\n--- FRAME PROFILE (ms, last " << g_HistorySize << " frames) ---\n";
+	std::cout << std::left << std::setw(28) << "scope"
+		<< std::right << std::setw(9) << "cpu avg" << std::setw(9) << "p50" << std::setw(9) << "p95" << std::setw(9) << "p99"
+		<< std::setw(9) << "gpu avg" << std::setw(9) << "p50" << std::setw(9) << "p95" << std::setw(9) << "p99" << "\n";
+
+	for (size_t i = 0; i < m_history.size(); i++)
+	{
+		SCOPE_STATS stats;
+		GetScopeStats(m_history[i].name, stats);
+
+		std::cout << std::left << std::setw(28) << stats.name << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(9) << stats.cpuAverage << std::setw(9) << stats.cpuP50
+			<< std::setw(9) << stats.cpuP95 << std::setw(9) << stats.cpuP99
+			<< std::setw(9) << stats.gpuAverage << std::setw(9) << stats.gpuP50
+			<< std::setw(9) << stats.gpuP95 << std::setw(9) << stats.gpuP99 << "\n";
+	}
+	std::cout << std::defaultfloat << std::endl;
+}
+
+/***********************************************************
+ *  RequestTrace()
+ *
+ *  This method is used for recording the passed in number of
+ *  the next frames for a Chrome trace file, which is written
+ *  once the GPU times of all of them have been read.
+ ***********************************************************/
+void FrameProfiler::RequestTrace(const std::string& filename, int frameCount)
+{
+	if ((m_traceFramesToRecord > 0) || (m_traceFramesPending > 0))
+	{
+		std::cout << "A frame trace is already being recorded" << std::endl;
+		return;
+	}
+
+	m_traceFilename = filename;
+	m_traceFramesToRecord = frameCount;
+	m_traceEvents.clear();
+	std::cout << "Recording a trace of " << frameCount << " frames" << std::endl;
+}
+
+/***********************************************************
+ *  IsTracing()
+ *
+ *  This method is used for checking whether a requested
+ *  trace is still recording frames or waiting for their GPU
+ *  times, since the trace is only written after more frames.
+ ***********************************************************/
+bool FrameProfiler::IsTracing() const
+{
+	return((m_traceFramesToRecord > 0) || (m_traceFramesPending > 0));
+}
+
+/***********************************************************
+ *  WriteTrace()
+ *
+ *  This method is used for writing the recorded trace events
+ *  as complete ("X") events of the Chrome trace event format,
+ *  with the CPU and the GPU scopes on separate timelines.
+ ***********************************************************/
+void FrameProfiler::WriteTrace()
+{
+	std::ofstream file(m_traceFilename, std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "Could not write the trace file:" << m_traceFilename << std::endl;
+		return;
+	}
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+	for (size_t i = 0; i < m_traceEvents.size(); i++)
+	{
+		const TRACE_EVENT& traceEvent = m_traceEvents[i];
+		file << ",\n{\"name\":\"" << traceEvent.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << traceEvent.threadID
+			<< ",\"ts\":" << traceEvent.start << ",\"dur\":" << traceEvent.duration << "}";
+	}
+	file << "\n]}\n";
+
+	std::cout << "Wrote the frame trace:" << m_traceFilename << std::endl;
+	m_traceEvents.clear();
+}
+
+/***********************************************************
+ *  ProfileScope()
+ *
+ *  The constructor for the class, which begins the scope
+ ***********************************************************/
+ProfileScope::ProfileScope(FrameProfiler* pProfiler, const char* name)
+{
+	m_pProfiler = pProfiler;
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->BeginScope(name);
+	}
+}
+
+/***********************************************************
+ *  ~ProfileScope()
+ *
+ *  The destructor for the class, which ends the scope
+ ***********************************************************/
+ProfileScope::~ProfileScope()
+{
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->EndScope();
+	}
+}
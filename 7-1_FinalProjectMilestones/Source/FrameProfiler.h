@@ -0,0 +1,167 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.h
+// ============
+// measure the CPU and GPU time of the phases of each rendered frame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  FrameProfiler
+ *
+ *  This class contains the code for timing named scopes of
+ *  each frame on the CPU, and on the GPU with timestamp
+ *  queries.  The GPU results are read a few frames later so
+ *  that the CPU never waits for them.  The last samples of
+ *  each scope are kept for averages and percentiles, and the
+ *  scopes of a number of frames can be written as a Chrome
+ *  trace file (chrome://tracing or ui.perfetto.dev).
+ ***********************************************************/
+class FrameProfiler
+{
+public:
+	// constructor
+	FrameProfiler();
+	// destructor
+	~FrameProfiler();
+
+	// the rolling statistics of one scope in milliseconds
+	struct SCOPE_STATS
+	{
+		std::string name;
+		int sampleCount;
+		float cpuAverage;
+		float cpuP50;
+		float cpuP95;
+		float cpuP99;
+		float gpuAverage;
+		float gpuP50;
+		float gpuP95;
+		float gpuP99;
+	};
+
+	// mark the start and the end of a frame, which is also
+	// recorded as the outermost scope named "Frame"
+	void BeginFrame();
+	void EndFrame();
+
+	// mark the start and the end of a named scope - scopes can
+	// be nested, and the names need to stay valid until the
+	// frame is finished (string literals)
+	void BeginScope(const char* name);
+	void EndScope();
+
+	// get the rolling statistics of a scope by name
+	bool GetScopeStats(const std::string& name, SCOPE_STATS& stats) const;
+	// output the rolling statistics of all scopes
+	void ReportStats() const;
+
+	// record the scopes of the next frames and write them to a
+	// Chrome trace file once their GPU times are known
+	void RequestTrace(const std::string& filename, int frameCount);
+	// check whether a requested trace still needs frames
+	bool IsTracing() const;
+
+private:
+	// one recorded scope of a frame
+	struct SCOPE_RECORD
+	{
+		const char* name;
+		int depth;
+		// CPU times in microseconds since the profiler started
+		double cpuStart;
+		double cpuEnd;
+		// indices of the start and end timestamp queries
+		int queryStart;
+		int queryEnd;
+	};
+
+	// the recorded scopes of one frame in flight
+	struct FRAME_RECORD
+	{
+		std::vector<SCOPE_RECORD> scopes;
+		// pool of timestamp queries, grown as needed
+		std::vector<GLuint> queries;
+		int queriesUsed;
+		// true when the frame waits for its GPU times
+		bool bPending;
+		// true when the frame is written to the trace file
+		bool bTraced;
+	};
+
+	// the kept samples of one scope
+	struct SCOPE_HISTORY
+	{
+		std::string name;
+		std::vector<float> cpuSamples;
+		std::vector<float> gpuSamples;
+		int nextSample;
+		int sampleCount;
+	};
+
+	// one event of the trace file
+	struct TRACE_EVENT
+	{
+		const char* name;
+		// 1 for the CPU timeline and 2 for the GPU timeline
+		int threadID;
+		double start;
+		double duration;
+	};
+
+	std::vector<FRAME_RECORD> m_frames;
+	int m_currentFrame;
+	// indices of the open scopes in the current frame
+	std::vector<int> m_openScopes;
+
+	std::vector<SCOPE_HISTORY> m_history;
+	std::unordered_map<std::string, int> m_historyIndices;
+
+	std::chrono::steady_clock::time_point m_startTime;
+	// GPU timestamp in nanoseconds at the CPU start time
+	GLint64 m_gpuStartTime;
+
+	std::string m_traceFilename;
+	// frames still to be recorded for the trace
+	int m_traceFramesToRecord;
+	// recorded frames with GPU times not yet read
+	int m_traceFramesPending;
+	std::vector<TRACE_EVENT> m_traceEvents;
+
+	// get the CPU time in microseconds since the start
+	double GetCpuTime() const;
+	// record a GPU timestamp into the next query of the frame
+	int RecordTimestamp(FRAME_RECORD& frame);
+	// read the GPU times of a finished frame into the history
+	void ResolveFrame(FRAME_RECORD& frame);
+	// add a sample to the history of a scope
+	void AddSample(const char* name, float cpuTime, float gpuTime);
+	// write the recorded trace events to the trace file
+	void WriteTrace();
+	// get a percentile of the passed in samples
+	static float GetPercentile(std::vector<float> samples, float percentile);
+};
+
+/***********************************************************
+ *  ProfileScope
+ *
+ *  This class times the code from its construction to the
+ *  end of the block it is declared in.  A NULL profiler is
+ *  allowed, which makes the scope do nothing.
+ ***********************************************************/
+class ProfileScope
+{
+public:
+	ProfileScope(FrameProfiler* pProfiler, const char* name);
+	~ProfileScope();
+
+private:
+	FrameProfiler* m_pProfiler;
+};
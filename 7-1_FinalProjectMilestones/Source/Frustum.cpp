@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.cpp
+// ============
+// test bounding volumes against the viewing volume of the camera
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Frustum.h"
+
+#include <cmath>
+
+/***********************************************************
+ *  Frustum()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Frustum::Frustum()
+{
+	// until the planes are extracted every box is visible
+	for (int i = 0; i < 6; i++)
+	{
+		m_planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+/***********************************************************
+ *  Extract()
+ *
+ *  This method is used for calculating the frustum planes
+ *  from the rows of the view projection matrix (the Gribb
+ *  and Hartmann method).  GLM matrices are column major, so
+ *  row r is (m[0][r], m[1][r], m[2][r], m[3][r]).
+ ***********************************************************/
+void Frustum::Extract(const glm::mat4& viewProjection)
+{
+	glm::vec4 rows[4];
+	for (int r = 0; r < 4; r++)
+	{
+		rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+	}
+
+	m_planes[0] = rows[3] + rows[0];
+	m_planes[1] = rows[3] - rows[0];
+	m_planes[2] = rows[3] + rows[1];
+	m_planes[3] = rows[3] - rows[1];
+	m_planes[4] = rows[3] + rows[2];
+	m_planes[5] = rows[3] - rows[2];
+
+	for (int i = 0; i < 6; i++)
+	{
+		float length = glm::length(glm::vec3(m_planes[i]));
+		if (length > 0.0f)
+		{
+			m_planes[i] /= length;
+		}
+	}
+}
+
+/***********************************************************
+ *  IsBoxVisible()
+ *
+ *  This method is used for checking whether a box may be
+ *  visible.  For each plane only the corner furthest along
+ *  the plane normal is tested - when that corner is behind
+ *  the plane, the whole box is outside.
+ ***********************************************************/
+bool Frustum::IsBoxVisible(const glm::vec3& minXYZ, const glm::vec3& maxXYZ) const
+{
+	for (int i = 0; i < 6; i++)
+	{
+		const glm::vec4& plane = m_planes[i];
+		glm::vec3 corner = glm::vec3(
+			(plane.x >= 0.0f) ? maxXYZ.x : minXYZ.x,
+			(plane.y >= 0.0f) ? maxXYZ.y : minXYZ.y,
+			(plane.z >= 0.0f) ? maxXYZ.z : minXYZ.z);
+
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetPlane()
+ *
+ *  This method is used for getting one of the six planes in
+ *  the order left, right, bottom, top, near and far.
+ ***********************************************************/
+const glm::vec4& Frustum::GetPlane(int planeIndex) const
+{
+	return(m_planes[planeIndex]);
+}
+
+/***********************************************************
+ *  ClassifyBox()
+ *
+ *  This method is used for checking where a box is relative
+ *  to the frustum.  The box is fully inside when, for every
+ *  plane, even the corner least along the plane normal is in
+ *  front of the plane.
+ ***********************************************************/
+Frustum::BOX_CLASS Frustum::ClassifyBox(const glm::vec3& minXYZ, const glm::vec3& maxXYZ) const
+{
+	BOX_CLASS boxClass = BOX_INSIDE;
+
+	for (int i = 0; i < 6; i++)
+	{
+		const glm::vec4& plane = m_planes[i];
+		glm::vec3 furthest = glm::vec3(
+			(plane.x >= 0.0f) ? maxXYZ.x : minXYZ.x,
+			(plane.y >= 0.0f) ? maxXYZ.y : minXYZ.y,
+			(plane.z >= 0.0f) ? maxXYZ.z : minXYZ.z);
+		glm::vec3 nearest = glm::vec3(
+			(plane.x >= 0.0f) ? minXYZ.x : maxXYZ.x,
+			(plane.y >= 0.0f) ? minXYZ.y : maxXYZ.y,
+			(plane.z >= 0.0f) ? minXYZ.z : maxXYZ.z);
+
+		if (glm::dot(glm::vec3(plane), furthest) + plane.w < 0.0f)
+		{
+			return(BOX_OUTSIDE);
+		}
+		if (glm::dot(glm::vec3(plane), nearest) + plane.w < 0.0f)
+		{
+			boxClass = BOX_INTERSECTS;
+		}
+	}
+
+	return(boxClass);
+}
+
+/***********************************************************
+ *  TransformBox()
+ *
+ *  This method is used for calculating the axis aligned box
+ *  around a transformed box, adding up the smallest and the
+ *  largest contribution of each matrix element (Arvo's
+ *  method) instead of transforming all eight corners.
+ ***********************************************************/
+void Frustum::TransformBox(
+	const glm::mat4& transform,
+	const glm::vec3& minXYZ,
+	const glm::vec3& maxXYZ,
+	glm::vec3& outMinXYZ,
+	glm::vec3& outMaxXYZ)
+{
+	glm::vec3 translation = glm::vec3(transform[3]);
+	outMinXYZ = translation;
+	outMaxXYZ = translation;
+
+	for (int column = 0; column < 3; column++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			float a = transform[column][row] * minXYZ[column];
+			float b = transform[column][row] * maxXYZ[column];
+			outMinXYZ[row] += fminf(a, b);
+			outMaxXYZ[row] += fmaxf(a, b);
+		}
+	}
+}
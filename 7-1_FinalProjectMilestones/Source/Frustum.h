@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// frustum.h
+// ============
+// test bounding volumes against the viewing volume of the camera
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  Frustum
+ *
+ *  This class contains the code for extracting the six
+ *  planes of the viewing volume from a view projection
+ *  matrix and testing boxes against them.
+ ***********************************************************/
+class Frustum
+{
+public:
+	// constructor
+	Frustum();
+
+	// where a box is relative to the frustum
+	enum BOX_CLASS
+	{
+		BOX_OUTSIDE = 0,
+		BOX_INTERSECTS,
+		BOX_INSIDE
+	};
+
+	// calculate the planes from the projection * view matrix
+	void Extract(const glm::mat4& viewProjection);
+	// check whether a world space box is at least partly inside
+	bool IsBoxVisible(const glm::vec3& minXYZ, const glm::vec3& maxXYZ) const;
+	// check whether a world space box is outside, crossing or
+	// fully inside of the frustum
+	BOX_CLASS ClassifyBox(const glm::vec3& minXYZ, const glm::vec3& maxXYZ) const;
+	// get one of the six planes, for the culling on the GPU
+	const glm::vec4& GetPlane(int planeIndex) const;
+
+	// transform a box into a box around the transformed box
+	static void TransformBox(
+		const glm::mat4& transform,
+		const glm::vec3& minXYZ,
+		const glm::vec3& maxXYZ,
+		glm::vec3& outMinXYZ,
+		glm::vec3& outMaxXYZ);
+
+private:
+	// the left, right, bottom, top, near and far planes with
+	// the normals pointing inward - xyz is the normal and w is
+	// the distance
+	glm::vec4 m_planes[6];
+};
@@ -0,0 +1,417 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuculler.cpp
+// ============
+// cull the objects of the static batches in a compute shader, which writes
+// the draw commands of the visible objects for indirect draws
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuCuller.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	// these need to match MAX_LODS, LOD_SCREEN_SIZE_COUNT and the
+	// local size in the culling shader
+	const int g_MaxLods = 4;
+	const int g_MaxLodScreenSizes = 3;
+	const int g_WorkGroupSize = 64;
+
+	// binding points of the shader storage buffers
+	const GLuint g_ObjectBinding = 0;
+	const GLuint g_GroupBinding = 1;
+	const GLuint g_CountBinding = 2;
+	const GLuint g_CommandBinding = 3;
+}
+
+/***********************************************************
+ *  GpuCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GpuCuller::GpuCuller(ResourcePool* pResourcePool)
+{
+	m_lodHysteresis = 0.0f;
+	m_objectCount = 0;
+	m_program = 0;
+	m_pResourcePool = pResourcePool;
+	m_objectBuffer = 0;
+	m_groupBuffer = 0;
+	m_countBuffer = 0;
+	m_commandBuffer = 0;
+	m_vao = 0;
+	m_bIndirectCount = (GLEW_ARB_indirect_parameters == GL_TRUE);
+	m_objectCountLocation = -1;
+	m_frustumCullingLocation = -1;
+	m_frustumPlanesLocation = -1;
+	m_viewPositionLocation = -1;
+	m_lodScaleLocation = -1;
+	m_lodScreenSizesLocation = -1;
+	m_lodHysteresisLocation = -1;
+	m_occlusionCullingLocation = -1;
+	m_pyramidViewProjectionLocation = -1;
+	m_pyramidViewSizeLocation = -1;
+	m_pyramidLevelCountLocation = -1;
+}
+
+/***********************************************************
+ *  ~GpuCuller()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GpuCuller::~GpuCuller()
+{
+	DestroyBuffers();
+	// the program belongs to the shader cache
+	m_program = 0;
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the OpenGL
+ *  context has the compute shaders, shader storage buffers,
+ *  buffer clears and indirect draws that the culling needs.
+ ***********************************************************/
+bool GpuCuller::IsSupported()
+{
+	return((GLEW_VERSION_4_3 == GL_TRUE) ||
+		((GLEW_ARB_compute_shader == GL_TRUE) &&
+		 (GLEW_ARB_shader_storage_buffer_object == GL_TRUE) &&
+		 (GLEW_ARB_clear_buffer_object == GL_TRUE) &&
+		 (GLEW_ARB_multi_draw_indirect == GL_TRUE)));
+}
+
+/***********************************************************
+ *  LoadShader()
+ *
+ *  This method is used for getting the culling compute
+ *  shader from the shader cache, and for finding its
+ *  uniforms.
+ ***********************************************************/
+bool GpuCuller::LoadShader(ShaderCache* pShaderCache, const char* filename)
+{
+	GLuint program = pShaderCache->GetComputeProgram(filename, "");
+	if (program == 0)
+	{
+		std::cout << "Could not build the culling shader " << filename << std::endl;
+		return(false);
+	}
+
+	m_program = program;
+	m_objectCountLocation = glGetUniformLocation(m_program, "objectCount");
+	m_frustumCullingLocation = glGetUniformLocation(m_program, "bFrustumCulling");
+	m_frustumPlanesLocation = glGetUniformLocation(m_program, "frustumPlanes");
+	m_viewPositionLocation = glGetUniformLocation(m_program, "viewPosition");
+	m_lodScaleLocation = glGetUniformLocation(m_program, "lodScale");
+	m_lodScreenSizesLocation = glGetUniformLocation(m_program, "lodScreenSizes");
+	m_lodHysteresisLocation = glGetUniformLocation(m_program, "lodHysteresis");
+	m_occlusionCullingLocation = glGetUniformLocation(m_program, "bOcclusionCulling");
+	m_pyramidViewProjectionLocation = glGetUniformLocation(m_program, "pyramidViewProjection");
+	m_pyramidViewSizeLocation = glGetUniformLocation(m_program, "pyramidViewSize");
+	m_pyramidLevelCountLocation = glGetUniformLocation(m_program, "pyramidLevelCount");
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetLodSettings()
+ *
+ *  This method is used for setting the screen sizes below
+ *  which the next coarser level of detail is used, and the
+ *  margin around them, the same as on the CPU.
+ ***********************************************************/
+void GpuCuller::SetLodSettings(const float* screenSizes, int screenSizeCount, float hysteresis)
+{
+	screenSizeCount = std::min(screenSizeCount, g_MaxLodScreenSizes);
+	m_lodScreenSizes.assign(screenSizes, screenSizes + screenSizeCount);
+	m_lodScreenSizes.resize(g_MaxLodScreenSizes, 0.0f);
+	m_lodHysteresis = hysteresis;
+}
+
+/***********************************************************
+ *  DestroyBuffers()
+ *
+ *  This method is used for giving the OpenGL buffers back to
+ *  the pool.
+ ***********************************************************/
+void GpuCuller::DestroyBuffers()
+{
+	if (m_objectBuffer != 0)
+	{
+		m_pResourcePool->ReleaseBuffer(m_objectBuffer);
+		m_pResourcePool->ReleaseBuffer(m_groupBuffer);
+		m_pResourcePool->ReleaseBuffer(m_countBuffer);
+		m_pResourcePool->ReleaseBuffer(m_commandBuffer);
+	}
+
+	m_objectBuffer = 0;
+	m_groupBuffer = 0;
+	m_countBuffer = 0;
+	m_commandBuffer = 0;
+	m_objectCount = 0;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the objects and
+ *  their buffers.
+ ***********************************************************/
+void GpuCuller::Clear()
+{
+	DestroyBuffers();
+	m_objects.clear();
+	m_groupSizes.clear();
+	m_groupFirstCommands.clear();
+	m_vao = 0;
+}
+
+/***********************************************************
+ *  AddObject()
+ *
+ *  This method is used for adding a baked object with its
+ *  world space box and the index ranges of its levels of
+ *  detail in the static batch.
+ ***********************************************************/
+void GpuCuller::AddObject(
+	const StaticBatch& staticBatch,
+	int staticObject,
+	const glm::vec3& boundsMin,
+	const glm::vec3& boundsMax,
+	int drawGroup)
+{
+	OBJECT_DATA object;
+	int lodCount = std::min(staticBatch.GetObjectLodCount(staticObject), g_MaxLods);
+
+	object.boundsMin = glm::vec4(boundsMin, 1.0f);
+	object.boundsMax = glm::vec4(boundsMax, 1.0f);
+	for (int lod = 0; lod < g_MaxLods; lod++)
+	{
+		object.firstIndex[lod] = 0;
+		object.indexCount[lod] = 0;
+		if (lod < lodCount)
+		{
+			staticBatch.GetObjectRange(staticObject, lod, object.firstIndex[lod], object.indexCount[lod]);
+		}
+	}
+	object.drawGroup = drawGroup;
+	object.lodCount = lodCount;
+	object.lodLevel = 0;
+	object.enabled = 1;
+	m_objects.push_back(object);
+
+	if (drawGroup >= m_groupSizes.size())
+	{
+		m_groupSizes.resize(drawGroup + 1, 0);
+	}
+	m_groupSizes[drawGroup]++;
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for uploading the objects into the
+ *  shader storage buffers.  Each draw group gets the room for
+ *  a command per object in the group, and the culling shader
+ *  appends the visible ones.
+ ***********************************************************/
+void GpuCuller::Upload(const StaticBatch& staticBatch, int drawGroupCount)
+{
+	DestroyBuffers();
+	m_vao = staticBatch.GetVertexArray();
+	if ((m_objects.empty() == true) || (m_vao == 0))
+	{
+		return;
+	}
+
+	m_groupSizes.resize(drawGroupCount, 0);
+	m_groupFirstCommands.resize(drawGroupCount);
+	GLuint commandCount = 0;
+	for (int group = 0; group < drawGroupCount; group++)
+	{
+		m_groupFirstCommands[group] = commandCount;
+		commandCount += m_groupSizes[group];
+	}
+	m_objectCount = m_objects.size();
+
+	// the pooled buffers can be larger than asked for, which the
+	// shader never reads past since it is given the counts
+	m_objectBuffer = m_pResourcePool->AcquireBuffer(sizeof(OBJECT_DATA) * m_objects.size(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(OBJECT_DATA) * m_objects.size(), m_objects.data());
+
+	m_groupBuffer = m_pResourcePool->AcquireBuffer(sizeof(GLuint) * drawGroupCount, GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_groupBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint) * drawGroupCount, m_groupFirstCommands.data());
+
+	m_countBuffer = m_pResourcePool->AcquireBuffer(sizeof(GLuint) * drawGroupCount, GL_DYNAMIC_DRAW);
+	m_commandBuffer = m_pResourcePool->AcquireBuffer(sizeof(StaticBatch::DRAW_COMMAND) * commandCount, GL_DYNAMIC_DRAW);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// the objects stay in the OpenGL buffers only
+	std::vector<OBJECT_DATA>().swap(m_objects);
+}
+
+/***********************************************************
+ *  DisableObject()
+ *
+ *  This method is used for stopping the culling shader from
+ *  drawing an object, which is drawn on the CPU once it has
+ *  moved away from its baked vertices.
+ ***********************************************************/
+void GpuCuller::DisableObject(int objectIndex)
+{
+	if ((m_objectBuffer == 0) || (objectIndex < 0) || (objectIndex >= m_objectCount))
+	{
+		return;
+	}
+
+	GLuint enabled = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER,
+		sizeof(OBJECT_DATA) * objectIndex + offsetof(OBJECT_DATA, enabled), sizeof(enabled), &enabled);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  IsReady()
+ *
+ *  This method is used for checking whether the culling
+ *  shader is loaded and the objects are uploaded.
+ ***********************************************************/
+bool GpuCuller::IsReady() const
+{
+	return((m_program != 0) && (m_objectBuffer != 0));
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for running the culling shader over
+ *  all of the objects.  The command counts are cleared first,
+ *  and the commands as well when the draws cannot read the
+ *  counts, so that the unused commands draw nothing.  The
+ *  depth pyramid is bound to the 2D target of the first
+ *  texture unit, which the texture arrays of the draws do
+ *  not use.  The shader program and the texture of the draws
+ *  are bound again afterwards.
+ ***********************************************************/
+void GpuCuller::Cull(
+	const Frustum& frustum,
+	const glm::vec3& viewPosition,
+	float lodScale,
+	bool bFrustumCulling,
+	const DepthPyramid* pDepthPyramid)
+{
+	if (IsReady() == false)
+	{
+		return;
+	}
+
+	GLint drawProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &drawProgram);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_countBuffer);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	if (m_bIndirectCount == false)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBuffer);
+		glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glm::vec4 planes[6];
+	for (int i = 0; i < 6; i++)
+	{
+		planes[i] = frustum.GetPlane(i);
+	}
+
+	glUseProgram(m_program);
+	glUniform1ui(m_objectCountLocation, m_objectCount);
+	glUniform1i(m_frustumCullingLocation, bFrustumCulling ? 1 : 0);
+	glUniform4fv(m_frustumPlanesLocation, 6, &planes[0].x);
+	glUniform3f(m_viewPositionLocation, viewPosition.x, viewPosition.y, viewPosition.z);
+	glUniform1f(m_lodScaleLocation, lodScale);
+	if (m_lodScreenSizes.empty() == false)
+	{
+		glUniform1fv(m_lodScreenSizesLocation, m_lodScreenSizes.size(), m_lodScreenSizes.data());
+	}
+	glUniform1f(m_lodHysteresisLocation, m_lodHysteresis);
+
+	bool bOcclusionCulling = (NULL != pDepthPyramid) && (pDepthPyramid->IsValid() == true);
+	GLint boundTexture = 0;
+	glUniform1i(m_occlusionCullingLocation, bOcclusionCulling ? 1 : 0);
+	if (bOcclusionCulling == true)
+	{
+		glm::vec2 viewSize = pDepthPyramid->GetViewSize();
+		glUniformMatrix4fv(m_pyramidViewProjectionLocation, 1, GL_FALSE, glm::value_ptr(pDepthPyramid->GetViewProjection()));
+		glUniform2f(m_pyramidViewSizeLocation, viewSize.x, viewSize.y);
+		glUniform1i(m_pyramidLevelCountLocation, pDepthPyramid->GetLevelCount());
+
+		glActiveTexture(GL_TEXTURE0);
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+		glBindTexture(GL_TEXTURE_2D, pDepthPyramid->GetTexture());
+	}
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_ObjectBinding, m_objectBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_GroupBinding, m_groupBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_CountBinding, m_countBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_CommandBinding, m_commandBuffer);
+
+	glDispatchCompute((m_objectCount + g_WorkGroupSize - 1) / g_WorkGroupSize, 1, 1);
+
+	// the draws read the commands and the counts written above
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+	if (bOcclusionCulling == true)
+	{
+		glBindTexture(GL_TEXTURE_2D, boundTexture);
+	}
+	glUseProgram(drawProgram);
+}
+
+/***********************************************************
+ *  DrawGroup()
+ *
+ *  This method is used for drawing the visible objects of a
+ *  draw group with one indirect draw.  With the indirect
+ *  parameters the number of commands is read from the count
+ *  buffer, otherwise all of the commands of the group are
+ *  submitted and the cleared ones draw nothing.
+ ***********************************************************/
+void GpuCuller::DrawGroup(int drawGroup)
+{
+	if ((IsReady() == false) || (drawGroup < 0) || (drawGroup >= m_groupSizes.size()) ||
+		(m_groupSizes[drawGroup] == 0))
+	{
+		return;
+	}
+
+	const void* commandOffset =
+		(const void*)(sizeof(StaticBatch::DRAW_COMMAND) * m_groupFirstCommands[drawGroup]);
+
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	if (m_bIndirectCount == true)
+	{
+		glBindBuffer(GL_PARAMETER_BUFFER_ARB, m_countBuffer);
+		glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, GL_UNSIGNED_INT, commandOffset,
+			(GLintptr)(sizeof(GLuint) * drawGroup), m_groupSizes[drawGroup], 0);
+		glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0);
+	}
+	else
+	{
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, commandOffset,
+			m_groupSizes[drawGroup], 0);
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+}
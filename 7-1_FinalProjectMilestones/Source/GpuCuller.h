@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuculler.h
+// ============
+// cull the objects of the static batches in a compute shader, which writes
+// the draw commands of the visible objects for indirect draws
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "DepthPyramid.h"
+#include "Frustum.h"
+#include "ResourcePool.h"
+#include "ShaderCache.h"
+#include "StaticBatch.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  GpuCuller
+ *
+ *  This class contains the code for keeping the boxes and
+ *  index ranges of the baked static objects in shader storage
+ *  buffers, and for culling them and choosing their level of
+ *  detail on the GPU, so that each draw group is drawn with
+ *  one indirect draw and no work per object on the CPU.  The
+ *  objects hidden behind the depth of the last frame are
+ *  culled as well when a depth pyramid is passed in.
+ ***********************************************************/
+class GpuCuller
+{
+public:
+	// constructor
+	GpuCuller(ResourcePool* pResourcePool);
+	// destructor
+	~GpuCuller();
+
+	// one object as laid out in the std430 object buffer of the
+	// culling shader - 80 bytes
+	struct OBJECT_DATA
+	{
+		glm::vec4 boundsMin;
+		glm::vec4 boundsMax;
+		GLuint firstIndex[4];
+		GLuint indexCount[4];
+		GLuint drawGroup;
+		GLuint lodCount;
+		GLuint lodLevel;
+		GLuint enabled;
+	};
+
+	// check whether the OpenGL context has compute shaders and
+	// shader storage buffers
+	static bool IsSupported();
+
+	// get the culling shader of a file from the shader cache
+	bool LoadShader(ShaderCache* pShaderCache, const char* filename);
+	// set the screen sizes that the levels of detail change at
+	void SetLodSettings(const float* screenSizes, int screenSizeCount, float hysteresis);
+
+	// remove all of the objects
+	void Clear();
+	// add a baked object of the static batch, in the order of
+	// the static batch objects
+	void AddObject(
+		const StaticBatch& staticBatch,
+		int staticObject,
+		const glm::vec3& boundsMin,
+		const glm::vec3& boundsMax,
+		int drawGroup);
+	// upload the objects into the shader storage buffers
+	void Upload(const StaticBatch& staticBatch, int drawGroupCount);
+	// stop drawing an object, after it has moved
+	void DisableObject(int objectIndex);
+
+	// get whether there are uploaded objects and a shader
+	bool IsReady() const;
+	// run the culling shader, which writes the draw commands -
+	// the depth pyramid can be NULL for no occlusion culling
+	void Cull(
+		const Frustum& frustum,
+		const glm::vec3& viewPosition,
+		float lodScale,
+		bool bFrustumCulling,
+		const DepthPyramid* pDepthPyramid);
+	// draw the visible objects of a draw group
+	void DrawGroup(int drawGroup);
+
+private:
+	// screen sizes that the levels of detail change at
+	std::vector<float> m_lodScreenSizes;
+	float m_lodHysteresis;
+	// the objects before they are uploaded
+	std::vector<OBJECT_DATA> m_objects;
+	// number of objects and first command of each draw group
+	std::vector<GLuint> m_groupSizes;
+	std::vector<GLuint> m_groupFirstCommands;
+	int m_objectCount;
+
+	GLuint m_program;
+	// gives out the shader storage buffers
+	ResourcePool* m_pResourcePool;
+	GLuint m_objectBuffer;
+	GLuint m_groupBuffer;
+	GLuint m_countBuffer;
+	GLuint m_commandBuffer;
+	GLuint m_vao;
+	// true when the draws read the command count from the count
+	// buffer, otherwise the unused commands are cleared to zero
+	bool m_bIndirectCount;
+
+	// uniform locations of the culling shader
+	GLint m_objectCountLocation;
+	GLint m_frustumCullingLocation;
+	GLint m_frustumPlanesLocation;
+	GLint m_viewPositionLocation;
+	GLint m_lodScaleLocation;
+	GLint m_lodScreenSizesLocation;
+	GLint m_lodHysteresisLocation;
+	GLint m_occlusionCullingLocation;
+	GLint m_pyramidViewProjectionLocation;
+	GLint m_pyramidViewSizeLocation;
+	GLint m_pyramidLevelCountLocation;
+
+	// free the OpenGL buffers
+	void DestroyBuffers();
+};
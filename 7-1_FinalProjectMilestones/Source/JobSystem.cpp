@@ -0,0 +1,249 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// run the per-frame scene work on a pool of worker threads that steal jobs
+// from each other - used for spreading loops over the cores
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace
+{
+	// the job system and queue of the worker thread this runs
+	// on - NULL and -1 on the threads that are not workers
+	thread_local const JobSystem* g_pWorkerSystem = NULL;
+	thread_local int g_workerQueueIndex = -1;
+}
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobSystem::JobSystem(int threadCount)
+{
+	m_queuedCount = 0;
+	m_bStopping = false;
+
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency() - 1;
+		if (threadCount < 1)
+		{
+			threadCount = 1;
+		}
+	}
+
+	// the queues are all created before any thread starts, since
+	// every thread steals from all of them
+	for (int i = 0; i <= threadCount; i++)
+	{
+		m_queues.push_back(new JOB_QUEUE());
+	}
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_workers.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+	}
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_bStopping = true;
+	}
+	m_jobReady.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	for (size_t i = 0; i < m_queues.size(); i++)
+	{
+		delete m_queues[i];
+	}
+	m_queues.clear();
+}
+
+/***********************************************************
+ *  GetThreadCount()
+ *
+ *  This method is used for getting the number of worker
+ *  threads.
+ ***********************************************************/
+int JobSystem::GetThreadCount() const
+{
+	return(m_workers.size());
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for splitting the items of a loop into
+ *  jobs and running them on the worker threads.  The jobs are
+ *  queued on the queue of the calling thread, which is the
+ *  worker's own queue for a loop started inside a job, and the
+ *  idle workers steal from it.  The calling thread runs jobs
+ *  too until every job of the loop is done.  A loop that fits
+ *  in one range is run on the calling thread only.
+ ***********************************************************/
+void JobSystem::ParallelFor(int itemCount, int rangeSize, const RANGE_FUNCTION& body)
+{
+	if (itemCount <= 0)
+	{
+		return;
+	}
+
+	rangeSize = std::max(rangeSize, 1);
+	if ((itemCount <= rangeSize) || (m_workers.empty() == true))
+	{
+		body(0, itemCount);
+		return;
+	}
+
+	const int callerQueue = GetCallerQueue();
+	int jobCount = (itemCount + rangeSize - 1) / rangeSize;
+	std::atomic<int> remaining(jobCount);
+
+	{
+		JOB_QUEUE& queue = *m_queues[callerQueue];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		for (int begin = 0; begin < itemCount; begin += rangeSize)
+		{
+			JOB job;
+			job.pBody = &body;
+			job.begin = begin;
+			job.end = std::min(begin + rangeSize, itemCount);
+			job.pRemaining = &remaining;
+			queue.jobs.push_back(job);
+		}
+	}
+	{
+		// taking the lock keeps a worker from missing the wake up
+		// between checking the count and starting to wait
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_queuedCount += jobCount;
+	}
+	m_jobReady.notify_all();
+
+	// help with the jobs until all of them are done, which may
+	// include jobs of the other loops that were stolen
+	while (remaining.load() > 0)
+	{
+		JOB job;
+		if (TakeJob(callerQueue, job) == true)
+		{
+			RunJob(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  GetCallerQueue()
+ *
+ *  This method is used for getting the queue of the calling
+ *  thread - its own queue for a worker, and the shared queue
+ *  of the other threads otherwise.
+ ***********************************************************/
+int JobSystem::GetCallerQueue() const
+{
+	if (g_pWorkerSystem == this)
+	{
+		return(g_workerQueueIndex);
+	}
+
+	return(m_workers.size());
+}
+
+/***********************************************************
+ *  TakeJob()
+ *
+ *  This method is used for taking the newest job from the
+ *  queue of a thread, or the oldest job of one of the other
+ *  queues when it is empty.  The oldest jobs are the largest
+ *  amount of work left, and stealing them keeps the threads
+ *  away from the end of the queue that the owner works at.
+ ***********************************************************/
+bool JobSystem::TakeJob(int queueIndex, JOB& job)
+{
+	{
+		JOB_QUEUE& queue = *m_queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty() == false)
+		{
+			job = queue.jobs.back();
+			queue.jobs.pop_back();
+			m_queuedCount--;
+			return(true);
+		}
+	}
+
+	for (size_t i = 1; i < m_queues.size(); i++)
+	{
+		JOB_QUEUE& queue = *m_queues[(queueIndex + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty() == false)
+		{
+			job = queue.jobs.front();
+			queue.jobs.pop_front();
+			m_queuedCount--;
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  RunJob()
+ *
+ *  This method is used for running the range of a job and
+ *  counting it as finished for its loop.
+ ***********************************************************/
+void JobSystem::RunJob(const JOB& job)
+{
+	(*job.pBody)(job.begin, job.end);
+	job.pRemaining->fetch_sub(1);
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used for running the jobs on a worker
+ *  thread, which sleeps while there are no queued jobs.
+ ***********************************************************/
+void JobSystem::WorkerLoop(int queueIndex)
+{
+	g_pWorkerSystem = this;
+	g_workerQueueIndex = queueIndex;
+
+	while (true)
+	{
+		JOB job;
+		if (TakeJob(queueIndex, job) == true)
+		{
+			RunJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_jobReady.wait(lock, [this]() { return((m_bStopping == true) || (m_queuedCount.load() > 0)); });
+		if (m_bStopping == true)
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// run the per-frame scene work on a pool of worker threads that steal jobs
+// from each other - used for spreading loops over the cores
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class contains the code for a pool of worker threads
+ *  with a job queue each.  A thread takes the newest job from
+ *  its own queue, and steals the oldest job from another queue
+ *  when its own is empty.  The thread that waits for a loop
+ *  to finish runs jobs as well instead of sleeping.  The jobs
+ *  make no OpenGL calls - those stay on the context thread.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// constructor - zero threads uses one thread per core,
+	// leaving one core for the rendering thread
+	JobSystem(int threadCount = 0);
+	// destructor
+	~JobSystem();
+
+	// the work of a parallel loop for the items from begin up
+	// to end
+	typedef std::function<void(int begin, int end)> RANGE_FUNCTION;
+
+	// run the loop body over the items split into ranges of
+	// about the passed in size, returning once all are done
+	void ParallelFor(int itemCount, int rangeSize, const RANGE_FUNCTION& body);
+
+	// get the number of worker threads
+	int GetThreadCount() const;
+
+private:
+	// one range of a parallel loop
+	struct JOB
+	{
+		const RANGE_FUNCTION* pBody;
+		int begin;
+		int end;
+		// jobs of the loop that have not finished yet
+		std::atomic<int>* pRemaining;
+	};
+
+	// the jobs of one thread, the owner works at the back and
+	// the other threads steal from the front
+	struct JOB_QUEUE
+	{
+		std::deque<JOB> jobs;
+		std::mutex mutex;
+	};
+
+	std::vector<std::thread> m_workers;
+	// a queue for each worker thread, then one for the threads
+	// calling ParallelFor()
+	std::vector<JOB_QUEUE*> m_queues;
+	// number of queued jobs not yet taken
+	std::atomic<int> m_queuedCount;
+	// true when the worker threads need to exit
+	std::atomic<bool> m_bStopping;
+	// the idle worker threads wait on this for new jobs
+	std::mutex m_sleepMutex;
+	std::condition_variable m_jobReady;
+
+	// main loop of each worker thread
+	void WorkerLoop(int queueIndex);
+	// get the queue that the calling thread adds its jobs to
+	int GetCallerQueue() const;
+	// take a job from a queue, stealing from the others when
+	// it is empty - false when there is none
+	bool TakeJob(int queueIndex, JOB& job);
+	// run a job and count it as finished
+	void RunJob(const JOB& job);
+};
@@ -0,0 +1,221 @@
+///////////////////////////////////////////////////////////////////////////////
+// ktxfile.cpp
+// ============
+// read and write the KTX (version 1) files used for the cooked textures
+///////////////////////////////////////////////////////////////////////////////
+
+#include "KtxFile.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// the identifier at the start of every KTX version 1 file
+	const unsigned char g_KtxIdentifier[12] = {
+		0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+	// written by the file author, reads back swapped when the
+	// file was written with the other byte order
+	const uint32_t g_KtxEndianness = 0x04030201;
+
+	// the header following the identifier
+	struct KTX_HEADER
+	{
+		uint32_t endianness;
+		uint32_t glType;
+		uint32_t glTypeSize;
+		uint32_t glFormat;
+		uint32_t glInternalFormat;
+		uint32_t glBaseInternalFormat;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t numberOfArrayElements;
+		uint32_t numberOfFaces;
+		uint32_t numberOfMipmapLevels;
+		uint32_t bytesOfKeyValueData;
+	};
+
+	const size_t g_KtxHeaderSize = sizeof(g_KtxIdentifier) + sizeof(KTX_HEADER);
+
+	// check the identifier and header of a KTX file, which only
+	// supports the single 2D compressed images that are cooked
+	bool ParseHeader(const unsigned char* fileData, size_t fileSize, KTX_HEADER& header)
+	{
+		if ((fileSize < g_KtxHeaderSize) ||
+			(memcmp(fileData, g_KtxIdentifier, sizeof(g_KtxIdentifier)) != 0))
+		{
+			return(false);
+		}
+
+		memcpy(&header, fileData + sizeof(g_KtxIdentifier), sizeof(KTX_HEADER));
+
+		if ((header.endianness != g_KtxEndianness) ||
+			(header.glType != 0) ||
+			(header.pixelWidth == 0) ||
+			(header.pixelHeight == 0) ||
+			(header.pixelDepth != 0) ||
+			(header.numberOfArrayElements != 0) ||
+			(header.numberOfFaces != 1))
+		{
+			return(false);
+		}
+
+		if (header.numberOfMipmapLevels == 0)
+		{
+			header.numberOfMipmapLevels = 1;
+		}
+
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  ReadHeader()
+ *
+ *  This method is used for reading only the header of the
+ *  passed in KTX file, without reading the image data.
+ ***********************************************************/
+bool KtxFile::ReadHeader(const char* filename, KTX_INFO& info)
+{
+	unsigned char headerData[g_KtxHeaderSize];
+	KTX_HEADER header;
+
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.read((char*)headerData, sizeof(headerData)))
+	{
+		return(false);
+	}
+
+	if (ParseHeader(headerData, sizeof(headerData), header) == false)
+	{
+		std::cout << "Not a supported KTX file:" << filename << std::endl;
+		return(false);
+	}
+
+	info.internalFormat = header.glInternalFormat;
+	info.width = header.pixelWidth;
+	info.height = header.pixelHeight;
+	info.levelCount = header.numberOfMipmapLevels;
+
+	return(true);
+}
+
+/***********************************************************
+ *  ParseLevels()
+ *
+ *  This method is used for finding the mip levels inside of
+ *  the contents of a KTX file that was read into memory.
+ ***********************************************************/
+bool KtxFile::ParseLevels(
+	const unsigned char* fileData,
+	size_t fileSize,
+	KTX_INFO& info,
+	std::vector<KTX_LEVEL>& levels)
+{
+	KTX_HEADER header;
+
+	levels.clear();
+	if (ParseHeader(fileData, fileSize, header) == false)
+	{
+		return(false);
+	}
+
+	info.internalFormat = header.glInternalFormat;
+	info.width = header.pixelWidth;
+	info.height = header.pixelHeight;
+	info.levelCount = header.numberOfMipmapLevels;
+
+	size_t offset = g_KtxHeaderSize + header.bytesOfKeyValueData;
+	int width = info.width;
+	int height = info.height;
+
+	for (int level = 0; level < info.levelCount; level++)
+	{
+		uint32_t imageSize = 0;
+		if (offset + sizeof(imageSize) > fileSize)
+		{
+			return(false);
+		}
+		memcpy(&imageSize, fileData + offset, sizeof(imageSize));
+		offset += sizeof(imageSize);
+
+		if (offset + imageSize > fileSize)
+		{
+			return(false);
+		}
+
+		KTX_LEVEL mipLevel;
+		mipLevel.width = width;
+		mipLevel.height = height;
+		mipLevel.data = fileData + offset;
+		mipLevel.dataSize = imageSize;
+		levels.push_back(mipLevel);
+
+		// each level is padded to a multiple of 4 bytes
+		offset += (imageSize + 3) & ~(size_t)3;
+		width = (width > 1) ? (width / 2) : 1;
+		height = (height > 1) ? (height / 2) : 1;
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used for writing the passed in compressed
+ *  mip levels to a KTX file.
+ ***********************************************************/
+bool KtxFile::Write(
+	const char* filename,
+	GLenum internalFormat,
+	GLenum baseInternalFormat,
+	const std::vector<KTX_LEVEL>& levels)
+{
+	if (levels.empty() == true)
+	{
+		return(false);
+	}
+
+	KTX_HEADER header;
+	header.endianness = g_KtxEndianness;
+	// compressed images have no type or format
+	header.glType = 0;
+	header.glTypeSize = 1;
+	header.glFormat = 0;
+	header.glInternalFormat = internalFormat;
+	header.glBaseInternalFormat = baseInternalFormat;
+	header.pixelWidth = levels[0].width;
+	header.pixelHeight = levels[0].height;
+	header.pixelDepth = 0;
+	header.numberOfArrayElements = 0;
+	header.numberOfFaces = 1;
+	header.numberOfMipmapLevels = levels.size();
+	header.bytesOfKeyValueData = 0;
+
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "Could not write KTX file:" << filename << std::endl;
+		return(false);
+	}
+
+	file.write((const char*)g_KtxIdentifier, sizeof(g_KtxIdentifier));
+	file.write((const char*)&header, sizeof(header));
+
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		const unsigned char padding[3] = { 0, 0, 0 };
+		uint32_t imageSize = levels[i].dataSize;
+
+		file.write((const char*)&imageSize, sizeof(imageSize));
+		file.write((const char*)levels[i].data, levels[i].dataSize);
+		file.write((const char*)padding, ((imageSize + 3) & ~3u) - imageSize);
+	}
+
+	return(file.good());
+}
@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////////////
+// ktxfile.h
+// ============
+// read and write the KTX (version 1) files used for the cooked textures
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+/***********************************************************
+ *  KtxFile
+ *
+ *  This class contains the code for reading and writing the
+ *  subset of the KTX file format used by the texture cooker -
+ *  a single 2D image with a chain of compressed mip levels.
+ ***********************************************************/
+class KtxFile
+{
+public:
+	// the values read from the header of a KTX file
+	struct KTX_INFO
+	{
+		GLenum internalFormat;
+		int width;
+		int height;
+		int levelCount;
+	};
+
+	// one mip level of the image - the data is not owned
+	struct KTX_LEVEL
+	{
+		int width;
+		int height;
+		const unsigned char* data;
+		size_t dataSize;
+	};
+
+	// read only the header of a KTX file
+	static bool ReadHeader(const char* filename, KTX_INFO& info);
+	// find the mip levels inside of the contents of a KTX file
+	// that was read into memory - the levels point into the data
+	static bool ParseLevels(
+		const unsigned char* fileData,
+		size_t fileSize,
+		KTX_INFO& info,
+		std::vector<KTX_LEVEL>& levels);
+	// write the mip levels of a compressed image to a KTX file
+	static bool Write(
+		const char* filename,
+		GLenum internalFormat,
+		GLenum baseInternalFormat,
+		const std::vector<KTX_LEVEL>& levels);
+};
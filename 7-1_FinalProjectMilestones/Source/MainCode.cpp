@@ -9,6 +9,9 @@
 
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <string>           // window title text
+#include <cmath>            // render target size
+#include <algorithm>        // std::max
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -22,6 +25,13 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "ShaderCache.h"
+#include "FrameProfiler.h"
+#include "AppOptions.h"
+#include "Benchmark.h"
+#include "RenderTarget.h"
+#include "DynamicResolution.h"
+#include "JobSystem.h"
 
 // Namespace for declaring global variables
 namespace
@@ -36,14 +46,54 @@ namespace
 	SceneManager* g_SceneManager = nullptr;
 	// shader manager object for dynamic interaction with the shader code
 	ShaderManager* g_ShaderManager = nullptr;
+	// shader cache object for building the shader programs and
+	// keeping their binaries between launches
+	ShaderCache* g_ShaderCache = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// frame profiler object for timing the phases of each frame
+	FrameProfiler* g_Profiler = nullptr;
+	// job system object for spreading the scene work over the cores
+	JobSystem* g_JobSystem = nullptr;
+
+	// trace file written by the profiler and its length in frames
+	const char* const TRACE_FILENAME = "frame_trace.json";
+	const int TRACE_FRAME_COUNT = 120;
+
+	// frames still drawn after the last change when drawing on
+	// demand, so that the occlusion results, which arrive a frame
+	// late, and the levels of detail settle
+	const int SETTLE_FRAME_COUNT = 3;
+	// longest wait for input when drawing on demand, after which
+	// the 3D scene is checked for changes again
+	const double IDLE_WAIT_SECONDS = 0.25;
+
+	// smallest render scale that the dynamic resolution lowers
+	// the 3D scene to, as a part of the largest scale
+	const float MIN_RENDER_SCALE = 0.5f;
+
+	// longest wait of the benchmark for the texture images to
+	// load before its timed frames start anyway
+	const double TEXTURE_WAIT_SECONDS = 30.0;
+
+	// direction towards the sun, its color and its specular
+	// intensity, when the sun lights the 3D scene
+	const glm::vec3 SUN_DIRECTION = glm::vec3(-0.4f, 1.0f, 0.35f);
+	const glm::vec3 SUN_COLOR = glm::vec3(0.45f, 0.43f, 0.38f);
+	const float SUN_SPECULAR = 0.3f;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+void ProcessProfilerKeys();
+void ProcessPicking();
+void SetWindowSwapInterval(int vsyncMode);
+bool IsRedrawNeeded(int& settleFrames);
+void WaitForNextFrame(double& nextFrameTime, float maxFps);
+bool BindSceneTarget(RenderTarget& renderTarget, int viewWidth, int viewHeight, float maxScale, float scale);
+int RunBenchmark(const Benchmark::SETTINGS& settings, const AppOptions::OPTIONS& options);
 
 
 /***********************************************************
@@ -54,6 +104,24 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// the offline texture cooking step runs without a window
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--cook-textures")
+		{
+			return(SceneManager::CookSceneTextures() ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+	}
+
+	// the options set up the 3D scene and the window, and the
+	// benchmark renders offscreen instead of into the window
+	Benchmark::SETTINGS benchmarkSettings;
+	AppOptions::OPTIONS options;
+	if (Benchmark::ParseArguments(argc, argv, benchmarkSettings, options) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
@@ -66,8 +134,15 @@ int main(int argc, char* argv[])
 	g_ViewManager = new ViewManager(
 		g_ShaderManager);
 
-	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	// try to create the main display window, which is hidden when
+	// only its OpenGL context is used
+	bool bHiddenWindow = (benchmarkSettings.bEnabled == true) ||
+		(options.exportFilename.empty() == false);
+	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE, bHiddenWindow);
+	if (g_Window == NULL)
+	{
+		return(EXIT_FAILURE);
+	}
 
 	// if GLEW fails initialization, then terminate the application
 	if (InitializeGLEW() == false)
@@ -75,61 +150,231 @@ int main(int argc, char* argv[])
 		return(EXIT_FAILURE);
 	}
 
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"shaders/vertexShader.glsl",
-		"shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
+	// the shader programs are built from the external GLSL files
+	// by the shader cache, which loads the binaries of the last
+	// launch instead of compiling them again
+	g_ShaderCache = new ShaderCache();
+	g_ShaderCache->SetBinaryCaching(options.bShaderCache);
 
 	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager = new SceneManager(g_ShaderManager, g_ShaderCache);
+	if (options.bJobSystem == true)
+	{
+		g_JobSystem = new JobSystem();
+		g_SceneManager->SetJobSystem(g_JobSystem);
+	}
+	g_SceneManager->SetSceneTiling(options.tileCount);
+	g_SceneManager->SetFrustumCulling(options.bFrustumCulling);
+	g_SceneManager->SetOcclusionCulling(options.bOcclusionCulling);
+	g_SceneManager->SetStaticBatching(options.bStaticBatching);
+	g_SceneManager->SetGpuCulling(options.bGpuCulling);
+	g_SceneManager->SetDepthPrepass(options.bDepthPrepass);
+	g_SceneManager->SetShaderVariants(options.bShaderVariants);
+	g_SceneManager->SetShadows(options.bShadows);
+	if (options.bSunLight == true)
+	{
+		g_SceneManager->SetSunLight(SUN_DIRECTION, SUN_COLOR, SUN_SPECULAR);
+	}
+	g_SceneManager->SetScatteredPointLights(options.pointLightCount);
+	g_SceneManager->SetSceneFile(options.sceneFilename);
+	g_SceneManager->SetSceneStreaming(options.streamCellSize,
+		options.streamRadius, options.streamBudget);
+	// only the window reloads the edited asset files
+	g_SceneManager->SetHotReload((options.bHotReload == true) && (bHiddenWindow == false));
 	g_SceneManager->PrepareScene();
 
-	// camera movement instructions
-	std::cout << "\n--- CAMERA FUNCTION DIRECTORY ---\n";
-	std::cout << "ESC = exit program\n";
-	std::cout << "W = zoom in\n";
-	std::cout << "S = zoom out\n";
-	std::cout << "A = pan left\n";
-	std::cout << "S = pan right\n";
-	std::cout << "Q = pan up\n";
-	std::cout << "E = pan down\n";
-	std::cout << "P = perspective view\n";
-	std::cout << "O = orthographic view\n";
-	std::cout << "Mouse cursor will change camera orientation\n";
-	std::cout << "Mouse scroll will increase (up) or decrease (down) camera movement speed\n";
-
-	// loop will keep running until the application is closed 
-	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
-	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
+	ShaderCache::CACHE_STATS shaderStats = g_ShaderCache->GetStats();
+	std::cout << "Shader programs: " << shaderStats.compiledPrograms << " compiled, "
+		<< shaderStats.loadedBinaries << " loaded from binaries, "
+		<< shaderStats.savedBinaries << " binaries written, in "
+		<< (shaderStats.buildSeconds * 1000.0) << " ms" << std::endl;
 
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// create the profiler once the OpenGL context is ready
+	g_Profiler = new FrameProfiler();
+	g_SceneManager->SetProfiler(g_Profiler);
 
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
-
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
-
-
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
-
-		// query the latest GLFW events
-		glfwPollEvents();
+	int exitCode = EXIT_SUCCESS;
+	if (options.exportFilename.empty() == false)
+	{
+		// the scene is written once it is prepared, without
+		// rendering it
+		exitCode = g_SceneManager->ExportScene(options.exportFilename) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	else if (benchmarkSettings.bEnabled == true)
+	{
+		exitCode = RunBenchmark(benchmarkSettings, options);
+	}
+	else
+	{
+		// camera movement instructions
+		std::cout << "\n--- CAMERA FUNCTION DIRECTORY ---\n";
+		std::cout << "ESC = exit program\n";
+		std::cout << "W = zoom in\n";
+		std::cout << "S = zoom out\n";
+		std::cout << "A = pan left\n";
+		std::cout << "S = pan right\n";
+		std::cout << "Q = pan up\n";
+		std::cout << "E = pan down\n";
+		std::cout << "P = perspective view\n";
+		std::cout << "O = orthographic view\n";
+		std::cout << "Mouse cursor will change camera orientation\n";
+		std::cout << "Mouse scroll will increase (up) or decrease (down) camera movement speed\n";
+		std::cout << "F2 = write a trace of the next " << TRACE_FRAME_COUNT << " frames to " << TRACE_FILENAME << "\n";
+		std::cout << "F3 = output the frame profile statistics\n";
+		std::cout << "Left mouse button = pick the object at the center of the view\n";
+
+		SetWindowSwapInterval(options.vsyncMode);
+		if ((options.outputWidth > 0) && (options.outputHeight > 0))
+		{
+			glfwSetWindowSize(g_Window, options.outputWidth, options.outputHeight);
+		}
+
+		// the 3D scene is rendered into an offscreen target at the
+		// render scale of the window size and stretched over the
+		// window, and the dynamic resolution lowers the scale when
+		// the GPU cannot hold the target frame rate
+		RenderTarget renderTarget;
+		DynamicResolution dynamicResolution;
+		dynamicResolution.SetTarget(options.dynamicResolutionFps,
+			options.renderScale * MIN_RENDER_SCALE, options.renderScale);
+
+		// time when the render statistics were last displayed
+		double lastStatsTime = glfwGetTime();
+		// earliest time of the next frame under the frame rate cap
+		double nextFrameTime = glfwGetTime();
+		// frames left to draw after the last change, on demand
+		int settleFrames = SETTLE_FRAME_COUNT;
+
+		// loop will keep running until the application is closed 
+		// or until an error has occurred
+		while (!glfwWindowShouldClose(g_Window))
+		{
+			// an edited texture, shader or scene file is loaded again
+			// without preparing the whole scene, and is drawn even
+			// when the view has not changed
+			if (g_SceneManager->ReloadChangedAssets() == true)
+			{
+				settleFrames = SETTLE_FRAME_COUNT;
+			}
+
+			// when drawing on demand, an unchanged view sleeps until
+			// the next input event instead of drawing the same frame
+			if ((options.bOnDemand == true) && (IsRedrawNeeded(settleFrames) == false))
+			{
+				glfwWaitEventsTimeout(IDLE_WAIT_SECONDS);
+				ProcessProfilerKeys();
+				ProcessPicking();
+				continue;
+			}
+
+			// nothing is drawn while the window is minimized
+			int viewWidth = g_ViewManager->GetViewWidth();
+			int viewHeight = g_ViewManager->GetViewHeight();
+			if ((viewWidth <= 0) || (viewHeight <= 0))
+			{
+				glfwWaitEventsTimeout(IDLE_WAIT_SECONDS);
+				continue;
+			}
+
+			if (BindSceneTarget(renderTarget, viewWidth, viewHeight,
+				options.renderScale, dynamicResolution.GetScale()) == false)
+			{
+				exitCode = EXIT_FAILURE;
+				break;
+			}
+
+			g_Profiler->BeginFrame();
+
+			// Enable z-depth
+			glEnable(GL_DEPTH_TEST);
+
+			// Clear the frame and z buffers
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			// convert from 3D object space to 2D view
+			g_Profiler->BeginScope("PrepareSceneView");
+			g_ViewManager->PrepareSceneView();
+			g_SceneManager->SetSceneView(g_ViewManager->GetViewMatrix(), g_ViewManager->GetProjectionMatrix());
+			g_Profiler->EndScope();
+
+			// refresh the 3D scene
+			g_Profiler->BeginScope("RenderScene");
+			dynamicResolution.BeginFrame();
+			g_SceneManager->RenderScene();
+			dynamicResolution.EndFrame();
+			g_Profiler->EndScope();
+
+			// stretch the rendered view over the window
+			g_Profiler->BeginScope("Upscale");
+			renderTarget.BlitToDefault(viewWidth, viewHeight);
+			g_Profiler->EndScope();
+
+			// display the render statistics in the window title once per second
+			if (glfwGetTime() - lastStatsTime >= 1.0)
+			{
+				SceneManager::RENDER_STATS stats = g_SceneManager->GetRenderStats();
+				FrameProfiler::SCOPE_STATS frameStats;
+				std::string title = std::string(WINDOW_TITLE) +
+					" - draws: " + std::to_string(stats.drawCalls) +
+					" (instanced: " + std::to_string(stats.instancedDrawCalls) + ")" +
+					", state changes: " + std::to_string(stats.stateChanges) +
+					", skipped: " + std::to_string(stats.stateChangesSkipped) +
+					", culled: " + std::to_string(stats.culledItems) +
+					", occluded: " + std::to_string(stats.occludedItems) +
+					", shadow draws: " + std::to_string(stats.shadowDrawCalls) +
+					", scale: " + std::to_string((int)(dynamicResolution.GetScale() * 100.0f + 0.5f)) + "%";
+				if (g_Profiler->GetScopeStats("Frame", frameStats) == true)
+				{
+					title += ", frame ms: " + std::to_string(frameStats.cpuAverage) +
+						" (p95: " + std::to_string(frameStats.cpuP95) + ")";
+				}
+				glfwSetWindowTitle(g_Window, title.c_str());
+				lastStatsTime = glfwGetTime();
+			}
+
+			// Flips the the back buffer with the front buffer every frame.
+			g_Profiler->BeginScope("SwapBuffers");
+			glfwSwapBuffers(g_Window);
+			g_Profiler->EndScope();
+
+			// query the latest GLFW events
+			g_Profiler->BeginScope("PollEvents");
+			glfwPollEvents();
+			ProcessProfilerKeys();
+			ProcessPicking();
+			g_Profiler->EndScope();
+
+			g_Profiler->EndFrame();
+
+			// the wait under the frame rate cap is not part of the
+			// timed frame
+			WaitForNextFrame(nextFrameTime, options.maxFps);
+		}
 	}
 
 	// clear the allocated manager objects from memory
+	if (NULL != g_Profiler)
+	{
+		g_Profiler->ReportStats();
+		delete g_Profiler;
+		g_Profiler = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
 		g_SceneManager = NULL;
 	}
+	if (NULL != g_ShaderCache)
+	{
+		delete g_ShaderCache;
+		g_ShaderCache = NULL;
+	}
+	if (NULL != g_JobSystem)
+	{
+		delete g_JobSystem;
+		g_JobSystem = NULL;
+	}
 	if (NULL != g_ViewManager)
 	{
 		delete g_ViewManager;
@@ -141,8 +386,8 @@ int main(int argc, char* argv[])
 		g_ShaderManager = NULL;
 	}
 
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
+	// Terminates the program with the result of the run
+	exit(exitCode);
 }
 
 /***********************************************************
@@ -197,4 +442,294 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *	ProcessProfilerKeys()
+ *
+ *  This function is used to handle the profiler keys, which
+ *  act once when they are pressed rather than while held.
+ ***********************************************************/
+void ProcessProfilerKeys()
+{
+	static bool bTraceKeyDown = false;
+	static bool bReportKeyDown = false;
+
+	bool bTraceKey = (glfwGetKey(g_Window, GLFW_KEY_F2) == GLFW_PRESS);
+	if ((bTraceKey == true) && (bTraceKeyDown == false))
+	{
+		g_Profiler->RequestTrace(TRACE_FILENAME, TRACE_FRAME_COUNT);
+	}
+	bTraceKeyDown = bTraceKey;
+
+	bool bReportKey = (glfwGetKey(g_Window, GLFW_KEY_F3) == GLFW_PRESS);
+	if ((bReportKey == true) && (bReportKeyDown == false))
+	{
+		g_Profiler->ReportStats();
+		g_SceneManager->ReportMemoryUsage();
+	}
+	bReportKeyDown = bReportKey;
+}
+
+/***********************************************************
+ *	ProcessPicking()
+ *
+ *  This function is used to pick the object under the center
+ *  of the view when the left mouse button is clicked - the
+ *  captured cursor always stays at the center.
+ ***********************************************************/
+void ProcessPicking()
+{
+	static bool bButtonDown = false;
+
+	bool bButton = (glfwGetMouseButton(g_Window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
+	if ((bButton == true) && (bButtonDown == false))
+	{
+		glm::vec3 origin;
+		glm::vec3 direction;
+		float distance = 0.0f;
+		g_ViewManager->GetPickRay(
+			g_ViewManager->GetViewWidth() * 0.5, g_ViewManager->GetViewHeight() * 0.5,
+			origin, direction);
+
+		int itemIndex = g_SceneManager->PickRenderItem(origin, direction, distance);
+		if (itemIndex >= 0)
+		{
+			const SceneManager::RENDER_ITEM& item = g_SceneManager->GetRenderItem(itemIndex);
+			std::cout << "Picked object " << itemIndex << " at distance " << distance
+				<< ", position (" << item.positionXYZ.x << ", " << item.positionXYZ.y
+				<< ", " << item.positionXYZ.z << ")" << std::endl;
+		}
+		else
+		{
+			std::cout << "No object picked" << std::endl;
+		}
+	}
+	bButtonDown = bButton;
+}
+
+/***********************************************************
+ *	SetWindowSwapInterval()
+ *
+ *  This function is used to set the vsync of the window.
+ *  Adaptive vsync waits for the display refresh like normal
+ *  vsync, but swaps at once when a frame is late instead of
+ *  waiting for the next refresh, and it falls back to normal
+ *  vsync when the driver does not support it.
+ ***********************************************************/
+void SetWindowSwapInterval(int vsyncMode)
+{
+	if (vsyncMode < 0)
+	{
+		bool bSwapTear = (glfwExtensionSupported("WGL_EXT_swap_control_tear") == GLFW_TRUE) ||
+			(glfwExtensionSupported("GLX_EXT_swap_control_tear") == GLFW_TRUE);
+		if (bSwapTear == false)
+		{
+			vsyncMode = 1;
+		}
+	}
+
+	glfwSwapInterval(vsyncMode);
+}
+
+/***********************************************************
+ *	IsRedrawNeeded()
+ *
+ *  This function is used to check whether the window needs
+ *  to be drawn again when drawing on demand.  The camera
+ *  input, the window being uncovered, changes of the 3D scene
+ *  and a recording trace all need a new frame, and a few more
+ *  frames are drawn after the last of them.
+ ***********************************************************/
+bool IsRedrawNeeded(int& settleFrames)
+{
+	bool bChanged = g_ViewManager->TakeViewChanges();
+	if ((g_SceneManager->NeedsRedraw() == true) || (g_Profiler->IsTracing() == true))
+	{
+		bChanged = true;
+	}
+
+	if (bChanged == true)
+	{
+		settleFrames = SETTLE_FRAME_COUNT;
+		return(true);
+	}
+	if (settleFrames > 0)
+	{
+		settleFrames--;
+		return(true);
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *	WaitForNextFrame()
+ *
+ *  This function is used to hold the next frame back until
+ *  the frame rate cap allows it, while still handling the
+ *  window events.  The frames are paced from the planned
+ *  time of the last one, so they do not drift, unless they
+ *  have fallen behind.
+ ***********************************************************/
+void WaitForNextFrame(double& nextFrameTime, float maxFps)
+{
+	if (maxFps <= 0.0f)
+	{
+		return;
+	}
+
+	double now = glfwGetTime();
+	nextFrameTime += 1.0 / maxFps;
+	if (nextFrameTime < now)
+	{
+		nextFrameTime = now;
+	}
+
+	double remaining = nextFrameTime - now;
+	while (remaining > 0.0)
+	{
+		glfwWaitEventsTimeout(remaining);
+		remaining = nextFrameTime - glfwGetTime();
+	}
+}
+
+/***********************************************************
+ *	BindSceneTarget()
+ *
+ *  This function is used to direct the rendering of the 3D
+ *  scene into the render target at the passed in scale of the
+ *  view size.  The render target is sized for the largest
+ *  scale, so that a lower scale only renders into a corner of
+ *  it, and it is only created again when the view size changes.
+ ***********************************************************/
+bool BindSceneTarget(RenderTarget& renderTarget, int viewWidth, int viewHeight, float maxScale, float scale)
+{
+	int targetWidth = std::max((int)ceilf(viewWidth * maxScale), 1);
+	int targetHeight = std::max((int)ceilf(viewHeight * maxScale), 1);
+	if ((renderTarget.GetWidth() != targetWidth) || (renderTarget.GetHeight() != targetHeight))
+	{
+		if (renderTarget.Create(targetWidth, targetHeight) == false)
+		{
+			return(false);
+		}
+	}
+
+	renderTarget.SetViewSize((int)(viewWidth * scale + 0.5f), (int)(viewHeight * scale + 0.5f));
+	renderTarget.Bind();
+	return(true);
+}
+
+/***********************************************************
+ *	RunBenchmark()
+ *
+ *  This function is used to render the 3D scene offscreen
+ *  with vsync off, along the scripted camera path of the
+ *  benchmark, and report the frame times.
+ ***********************************************************/
+int RunBenchmark(const Benchmark::SETTINGS& settings, const AppOptions::OPTIONS& options)
+{
+	// the output size replaces the size of the hidden window, and
+	// the report shows the size actually rendered
+	if ((options.outputWidth > 0) && (options.outputHeight > 0))
+	{
+		g_ViewManager->SetViewSize(options.outputWidth, options.outputHeight);
+	}
+	AppOptions::OPTIONS runOptions = options;
+	runOptions.outputWidth = g_ViewManager->GetViewWidth();
+	runOptions.outputHeight = g_ViewManager->GetViewHeight();
+
+	RenderTarget renderTarget;
+	DynamicResolution dynamicResolution;
+	dynamicResolution.SetTarget(options.dynamicResolutionFps,
+		options.renderScale * MIN_RENDER_SCALE, options.renderScale);
+	if (BindSceneTarget(renderTarget, runOptions.outputWidth, runOptions.outputHeight,
+		options.renderScale, dynamicResolution.GetScale()) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// nothing is presented, so the frames are not held back
+	// by the display refresh
+	glfwSwapInterval(0);
+
+	glm::vec3 sceneMin;
+	glm::vec3 sceneMax;
+	g_SceneManager->GetSceneBounds(sceneMin, sceneMax);
+	Benchmark benchmark(settings, runOptions, sceneMin, sceneMax);
+
+	// sum of the render scales of the timed frames
+	double scaleSum = 0.0;
+
+	// the texture images decode in the background, and the
+	// timing only starts once all of them are in place
+	double loadStartTime = glfwGetTime();
+	int frame = -settings.warmupFrames;
+	while (frame < settings.frameCount)
+	{
+		if ((frame == 0) && (g_SceneManager->GetPendingTextureCount() > 0) &&
+			(glfwGetTime() - loadStartTime < TEXTURE_WAIT_SECONDS))
+		{
+			frame = -1;
+		}
+		if (frame == 0)
+		{
+			benchmark.Start();
+		}
+
+		BindSceneTarget(renderTarget, runOptions.outputWidth, runOptions.outputHeight,
+			options.renderScale, dynamicResolution.GetScale());
+		if (frame >= 0)
+		{
+			scaleSum += dynamicResolution.GetScale();
+		}
+
+		g_Profiler->BeginFrame();
+
+		glm::vec3 position;
+		glm::vec3 target;
+		benchmark.GetCameraPose(std::max(frame, 0), position, target);
+		g_ViewManager->SetCameraPose(position, target);
+
+		glEnable(GL_DEPTH_TEST);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		g_Profiler->BeginScope("PrepareSceneView");
+		g_ViewManager->PrepareSceneView();
+		g_SceneManager->SetSceneView(g_ViewManager->GetViewMatrix(), g_ViewManager->GetProjectionMatrix());
+		g_Profiler->EndScope();
+
+		g_Profiler->BeginScope("RenderScene");
+		dynamicResolution.BeginFrame();
+		g_SceneManager->RenderScene();
+		dynamicResolution.EndFrame();
+		g_Profiler->EndScope();
+
+		// keep the hidden window responsive to the system
+		g_Profiler->BeginScope("PollEvents");
+		glfwPollEvents();
+		g_Profiler->EndScope();
+
+		g_Profiler->EndFrame();
+
+		if (frame >= 0)
+		{
+			benchmark.EndFrame();
+		}
+		frame++;
+	}
+
+	Benchmark::RESULTS results = benchmark.Finish();
+	if (settings.frameCount > 0)
+	{
+		results.renderScale = (float)(scaleSum / settings.frameCount);
+	}
+	RenderTarget::BindDefault(g_ViewManager->GetViewWidth(), g_ViewManager->GetViewHeight());
+
+	SceneManager::RENDER_STATS stats = g_SceneManager->GetRenderStats();
+	bool bPassed = benchmark.Report(results, g_SceneManager->GetRenderItemCount(), stats.visibleItems, stats.drawCalls);
+	g_SceneManager->ReportMemoryUsage();
+
+	return(bPassed ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,45 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// map a whole file into memory read only - used for loading the binary scene
+// files in place
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class contains the code for mapping the contents of
+ *  a file into the address space of the application, so the
+ *  file is read in place by the operating system as its
+ *  pages are touched instead of being copied into a buffer.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+	// map the whole of a file, which returns false when the file
+	// cannot be opened or is empty
+	bool Open(const char* filename);
+	// unmap the file
+	void Close();
+
+	// get the mapped contents, NULL when no file is mapped
+	const unsigned char* GetData() const;
+	// get the size of the mapped contents in bytes
+	size_t GetSize() const;
+
+private:
+	const unsigned char* m_pData;
+	size_t m_size;
+	// handles of the open file and of its mapping on Windows
+	void* m_fileHandle;
+	void* m_mappingHandle;
+};
@@ -0,0 +1,987 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshmanager.cpp
+// ============
+// manage the application owned copies of the basic shape meshes - used for
+// the instanced drawing of repeated objects in the 3D scene
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// declaration of global variables
+namespace
+{
+	// number of floats for each interleaved vertex
+	const int g_FloatsPerVertex = 8;
+
+	// vertex attribute locations used by the vertex shader
+	const GLuint g_PositionLocation = 0;
+	const GLuint g_NormalLocation = 1;
+	const GLuint g_TextureCoordLocation = 2;
+	// the instance model matrix uses four consecutive locations
+	const GLuint g_InstanceModelLocation = 3;
+	const GLuint g_InstanceColorLocation = 7;
+	const GLuint g_InstanceUVScaleLocation = 8;
+	const GLuint g_InstanceTextureLayerLocation = 9;
+
+	// number of segments around the tapered cylinder for each
+	// level of detail, from the nearest to the furthest
+	const int g_TaperedCylinderSegments[] = { 36, 18, 10, 6 };
+	const int g_TaperedCylinderLodCount =
+		sizeof(g_TaperedCylinderSegments) / sizeof(g_TaperedCylinderSegments[0]);
+
+	const float g_PI = 3.14159265f;
+
+	// number of instances the instance buffer holds per frame
+	// before it grows
+	const int g_InitialInstanceCapacity = 1024;
+
+	// bytes of the shared vertex and index buffers of the meshes
+	// before they grow, which hold all of the basic shapes
+	const GLsizeiptr g_InitialVertexBytes = 256 * 1024;
+	const GLsizeiptr g_InitialIndexBytes = 64 * 1024;
+}
+
+/***********************************************************
+ *  MeshManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshManager::MeshManager(ResourcePool* pResourcePool)
+{
+	GL_MESH emptyMesh = { { 0, 0 }, { 0, 0 }, 0, 0, 0, { glm::vec3(0.0f), glm::vec3(0.0f) } };
+
+	m_planeMesh = emptyMesh;
+	m_boxMesh = emptyMesh;
+	m_taperedCylinderLods.resize(g_TaperedCylinderLodCount, emptyMesh);
+	m_prismMesh = emptyMesh;
+	m_pyramid3Mesh = emptyMesh;
+
+	// the instance buffer needs to exist before the vertex array
+	// is set up, since the vertex array records it
+	m_pInstanceRing = new RingBuffer(GL_ARRAY_BUFFER, sizeof(INSTANCE_DATA) * g_InitialInstanceCapacity);
+	m_instanceOffset = 0;
+	m_bBaseInstance = ((GLEW_VERSION_4_2 == GL_TRUE) || (GLEW_ARB_base_instance == GL_TRUE));
+
+	// the shared buffers start out as one free range each
+	m_pResourcePool = pResourcePool;
+	m_vertexBuffer = m_pResourcePool->AcquireBuffer(g_InitialVertexBytes, GL_STATIC_DRAW, &m_vertexCapacity);
+	m_indexBuffer = m_pResourcePool->AcquireBuffer(g_InitialIndexBytes, GL_STATIC_DRAW, &m_indexCapacity);
+	BUFFER_RANGE vertexRange = { 0, m_vertexCapacity };
+	BUFFER_RANGE indexRange = { 0, m_indexCapacity };
+	m_freeVertexRanges.push_back(vertexRange);
+	m_freeIndexRanges.push_back(indexRange);
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+	SetVertexAttributes();
+
+	// per-instance attributes, which advance once per instance
+	SetInstanceAttributes(0);
+	for (int column = 0; column < 4; column++)
+	{
+		glEnableVertexAttribArray(g_InstanceModelLocation + column);
+		glVertexAttribDivisor(g_InstanceModelLocation + column, 1);
+	}
+	glEnableVertexAttribArray(g_InstanceColorLocation);
+	glVertexAttribDivisor(g_InstanceColorLocation, 1);
+	glEnableVertexAttribArray(g_InstanceUVScaleLocation);
+	glVertexAttribDivisor(g_InstanceUVScaleLocation, 1);
+	glEnableVertexAttribArray(g_InstanceTextureLayerLocation);
+	glVertexAttribDivisor(g_InstanceTextureLayerLocation, 1);
+
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  ~MeshManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshManager::~MeshManager()
+{
+	DestroyMesh(m_planeMesh);
+	DestroyMesh(m_boxMesh);
+	for (size_t i = 0; i < m_taperedCylinderLods.size(); i++)
+	{
+		DestroyMesh(m_taperedCylinderLods[i]);
+	}
+	DestroyMesh(m_prismMesh);
+	DestroyMesh(m_pyramid3Mesh);
+
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		m_vao = 0;
+	}
+	m_pResourcePool->ReleaseBuffer(m_vertexBuffer);
+	m_pResourcePool->ReleaseBuffer(m_indexBuffer);
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_pResourcePool = NULL;
+
+	delete m_pInstanceRing;
+	m_pInstanceRing = NULL;
+}
+
+/***********************************************************
+ *  AddVertex()
+ *
+ *  This method is used for appending one interleaved vertex
+ *  to the passed in geometry.
+ ***********************************************************/
+void MeshManager::AddVertex(
+	MESH_GEOMETRY& geometry,
+	glm::vec3 position,
+	glm::vec3 normal,
+	glm::vec2 uv)
+{
+	geometry.vertices.push_back(position.x);
+	geometry.vertices.push_back(position.y);
+	geometry.vertices.push_back(position.z);
+	geometry.vertices.push_back(normal.x);
+	geometry.vertices.push_back(normal.y);
+	geometry.vertices.push_back(normal.z);
+	geometry.vertices.push_back(uv.x);
+	geometry.vertices.push_back(uv.y);
+}
+
+/***********************************************************
+ *  AddTriangle()
+ *
+ *  This method is used for appending a flat shaded triangle
+ *  to the passed in geometry.  The winding is flipped when
+ *  needed so that the front face points along the normal.
+ ***********************************************************/
+void MeshManager::AddTriangle(
+	MESH_GEOMETRY& geometry,
+	glm::vec3 p0, glm::vec2 uv0,
+	glm::vec3 p1, glm::vec2 uv1,
+	glm::vec3 p2, glm::vec2 uv2,
+	glm::vec3 normal)
+{
+	GLushort firstIndex = geometry.vertices.size() / g_FloatsPerVertex;
+
+	AddVertex(geometry, p0, normal, uv0);
+	AddVertex(geometry, p1, normal, uv1);
+	AddVertex(geometry, p2, normal, uv2);
+
+	geometry.indices.push_back(firstIndex);
+	if (glm::dot(glm::cross(p1 - p0, p2 - p0), normal) >= 0.0f)
+	{
+		geometry.indices.push_back(firstIndex + 1);
+		geometry.indices.push_back(firstIndex + 2);
+	}
+	else
+	{
+		geometry.indices.push_back(firstIndex + 2);
+		geometry.indices.push_back(firstIndex + 1);
+	}
+}
+
+/***********************************************************
+ *  AddQuad()
+ *
+ *  This method is used for appending a flat shaded quad to
+ *  the passed in geometry.  The corners are passed in order
+ *  around the quad, starting from the corner that is mapped
+ *  to the (0, 0) texture coordinate.
+ ***********************************************************/
+void MeshManager::AddQuad(
+	MESH_GEOMETRY& geometry,
+	glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3,
+	glm::vec3 normal)
+{
+	AddTriangle(geometry,
+		p0, glm::vec2(0.0f, 0.0f),
+		p1, glm::vec2(1.0f, 0.0f),
+		p2, glm::vec2(1.0f, 1.0f),
+		normal);
+	AddTriangle(geometry,
+		p0, glm::vec2(0.0f, 0.0f),
+		p2, glm::vec2(1.0f, 1.0f),
+		p3, glm::vec2(0.0f, 1.0f),
+		normal);
+}
+
+/***********************************************************
+ *  GeneratePlaneGeometry()
+ *
+ *  This method is used for generating a flat plane in the
+ *  XZ plane, from -1 to 1 on the X and Z axes.
+ ***********************************************************/
+void MeshManager::GeneratePlaneGeometry(MESH_GEOMETRY& geometry)
+{
+	AddQuad(geometry,
+		glm::vec3(-1.0f, 0.0f, 1.0f),
+		glm::vec3(1.0f, 0.0f, 1.0f),
+		glm::vec3(1.0f, 0.0f, -1.0f),
+		glm::vec3(-1.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+/***********************************************************
+ *  GenerateBoxGeometry()
+ *
+ *  This method is used for generating a unit box centered on
+ *  the origin, with the full texture mapped onto each face.
+ ***********************************************************/
+void MeshManager::GenerateBoxGeometry(MESH_GEOMETRY& geometry)
+{
+	// the face normals and the two axes spanning each face
+	const glm::vec3 normals[6] = {
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f) };
+	const glm::vec3 uAxes[6] = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 0.0f, 1.0f),
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f) };
+	const glm::vec3 vAxes[6] = {
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+
+	for (int i = 0; i < 6; i++)
+	{
+		glm::vec3 center = normals[i] * 0.5f;
+		glm::vec3 u = uAxes[i] * 0.5f;
+		glm::vec3 v = vAxes[i] * 0.5f;
+
+		AddQuad(geometry,
+			center - u - v,
+			center + u - v,
+			center + u + v,
+			center - u + v,
+			normals[i]);
+	}
+}
+
+/***********************************************************
+ *  GenerateTaperedCylinderGeometry()
+ *
+ *  This method is used for generating a tapered cylinder
+ *  standing on the origin, with a bottom radius of 1, a top
+ *  radius of 0.5 and a height of 1.
+ ***********************************************************/
+void MeshManager::GenerateTaperedCylinderGeometry(
+	MESH_GEOMETRY& geometry,
+	int segments)
+{
+	const float bottomRadius = 1.0f;
+	const float topRadius = 0.5f;
+	const float height = 1.0f;
+
+	// the sides are smooth shaded, so the ring vertices are
+	// shared between neighbouring segments
+	GLushort firstIndex = geometry.vertices.size() / g_FloatsPerVertex;
+	for (int i = 0; i <= segments; i++)
+	{
+		float angle = 2.0f * g_PI * i / segments;
+		float c = std::cos(angle);
+		float s = std::sin(angle);
+		glm::vec3 normal = glm::normalize(glm::vec3(c * height, bottomRadius - topRadius, s * height));
+		float u = (float)i / segments;
+
+		AddVertex(geometry, glm::vec3(c * bottomRadius, 0.0f, s * bottomRadius), normal, glm::vec2(u, 0.0f));
+		AddVertex(geometry, glm::vec3(c * topRadius, height, s * topRadius), normal, glm::vec2(u, 1.0f));
+	}
+	for (int i = 0; i < segments; i++)
+	{
+		GLushort bottom0 = firstIndex + (i * 2);
+		GLushort top0 = bottom0 + 1;
+		GLushort bottom1 = bottom0 + 2;
+		GLushort top1 = bottom0 + 3;
+
+		geometry.indices.push_back(bottom0);
+		geometry.indices.push_back(top0);
+		geometry.indices.push_back(top1);
+		geometry.indices.push_back(bottom0);
+		geometry.indices.push_back(top1);
+		geometry.indices.push_back(bottom1);
+	}
+
+	// the bottom and top caps
+	glm::vec3 bottomCenter(0.0f, 0.0f, 0.0f);
+	glm::vec3 topCenter(0.0f, height, 0.0f);
+	for (int i = 0; i < segments; i++)
+	{
+		float angle0 = 2.0f * g_PI * i / segments;
+		float angle1 = 2.0f * g_PI * (i + 1) / segments;
+		glm::vec2 ring0(std::cos(angle0), std::sin(angle0));
+		glm::vec2 ring1(std::cos(angle1), std::sin(angle1));
+		glm::vec2 uv0 = glm::vec2(0.5f) + (ring0 * 0.5f);
+		glm::vec2 uv1 = glm::vec2(0.5f) + (ring1 * 0.5f);
+
+		AddTriangle(geometry,
+			bottomCenter, glm::vec2(0.5f, 0.5f),
+			glm::vec3(ring0.x * bottomRadius, 0.0f, ring0.y * bottomRadius), uv0,
+			glm::vec3(ring1.x * bottomRadius, 0.0f, ring1.y * bottomRadius), uv1,
+			glm::vec3(0.0f, -1.0f, 0.0f));
+		AddTriangle(geometry,
+			topCenter, glm::vec2(0.5f, 0.5f),
+			glm::vec3(ring0.x * topRadius, height, ring0.y * topRadius), uv0,
+			glm::vec3(ring1.x * topRadius, height, ring1.y * topRadius), uv1,
+			glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+}
+
+/***********************************************************
+ *  GeneratePrismGeometry()
+ *
+ *  This method is used for generating a unit triangular prism
+ *  centered on the origin.  The triangle lies in the XZ plane
+ *  with its apex towards +Z, and is extruded along the Y axis.
+ ***********************************************************/
+void MeshManager::GeneratePrismGeometry(MESH_GEOMETRY& geometry)
+{
+	const glm::vec3 corners[3] = {
+		glm::vec3(-0.5f, 0.0f, -0.5f),
+		glm::vec3(0.5f, 0.0f, -0.5f),
+		glm::vec3(0.0f, 0.0f, 0.5f) };
+	const glm::vec3 top(0.0f, 0.5f, 0.0f);
+	const glm::vec3 bottom(0.0f, -0.5f, 0.0f);
+	const glm::vec3 center = (corners[0] + corners[1] + corners[2]) / 3.0f;
+
+	// the triangle ends
+	AddTriangle(geometry,
+		corners[0] + top, glm::vec2(0.0f, 0.0f),
+		corners[1] + top, glm::vec2(1.0f, 0.0f),
+		corners[2] + top, glm::vec2(0.5f, 1.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f));
+	AddTriangle(geometry,
+		corners[0] + bottom, glm::vec2(0.0f, 0.0f),
+		corners[1] + bottom, glm::vec2(1.0f, 0.0f),
+		corners[2] + bottom, glm::vec2(0.5f, 1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f));
+
+	// the three rectangular sides
+	for (int i = 0; i < 3; i++)
+	{
+		glm::vec3 p0 = corners[i];
+		glm::vec3 p1 = corners[(i + 1) % 3];
+		glm::vec3 edge = p1 - p0;
+		glm::vec3 normal = glm::normalize(glm::cross(edge, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+		// point the normal away from the center of the prism
+		if (glm::dot(normal, ((p0 + p1) * 0.5f) - center) < 0.0f)
+		{
+			normal = -normal;
+		}
+
+		AddQuad(geometry,
+			p0 + bottom,
+			p1 + bottom,
+			p1 + top,
+			p0 + top,
+			normal);
+	}
+}
+
+/***********************************************************
+ *  GeneratePyramid3Geometry()
+ *
+ *  This method is used for generating a unit three sided
+ *  pyramid centered on the origin, with the base at -0.5 and
+ *  the apex at 0.5 on the Y axis.
+ ***********************************************************/
+void MeshManager::GeneratePyramid3Geometry(MESH_GEOMETRY& geometry)
+{
+	const glm::vec3 corners[3] = {
+		glm::vec3(-0.5f, -0.5f, -0.5f),
+		glm::vec3(0.5f, -0.5f, -0.5f),
+		glm::vec3(0.0f, -0.5f, 0.5f) };
+	const glm::vec3 apex(0.0f, 0.5f, 0.0f);
+	const glm::vec3 center = (corners[0] + corners[1] + corners[2] + apex) * 0.25f;
+
+	// the base
+	AddTriangle(geometry,
+		corners[0], glm::vec2(0.0f, 0.0f),
+		corners[1], glm::vec2(1.0f, 0.0f),
+		corners[2], glm::vec2(0.5f, 1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f));
+
+	// the three sloped sides
+	for (int i = 0; i < 3; i++)
+	{
+		glm::vec3 p0 = corners[i];
+		glm::vec3 p1 = corners[(i + 1) % 3];
+		glm::vec3 normal = glm::normalize(glm::cross(p1 - p0, apex - p0));
+
+		// point the normal away from the center of the pyramid
+		if (glm::dot(normal, ((p0 + p1 + apex) / 3.0f) - center) < 0.0f)
+		{
+			normal = -normal;
+		}
+
+		AddTriangle(geometry,
+			p0, glm::vec2(0.0f, 0.0f),
+			p1, glm::vec2(1.0f, 0.0f),
+			apex, glm::vec2(0.5f, 1.0f),
+			normal);
+	}
+}
+
+/***********************************************************
+ *  CreateMesh()
+ *
+ *  This method is used for uploading the passed in geometry
+ *  into free ranges of the shared vertex and index buffers,
+ *  which grow when the geometry does not fit.  The indices
+ *  stay relative to the first vertex of the mesh, which the
+ *  draws pass as the base vertex.
+ ***********************************************************/
+void MeshManager::CreateMesh(GL_MESH& mesh, const MESH_GEOMETRY& geometry)
+{
+	GLsizeiptr vertexBytes = sizeof(GLfloat) * geometry.vertices.size();
+	GLsizeiptr indexBytes = sizeof(GLushort) * geometry.indices.size();
+
+	DestroyMesh(mesh);
+	if ((vertexBytes == 0) || (indexBytes == 0))
+	{
+		return;
+	}
+
+	if (AllocateRange(m_freeVertexRanges, vertexBytes, mesh.vertexRange) == false)
+	{
+		GrowBuffer(m_vertexBuffer, m_vertexCapacity, m_freeVertexRanges, vertexBytes);
+		AllocateRange(m_freeVertexRanges, vertexBytes, mesh.vertexRange);
+	}
+	if (AllocateRange(m_freeIndexRanges, indexBytes, mesh.indexRange) == false)
+	{
+		GrowBuffer(m_indexBuffer, m_indexCapacity, m_freeIndexRanges, indexBytes);
+		AllocateRange(m_freeIndexRanges, indexBytes, mesh.indexRange);
+	}
+
+	// the copy target leaves the element buffer of the bound
+	// vertex array alone
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, mesh.vertexRange.offset, vertexBytes, geometry.vertices.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, mesh.indexRange.offset, indexBytes, geometry.indices.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	mesh.baseVertex = mesh.vertexRange.offset / (sizeof(GLfloat) * g_FloatsPerVertex);
+	mesh.firstIndex = mesh.indexRange.offset / sizeof(GLushort);
+	mesh.nIndices = geometry.indices.size();
+	mesh.geometry = geometry;
+
+	// the bounds are kept for culling the drawn objects
+	for (size_t i = 0; i < geometry.vertices.size(); i += g_FloatsPerVertex)
+	{
+		glm::vec3 position = glm::vec3(
+			geometry.vertices[i], geometry.vertices[i + 1], geometry.vertices[i + 2]);
+		if (i == 0)
+		{
+			mesh.bounds.minXYZ = position;
+			mesh.bounds.maxXYZ = position;
+		}
+		mesh.bounds.minXYZ = glm::min(mesh.bounds.minXYZ, position);
+		mesh.bounds.maxXYZ = glm::max(mesh.bounds.maxXYZ, position);
+	}
+}
+
+/***********************************************************
+ *  DestroyMesh()
+ *
+ *  This method is used for giving the ranges of a loaded mesh
+ *  back to the shared buffers, so another mesh can use them.
+ ***********************************************************/
+void MeshManager::DestroyMesh(GL_MESH& mesh)
+{
+	if (mesh.nIndices == 0)
+	{
+		return;
+	}
+
+	FreeRange(m_freeVertexRanges, mesh.vertexRange);
+	FreeRange(m_freeIndexRanges, mesh.indexRange);
+
+	mesh.vertexRange.offset = 0;
+	mesh.vertexRange.size = 0;
+	mesh.indexRange.offset = 0;
+	mesh.indexRange.size = 0;
+	mesh.baseVertex = 0;
+	mesh.firstIndex = 0;
+	mesh.nIndices = 0;
+	mesh.geometry = MESH_GEOMETRY();
+}
+
+/***********************************************************
+ *  AllocateRange()
+ *
+ *  This method is used for taking the room for the passed in
+ *  number of bytes from the first free range that fits.  The
+ *  sizes are always whole vertices or indices, so the ranges
+ *  stay aligned to them.
+ ***********************************************************/
+bool MeshManager::AllocateRange(
+	std::vector<BUFFER_RANGE>& freeRanges,
+	GLsizeiptr size,
+	BUFFER_RANGE& range)
+{
+	for (size_t i = 0; i < freeRanges.size(); i++)
+	{
+		if (freeRanges[i].size >= size)
+		{
+			range.offset = freeRanges[i].offset;
+			range.size = size;
+
+			freeRanges[i].offset += size;
+			freeRanges[i].size -= size;
+			if (freeRanges[i].size == 0)
+			{
+				freeRanges.erase(freeRanges.begin() + i);
+			}
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  FreeRange()
+ *
+ *  This method is used for giving a range back to the free
+ *  ranges, which are kept in offset order and joined with the
+ *  neighbours they touch.
+ ***********************************************************/
+void MeshManager::FreeRange(std::vector<BUFFER_RANGE>& freeRanges, const BUFFER_RANGE& range)
+{
+	if (range.size <= 0)
+	{
+		return;
+	}
+
+	size_t i = 0;
+	while ((i < freeRanges.size()) && (freeRanges[i].offset < range.offset))
+	{
+		i++;
+	}
+	freeRanges.insert(freeRanges.begin() + i, range);
+
+	// join with the next range, then with the previous one
+	if ((i + 1 < freeRanges.size()) &&
+		(freeRanges[i].offset + freeRanges[i].size == freeRanges[i + 1].offset))
+	{
+		freeRanges[i].size += freeRanges[i + 1].size;
+		freeRanges.erase(freeRanges.begin() + i + 1);
+	}
+	if ((i > 0) &&
+		(freeRanges[i - 1].offset + freeRanges[i - 1].size == freeRanges[i].offset))
+	{
+		freeRanges[i - 1].size += freeRanges[i].size;
+		freeRanges.erase(freeRanges.begin() + i);
+	}
+}
+
+/***********************************************************
+ *  GrowBuffer()
+ *
+ *  This method is used for moving a shared buffer into one
+ *  from the pool with room for at least the passed in size
+ *  more.  The ranges keep their offsets, so only the new room
+ *  at the end is added to the free ranges, and the vertex
+ *  array is pointed at the new buffer.
+ ***********************************************************/
+void MeshManager::GrowBuffer(
+	GLuint& bufferID,
+	GLsizeiptr& capacity,
+	std::vector<BUFFER_RANGE>& freeRanges,
+	GLsizeiptr neededSize)
+{
+	GLsizeiptr newCapacity = 0;
+	GLuint newBuffer = m_pResourcePool->AcquireBuffer(
+		std::max(capacity * 2, capacity + neededSize), GL_STATIC_DRAW, &newCapacity);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, bufferID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	m_pResourcePool->ReleaseBuffer(bufferID);
+
+	BUFFER_RANGE newRange = { capacity, newCapacity - capacity };
+	bufferID = newBuffer;
+	capacity = newCapacity;
+	FreeRange(freeRanges, newRange);
+
+	glBindVertexArray(m_vao);
+	SetVertexAttributes();
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  SetVertexAttributes()
+ *
+ *  This method is used for pointing the per-vertex attributes
+ *  and the element buffer of the bound vertex array at the
+ *  shared buffers of the meshes.
+ ***********************************************************/
+void MeshManager::SetVertexAttributes()
+{
+	const GLsizei vertexStride = sizeof(GLfloat) * g_FloatsPerVertex;
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glVertexAttribPointer(g_PositionLocation, 3, GL_FLOAT, GL_FALSE, vertexStride, (void*)0);
+	glEnableVertexAttribArray(g_PositionLocation);
+	glVertexAttribPointer(g_NormalLocation, 3, GL_FLOAT, GL_FALSE, vertexStride, (void*)(sizeof(GLfloat) * 3));
+	glEnableVertexAttribArray(g_NormalLocation);
+	glVertexAttribPointer(g_TextureCoordLocation, 2, GL_FLOAT, GL_FALSE, vertexStride, (void*)(sizeof(GLfloat) * 6));
+	glEnableVertexAttribArray(g_TextureCoordLocation);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+}
+
+/***********************************************************
+ *  SetInstanceAttributes()
+ *
+ *  This method is used for pointing the instance attributes
+ *  of the bound vertex array at the instances starting at the
+ *  passed in byte offset of the instance buffer.
+ ***********************************************************/
+void MeshManager::SetInstanceAttributes(GLintptr offset)
+{
+	const GLsizei instanceStride = sizeof(INSTANCE_DATA);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_pInstanceRing->GetBuffer());
+	for (int column = 0; column < 4; column++)
+	{
+		glVertexAttribPointer(g_InstanceModelLocation + column, 4, GL_FLOAT, GL_FALSE, instanceStride,
+			(void*)(offset + offsetof(INSTANCE_DATA, model) + (sizeof(glm::vec4) * column)));
+	}
+	glVertexAttribPointer(g_InstanceColorLocation, 4, GL_FLOAT, GL_FALSE, instanceStride,
+		(void*)(offset + offsetof(INSTANCE_DATA, color)));
+	glVertexAttribPointer(g_InstanceUVScaleLocation, 2, GL_FLOAT, GL_FALSE, instanceStride,
+		(void*)(offset + offsetof(INSTANCE_DATA, uvScale)));
+	glVertexAttribPointer(g_InstanceTextureLayerLocation, 1, GL_FLOAT, GL_FALSE, instanceStride,
+		(void*)(offset + offsetof(INSTANCE_DATA, textureLayer)));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  RebindInstanceBuffer()
+ *
+ *  This method is used for pointing the vertex array of the
+ *  meshes at the instance buffer, which is needed after the
+ *  instance buffer has grown.
+ ***********************************************************/
+void MeshManager::RebindInstanceBuffer()
+{
+	glBindVertexArray(m_vao);
+	SetInstanceAttributes(0);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  BeginInstances()
+ *
+ *  This method is used for getting the room for the values of
+ *  every instanced draw of the frame in the next section of
+ *  the instance buffer.  The caller writes them directly, and
+ *  the draws then pick their run of instances by index.  The
+ *  sections grow when the frame has more instances than they
+ *  hold.
+ ***********************************************************/
+MeshManager::INSTANCE_DATA* MeshManager::BeginInstances(int instanceCount)
+{
+	GLsizeiptr dataSize = sizeof(INSTANCE_DATA) * instanceCount;
+
+	m_pInstanceRing->BeginFrame();
+	void* pInstances = m_pInstanceRing->Allocate(dataSize, sizeof(INSTANCE_DATA), m_instanceOffset);
+	if (pInstances == NULL)
+	{
+		if (m_pInstanceRing->Reserve(dataSize + sizeof(INSTANCE_DATA)) == true)
+		{
+			RebindInstanceBuffer();
+		}
+		pInstances = m_pInstanceRing->Allocate(dataSize, sizeof(INSTANCE_DATA), m_instanceOffset);
+	}
+	if (pInstances == NULL)
+	{
+		m_instanceOffset = 0;
+	}
+
+	return((INSTANCE_DATA*)pInstances);
+}
+
+/***********************************************************
+ *  EndInstances()
+ *
+ *  This method is used for making the per-instance values
+ *  written since BeginInstances() visible to the draws.
+ ***********************************************************/
+void MeshManager::EndInstances()
+{
+	m_pInstanceRing->Flush();
+}
+
+/***********************************************************
+ *  DrawMeshInstanced()
+ *
+ *  This method is used for drawing a run of the uploaded
+ *  instances of the mesh with a single draw command.  The run
+ *  is picked with the base instance, or by pointing the
+ *  instance attributes at it when there is no base instance.
+ ***********************************************************/
+void MeshManager::DrawMeshInstanced(
+	const GL_MESH& mesh,
+	int firstInstance,
+	int instanceCount)
+{
+	if ((mesh.nIndices == 0) || (instanceCount <= 0))
+	{
+		return;
+	}
+
+	const void* indexOffset = (const void*)(sizeof(GLushort) * mesh.firstIndex);
+
+	glBindVertexArray(m_vao);
+	if (m_bBaseInstance == true)
+	{
+		GLuint baseInstance = (m_instanceOffset / sizeof(INSTANCE_DATA)) + firstInstance;
+		glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, mesh.nIndices, GL_UNSIGNED_SHORT,
+			indexOffset, instanceCount, mesh.baseVertex, baseInstance);
+	}
+	else
+	{
+		SetInstanceAttributes(m_instanceOffset + (sizeof(INSTANCE_DATA) * firstInstance));
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh.nIndices, GL_UNSIGNED_SHORT,
+			indexOffset, instanceCount, mesh.baseVertex);
+	}
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DrawMeshSingle()
+ *
+ *  This method is used for drawing the mesh once.  The shader
+ *  takes the model matrix from its uniform instead of the
+ *  instance attributes for these draws.
+ ***********************************************************/
+void MeshManager::DrawMeshSingle(const GL_MESH& mesh)
+{
+	if (mesh.nIndices == 0)
+	{
+		return;
+	}
+
+	glBindVertexArray(m_vao);
+	glDrawElementsBaseVertex(GL_TRIANGLES, mesh.nIndices, GL_UNSIGNED_SHORT,
+		(const void*)(sizeof(GLushort) * mesh.firstIndex), mesh.baseVertex);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  Load*Mesh()
+ *
+ *  These methods are used for generating the basic shape
+ *  meshes and loading them into memory.
+ ***********************************************************/
+void MeshManager::LoadPlaneMesh()
+{
+	MESH_GEOMETRY geometry;
+	GeneratePlaneGeometry(geometry);
+	CreateMesh(m_planeMesh, geometry);
+}
+
+void MeshManager::LoadBoxMesh()
+{
+	MESH_GEOMETRY geometry;
+	GenerateBoxGeometry(geometry);
+	CreateMesh(m_boxMesh, geometry);
+}
+
+void MeshManager::LoadTaperedCylinderMesh()
+{
+	// every level of detail is generated with fewer segments,
+	// which the distant objects are drawn with
+	for (int i = 0; i < g_TaperedCylinderLodCount; i++)
+	{
+		MESH_GEOMETRY geometry;
+		GenerateTaperedCylinderGeometry(geometry, g_TaperedCylinderSegments[i]);
+		CreateMesh(m_taperedCylinderLods[i], geometry);
+	}
+}
+
+void MeshManager::LoadPrismMesh()
+{
+	MESH_GEOMETRY geometry;
+	GeneratePrismGeometry(geometry);
+	CreateMesh(m_prismMesh, geometry);
+}
+
+void MeshManager::LoadPyramid3Mesh()
+{
+	MESH_GEOMETRY geometry;
+	GeneratePyramid3Geometry(geometry);
+	CreateMesh(m_pyramid3Mesh, geometry);
+}
+
+/***********************************************************
+ *  Draw*MeshInstanced()
+ *
+ *  These methods are used for drawing a run of the uploaded
+ *  instances of the basic shape meshes with a single draw
+ *  command.
+ ***********************************************************/
+void MeshManager::DrawPlaneMeshInstanced(int firstInstance, int instanceCount)
+{
+	DrawMeshInstanced(m_planeMesh, firstInstance, instanceCount);
+}
+
+void MeshManager::DrawBoxMeshInstanced(int firstInstance, int instanceCount)
+{
+	DrawMeshInstanced(m_boxMesh, firstInstance, instanceCount);
+}
+
+void MeshManager::DrawTaperedCylinderMeshInstanced(int firstInstance, int instanceCount, int lodLevel)
+{
+	lodLevel = std::min(std::max(lodLevel, 0), g_TaperedCylinderLodCount - 1);
+	DrawMeshInstanced(m_taperedCylinderLods[lodLevel], firstInstance, instanceCount);
+}
+
+void MeshManager::DrawPrismMeshInstanced(int firstInstance, int instanceCount)
+{
+	DrawMeshInstanced(m_prismMesh, firstInstance, instanceCount);
+}
+
+void MeshManager::DrawPyramid3MeshInstanced(int firstInstance, int instanceCount)
+{
+	DrawMeshInstanced(m_pyramid3Mesh, firstInstance, instanceCount);
+}
+
+/***********************************************************
+ *  Draw*Mesh()
+ *
+ *  These methods are used for drawing the basic shape meshes
+ *  once, with the model matrix set in the shader.
+ ***********************************************************/
+void MeshManager::DrawPlaneMesh()
+{
+	DrawMeshSingle(m_planeMesh);
+}
+
+void MeshManager::DrawBoxMesh()
+{
+	DrawMeshSingle(m_boxMesh);
+}
+
+void MeshManager::DrawTaperedCylinderMesh()
+{
+	DrawMeshSingle(m_taperedCylinderLods[0]);
+}
+
+void MeshManager::DrawPrismMesh()
+{
+	DrawMeshSingle(m_prismMesh);
+}
+
+void MeshManager::DrawPyramid3Mesh()
+{
+	DrawMeshSingle(m_pyramid3Mesh);
+}
+
+/***********************************************************
+ *  GetPlaneMeshBounds()
+ *
+ *  This method is used for getting the bounds of the loaded
+ *  plane mesh.
+ ***********************************************************/
+MeshManager::MESH_BOUNDS MeshManager::GetPlaneMeshBounds() const
+{
+	return(m_planeMesh.bounds);
+}
+
+/***********************************************************
+ *  GetBoxMeshBounds()
+ *
+ *  This method is used for getting the bounds of the loaded
+ *  box mesh.
+ ***********************************************************/
+MeshManager::MESH_BOUNDS MeshManager::GetBoxMeshBounds() const
+{
+	return(m_boxMesh.bounds);
+}
+
+/***********************************************************
+ *  GetTaperedCylinderMeshBounds()
+ *
+ *  This method is used for getting the bounds of the loaded
+ *  tapered cylinder mesh.  The coarser levels of detail fit
+ *  inside of the finest one.
+ ***********************************************************/
+MeshManager::MESH_BOUNDS MeshManager::GetTaperedCylinderMeshBounds() const
+{
+	return(m_taperedCylinderLods[0].bounds);
+}
+
+/***********************************************************
+ *  GetTaperedCylinderLodCount()
+ *
+ *  This method is used for getting the number of levels of
+ *  detail of the tapered cylinder mesh.
+ ***********************************************************/
+int MeshManager::GetTaperedCylinderLodCount() const
+{
+	return(g_TaperedCylinderLodCount);
+}
+
+/***********************************************************
+ *  GetPrismMeshBounds()
+ *
+ *  This method is used for getting the bounds of the loaded
+ *  prism mesh.
+ ***********************************************************/
+MeshManager::MESH_BOUNDS MeshManager::GetPrismMeshBounds() const
+{
+	return(m_prismMesh.bounds);
+}
+
+/***********************************************************
+ *  GetPyramid3MeshBounds()
+ *
+ *  This method is used for getting the bounds of the loaded
+ *  pyramid3 mesh.
+ ***********************************************************/
+MeshManager::MESH_BOUNDS MeshManager::GetPyramid3MeshBounds() const
+{
+	return(m_pyramid3Mesh.bounds);
+}
+
+/***********************************************************
+ *  Get*MeshGeometry()
+ *
+ *  These methods are used for getting the generated geometry
+ *  of the loaded basic shape meshes.
+ ***********************************************************/
+const MeshManager::MESH_GEOMETRY& MeshManager::GetPlaneMeshGeometry() const
+{
+	return(m_planeMesh.geometry);
+}
+
+const MeshManager::MESH_GEOMETRY& MeshManager::GetBoxMeshGeometry() const
+{
+	return(m_boxMesh.geometry);
+}
+
+const MeshManager::MESH_GEOMETRY& MeshManager::GetTaperedCylinderMeshGeometry(int lodLevel) const
+{
+	lodLevel = std::min(std::max(lodLevel, 0), g_TaperedCylinderLodCount - 1);
+	return(m_taperedCylinderLods[lodLevel].geometry);
+}
+
+const MeshManager::MESH_GEOMETRY& MeshManager::GetPrismMeshGeometry() const
+{
+	return(m_prismMesh.geometry);
+}
+
+const MeshManager::MESH_GEOMETRY& MeshManager::GetPyramid3MeshGeometry() const
+{
+	return(m_pyramid3Mesh.geometry);
+}
@@ -0,0 +1,214 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshmanager.h
+// ============
+// manage the application owned copies of the basic shape meshes - used for
+// the instanced drawing of repeated objects in the 3D scene
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ResourcePool.h"
+#include "RingBuffer.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  MeshManager
+ *
+ *  This class contains the code for generating the basic
+ *  shape meshes (with the same unit dimensions as the
+ *  ShapeMeshes primitives) and drawing many instances of
+ *  them with a single draw command.  All of the meshes share
+ *  one vertex buffer, one index buffer and one vertex array,
+ *  and each draw picks its mesh by the base vertex and the
+ *  first index.
+ ***********************************************************/
+class MeshManager
+{
+public:
+	// constructor
+	MeshManager(ResourcePool* pResourcePool);
+	// destructor
+	~MeshManager();
+
+	// per-instance values uploaded into the instance buffer,
+	// which match the instance attributes in the vertex shader
+	struct INSTANCE_DATA
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		glm::vec2 uvScale;
+		// layer in the texture array bound for the draw
+		float textureLayer;
+	};
+
+	// the CPU side copy of a generated mesh - the vertices are
+	// interleaved as position (3), normal (3), texture coords (2)
+	struct MESH_GEOMETRY
+	{
+		std::vector<GLfloat> vertices;
+		std::vector<GLushort> indices;
+	};
+
+	// the box around the vertices of a mesh in its own space
+	struct MESH_BOUNDS
+	{
+		glm::vec3 minXYZ;
+		glm::vec3 maxXYZ;
+	};
+
+private:
+	// a run of bytes in one of the shared buffers
+	struct BUFFER_RANGE
+	{
+		GLintptr offset;
+		GLsizeiptr size;
+	};
+
+	// the ranges of the shared buffers holding one loaded mesh
+	struct GL_MESH
+	{
+		BUFFER_RANGE vertexRange;
+		BUFFER_RANGE indexRange;
+		GLint baseVertex;
+		GLuint firstIndex;
+		GLuint nIndices;
+		MESH_BOUNDS bounds;
+		// the generated vertices and indices, which are kept
+		// for baking the static objects of the scene
+		MESH_GEOMETRY geometry;
+	};
+
+	GL_MESH m_planeMesh;
+	GL_MESH m_boxMesh;
+	// levels of detail of the tapered cylinder, the finest first
+	std::vector<GL_MESH> m_taperedCylinderLods;
+	GL_MESH m_prismMesh;
+	GL_MESH m_pyramid3Mesh;
+
+	// gives out the shared buffers
+	ResourcePool* m_pResourcePool;
+	// the vertex array recording the shared buffers and the
+	// instance buffer for every mesh
+	GLuint m_vao;
+	// the shared buffers, with the ranges not used by any mesh
+	GLuint m_vertexBuffer;
+	GLsizeiptr m_vertexCapacity;
+	std::vector<BUFFER_RANGE> m_freeVertexRanges;
+	GLuint m_indexBuffer;
+	GLsizeiptr m_indexCapacity;
+	std::vector<BUFFER_RANGE> m_freeIndexRanges;
+
+	// sections holding the per-instance values of each frame
+	RingBuffer* m_pInstanceRing;
+	// offset of the instances uploaded for the current frame
+	GLintptr m_instanceOffset;
+	// true when the draws can start at a base instance, otherwise
+	// the instance attributes are pointed at each draw's instances
+	bool m_bBaseInstance;
+
+	// generate the geometry for each of the basic shapes
+	void GeneratePlaneGeometry(MESH_GEOMETRY& geometry);
+	void GenerateBoxGeometry(MESH_GEOMETRY& geometry);
+	void GenerateTaperedCylinderGeometry(MESH_GEOMETRY& geometry, int segments);
+	void GeneratePrismGeometry(MESH_GEOMETRY& geometry);
+	void GeneratePyramid3Geometry(MESH_GEOMETRY& geometry);
+
+	// add flat shaded faces to the geometry, wound counter
+	// clockwise when viewed from the side the normal points to
+	void AddTriangle(MESH_GEOMETRY& geometry,
+		glm::vec3 p0, glm::vec2 uv0,
+		glm::vec3 p1, glm::vec2 uv1,
+		glm::vec3 p2, glm::vec2 uv2,
+		glm::vec3 normal);
+	void AddQuad(MESH_GEOMETRY& geometry,
+		glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3,
+		glm::vec3 normal);
+	void AddVertex(MESH_GEOMETRY& geometry,
+		glm::vec3 position, glm::vec3 normal, glm::vec2 uv);
+
+	// upload the geometry into the shared buffers for drawing
+	void CreateMesh(GL_MESH& mesh, const MESH_GEOMETRY& geometry);
+	// give the ranges of a mesh back to the shared buffers
+	void DestroyMesh(GL_MESH& mesh);
+	// take a range from the free ranges of a shared buffer, the
+	// first one that fits - false when none of them does
+	bool AllocateRange(std::vector<BUFFER_RANGE>& freeRanges, GLsizeiptr size, BUFFER_RANGE& range);
+	// give a range back, joining it with the free neighbours
+	void FreeRange(std::vector<BUFFER_RANGE>& freeRanges, const BUFFER_RANGE& range);
+	// move a shared buffer into a larger one from the pool,
+	// which adds the new room to its free ranges
+	void GrowBuffer(GLuint& bufferID, GLsizeiptr& capacity,
+		std::vector<BUFFER_RANGE>& freeRanges, GLsizeiptr neededSize);
+	// point the per-vertex attributes and the element buffer of
+	// the vertex array at the shared buffers
+	void SetVertexAttributes();
+	// point the instance attributes of the bound vertex array at
+	// an offset of the instance buffer
+	void SetInstanceAttributes(GLintptr offset);
+	// point the vertex array at the instance buffer, after it
+	// has been created again
+	void RebindInstanceBuffer();
+	// draw a run of the uploaded instances with a mesh
+	void DrawMeshInstanced(const GL_MESH& mesh,
+		int firstInstance, int instanceCount);
+	// draw a mesh once, with the model matrix of the shader
+	void DrawMeshSingle(const GL_MESH& mesh);
+
+public:
+	// load the basic shape meshes into memory
+	void LoadPlaneMesh();
+	void LoadBoxMesh();
+	void LoadTaperedCylinderMesh();
+	void LoadPrismMesh();
+	void LoadPyramid3Mesh();
+
+	// get the room for the per-instance values of all of the
+	// draws of a frame, which are written straight into the
+	// instance buffer in one pass - NULL when there is no room
+	INSTANCE_DATA* BeginInstances(int instanceCount);
+	// finish writing the per-instance values of the frame
+	void EndInstances();
+
+	// draw many of the uploaded instances of the basic shape
+	// meshes with one draw command - each instance has its own
+	// model matrix, color and texture UV scale, and the tapered
+	// cylinder can be drawn with a coarser level of detail
+	void DrawPlaneMeshInstanced(int firstInstance, int instanceCount);
+	void DrawBoxMeshInstanced(int firstInstance, int instanceCount);
+	void DrawTaperedCylinderMeshInstanced(int firstInstance, int instanceCount, int lodLevel = 0);
+	void DrawPrismMeshInstanced(int firstInstance, int instanceCount);
+	void DrawPyramid3MeshInstanced(int firstInstance, int instanceCount);
+
+	// draw the basic shape meshes once, with the model matrix
+	// set in the shader instead of the instance values
+	void DrawPlaneMesh();
+	void DrawBoxMesh();
+	void DrawTaperedCylinderMesh();
+	void DrawPrismMesh();
+	void DrawPyramid3Mesh();
+
+	// get the bounds of the loaded basic shape meshes, which
+	// are used for culling the objects drawn with them
+	MESH_BOUNDS GetPlaneMeshBounds() const;
+	MESH_BOUNDS GetBoxMeshBounds() const;
+	MESH_BOUNDS GetTaperedCylinderMeshBounds() const;
+	MESH_BOUNDS GetPrismMeshBounds() const;
+	MESH_BOUNDS GetPyramid3MeshBounds() const;
+
+	// get the generated geometry of the loaded basic shape
+	// meshes, in their own space
+	const MESH_GEOMETRY& GetPlaneMeshGeometry() const;
+	const MESH_GEOMETRY& GetBoxMeshGeometry() const;
+	const MESH_GEOMETRY& GetTaperedCylinderMeshGeometry(int lodLevel = 0) const;
+	const MESH_GEOMETRY& GetPrismMeshGeometry() const;
+	const MESH_GEOMETRY& GetPyramid3MeshGeometry() const;
+
+	// get the number of levels of detail of the tapered cylinder -
+	// the other shapes are already as simple as they can be and
+	// only have one level
+	int GetTaperedCylinderLodCount() const;
+};
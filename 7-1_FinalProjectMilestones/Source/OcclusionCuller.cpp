@@ -0,0 +1,247 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.cpp
+// ============
+// skip the drawing of objects hidden behind other objects, using the GPU
+// occlusion query results of the previous frames
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cstddef>
+
+// declaration of global variables
+namespace
+{
+	// number of frames between the queries of a visible object,
+	// since a visible object rarely becomes hidden suddenly
+	const int g_VisibleQueryInterval = 4;
+}
+
+/***********************************************************
+ *  OcclusionCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionCuller::OcclusionCuller()
+{
+	m_frameNumber = 0;
+	m_queryCount = 0;
+
+	// the conservative query may answer faster, and a false
+	// visible result only costs a draw
+	m_queryTarget = GLEW_VERSION_4_3 ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+}
+
+/***********************************************************
+ *  ~OcclusionCuller()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OcclusionCuller::~OcclusionCuller()
+{
+	DeleteQueries();
+}
+
+/***********************************************************
+ *  DeleteQueries()
+ *
+ *  This method is used for freeing the query objects.
+ ***********************************************************/
+void OcclusionCuller::DeleteQueries()
+{
+	for (size_t i = 0; i < m_objects.size(); i++)
+	{
+		if (m_objects[i].query != 0)
+		{
+			glDeleteQueries(1, &m_objects[i].query);
+		}
+	}
+	m_objects.clear();
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for setting the number of objects.
+ *  Every object starts as visible, and its query object is
+ *  created when it is first queried.
+ ***********************************************************/
+void OcclusionCuller::Resize(int objectCount)
+{
+	DeleteQueries();
+
+	OBJECT_QUERY object;
+	object.query = 0;
+	object.bPending = false;
+	object.bOccluded = false;
+	object.lastFrame = -1;
+	m_objects.resize(objectCount, object);
+}
+
+/***********************************************************
+ *  ResetRange()
+ *
+ *  This method is used for making a range of objects visible
+ *  again without a result.  The query objects are kept, and
+ *  a query still in flight is never read, since its result
+ *  belongs to the object that was there before.
+ ***********************************************************/
+void OcclusionCuller::ResetRange(int firstObject, int objectCount)
+{
+	int endObject = std::min(firstObject + objectCount, (int)m_objects.size());
+	for (int i = std::max(firstObject, 0); i < endObject; i++)
+	{
+		m_objects[i].bPending = false;
+		m_objects[i].bOccluded = false;
+		m_objects[i].lastFrame = -1;
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting the queries of a new
+ *  frame.
+ ***********************************************************/
+void OcclusionCuller::BeginFrame()
+{
+	m_frameNumber++;
+	m_queryCount = 0;
+}
+
+/***********************************************************
+ *  ReadResults()
+ *
+ *  This method is used for reading the results of the
+ *  pending queries that have been answered.  The queries
+ *  still waiting keep the last known result.
+ ***********************************************************/
+void OcclusionCuller::ReadResults()
+{
+	for (size_t i = 0; i < m_objects.size(); i++)
+	{
+		OBJECT_QUERY& object = m_objects[i];
+		if (object.bPending == false)
+		{
+			continue;
+		}
+
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(object.query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_TRUE)
+		{
+			GLuint samplesPassed = 0;
+			glGetQueryObjectuiv(object.query, GL_QUERY_RESULT, &samplesPassed);
+			object.bOccluded = (samplesPassed == 0);
+			object.bPending = false;
+		}
+	}
+}
+
+/***********************************************************
+ *  CheckOccluded()
+ *
+ *  This method is used for checking whether an object in the
+ *  view frustum was hidden at its last answered query.  The
+ *  result of an object that was outside of the frustum in
+ *  the last frame is out of date, so it counts as visible.
+ ***********************************************************/
+bool OcclusionCuller::CheckOccluded(int objectIndex)
+{
+	if ((objectIndex < 0) || (objectIndex >= (int)m_objects.size()))
+	{
+		return(false);
+	}
+
+	OBJECT_QUERY& object = m_objects[objectIndex];
+	if (object.lastFrame != m_frameNumber - 1)
+	{
+		object.bOccluded = false;
+	}
+	object.lastFrame = m_frameNumber;
+
+	return(object.bOccluded);
+}
+
+/***********************************************************
+ *  NeedsQuery()
+ *
+ *  This method is used for checking whether an object should
+ *  be queried in this frame.  A query waiting for its result
+ *  is not issued again.  The visible objects are spread over
+ *  g_VisibleQueryInterval frames by their index.
+ ***********************************************************/
+bool OcclusionCuller::NeedsQuery(int objectIndex) const
+{
+	if ((objectIndex < 0) || (objectIndex >= (int)m_objects.size()))
+	{
+		return(false);
+	}
+
+	const OBJECT_QUERY& object = m_objects[objectIndex];
+	if (object.bPending == true)
+	{
+		return(false);
+	}
+	if (object.bOccluded == true)
+	{
+		return(true);
+	}
+
+	return(((objectIndex + m_frameNumber) % g_VisibleQueryInterval) == 0);
+}
+
+/***********************************************************
+ *  SetVisible()
+ *
+ *  This method is used for marking an object visible without
+ *  querying it.
+ ***********************************************************/
+void OcclusionCuller::SetVisible(int objectIndex)
+{
+	if ((objectIndex >= 0) && (objectIndex < (int)m_objects.size()))
+	{
+		m_objects[objectIndex].bOccluded = false;
+	}
+}
+
+/***********************************************************
+ *  BeginQuery()
+ *
+ *  This method is used for starting the query of an object,
+ *  which counts the samples of the following draws.
+ ***********************************************************/
+void OcclusionCuller::BeginQuery(int objectIndex)
+{
+	OBJECT_QUERY& object = m_objects[objectIndex];
+	if (object.query == 0)
+	{
+		glGenQueries(1, &object.query);
+	}
+
+	glBeginQuery(m_queryTarget, object.query);
+	object.bPending = true;
+	m_queryCount++;
+}
+
+/***********************************************************
+ *  EndQuery()
+ *
+ *  This method is used for ending the current query.
+ ***********************************************************/
+void OcclusionCuller::EndQuery()
+{
+	glEndQuery(m_queryTarget);
+}
+
+/***********************************************************
+ *  GetQueryCount()
+ *
+ *  This method is used for getting the number of queries
+ *  issued in this frame.
+ ***********************************************************/
+int OcclusionCuller::GetQueryCount() const
+{
+	return(m_queryCount);
+}
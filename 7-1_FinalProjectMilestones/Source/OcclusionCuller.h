@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.h
+// ============
+// skip the drawing of objects hidden behind other objects, using the GPU
+// occlusion query results of the previous frames
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  OcclusionCuller
+ *
+ *  This class contains the code for keeping one occlusion
+ *  query per object and whether the object was hidden the
+ *  last time its query was answered.  The queries are
+ *  issued with the bounding boxes of the objects after the
+ *  visible objects are drawn, and their results are only
+ *  read once they are available, so the CPU never waits.
+ ***********************************************************/
+class OcclusionCuller
+{
+public:
+	// constructor
+	OcclusionCuller();
+	// destructor
+	~OcclusionCuller();
+
+	// set the number of objects, which forgets all results
+	void Resize(int objectCount);
+	// forget the results of a range of objects, whose indices
+	// now hold other objects
+	void ResetRange(int firstObject, int objectCount);
+	// read the results of the queries that are answered
+	void ReadResults();
+	// start a new frame for spreading out the queries
+	void BeginFrame();
+
+	// check whether an object in the view frustum was hidden
+	// at its last query, which also records that it was in
+	// the frustum in this frame
+	bool CheckOccluded(int objectIndex);
+	// check whether the query of an object should be issued in
+	// this frame - hidden objects are queried every frame, and
+	// visible objects every few frames
+	bool NeedsQuery(int objectIndex) const;
+	// mark an object visible without a query, such as when the
+	// camera is inside of its box
+	void SetVisible(int objectIndex);
+
+	// surround the draw of the box of an object with its query
+	void BeginQuery(int objectIndex);
+	void EndQuery();
+
+	// get the number of queries issued in this frame
+	int GetQueryCount() const;
+
+private:
+	// the query state of one object
+	struct OBJECT_QUERY
+	{
+		GLuint query;
+		// true while the query waits for its result
+		bool bPending;
+		// true when the object was hidden at its last result
+		bool bOccluded;
+		// last frame the object was in the view frustum
+		int lastFrame;
+	};
+
+	std::vector<OBJECT_QUERY> m_objects;
+	// counter used for spreading the queries of the visible
+	// objects over several frames
+	int m_frameNumber;
+	int m_queryCount;
+	// GL_ANY_SAMPLES_PASSED_CONSERVATIVE when supported
+	GLenum m_queryTarget;
+
+	// free the query objects
+	void DeleteQueries();
+};
@@ -0,0 +1,221 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertarget.cpp
+// ============
+// manage an offscreen framebuffer that the 3D scene can be rendered into
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderTarget.h"
+
+#include <algorithm>
+#include <iostream>
+
+/***********************************************************
+ *  RenderTarget()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderTarget::RenderTarget()
+{
+	m_framebuffer = 0;
+	m_colorTexture = 0;
+	m_depthBuffer = 0;
+	m_width = 0;
+	m_height = 0;
+	m_viewWidth = 0;
+	m_viewHeight = 0;
+}
+
+/***********************************************************
+ *  ~RenderTarget()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderTarget::~RenderTarget()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the framebuffer with an
+ *  RGBA8 color texture and a 24 bit depth buffer of the
+ *  passed in size.  The whole framebuffer is the view.
+ ***********************************************************/
+bool RenderTarget::Create(int width, int height)
+{
+	Destroy();
+
+	glGenTextures(1, &m_colorTexture);
+	glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Could not create the " << width << "x" << height
+			<< " render target, status:" << status << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_width = width;
+	m_height = height;
+	m_viewWidth = width;
+	m_viewHeight = height;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the framebuffer and its
+ *  buffers.
+ ***********************************************************/
+void RenderTarget::Destroy()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (m_depthBuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_depthBuffer = 0;
+	}
+	if (m_colorTexture != 0)
+	{
+		glDeleteTextures(1, &m_colorTexture);
+		m_colorTexture = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+	m_viewWidth = 0;
+	m_viewHeight = 0;
+}
+
+/***********************************************************
+ *  SetViewSize()
+ *
+ *  This method is used for setting the size of the corner of
+ *  the framebuffer that the next renders fill.
+ ***********************************************************/
+void RenderTarget::SetViewSize(int width, int height)
+{
+	m_viewWidth = std::min(std::max(width, 1), m_width);
+	m_viewHeight = std::min(std::max(height, 1), m_height);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for directing the rendering into the
+ *  view of the framebuffer.
+ ***********************************************************/
+void RenderTarget::Bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_viewWidth, m_viewHeight);
+}
+
+/***********************************************************
+ *  BindDefault()
+ *
+ *  This method is used for directing the rendering back into
+ *  the window with the passed in size.
+ ***********************************************************/
+void RenderTarget::BindDefault(int width, int height)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, width, height);
+}
+
+/***********************************************************
+ *  BlitToDefault()
+ *
+ *  This method is used for copying the rendered view into
+ *  the window, scaled to the passed in window size, which is
+ *  then the target of the rendering.
+ ***********************************************************/
+void RenderTarget::BlitToDefault(int width, int height) const
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, m_viewWidth, m_viewHeight, 0, 0, width, height,
+		GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	BindDefault(width, height);
+}
+
+/***********************************************************
+ *  GetWidth()
+ *
+ *  This method is used for getting the width of the
+ *  framebuffer.
+ ***********************************************************/
+int RenderTarget::GetWidth() const
+{
+	return(m_width);
+}
+
+/***********************************************************
+ *  GetHeight()
+ *
+ *  This method is used for getting the height of the
+ *  framebuffer.
+ ***********************************************************/
+int RenderTarget::GetHeight() const
+{
+	return(m_height);
+}
+
+/***********************************************************
+ *  GetColorTexture()
+ *
+ *  This method is used for getting the OpenGL texture that
+ *  holds the rendered colors.
+ ***********************************************************/
+GLuint RenderTarget::GetColorTexture() const
+{
+	return(m_colorTexture);
+}
+
+/***********************************************************
+ *  GetViewWidth()
+ *
+ *  This method is used for getting the width of the
+ *  rendered view.
+ ***********************************************************/
+int RenderTarget::GetViewWidth() const
+{
+	return(m_viewWidth);
+}
+
+/***********************************************************
+ *  GetViewHeight()
+ *
+ *  This method is used for getting the height of the
+ *  rendered view.
+ ***********************************************************/
+int RenderTarget::GetViewHeight() const
+{
+	return(m_viewHeight);
+}
@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertarget.h
+// ============
+// manage an offscreen framebuffer that the 3D scene can be rendered into
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  RenderTarget
+ *
+ *  This class contains the code for creating a framebuffer
+ *  object with a color texture and a depth buffer, and for
+ *  directing the rendering into it.  The rendering can be
+ *  limited to a corner of the framebuffer, so that the
+ *  resolution can change every frame without creating the
+ *  buffers again, and that corner can be stretched over the
+ *  window.
+ ***********************************************************/
+class RenderTarget
+{
+public:
+	// constructor
+	RenderTarget();
+	// destructor
+	~RenderTarget();
+
+	// create the framebuffer with the passed in size, which
+	// replaces the buffers of an earlier size
+	bool Create(int width, int height);
+	// free the framebuffer and its buffers
+	void Destroy();
+
+	// set the size of the corner of the framebuffer that is
+	// rendered into, which is limited to the framebuffer size
+	void SetViewSize(int width, int height);
+	// direct the rendering into the framebuffer and set the
+	// viewport to the view size
+	void Bind() const;
+	// direct the rendering back into the window
+	static void BindDefault(int width, int height);
+	// stretch the rendered view over the window with the passed
+	// in size, with linear filtering
+	void BlitToDefault(int width, int height) const;
+
+	// get the size of the framebuffer
+	int GetWidth() const;
+	int GetHeight() const;
+	// get the size of the rendered view
+	int GetViewWidth() const;
+	int GetViewHeight() const;
+	// get the OpenGL texture holding the rendered colors
+	GLuint GetColorTexture() const;
+
+private:
+	GLuint m_framebuffer;
+	GLuint m_colorTexture;
+	GLuint m_depthBuffer;
+	int m_width;
+	int m_height;
+	int m_viewWidth;
+	int m_viewHeight;
+};
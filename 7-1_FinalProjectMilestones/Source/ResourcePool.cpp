@@ -0,0 +1,298 @@
+///////////////////////////////////////////////////////////////////////////////
+// resourcepool.cpp
+// ============
+// hand out the OpenGL buffers and textures of the 3D scene, and keep the
+// released ones for reuse so that reloading the scene does not grow memory
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ResourcePool.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// the smallest size class of the buffers - the larger ones
+	// are the powers of two above it
+	const GLsizeiptr g_MinBufferCapacity = 4096;
+	// bytes of released buffers and textures kept by default
+	const GLsizeiptr g_DefaultFreeBudget = 64 * 1024 * 1024;
+
+	/***********************************************************
+	 *  GetSizeClass()
+	 *
+	 *  This function is used for rounding a buffer size up to
+	 *  the capacity of its size class, so that buffers which
+	 *  grow a little between loads can still be reused.
+	 ***********************************************************/
+	GLsizeiptr GetSizeClass(GLsizeiptr size)
+	{
+		GLsizeiptr capacity = g_MinBufferCapacity;
+		while (capacity < size)
+		{
+			capacity *= 2;
+		}
+		return(capacity);
+	}
+}
+
+/***********************************************************
+ *  ResourcePool()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ResourcePool::ResourcePool()
+{
+	m_liveBufferBytes = 0;
+	m_liveTextureBytes = 0;
+	m_freeBytes = 0;
+	m_freeBudget = g_DefaultFreeBudget;
+}
+
+/***********************************************************
+ *  ~ResourcePool()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ResourcePool::~ResourcePool()
+{
+	Trim();
+
+	// the owners release everything before the pool goes away,
+	// so anything left here would have leaked
+	if ((m_liveBuffers.empty() == false) || (m_liveTextures.empty() == false))
+	{
+		std::cout << "Resource pool: " << m_liveBuffers.size() << " buffers and "
+			<< m_liveTextures.size() << " textures were never released" << std::endl;
+	}
+	for (std::unordered_map<GLuint, BUFFER_ENTRY>::iterator it = m_liveBuffers.begin();
+		it != m_liveBuffers.end(); ++it)
+	{
+		glDeleteBuffers(1, &it->second.bufferID);
+	}
+	for (std::unordered_map<GLuint, TEXTURE_ENTRY>::iterator it = m_liveTextures.begin();
+		it != m_liveTextures.end(); ++it)
+	{
+		glDeleteTextures(1, &it->second.textureID);
+	}
+	m_liveBuffers.clear();
+	m_liveTextures.clear();
+}
+
+/***********************************************************
+ *  AcquireBuffer()
+ *
+ *  This method is used for getting a buffer with room for at
+ *  least the passed in number of bytes.  A released buffer of
+ *  the same size class and usage is taken when there is one,
+ *  otherwise a new one is allocated for the whole class.  The
+ *  copy target is used for the allocation so that the element
+ *  buffer of the bound vertex array is left alone.
+ ***********************************************************/
+GLuint ResourcePool::AcquireBuffer(GLsizeiptr size, GLenum usage, GLsizeiptr* pCapacity)
+{
+	BUFFER_ENTRY entry = { 0, GetSizeClass(size), usage };
+
+	for (size_t i = 0; i < m_freeBuffers.size(); i++)
+	{
+		if ((m_freeBuffers[i].capacity == entry.capacity) && (m_freeBuffers[i].usage == usage))
+		{
+			entry = m_freeBuffers[i];
+			m_freeBuffers.erase(m_freeBuffers.begin() + i);
+			m_freeBytes -= entry.capacity;
+			break;
+		}
+	}
+
+	if (entry.bufferID == 0)
+	{
+		glGenBuffers(1, &entry.bufferID);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, entry.bufferID);
+		glBufferData(GL_COPY_WRITE_BUFFER, entry.capacity, NULL, usage);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	m_liveBuffers[entry.bufferID] = entry;
+	m_liveBufferBytes += entry.capacity;
+
+	if (pCapacity != NULL)
+	{
+		*pCapacity = entry.capacity;
+	}
+
+	return(entry.bufferID);
+}
+
+/***********************************************************
+ *  ReleaseBuffer()
+ *
+ *  This method is used for giving a buffer back to the pool.
+ *  Handles that did not come from the pool are ignored.
+ ***********************************************************/
+void ResourcePool::ReleaseBuffer(GLuint bufferID)
+{
+	std::unordered_map<GLuint, BUFFER_ENTRY>::iterator found = m_liveBuffers.find(bufferID);
+	if (found == m_liveBuffers.end())
+	{
+		return;
+	}
+
+	BUFFER_ENTRY entry = found->second;
+	m_liveBuffers.erase(found);
+	m_liveBufferBytes -= entry.capacity;
+
+	m_freeBuffers.push_back(entry);
+	m_freeBytes += entry.capacity;
+	EnforceFreeBudget();
+}
+
+/***********************************************************
+ *  AcquireTexture()
+ *
+ *  This method is used for getting a texture with the passed
+ *  in layout.  A released texture is only taken when it has
+ *  the same target, format, size and number of levels, so its
+ *  storage can be written again without allocating it.
+ ***********************************************************/
+GLuint ResourcePool::AcquireTexture(const TEXTURE_DESC& desc, bool& bReused)
+{
+	TEXTURE_ENTRY entry = { 0, desc };
+
+	bReused = false;
+	for (size_t i = 0; i < m_freeTextures.size(); i++)
+	{
+		const TEXTURE_DESC& freeDesc = m_freeTextures[i].desc;
+		if ((freeDesc.target == desc.target) &&
+			(freeDesc.internalFormat == desc.internalFormat) &&
+			(freeDesc.width == desc.width) &&
+			(freeDesc.height == desc.height) &&
+			(freeDesc.depth == desc.depth) &&
+			(freeDesc.levelCount == desc.levelCount))
+		{
+			entry.textureID = m_freeTextures[i].textureID;
+			m_freeBytes -= freeDesc.byteSize;
+			m_freeTextures.erase(m_freeTextures.begin() + i);
+			bReused = true;
+			break;
+		}
+	}
+
+	if (entry.textureID == 0)
+	{
+		glGenTextures(1, &entry.textureID);
+	}
+
+	m_liveTextures[entry.textureID] = entry;
+	m_liveTextureBytes += desc.byteSize;
+
+	return(entry.textureID);
+}
+
+/***********************************************************
+ *  ReleaseTexture()
+ *
+ *  This method is used for giving a texture back to the pool.
+ *  Handles that did not come from the pool are ignored.
+ ***********************************************************/
+void ResourcePool::ReleaseTexture(GLuint textureID)
+{
+	std::unordered_map<GLuint, TEXTURE_ENTRY>::iterator found = m_liveTextures.find(textureID);
+	if (found == m_liveTextures.end())
+	{
+		return;
+	}
+
+	TEXTURE_ENTRY entry = found->second;
+	m_liveTextures.erase(found);
+	m_liveTextureBytes -= entry.desc.byteSize;
+
+	m_freeTextures.push_back(entry);
+	m_freeBytes += entry.desc.byteSize;
+	EnforceFreeBudget();
+}
+
+/***********************************************************
+ *  Trim()
+ *
+ *  This method is used for deleting all of the released
+ *  buffers and textures, once the resources of a newly loaded
+ *  scene have all been acquired.
+ ***********************************************************/
+void ResourcePool::Trim()
+{
+	for (size_t i = 0; i < m_freeBuffers.size(); i++)
+	{
+		glDeleteBuffers(1, &m_freeBuffers[i].bufferID);
+	}
+	for (size_t i = 0; i < m_freeTextures.size(); i++)
+	{
+		glDeleteTextures(1, &m_freeTextures[i].textureID);
+	}
+	m_freeBuffers.clear();
+	m_freeTextures.clear();
+	m_freeBytes = 0;
+}
+
+/***********************************************************
+ *  SetFreeBudget()
+ *
+ *  This method is used for setting the bytes of released
+ *  buffers and textures that are kept for reuse.
+ ***********************************************************/
+void ResourcePool::SetFreeBudget(GLsizeiptr budgetBytes)
+{
+	m_freeBudget = budgetBytes;
+	EnforceFreeBudget();
+}
+
+/***********************************************************
+ *  EnforceFreeBudget()
+ *
+ *  This method is used for deleting the released resources,
+ *  the oldest first, until the kept ones fit in the budget.
+ ***********************************************************/
+void ResourcePool::EnforceFreeBudget()
+{
+	while ((m_freeBytes > m_freeBudget) && (m_freeBuffers.empty() == false))
+	{
+		glDeleteBuffers(1, &m_freeBuffers[0].bufferID);
+		m_freeBytes -= m_freeBuffers[0].capacity;
+		m_freeBuffers.erase(m_freeBuffers.begin());
+	}
+	while ((m_freeBytes > m_freeBudget) && (m_freeTextures.empty() == false))
+	{
+		glDeleteTextures(1, &m_freeTextures[0].textureID);
+		m_freeBytes -= m_freeTextures[0].desc.byteSize;
+		m_freeTextures.erase(m_freeTextures.begin());
+	}
+}
+
+/***********************************************************
+ *  GetStats()
+ *
+ *  This method is used for getting the number and the size
+ *  of the buffers and textures in use and kept for reuse.
+ ***********************************************************/
+ResourcePool::POOL_STATS ResourcePool::GetStats() const
+{
+	POOL_STATS stats;
+
+	stats.liveBuffers = m_liveBuffers.size();
+	stats.liveBufferBytes = m_liveBufferBytes;
+	stats.freeBuffers = m_freeBuffers.size();
+	stats.freeBufferBytes = 0;
+	for (size_t i = 0; i < m_freeBuffers.size(); i++)
+	{
+		stats.freeBufferBytes += m_freeBuffers[i].capacity;
+	}
+	stats.liveTextures = m_liveTextures.size();
+	stats.liveTextureBytes = m_liveTextureBytes;
+	stats.freeTextures = m_freeTextures.size();
+	stats.freeTextureBytes = 0;
+	for (size_t i = 0; i < m_freeTextures.size(); i++)
+	{
+		stats.freeTextureBytes += m_freeTextures[i].desc.byteSize;
+	}
+
+	return(stats);
+}
@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////////////
+// resourcepool.h
+// ============
+// hand out the OpenGL buffers and textures of the 3D scene, and keep the
+// released ones for reuse so that reloading the scene does not grow memory
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  ResourcePool
+ *
+ *  This class contains the code for creating the OpenGL
+ *  buffers and textures, tracking which of them are in use,
+ *  and keeping the released ones until a request with the
+ *  same size class or layout can take them again.  The kept
+ *  ones are deleted once they pass the free budget, or when
+ *  the pool is trimmed.
+ ***********************************************************/
+class ResourcePool
+{
+public:
+	// constructor
+	ResourcePool();
+	// destructor
+	~ResourcePool();
+
+	// the layout of a pooled texture, which a released texture
+	// has to match exactly to be reused
+	struct TEXTURE_DESC
+	{
+		GLenum target;
+		GLenum internalFormat;
+		int width;
+		int height;
+		int depth;
+		int levelCount;
+		// size of all of the levels, for the statistics only
+		GLsizeiptr byteSize;
+	};
+
+	// the memory held by the pool
+	struct POOL_STATS
+	{
+		int liveBuffers;
+		GLsizeiptr liveBufferBytes;
+		int freeBuffers;
+		GLsizeiptr freeBufferBytes;
+		int liveTextures;
+		GLsizeiptr liveTextureBytes;
+		int freeTextures;
+		GLsizeiptr freeTextureBytes;
+	};
+
+	// get a buffer with room for at least the passed in number of
+	// bytes, allocated with the usage hint - the contents of a
+	// reused buffer are undefined, and the capacity is returned
+	GLuint AcquireBuffer(GLsizeiptr size, GLenum usage, GLsizeiptr* pCapacity = NULL);
+	// give a buffer back to the pool, which may keep it for reuse
+	void ReleaseBuffer(GLuint bufferID);
+
+	// get a texture with the passed in layout - the storage of the
+	// levels only needs to be allocated by the caller when the
+	// texture is new, which is returned in bReused
+	GLuint AcquireTexture(const TEXTURE_DESC& desc, bool& bReused);
+	// give a texture back to the pool, which may keep it for reuse
+	void ReleaseTexture(GLuint textureID);
+
+	// delete all of the released buffers and textures
+	void Trim();
+	// set the bytes of released buffers and textures kept for reuse
+	void SetFreeBudget(GLsizeiptr budgetBytes);
+	// get the memory held by the pool
+	POOL_STATS GetStats() const;
+
+private:
+	struct BUFFER_ENTRY
+	{
+		GLuint bufferID;
+		GLsizeiptr capacity;
+		GLenum usage;
+	};
+	struct TEXTURE_ENTRY
+	{
+		GLuint textureID;
+		TEXTURE_DESC desc;
+	};
+
+	// the handed out buffers and textures by their handles
+	std::unordered_map<GLuint, BUFFER_ENTRY> m_liveBuffers;
+	std::unordered_map<GLuint, TEXTURE_ENTRY> m_liveTextures;
+	// the released ones, the oldest first
+	std::vector<BUFFER_ENTRY> m_freeBuffers;
+	std::vector<TEXTURE_ENTRY> m_freeTextures;
+
+	GLsizeiptr m_liveBufferBytes;
+	GLsizeiptr m_liveTextureBytes;
+	GLsizeiptr m_freeBytes;
+	GLsizeiptr m_freeBudget;
+
+	// delete the oldest released resources until the free budget
+	// is kept
+	void EnforceFreeBudget();
+};
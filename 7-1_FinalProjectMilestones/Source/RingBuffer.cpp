@@ -0,0 +1,276 @@
+///////////////////////////////////////////////////////////////////////////////
+// ringbuffer.cpp
+// ============
+// stream the per-frame data into the sections of one persistently mapped
+// buffer, which the CPU writes while the GPU reads the previous frames
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RingBuffer.h"
+
+#include <cstddef>
+
+// declaration of global variables
+namespace
+{
+	// nanoseconds waited for a fence before checking again
+	const GLuint64 g_FenceWaitTimeout = 1000000;
+	// flags of the persistent mapping
+	const GLbitfield g_MapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+}
+
+/***********************************************************
+ *  RingBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RingBuffer::RingBuffer(GLenum target, GLsizeiptr sectionSize)
+{
+	m_target = target;
+	m_bufferID = 0;
+	m_sectionSize = sectionSize;
+	m_section = 0;
+	m_sectionUsed = 0;
+	m_pMapped = NULL;
+	m_flushStart = 0;
+	m_flushEnd = 0;
+	for (int i = 0; i < SECTION_COUNT; i++)
+	{
+		m_fences[i] = 0;
+	}
+
+	CreateBuffer();
+}
+
+/***********************************************************
+ *  ~RingBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RingBuffer::~RingBuffer()
+{
+	DestroyBuffer();
+}
+
+/***********************************************************
+ *  CreateBuffer()
+ *
+ *  This method is used for creating the buffer with room for
+ *  all of the sections.  With buffer storage it is mapped once
+ *  and stays mapped, and the coherent mapping makes the writes
+ *  visible to the GPU without flushing them.
+ ***********************************************************/
+void RingBuffer::CreateBuffer()
+{
+	GLsizeiptr bufferSize = m_sectionSize * SECTION_COUNT;
+
+	glGenBuffers(1, &m_bufferID);
+	glBindBuffer(m_target, m_bufferID);
+	if ((GLEW_VERSION_4_4 == GL_TRUE) || (GLEW_ARB_buffer_storage == GL_TRUE))
+	{
+		glBufferStorage(m_target, bufferSize, NULL, g_MapFlags);
+		m_pMapped = (char*)glMapBufferRange(m_target, 0, bufferSize, g_MapFlags);
+	}
+	if (m_pMapped == NULL)
+	{
+		glBufferData(m_target, bufferSize, NULL, GL_STREAM_DRAW);
+		m_staging.resize(bufferSize);
+	}
+	glBindBuffer(m_target, 0);
+
+	m_section = 0;
+	m_sectionUsed = 0;
+	m_flushStart = 0;
+	m_flushEnd = 0;
+}
+
+/***********************************************************
+ *  DestroyBuffer()
+ *
+ *  This method is used for unmapping and freeing the buffer
+ *  and the fences of its sections.
+ ***********************************************************/
+void RingBuffer::DestroyBuffer()
+{
+	for (int i = 0; i < SECTION_COUNT; i++)
+	{
+		if (m_fences[i] != 0)
+		{
+			glDeleteSync(m_fences[i]);
+			m_fences[i] = 0;
+		}
+	}
+
+	if (m_bufferID != 0)
+	{
+		if (m_pMapped != NULL)
+		{
+			glBindBuffer(m_target, m_bufferID);
+			glUnmapBuffer(m_target);
+			glBindBuffer(m_target, 0);
+		}
+		glDeleteBuffers(1, &m_bufferID);
+	}
+
+	m_bufferID = 0;
+	m_pMapped = NULL;
+	m_staging.clear();
+}
+
+/***********************************************************
+ *  WaitForSection()
+ *
+ *  This method is used for waiting until the GPU has run the
+ *  commands reading a section, which only blocks when the CPU
+ *  is a whole ring of frames ahead.
+ ***********************************************************/
+void RingBuffer::WaitForSection(int section)
+{
+	if (m_fences[section] == 0)
+	{
+		return;
+	}
+
+	GLenum result = GL_TIMEOUT_EXPIRED;
+	while ((result != GL_ALREADY_SIGNALED) &&
+		(result != GL_CONDITION_SATISFIED) &&
+		(result != GL_WAIT_FAILED))
+	{
+		result = glClientWaitSync(m_fences[section], GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceWaitTimeout);
+	}
+
+	glDeleteSync(m_fences[section]);
+	m_fences[section] = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting to write the next
+ *  section.  All of the commands reading the section written
+ *  before have been submitted by now, so its fence is placed
+ *  here, and the next section is only written once the GPU is
+ *  done with it.
+ ***********************************************************/
+void RingBuffer::BeginFrame()
+{
+	if (m_sectionUsed > 0)
+	{
+		m_fences[m_section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_section = (m_section + 1) % SECTION_COUNT;
+	}
+
+	WaitForSection(m_section);
+	m_sectionUsed = 0;
+	m_flushStart = m_section * m_sectionSize;
+	m_flushEnd = m_flushStart;
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for getting room in the current
+ *  section for the passed in number of bytes.  The returned
+ *  address is written directly, and the offset is where the
+ *  data is in the buffer for the draws reading it.
+ ***********************************************************/
+void* RingBuffer::Allocate(GLsizeiptr dataSize, GLsizeiptr alignment, GLintptr& offset)
+{
+	GLintptr sectionStart = m_section * m_sectionSize;
+	GLintptr start = sectionStart + m_sectionUsed;
+
+	if (alignment > 1)
+	{
+		start = ((start + alignment - 1) / alignment) * alignment;
+	}
+	if ((start + dataSize) > (sectionStart + m_sectionSize))
+	{
+		return(NULL);
+	}
+
+	m_sectionUsed = (start + dataSize) - sectionStart;
+	m_flushEnd = start + dataSize;
+	offset = start;
+
+	if (m_pMapped != NULL)
+	{
+		return(m_pMapped + start);
+	}
+
+	return(&m_staging[start]);
+}
+
+/***********************************************************
+ *  Flush()
+ *
+ *  This method is used for making the written data visible
+ *  to the GPU.  The persistent mapping is coherent, so only
+ *  the copy written without buffer storage is uploaded here.
+ ***********************************************************/
+void RingBuffer::Flush()
+{
+	if ((m_pMapped != NULL) || (m_flushEnd <= m_flushStart))
+	{
+		m_flushStart = m_flushEnd;
+		return;
+	}
+
+	glBindBuffer(m_target, m_bufferID);
+	glBufferSubData(m_target, m_flushStart, m_flushEnd - m_flushStart, &m_staging[m_flushStart]);
+	glBindBuffer(m_target, 0);
+	m_flushStart = m_flushEnd;
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used for growing the sections when the data
+ *  of a frame does not fit.  Every section is waited for and
+ *  the buffer is created again, so this is only expected while
+ *  the amount of data per frame settles.
+ ***********************************************************/
+bool RingBuffer::Reserve(GLsizeiptr sectionSize)
+{
+	if (sectionSize <= m_sectionSize)
+	{
+		return(false);
+	}
+
+	for (int i = 0; i < SECTION_COUNT; i++)
+	{
+		WaitForSection(i);
+	}
+	DestroyBuffer();
+
+	// double the size, so that growing one frame at a time does
+	// not create the buffer again every frame
+	m_sectionSize = (m_sectionSize > 0) ? m_sectionSize : sectionSize;
+	while (m_sectionSize < sectionSize)
+	{
+		m_sectionSize *= 2;
+	}
+	CreateBuffer();
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetBuffer()
+ *
+ *  This method is used for getting the OpenGL handle of the
+ *  buffer, which changes when the sections grow.
+ ***********************************************************/
+GLuint RingBuffer::GetBuffer() const
+{
+	return(m_bufferID);
+}
+
+/***********************************************************
+ *  GetSectionSize()
+ *
+ *  This method is used for getting the size of each section
+ *  in bytes.
+ ***********************************************************/
+GLsizeiptr RingBuffer::GetSectionSize() const
+{
+	return(m_sectionSize);
+}
@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// ringbuffer.h
+// ============
+// stream the per-frame data into the sections of one persistently mapped
+// buffer, which the CPU writes while the GPU reads the previous frames
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  RingBuffer
+ *
+ *  This class contains the code for a buffer split into three
+ *  sections that are written in turn.  A fence is placed after
+ *  the commands reading each section, and the CPU only waits
+ *  when it comes back around to a section the GPU is still
+ *  reading.  The buffer is mapped once for the whole run when
+ *  the context has buffer storage, otherwise the written data
+ *  is uploaded with one update per frame.
+ ***********************************************************/
+class RingBuffer
+{
+public:
+	// constructor
+	RingBuffer(GLenum target, GLsizeiptr sectionSize);
+	// destructor
+	~RingBuffer();
+
+	// start writing the next section, after placing the fence
+	// of the section written before
+	void BeginFrame();
+	// get room for the passed in number of bytes in the current
+	// section, at an offset that is a multiple of the passed in
+	// alignment from the start of the buffer - NULL when the
+	// section is full
+	void* Allocate(GLsizeiptr dataSize, GLsizeiptr alignment, GLintptr& offset);
+	// make the data written since BeginFrame() visible to the GPU
+	void Flush();
+	// grow the sections to at least the passed in size, which
+	// waits for the GPU and creates a new buffer - returns true
+	// when the buffer has been replaced
+	bool Reserve(GLsizeiptr sectionSize);
+
+	// get the OpenGL handle of the buffer
+	GLuint GetBuffer() const;
+	// get the size of each section in bytes
+	GLsizeiptr GetSectionSize() const;
+
+private:
+	static const int SECTION_COUNT = 3;
+
+	// OpenGL target the buffer is bound to for updates
+	GLenum m_target;
+	// OpenGL handle of the buffer
+	GLuint m_bufferID;
+	GLsizeiptr m_sectionSize;
+	// section being written and the bytes used in it
+	int m_section;
+	GLsizeiptr m_sectionUsed;
+	// fence after the last commands reading each section
+	GLsync m_fences[SECTION_COUNT];
+	// address of the mapped buffer, NULL without buffer storage
+	char* m_pMapped;
+	// CPU copy of the buffer written without buffer storage
+	std::vector<char> m_staging;
+	// range of the current section written since BeginFrame()
+	GLintptr m_flushStart;
+	GLintptr m_flushEnd;
+
+	// create and map the buffer for the current section size
+	void CreateBuffer();
+	// unmap and free the buffer and the fences
+	void DestroyBuffer();
+	// wait until the GPU has read a section
+	void WaitForSection(int section);
+};
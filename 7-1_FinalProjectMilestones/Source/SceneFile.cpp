@@ -0,0 +1,325 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// read and write the binary scene files, which are loaded by mapping them into
+// memory and reading their tables in place
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	const char g_SceneIdentifier[4] = { 'S', 'C', 'N', '1' };
+	// read back as this value only when the file has the byte
+	// order of the reader
+	const uint32_t g_SceneEndianness = 0x04030201;
+	const uint32_t g_SceneVersion = 1;
+
+	// the tables start on 8 byte boundaries of the file
+	const uint64_t g_TableAlignment = 8;
+
+	/***********************************************************
+	 *  AlignOffset()
+	 *
+	 *  This function is used for rounding a file offset up to
+	 *  the start of the next table.
+	 ***********************************************************/
+	uint64_t AlignOffset(uint64_t offset)
+	{
+		return((offset + g_TableAlignment - 1) & ~(g_TableAlignment - 1));
+	}
+
+	/***********************************************************
+	 *  WriteTable()
+	 *
+	 *  This function is used for writing a table of records at
+	 *  its offset, padding the file up to the offset first.
+	 ***********************************************************/
+	template <typename RECORD>
+	void WriteTable(std::ofstream& file, uint64_t& fileOffset, uint64_t tableOffset,
+		const std::vector<RECORD>& records)
+	{
+		const char padding[g_TableAlignment] = { 0 };
+		file.write(padding, (std::streamsize)(tableOffset - fileOffset));
+		if (records.empty() == false)
+		{
+			file.write((const char*)records.data(), (std::streamsize)(sizeof(RECORD) * records.size()));
+		}
+		fileOffset = tableOffset + sizeof(RECORD) * records.size();
+	}
+}
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	m_pHeader = NULL;
+	m_pObjects = NULL;
+	m_pMaterials = NULL;
+	m_pTextures = NULL;
+	m_pLights = NULL;
+	m_pPointLights = NULL;
+}
+
+/***********************************************************
+ *  ~SceneFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneFile::~SceneFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping a scene file and checking
+ *  its header and that every table lies inside of the file.
+ *  Nothing else is read until the tables are used, so the
+ *  time to open a file does not grow with its objects.
+ ***********************************************************/
+bool SceneFile::Open(const char* filename)
+{
+	Close();
+
+	if (m_file.Open(filename) == false)
+	{
+		return(false);
+	}
+
+	const SCENE_HEADER* pHeader = (const SCENE_HEADER*)m_file.GetData();
+	if ((m_file.GetSize() < sizeof(SCENE_HEADER)) ||
+		(memcmp(pHeader->identifier, g_SceneIdentifier, sizeof(g_SceneIdentifier)) != 0) ||
+		(pHeader->endianness != g_SceneEndianness))
+	{
+		std::cout << "Not a scene file: " << filename << std::endl;
+		Close();
+		return(false);
+	}
+
+	if (pHeader->version != g_SceneVersion)
+	{
+		std::cout << "Not implemented to handle scene file version " << pHeader->version
+			<< ": " << filename << std::endl;
+		Close();
+		return(false);
+	}
+
+	m_pObjects = (const SCENE_OBJECT*)GetTable(
+		pHeader->objectOffset, pHeader->objectCount, sizeof(SCENE_OBJECT));
+	m_pMaterials = (const SCENE_MATERIAL*)GetTable(
+		pHeader->materialOffset, pHeader->materialCount, sizeof(SCENE_MATERIAL));
+	m_pTextures = (const SCENE_TEXTURE*)GetTable(
+		pHeader->textureOffset, pHeader->textureCount, sizeof(SCENE_TEXTURE));
+	m_pLights = (const SCENE_LIGHT*)GetTable(
+		pHeader->lightOffset, pHeader->lightCount, sizeof(SCENE_LIGHT));
+	m_pPointLights = (const SCENE_POINT_LIGHT*)GetTable(
+		pHeader->pointLightOffset, pHeader->pointLightCount, sizeof(SCENE_POINT_LIGHT));
+
+	if (((NULL == m_pObjects) && (pHeader->objectCount > 0)) ||
+		((NULL == m_pMaterials) && (pHeader->materialCount > 0)) ||
+		((NULL == m_pTextures) && (pHeader->textureCount > 0)) ||
+		((NULL == m_pLights) && (pHeader->lightCount > 0)) ||
+		((NULL == m_pPointLights) && (pHeader->pointLightCount > 0)))
+	{
+		std::cout << "The scene file is damaged: " << filename << std::endl;
+		Close();
+		return(false);
+	}
+
+	m_pHeader = pHeader;
+	return(true);
+}
+
+/***********************************************************
+ *  GetTable()
+ *
+ *  This method is used for getting a table of the mapped
+ *  file.  NULL is returned when the table is empty or does
+ *  not lie on a record boundary inside of the file.
+ ***********************************************************/
+const void* SceneFile::GetTable(uint64_t offset, uint32_t count, size_t recordSize) const
+{
+	uint64_t fileSize = m_file.GetSize();
+
+	if ((count == 0) || (offset < sizeof(SCENE_HEADER)) || (offset > fileSize) ||
+		((offset % g_TableAlignment) != 0) ||
+		((uint64_t)count > (fileSize - offset) / recordSize))
+	{
+		return(NULL);
+	}
+
+	return(m_file.GetData() + offset);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the scene file, after
+ *  which the tables are no longer valid.
+ ***********************************************************/
+void SceneFile::Close()
+{
+	m_file.Close();
+	m_pHeader = NULL;
+	m_pObjects = NULL;
+	m_pMaterials = NULL;
+	m_pTextures = NULL;
+	m_pLights = NULL;
+	m_pPointLights = NULL;
+}
+
+/***********************************************************
+ *  GetObjects()
+ *
+ *  These methods are used for getting the tables of the
+ *  opened scene file and their numbers of records.
+ ***********************************************************/
+const SceneFile::SCENE_OBJECT* SceneFile::GetObjects() const
+{
+	return(m_pObjects);
+}
+
+int SceneFile::GetObjectCount() const
+{
+	return((NULL == m_pHeader) ? 0 : (int)m_pHeader->objectCount);
+}
+
+const SceneFile::SCENE_MATERIAL* SceneFile::GetMaterials() const
+{
+	return(m_pMaterials);
+}
+
+int SceneFile::GetMaterialCount() const
+{
+	return((NULL == m_pHeader) ? 0 : (int)m_pHeader->materialCount);
+}
+
+const SceneFile::SCENE_TEXTURE* SceneFile::GetTextures() const
+{
+	return(m_pTextures);
+}
+
+int SceneFile::GetTextureCount() const
+{
+	return((NULL == m_pHeader) ? 0 : (int)m_pHeader->textureCount);
+}
+
+const SceneFile::SCENE_LIGHT* SceneFile::GetLights() const
+{
+	return(m_pLights);
+}
+
+int SceneFile::GetLightCount() const
+{
+	return((NULL == m_pHeader) ? 0 : (int)m_pHeader->lightCount);
+}
+
+const SceneFile::SCENE_POINT_LIGHT* SceneFile::GetPointLights() const
+{
+	return(m_pPointLights);
+}
+
+int SceneFile::GetPointLightCount() const
+{
+	return((NULL == m_pHeader) ? 0 : (int)m_pHeader->pointLightCount);
+}
+
+/***********************************************************
+ *  GetString()
+ *
+ *  This method is used for reading a string field of a
+ *  record, which does not need to be ended inside of the
+ *  field in a damaged file.
+ ***********************************************************/
+std::string SceneFile::GetString(const char* field, int length)
+{
+	const char* end = (const char*)memchr(field, 0, length);
+	if (NULL == end)
+	{
+		end = field + length;
+	}
+
+	return(std::string(field, end));
+}
+
+/***********************************************************
+ *  SetString()
+ *
+ *  This method is used for copying a string into a field of
+ *  a record, with the rest of the field cleared.  A string
+ *  too long for the field is cut short.
+ ***********************************************************/
+bool SceneFile::SetString(char* field, int length, const std::string& value)
+{
+	memset(field, 0, length);
+
+	size_t copyLength = std::min(value.size(), (size_t)(length - 1));
+	memcpy(field, value.c_str(), copyLength);
+
+	return(copyLength == value.size());
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used for writing the passed in tables into
+ *  a scene file.  The header is followed by the tables in a
+ *  fixed order, each starting on an 8 byte boundary.
+ ***********************************************************/
+bool SceneFile::Write(const char* filename, const SCENE_CONTENTS& contents)
+{
+	SCENE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.identifier, g_SceneIdentifier, sizeof(g_SceneIdentifier));
+	header.endianness = g_SceneEndianness;
+	header.version = g_SceneVersion;
+	header.objectCount = (uint32_t)contents.objects.size();
+	header.materialCount = (uint32_t)contents.materials.size();
+	header.textureCount = (uint32_t)contents.textures.size();
+	header.lightCount = (uint32_t)contents.lights.size();
+	header.pointLightCount = (uint32_t)contents.pointLights.size();
+
+	header.objectOffset = AlignOffset(sizeof(SCENE_HEADER));
+	header.materialOffset = AlignOffset(header.objectOffset +
+		sizeof(SCENE_OBJECT) * contents.objects.size());
+	header.textureOffset = AlignOffset(header.materialOffset +
+		sizeof(SCENE_MATERIAL) * contents.materials.size());
+	header.lightOffset = AlignOffset(header.textureOffset +
+		sizeof(SCENE_TEXTURE) * contents.textures.size());
+	header.pointLightOffset = AlignOffset(header.lightOffset +
+		sizeof(SCENE_LIGHT) * contents.lights.size());
+
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "Could not write the scene file " << filename << std::endl;
+		return(false);
+	}
+
+	file.write((const char*)&header, sizeof(header));
+	uint64_t fileOffset = sizeof(header);
+	WriteTable(file, fileOffset, header.objectOffset, contents.objects);
+	WriteTable(file, fileOffset, header.materialOffset, contents.materials);
+	WriteTable(file, fileOffset, header.textureOffset, contents.textures);
+	WriteTable(file, fileOffset, header.lightOffset, contents.lights);
+	WriteTable(file, fileOffset, header.pointLightOffset, contents.pointLights);
+
+	if (!file)
+	{
+		std::cout << "Could not write the scene file " << filename << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// read and write the binary scene files, which are loaded by mapping them into
+// memory and reading their tables in place
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class contains the code for the binary scene file
+ *  format.  A file is a fixed header followed by tables of
+ *  fixed size records - the objects, their materials and
+ *  textures, and the light sources.  The records are plain
+ *  values in the byte order of the writer, so an opened file
+ *  is only checked and its tables are used straight from the
+ *  mapped memory, without parsing or copying the objects.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// constructor
+	SceneFile();
+	// destructor
+	~SceneFile();
+
+	// the longest texture filename and tag, including the end
+	// of the string
+	static const int FILENAME_LENGTH = 96;
+	static const int TAG_LENGTH = 32;
+
+	// one object of the scene - 72 bytes
+	struct SCENE_OBJECT
+	{
+		// the mesh identifier of the scene manager
+		int32_t mesh;
+		// index into the texture table, -1 when the object is
+		// drawn with its color
+		int32_t textureIndex;
+		// index into the material table, -1 for no material
+		int32_t materialIndex;
+		float scale[3];
+		float rotationDegrees[3];
+		float position[3];
+		float color[4];
+		float uvScale[2];
+	};
+
+	// one object material - 76 bytes
+	struct SCENE_MATERIAL
+	{
+		float ambientStrength;
+		float ambientColor[3];
+		float diffuseColor[3];
+		float specularColor[3];
+		float shininess;
+		char tag[TAG_LENGTH];
+	};
+
+	// one texture image file - 128 bytes
+	struct SCENE_TEXTURE
+	{
+		char filename[FILENAME_LENGTH];
+		char tag[TAG_LENGTH];
+	};
+
+	// one of the fixed light sources - 56 bytes
+	struct SCENE_LIGHT
+	{
+		float position[3];
+		float ambientColor[3];
+		float diffuseColor[3];
+		float specularColor[3];
+		float focalStrength;
+		float specularIntensity;
+	};
+
+	// one point light - 32 bytes
+	struct SCENE_POINT_LIGHT
+	{
+		float position[3];
+		float radius;
+		float color[3];
+		float specularIntensity;
+	};
+
+	// the tables written into a scene file
+	struct SCENE_CONTENTS
+	{
+		std::vector<SCENE_OBJECT> objects;
+		std::vector<SCENE_MATERIAL> materials;
+		std::vector<SCENE_TEXTURE> textures;
+		std::vector<SCENE_LIGHT> lights;
+		std::vector<SCENE_POINT_LIGHT> pointLights;
+	};
+
+	// map a scene file and check that its tables fit inside it
+	bool Open(const char* filename);
+	// unmap the scene file
+	void Close();
+
+	// get the tables of the opened file, which point into the
+	// mapped memory and are valid until the file is closed
+	const SCENE_OBJECT* GetObjects() const;
+	int GetObjectCount() const;
+	const SCENE_MATERIAL* GetMaterials() const;
+	int GetMaterialCount() const;
+	const SCENE_TEXTURE* GetTextures() const;
+	int GetTextureCount() const;
+	const SCENE_LIGHT* GetLights() const;
+	int GetLightCount() const;
+	const SCENE_POINT_LIGHT* GetPointLights() const;
+	int GetPointLightCount() const;
+
+	// get a string field of a record, which is cut at the field
+	// length when it is not ended
+	static std::string GetString(const char* field, int length);
+	// copy a string into a field of a record, returning false
+	// when it had to be cut short
+	static bool SetString(char* field, int length, const std::string& value);
+
+	// write the tables into a scene file
+	static bool Write(const char* filename, const SCENE_CONTENTS& contents);
+
+private:
+	// the header at the start of a scene file - 72 bytes
+	struct SCENE_HEADER
+	{
+		char identifier[4];
+		uint32_t endianness;
+		uint32_t version;
+		uint32_t objectCount;
+		uint32_t materialCount;
+		uint32_t textureCount;
+		uint32_t lightCount;
+		uint32_t pointLightCount;
+		// byte offsets of the tables from the start of the file
+		uint64_t objectOffset;
+		uint64_t materialOffset;
+		uint64_t textureOffset;
+		uint64_t lightOffset;
+		uint64_t pointLightOffset;
+	};
+
+	// get a table of the mapped file after checking that it fits
+	const void* GetTable(uint64_t offset, uint32_t count, size_t recordSize) const;
+
+	MappedFile m_file;
+	const SCENE_HEADER* m_pHeader;
+	const SCENE_OBJECT* m_pObjects;
+	const SCENE_MATERIAL* m_pMaterials;
+	const SCENE_TEXTURE* m_pTextures;
+	const SCENE_LIGHT* m_pLights;
+	const SCENE_POINT_LIGHT* m_pPointLights;
+};
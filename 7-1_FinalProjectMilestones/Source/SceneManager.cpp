@@ -8,6 +8,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "TextureCooker.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -15,6 +16,15 @@
 #endif
 
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
 
 // declaration of global variables
 namespace
@@ -24,6 +34,156 @@ namespace
 	const char* g_TextureValueName = "objectTexture";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	const char* g_UseClusteredLightsName = "bUseClusteredLights";
+	const char* g_UseInstancingName = "bUseInstancing";
+	const char* g_UseStaticBatchName = "bUseStaticBatch";
+	const char* g_DepthOnlyName = "bDepthOnly";
+	const char* g_MaterialIndexName = "materialIndex";
+	const char* g_UVScaleName = "UVscale";
+	const char* g_TextureLayerName = "textureLayer";
+	const char* g_LightViewProjectionName = "lightViewProjection";
+	const char* g_UseShadowsName = "bUseShadows";
+	const char* g_StaticShadowMapsName = "staticShadowMaps";
+	const char* g_DynamicShadowMapsName = "dynamicShadowMaps";
+	const char* g_SunShadowMapsName = "sunShadowMaps";
+	const char* g_DynamicSunShadowMapsName = "dynamicSunShadowMaps";
+
+	// this needs to match MAX_MATERIALS in the fragment shader
+	const int g_MaxMaterials = 256;
+
+	// the most decoded images uploaded into textures per frame
+	const int g_MaxTextureUploadsPerFrame = 2;
+
+	// bytes of the frame arena before the first frames grow it
+	const size_t g_FrameArenaBytes = 256 * 1024;
+
+	// the texture image files used by the 3D scene - these are
+	// also the files cooked by CookSceneTextures()
+	struct SCENE_TEXTURE
+	{
+		const char* filename;
+		const char* tag;
+	};
+	const SCENE_TEXTURE g_SceneTextures[] = {
+		// brick texture
+		{ "textures/Brick.jpg", "brick" },
+		// regular wood texture
+		{ "textures/Wood Test.jpg", "wood" },
+		// stucco texture
+		{ "textures/Wall.jpg", "wall" },
+		// grass texture
+		{ "textures/Grass.jpg", "grass" },
+		// cement texture
+		{ "textures/PatternCement.jpeg", "cement" },
+		// light tan beam texture
+		{ "textures/LightTan.jpg", "beam" },
+		// front door texture
+		{ "textures/door.jpg", "door" },
+		// outside industrial green texture
+		{ "textures/outergreen.jpg", "outergreen" },
+		// smooth concrete texture
+		{ "textures/concrete.jpeg", "concrete" },
+		// black roof texture
+		{ "textures/roof.jpg", "roof" },
+		// window texture
+		{ "textures/glass.jpg", "window" },
+		// garage door texture
+		{ "textures/garagedoor.jpg", "garage" } };
+	const int g_SceneTextureCount = sizeof(g_SceneTextures) / sizeof(g_SceneTextures[0]);
+
+	// the meshes that a binary scene file object can name
+	const int g_MeshTypeCount = 5;
+
+	// the memory of one object of a streamed world - its render
+	// item and its share of the spatial index of its slot
+	const size_t g_StreamedItemBytes = sizeof(SceneManager::RENDER_ITEM) + 64;
+	// the cells ahead of the camera within this many seconds of
+	// its movement are loaded before it reaches them
+	const float g_StreamPrefetchSeconds = 2.0f;
+
+	// distance between the copies of the 3D scene when it is
+	// tiled, which leaves a gap between the ground planes
+	const glm::vec3 g_TileSpacing = glm::vec3(42.0f, 0.0f, 22.0f);
+
+	// the boxes drawn for the occlusion queries are grown by this
+	// part of their size plus this distance, so that the box of
+	// a visible object is never hidden by the object itself
+	const float g_OcclusionBoxGrowth = 0.01f;
+	const float g_OcclusionBoxMargin = 0.01f;
+
+	// the part of the view height covered by the bounding sphere
+	// of an object below which the next coarser level of detail
+	// is used, and the margin around these that an object needs
+	// to cross before it changes level again
+	const float g_LodScreenSizes[] = { 0.08f, 0.03f, 0.012f };
+	const int g_LodScreenSizeCount = sizeof(g_LodScreenSizes) / sizeof(g_LodScreenSizes[0]);
+	const float g_LodHysteresis = 0.15f;
+
+	// number of render items in each job of the loops that are
+	// spread over the job system
+	const int g_JobRangeSize = 256;
+
+	// shaders of the program drawing the 3D scene, which the
+	// specialized variants are built from as well
+	const char* g_VertexShaderFilename = "shaders/vertexShader.glsl";
+	const char* g_FragmentShaderFilename = "shaders/fragmentShader.glsl";
+	// compute shader culling the static batches on the GPU
+	const char* g_CullingShaderFilename = "shaders/cullingShader.glsl";
+	const char* g_DepthPyramidShaderFilename = "shaders/depthPyramidShader.glsl";
+	// compute shader binning the point lights into clusters
+	const char* g_LightClusterShaderFilename = "shaders/lightClusterShader.glsl";
+
+	// the point lights spread over the scene by the benchmark are
+	// placed this high above the objects, like street lamps, and
+	// light the objects within their radius
+	const float g_ScatteredLightHeight = 2.5f;
+	const float g_ScatteredLightRadius = 5.0f;
+	const glm::vec3 g_ScatteredLightColor = glm::vec3(0.6f, 0.5f, 0.35f);
+	const float g_ScatteredLightSpecular = 0.3f;
+
+	// size of the shadow maps of the light sources and of the
+	// cascades of the sun, the number of cascades and the view
+	// distance that they cover - the sun lights the objects past
+	// that distance without shadows
+	const int g_LightShadowMapSize = 1024;
+	const int g_SunShadowMapSize = 2048;
+	const int g_SunCascadeCount = 3;
+	const float g_SunShadowDistance = 60.0f;
+	// frames that a moving item needs to hold still before it
+	// casts its shadows into the cached maps again
+	const int g_DynamicSettleFrames = 120;
+	// slope and constant depth offsets of the shadow casters, which
+	// keep the lit surfaces from shadowing themselves
+	const float g_ShadowSlopeOffset = 2.0f;
+	const float g_ShadowDepthOffset = 4.0f;
+
+	// names of the profiler scopes of the draws, indexed by the
+	// mesh identifier
+	const char* g_InstancedScopeNames[] = {
+		"Draw Plane instanced", "Draw Box instanced", "Draw TaperedCylinder instanced",
+		"Draw Prism instanced", "Draw Pyramid3 instanced" };
+	const char* g_ShadowScopeNames[] = {
+		"Shadow Plane", "Shadow Box", "Shadow TaperedCylinder",
+		"Shadow Prism", "Shadow Pyramid3" };
+
+	/***********************************************************
+	 *  IsSameTable()
+	 *
+	 *  This function is used for checking whether a table of a
+	 *  scene file holds the same records as the copy of the
+	 *  table that was kept when the scene was loaded.
+	 ***********************************************************/
+	template <typename RECORD>
+	bool IsSameTable(const std::vector<RECORD>& kept, const RECORD* pRecords, int recordCount)
+	{
+		if (kept.size() != (size_t)recordCount)
+		{
+			return(false);
+		}
+
+		return((recordCount == 0) ||
+			(memcmp(kept.data(), pRecords, sizeof(RECORD) * recordCount) == 0));
+	}
 }
 
 /***********************************************************
@@ -31,10 +191,128 @@ namespace
  *
  *  The constructor for the class
  ***********************************************************/
-SceneManager::SceneManager(ShaderManager *pShaderManager)
+SceneManager::SceneManager(ShaderManager *pShaderManager, ShaderCache* pShaderCache)
 {
 	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
+	m_pShaderCache = pShaderCache;
+
+	// the uber shader program switches the features with its
+	// uniforms, and draws until the variants are built - its
+	// uniform blocks are connected to the shared camera, light
+	// and material buffers, and its storage blocks to the point
+	// lights and their clusters
+	GLuint programID = m_pShaderCache->GetProgram(
+		g_VertexShaderFilename, g_FragmentShaderFilename, "");
+	glUseProgram(programID);
+	UniformBuffer::BindProgramBlocks(programID);
+	ClusteredLights::BindProgramBlocks(programID);
+
+	// resolve the uniforms of the shader program once
+	m_pUniformCache = new UniformCache();
+	m_programSlot = m_pUniformCache->LoadProgramUniforms(programID);
+	m_uniforms.model = m_pUniformCache->GetHandle(g_ModelName);
+	m_uniforms.objectColor = m_pUniformCache->GetHandle(g_ColorValueName);
+	m_uniforms.objectTexture = m_pUniformCache->GetHandle(g_TextureValueName);
+	m_uniforms.bUseTexture = m_pUniformCache->GetHandle(g_UseTextureName);
+	m_uniforms.bUseLighting = m_pUniformCache->GetHandle(g_UseLightingName);
+	m_uniforms.bUseClusteredLights = m_pUniformCache->GetHandle(g_UseClusteredLightsName);
+	m_uniforms.bUseInstancing = m_pUniformCache->GetHandle(g_UseInstancingName);
+	m_uniforms.bUseStaticBatch = m_pUniformCache->GetHandle(g_UseStaticBatchName);
+	m_uniforms.bDepthOnly = m_pUniformCache->GetHandle(g_DepthOnlyName);
+	m_uniforms.UVscale = m_pUniformCache->GetHandle(g_UVScaleName);
+	m_uniforms.materialIndex = m_pUniformCache->GetHandle(g_MaterialIndexName);
+	m_uniforms.textureLayer = m_pUniformCache->GetHandle(g_TextureLayerName);
+	m_uniforms.lightViewProjection = m_pUniformCache->GetHandle(g_LightViewProjectionName);
+	m_uniforms.bUseShadows = m_pUniformCache->GetHandle(g_UseShadowsName);
+	m_uniforms.staticShadowMaps = m_pUniformCache->GetHandle(g_StaticShadowMapsName);
+	m_uniforms.dynamicShadowMaps = m_pUniformCache->GetHandle(g_DynamicShadowMapsName);
+	m_uniforms.sunShadowMaps = m_pUniformCache->GetHandle(g_SunShadowMapsName);
+	m_uniforms.dynamicSunShadowMaps = m_pUniformCache->GetHandle(g_DynamicSunShadowMapsName);
+
+	m_pResourcePool = new ResourcePool();
+	m_pFrameArena = new FrameArena(g_FrameArenaBytes);
+	m_pTextureManager = new TextureManager(m_pResourcePool);
+	m_instancedMeshes = new MeshManager(m_pResourcePool);
+	m_pMaterialBuffer = new UniformBuffer(
+		sizeof(MATERIAL_BLOCK_ENTRY) * g_MaxMaterials, UniformBuffer::MATERIAL_BINDING);
+	m_pLightBuffer = new UniformBuffer(
+		sizeof(m_lightSources), UniformBuffer::LIGHT_BINDING);
+	memset((void*)m_lightSources, 0, sizeof(m_lightSources));
+	for (int i = 0; i < UniformBuffer::TOTAL_LIGHTS; i++)
+	{
+		m_lightSources[i].shadowLayer = -1.0f;
+	}
+	m_lightSourceCount = 0;
+	m_bSceneLighting = false;
+	m_pClusteredLights = new ClusteredLights(m_pResourcePool);
+	m_bClusteredLighting = false;
+	m_scatteredLightCount = 0;
+	m_pCellStreamer = NULL;
+	m_bCellsChanged = false;
+	m_streamCellSize = 0.0f;
+	m_streamRadius = 100.0f;
+	m_streamBudgetMegabytes = 256;
+	m_slotCapacity = 0;
+	m_bDrawOrderDirty = true;
+	m_opaqueCount = 0;
+	m_bDepthPrepass = true;
+	m_bDepthOnlyPass = false;
+	for (int i = 0; i < VARIANT_COUNT; i++)
+	{
+		m_variantSlots[i] = -1;
+	}
+	m_bShaderVariants = true;
+	m_pProfiler = NULL;
+	m_pJobSystem = NULL;
+	m_tileCount = 1;
+	m_bHotReload = false;
+	m_pFileWatcher = NULL;
+	m_bFrustumCulling = true;
+	m_pOcclusionCuller = new OcclusionCuller();
+	m_bOcclusionCulling = true;
+	m_viewPosition = glm::vec3(0.0f);
+	m_lodScale = 1.0f;
+	m_projection = glm::mat4(1.0f);
+	m_pStaticBatch = new StaticBatch(m_pResourcePool);
+	m_bStaticBatching = true;
+	m_pGpuCuller = new GpuCuller(m_pResourcePool);
+	m_pGpuCuller->SetLodSettings(g_LodScreenSizes, g_LodScreenSizeCount, g_LodHysteresis);
+	m_bGpuCulling = true;
+	m_pDepthPyramid = new DepthPyramid(m_pResourcePool);
+
+	// the shadow samplers are set to their units at once, since
+	// samplers of different types cannot share the first unit
+	m_pShadowMaps = new ShadowMaps(m_pResourcePool);
+	m_pUniformCache->SetSampler2DValue(m_uniforms.staticShadowMaps,
+		m_pShadowMaps->GetTextureUnit(ShadowMaps::MAPS_STATIC));
+	m_pUniformCache->SetSampler2DValue(m_uniforms.dynamicShadowMaps,
+		m_pShadowMaps->GetTextureUnit(ShadowMaps::MAPS_DYNAMIC));
+	m_pUniformCache->SetSampler2DValue(m_uniforms.sunShadowMaps,
+		m_pShadowMaps->GetTextureUnit(ShadowMaps::MAPS_SUN));
+	m_pUniformCache->SetSampler2DValue(m_uniforms.dynamicSunShadowMaps,
+		m_pShadowMaps->GetTextureUnit(ShadowMaps::MAPS_SUN_DYNAMIC));
+	m_bShadows = true;
+	m_bSunLight = false;
+	m_bShadowMaps = false;
+	m_shadowSlot = -1;
+	m_bShadowPass = false;
+	m_bStaticShadowsDirty = true;
+	m_shadowBoundsMin = glm::vec3(0.0f);
+	m_shadowBoundsMax = glm::vec3(0.0f);
+	m_view = glm::mat4(1.0f);
+
+	m_renderStats.drawCalls = 0;
+	m_renderStats.instancedDrawCalls = 0;
+	m_renderStats.stateChanges = 0;
+	m_renderStats.stateChangesSkipped = 0;
+	m_renderStats.visibleItems = 0;
+	m_renderStats.culledItems = 0;
+	m_renderStats.occludedItems = 0;
+	m_renderStats.occlusionQueries = 0;
+	m_renderStats.reducedLodItems = 0;
+	m_renderStats.staticItems = 0;
+	m_renderStats.shadowDrawCalls = 0;
+	InvalidateShaderStateCache();
 }
 
 /***********************************************************
@@ -44,165 +322,151 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
  ***********************************************************/
 SceneManager::~SceneManager()
 {
+	// the streaming thread writes into the render items
+	if (NULL != m_pCellStreamer)
+	{
+		delete m_pCellStreamer;
+		m_pCellStreamer = NULL;
+	}
+	if (NULL != m_pFileWatcher)
+	{
+		delete m_pFileWatcher;
+		m_pFileWatcher = NULL;
+	}
 	m_pShaderManager = NULL;
-	delete m_basicMeshes;
-	m_basicMeshes = NULL;
+	m_pShaderCache = NULL;
+	m_pUniformCache->ReportMissingUniforms();
+	delete m_pUniformCache;
+	m_pUniformCache = NULL;
+	delete m_pTextureManager;
+	m_pTextureManager = NULL;
+	delete m_instancedMeshes;
+	m_instancedMeshes = NULL;
+	delete m_pMaterialBuffer;
+	m_pMaterialBuffer = NULL;
+	delete m_pLightBuffer;
+	m_pLightBuffer = NULL;
+	delete m_pClusteredLights;
+	m_pClusteredLights = NULL;
+	delete m_pOcclusionCuller;
+	m_pOcclusionCuller = NULL;
+	delete m_pGpuCuller;
+	m_pGpuCuller = NULL;
+	delete m_pDepthPyramid;
+	m_pDepthPyramid = NULL;
+	delete m_pStaticBatch;
+	m_pStaticBatch = NULL;
+	delete m_pShadowMaps;
+	m_pShadowMaps = NULL;
+	delete m_pFrameArena;
+	m_pFrameArena = NULL;
+	// the owners above have given their resources back by now
+	delete m_pResourcePool;
+	m_pResourcePool = NULL;
 }
 
 /***********************************************************
  *  CreateGLTexture()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
- ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
-{
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
+ *  This method is used for registering a texture image file
+ *  with the texture manager, which stores the texture in the
+ *  texture array for its image size and queues the image file
+ *  for decoding on the texture loader threads.  The returned
+ *  handle is -1 when the texture could not be created.
+ ***********************************************************/
+int SceneManager::CreateGLTexture(const char* filename, const std::string& tag)
+{
+	int textureHandle = m_pTextureManager->RegisterTexture(filename, tag);
 
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
+	// remember the files of the new textures for exporting
+	if (textureHandle == (int)m_textureFiles.size())
+	{
+		SceneFile::SCENE_TEXTURE textureFile;
+		SceneFile::SetString(textureFile.filename, SceneFile::FILENAME_LENGTH, filename);
+		SceneFile::SetString(textureFile.tag, SceneFile::TAG_LENGTH, tag);
+		m_textureFiles.push_back(textureFile);
+	}
 
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+	return(textureHandle);
+}
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+/***********************************************************
+ *  CookSceneTextures()
+ *
+ *  This method is used for the offline texture cooking step,
+ *  which writes a compressed KTX file with the precomputed mip
+ *  chain next to each texture image of the 3D scene.  The
+ *  cooked files are preferred over the images when the scene
+ *  is prepared.  No OpenGL context is needed.
+ ***********************************************************/
+bool SceneManager::CookSceneTextures()
+{
+	bool bSuccess = true;
 
-		return true;
+	for (int i = 0; i < g_SceneTextureCount; i++)
+	{
+		if (TextureCooker::CookTexture(g_SceneTextures[i].filename) == false)
+		{
+			bSuccess = false;
+		}
 	}
 
-	std::cout << "Could not load image:" << filename << std::endl;
-
-	// Error loading the image
-	return false;
+	return(bSuccess);
 }
 
 /***********************************************************
  *  BindGLTextures()
  *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  This method is used for allocating the texture arrays for
+ *  the registered textures and binding each array to its own
+ *  texture unit.  The textures show a placeholder until their
+ *  decoded images are uploaded.
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
-	}
+	m_pTextureManager->CreateTextureArrays();
+	m_pTextureManager->BindTextureArrays();
 }
 
 /***********************************************************
  *  DestroyGLTextures()
  *
  *  This method is used for freeing the memory in all the
- *  used texture memory slots.
+ *  used texture arrays.
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		glGenTextures(1, &m_textureIDs[i].ID);
-	}
+	m_pTextureManager->DestroyTextures();
 }
 
 /***********************************************************
  *  FindTextureID()
  *
- *  This method is used for getting an ID for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  This method is used for getting the ID of the texture
+ *  array that holds the previously loaded texture bitmap
+ *  associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+int SceneManager::FindTextureID(const std::string& tag)
 {
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
+	TextureManager::TEXTURE_LOCATION location =
+		m_pTextureManager->GetTextureLocation(FindTextureHandle(tag));
+	if (location.arrayIndex < 0)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
+		return(-1);
 	}
 
-	return(textureID);
+	return(m_pTextureManager->GetArrayTextureID(location.arrayIndex));
 }
 
 /***********************************************************
- *  FindTextureSlot()
+ *  FindTextureHandle()
  *
- *  This method is used for getting a slot index for the previously
+ *  This method is used for getting the handle for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::FindTextureHandle(const std::string& tag)
 {
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
-	}
-
-	return(textureSlot);
+	return(m_pTextureManager->FindTexture(tag));
 }
 
 /***********************************************************
@@ -211,33 +475,79 @@ int SceneManager::FindTextureSlot(std::string tag)
  *  This method is used for getting a material from the previously
  *  defined materials list that is associated with the passed in tag.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+bool SceneManager::FindMaterial(const std::string& tag, OBJECT_MATERIAL& material)
 {
-	if (m_objectMaterials.size() == 0)
+	int materialIndex = FindMaterialIndex(tag);
+	if (materialIndex < 0)
 	{
 		return(false);
 	}
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
+	material = m_objectMaterials[materialIndex];
+	return(true);
+}
+
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the index of a material in
+ *  the previously defined materials list that is associated
+ *  with the passed in tag.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(const std::string& tag)
+{
+	std::unordered_map<std::string, int>::const_iterator found = m_materialIndices.find(tag);
+	if (found == m_materialIndices.end())
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.ambientColor = m_objectMaterials[index].ambientColor;
-			material.ambientStrength = m_objectMaterials[index].ambientStrength;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
+		return(-1);
 	}
 
-	return(true);
+	return(found->second);
+}
+
+/***********************************************************
+ *  AddObjectMaterial()
+ *
+ *  This method is used for adding a material to the defined
+ *  materials list.  The returned handle is the index of the
+ *  material, which selects it in the material buffer.
+ ***********************************************************/
+int SceneManager::AddObjectMaterial(const OBJECT_MATERIAL& material)
+{
+	std::unordered_map<std::string, int>::const_iterator found = m_materialIndices.find(material.tag);
+	if (found != m_materialIndices.end())
+	{
+		std::cout << "Material " << material.tag << " is already defined" << std::endl;
+		return(found->second);
+	}
+
+	int materialIndex = m_objectMaterials.size();
+	m_objectMaterials.push_back(material);
+	m_materialIndices[material.tag] = materialIndex;
+
+	return(materialIndex);
+}
+
+/***********************************************************
+ *  ComputeModelMatrix()
+ *
+ *  This method is used for calculating the model matrix
+ *  from the passed in transformation values.
+ ***********************************************************/
+glm::mat4 SceneManager::ComputeModelMatrix(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	// the product translation * rotationZ * rotationY * rotationX
+	// * scale is written out directly instead of multiplying the
+	// five matrices
+	return(TransformKernel::ComputeModelMatrix(
+		scaleXYZ,
+		glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees),
+		positionXYZ));
 }
 
 /***********************************************************
@@ -253,29 +563,98 @@ void SceneManager::SetTransformations(
 	float ZrotationDegrees,
 	glm::vec3 positionXYZ)
 {
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationZ * rotationY * rotationX * scale;
+	SetTransformations(ComputeModelMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ));
+}
 
+/***********************************************************
+ *  SetTransformations()
+ *
+ *  This method is used for setting the transform buffer
+ *  using a previously calculated model matrix.
+ ***********************************************************/
+void SceneManager::SetTransformations(
+	const glm::mat4& modelView)
+{
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		m_pUniformCache->SetMat4Value(m_uniforms.model, modelView);
+	}
+}
+
+/***********************************************************
+ *  SetUseTexture()
+ *
+ *  This method is used for setting whether the next draw
+ *  command uses a texture or a color into the shader.  The
+ *  value is skipped when it has not changed since it was last
+ *  set.
+ ***********************************************************/
+void SceneManager::SetUseTexture(bool bUseTexture)
+{
+	if ((m_stateCache.bUseTextureValid == true) &&
+		(m_stateCache.bUseTexture == bUseTexture))
+	{
+		m_renderStats.stateChangesSkipped++;
+		return;
+	}
+
+	m_pUniformCache->SetBoolValue(m_uniforms.bUseTexture, bUseTexture);
+	m_stateCache.bUseTexture = bUseTexture;
+	m_stateCache.bUseTextureValid = true;
+	m_renderStats.stateChanges++;
+
+	// the variants have the texture switch built in
+	SelectShaderVariant();
+}
+
+/***********************************************************
+ *  SetUseInstancing()
+ *
+ *  This method is used for setting whether the next draw
+ *  command takes the model matrix, color and UV scale from
+ *  the per-instance values instead of the shader uniforms.
+ ***********************************************************/
+void SceneManager::SetUseInstancing(bool bUseInstancing)
+{
+	if ((m_stateCache.bUseInstancingValid == true) &&
+		(m_stateCache.bUseInstancing == bUseInstancing))
+	{
+		m_renderStats.stateChangesSkipped++;
+		return;
+	}
+
+	m_pUniformCache->SetBoolValue(m_uniforms.bUseInstancing, bUseInstancing);
+	m_stateCache.bUseInstancing = bUseInstancing;
+	m_stateCache.bUseInstancingValid = true;
+	m_renderStats.stateChanges++;
+}
+
+/***********************************************************
+ *  SetUseStaticBatch()
+ *
+ *  This method is used for setting whether the next draw
+ *  command uses the baked static vertices, which are already
+ *  in world space and carry the color, UV scale and texture
+ *  layer of their objects.
+ ***********************************************************/
+void SceneManager::SetUseStaticBatch(bool bUseStaticBatch)
+{
+	if ((m_stateCache.bUseStaticBatchValid == true) &&
+		(m_stateCache.bUseStaticBatch == bUseStaticBatch))
+	{
+		m_renderStats.stateChangesSkipped++;
+		return;
 	}
+
+	m_pUniformCache->SetBoolValue(m_uniforms.bUseStaticBatch, bUseStaticBatch);
+	m_stateCache.bUseStaticBatch = bUseStaticBatch;
+	m_stateCache.bUseStaticBatchValid = true;
+	m_renderStats.stateChanges++;
 }
 
 /***********************************************************
@@ -300,8 +679,20 @@ void SceneManager::SetShaderColor(
 
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		SetUseTexture(false);
+
+		if ((m_stateCache.bColorValid == true) &&
+			(m_stateCache.color == currentColor))
+		{
+			m_renderStats.stateChangesSkipped++;
+		}
+		else
+		{
+			m_pUniformCache->SetVec4Value(m_uniforms.objectColor, currentColor);
+			m_stateCache.color = currentColor;
+			m_stateCache.bColorValid = true;
+			m_renderStats.stateChanges++;
+		}
 	}
 }
 
@@ -312,16 +703,80 @@ void SceneManager::SetShaderColor(
  *  associated with the passed in ID into the shader.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
-	std::string textureTag)
+	const std::string& textureTag)
+{
+	SetShaderTexture(FindTextureHandle(textureTag));
+}
+
+/***********************************************************
+ *  SetShaderTexture()
+ *
+ *  This method is used for setting the texture data for the
+ *  passed in (previously resolved) texture handle into the
+ *  shader.
+ ***********************************************************/
+void SceneManager::SetShaderTexture(
+	int textureHandle)
+{
+	TextureManager::TEXTURE_LOCATION location =
+		m_pTextureManager->GetTextureLocation(textureHandle);
+
+	if (location.arrayIndex >= 0)
+	{
+		SetShaderTextureArray(location.arrayIndex);
+		SetShaderTextureLayer(location.layer);
+	}
+}
+
+/***********************************************************
+ *  SetShaderTextureArray()
+ *
+ *  This method is used for selecting the texture array in the
+ *  shader by the texture unit it is bound to.  The value is
+ *  skipped when it has not changed since it was last set.
+ ***********************************************************/
+void SceneManager::SetShaderTextureArray(
+	int textureArray)
 {
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
+		SetUseTexture(true);
+
+		if ((m_stateCache.bTextureArrayValid == true) &&
+			(m_stateCache.textureArray == textureArray))
+		{
+			m_renderStats.stateChangesSkipped++;
+		}
+		else
+		{
+			m_pUniformCache->SetSampler2DValue(m_uniforms.objectTexture, textureArray);
+			m_stateCache.textureArray = textureArray;
+			m_stateCache.bTextureArrayValid = true;
+			m_renderStats.stateChanges++;
+		}
+	}
+}
 
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+/***********************************************************
+ *  SetShaderTextureLayer()
+ *
+ *  This method is used for selecting the layer of the texture
+ *  array for the next non-instanced draw command.
+ ***********************************************************/
+void SceneManager::SetShaderTextureLayer(
+	int textureLayer)
+{
+	if ((m_stateCache.bTextureLayerValid == true) &&
+		(m_stateCache.textureLayer == textureLayer))
+	{
+		m_renderStats.stateChangesSkipped++;
+		return;
 	}
+
+	m_pUniformCache->SetIntValue(m_uniforms.textureLayer, textureLayer);
+	m_stateCache.textureLayer = textureLayer;
+	m_stateCache.bTextureLayerValid = true;
+	m_renderStats.stateChanges++;
 }
 
 /***********************************************************
@@ -332,9 +787,22 @@ void SceneManager::SetShaderTexture(
  ***********************************************************/
 void SceneManager::SetTextureUVScale(float u, float v)
 {
+	glm::vec2 uvScale(u, v);
+
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		if ((m_stateCache.bUVScaleValid == true) &&
+			(m_stateCache.uvScale == uvScale))
+		{
+			m_renderStats.stateChangesSkipped++;
+		}
+		else
+		{
+			m_pUniformCache->SetVec2Value(m_uniforms.UVscale, uvScale);
+			m_stateCache.uvScale = uvScale;
+			m_stateCache.bUVScaleValid = true;
+			m_renderStats.stateChanges++;
+		}
 	}
 }
 
@@ -345,898 +813,3703 @@ void SceneManager::SetTextureUVScale(float u, float v)
  *  into the shader.
  ***********************************************************/
 void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+	const std::string& materialTag)
 {
-	if (m_objectMaterials.size() > 0)
-	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
-
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
-		{
-			// pass the material properties into the shader
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-		}
-	}
+	SetShaderMaterial(FindMaterialIndex(materialTag));
 }
 
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
-
-/***************************************************************
- * DefineObjectMaterials()
+/***********************************************************
+ *  SetShaderMaterial()
  *
- * Method for defining various material settings for all objects
- * within the 3D scene.
- ***************************************************************/
-void SceneManager::DefineObjectMaterials() {
-	
-	// shiny material definition
-	OBJECT_MATERIAL shinyMaterial;
-	shinyMaterial.ambientColor = glm::vec3(0.3f, 0.1f, 0.1f);
-	shinyMaterial.ambientStrength = 0.1;
-	shinyMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	shinyMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	shinyMaterial.shininess = 64.0f;
-	shinyMaterial.tag = "metal";
-
-	m_objectMaterials.push_back(shinyMaterial);
+ *  This method is used for selecting the material at the
+ *  passed in (previously resolved) index in the shader.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	int materialIndex)
+{
+	if ((materialIndex >= 0) && (materialIndex < m_objectMaterials.size()))
+	{
+		// skip the index when the same material was the last
+		// one set into the shader
+		if ((m_stateCache.bMaterialValid == true) &&
+			(m_stateCache.materialIndex == materialIndex))
+		{
+			m_renderStats.stateChangesSkipped++;
+			return;
+		}
 
-	// dull material definition
-	OBJECT_MATERIAL dullMaterial;
-	dullMaterial.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	dullMaterial.ambientStrength = 0.1;
-	dullMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	dullMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	dullMaterial.shininess = 16.0f;
-	dullMaterial.tag = "wood";
+		// the material values are already in the material buffer,
+		// so only the index of the material is passed into the shader
+		m_pUniformCache->SetIntValue(m_uniforms.materialIndex, materialIndex);
 
-	m_objectMaterials.push_back(dullMaterial);
+		m_stateCache.materialIndex = materialIndex;
+		m_stateCache.bMaterialValid = true;
+		m_renderStats.stateChanges++;
+	}
 }
-/*******************************************************
- * SetupSceneLights()
- * 
- * Method for adding and configuring light sources, 4 max
- *******************************************************/
-void SceneManager::SetupSceneLights() {
-
-	// using default OpenGL lighting
-	m_pShaderManager->setBoolValue(g_UseLightingName, true);
-
-	// camera position at (0.0f, 5.0f, 12.0f) making sure all light positions aren't blocked by camera
-
-	// light 1
-	m_pShaderManager->setVec3Value("lightSources[0].position", -7.0f, 7.0f, 10.0f);
-	m_pShaderManager->setVec3Value("lightSources[0].ambientColor", 0.8f, 0.8f, 0.7f);
-	m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", 1.0f, 0.95f, 0.85f);
-	m_pShaderManager->setVec3Value("lightSources[0].specularColor", 1.0f, 1.0f, 1.0f);
-	m_pShaderManager->setFloatValue("lightSources[0].focalStrength", 32.0f);
-	m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 0.7f);
 
-	// light 2
-	m_pShaderManager->setVec3Value("lightSources[1].position", 7.0f, -6.0f, 1.0f);
-	m_pShaderManager->setVec3Value("lightSources[1].ambientColor", 0.8f, 0.8f, 0.7f);
-	m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", 1.0f, 0.95f, 0.85f);
-	m_pShaderManager->setVec3Value("lightSources[1].specularColor", 1.0f, 1.0f, 1.0f);
-	m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 32.0f);
-	m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 0.7f);
-
-	// light 3
-	m_pShaderManager->setVec3Value("lightSources[2].position", 7.0f, 7.0f, 5.0f);
-	m_pShaderManager->setVec3Value("lightSources[2].ambientColor", 0.8f, 0.8f, 0.7f);
-	m_pShaderManager->setVec3Value("lightSources[2].diffuseColor", 1.0f, 0.95f, 0.85f);
-	m_pShaderManager->setVec3Value("lightSources[2].specularColor", 1.0f, 1.0f, 1.0f);
-	m_pShaderManager->setFloatValue("lightSources[2].focalStrength", 16.0f);
-	m_pShaderManager->setFloatValue("lightSources[2].specularIntensity", 0.7f);
-
-	// light 4
-	m_pShaderManager->setVec3Value("lightSources[3].position", -7.0f,-6.0f, 1.0f);
-	m_pShaderManager->setVec3Value("lightSources[3].ambientColor", 0.8f, 0.8f, 0.7f);
-	m_pShaderManager->setVec3Value("lightSources[3].diffuseColor", 1.0f, 0.95f, 0.85f);
-	m_pShaderManager->setVec3Value("lightSources[3].specularColor", 1.0f, 1.0f, 1.0f);
-	m_pShaderManager->setFloatValue("lightSources[3].focalStrength", 32.0f);
-	m_pShaderManager->setFloatValue("lightSources[3].specularIntensity", 0.7f);
+/***********************************************************
+ *  InvalidateShaderStateCache()
+ *
+ *  This method is used for forgetting the values last set
+ *  into the shader, so that the next draw sets all of them.
+ *  It needs to be called whenever the shader values may have
+ *  been changed outside of this class.
+ ***********************************************************/
+void SceneManager::InvalidateShaderStateCache()
+{
+	m_stateCache.bUseTextureValid = false;
+	m_stateCache.bUseInstancingValid = false;
+	m_stateCache.bUseStaticBatchValid = false;
+	m_stateCache.bColorValid = false;
+	m_stateCache.bTextureArrayValid = false;
+	m_stateCache.bTextureLayerValid = false;
+	m_stateCache.bUVScaleValid = false;
+	m_stateCache.bMaterialValid = false;
 }
 
 /***********************************************************
- *  PrepareScene()
+ *  AddRenderItem()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  This method is used for adding an object to the retained
+ *  list of render items.  The texture slot and material
+ *  index are resolved from the passed in tags only once,
+ *  here, instead of on every rendered frame.  An empty
+ *  texture tag means the object is drawn with its color.
  ***********************************************************/
-void SceneManager::PrepareScene()
+int SceneManager::AddRenderItem(
+	MESH_TYPE mesh,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	glm::vec4 color,
+	const std::string& textureTag,
+	glm::vec2 uvScale,
+	const std::string& materialTag)
 {
-	// only one instance of a particular mesh needs to be
-	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
-
-	// load meshes
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadBoxMesh(); //adding box mesh to PrepareScene
-	m_basicMeshes->LoadTaperedCylinderMesh(); //adding tapered cylinder to PrepareScene
-	m_basicMeshes->LoadPrismMesh(); // adding prism mesh to PrepareScene
-	m_basicMeshes->LoadPyramid3Mesh(); // adding pyramid mesh to PrepareScene
-
-	// load textures
-	bool bReturn = false;
-
-	// brick texture
-	bReturn = CreateGLTexture("textures/Brick.jpg", "brick");
-	// regular wood texture
-	bReturn = CreateGLTexture("textures/Wood Test.jpg", "wood");
-	// stucco texture
-	bReturn = CreateGLTexture("textures/Wall.jpg", "wall");
-	// grass texture
-	bReturn = CreateGLTexture("textures/Grass.jpg", "grass");
-	// cement texture
-	bReturn = CreateGLTexture("textures/PatternCement.jpeg", "cement");
-	// light tan beam texture
-	bReturn = CreateGLTexture("textures/LightTan.jpg", "beam");
-	// front door texture
-	bReturn = CreateGLTexture("textures/door.jpg", "door");
-	// outside industrial green texture
-	bReturn = CreateGLTexture("textures/outergreen.jpg", "outergreen");
-	// smooth concrete texture
-	bReturn = CreateGLTexture("textures/concrete.jpeg", "concrete");
-	// black roof texture
-	bReturn = CreateGLTexture("textures/roof.jpg", "roof");
-	// window texture
-	bReturn = CreateGLTexture("textures/glass.jpg", "window");
-	// garage door texture
-	bReturn = CreateGLTexture("textures/garagedoor.jpg", "garage");
-
-	// binding loaded textures into texture slots (16 max)
-	BindGLTextures();
+	RENDER_ITEM item;
+
+	item.mesh = mesh;
+	item.scaleXYZ = scaleXYZ;
+	item.rotationDegrees = glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees);
+	item.positionXYZ = positionXYZ;
+	UpdateItemTransform(item);
+	item.color = color;
+	int textureHandle = -1;
+	if (textureTag.empty() == false)
+	{
+		textureHandle = FindTextureHandle(textureTag);
+	}
+	SetItemTexture(item, textureHandle);
+	item.uvScale = uvScale;
+	item.materialIndex = FindMaterialIndex(materialTag);
+	item.lodLevel = 0;
+	item.staticObject = -1;
+	item.bDirty = false;
+	item.bDynamic = false;
+	item.stillFrames = 0;
+
+	m_renderItems.push_back(item);
+	m_bDrawOrderDirty = true;
+
+	return(m_renderItems.size() - 1);
 }
 
 /***********************************************************
- *  RenderScene()
+ *  SetItemTexture()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for setting the texture of a render
+ *  item and where the texture is stored.  The alpha of a
+ *  textured item comes from its texture and the alpha of
+ *  any other item from its color, so the color needs to be
+ *  set first.
  ***********************************************************/
-void SceneManager::RenderScene()
+void SceneManager::SetItemTexture(RENDER_ITEM& item, int textureHandle) const
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
+	TextureManager::TEXTURE_LOCATION location =
+		m_pTextureManager->GetTextureLocation(textureHandle);
 
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	// first plane (ground level)
-	// set the XYZ scale for the mesh 
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
+	item.textureHandle = textureHandle;
+	item.textureArray = location.arrayIndex;
+	item.textureLayer = location.layer;
+	if (item.textureArray >= 0)
+	{
+		item.bTransparent = location.bHasAlpha;
+	}
+	else
+	{
+		item.bTransparent = (item.color.a < 1.0f);
+	}
+}
+
+/***********************************************************
+ *  SetRenderItemTransform()
+ *
+ *  This method is used for changing the transformation
+ *  values of a render item.  The item is marked dirty and
+ *  its model matrix is recalculated on the next render.
+ ***********************************************************/
+void SceneManager::SetRenderItemTransform(
+	int itemIndex,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	// the objects of a streamed world are placed by its file
+	if ((itemIndex < 0) || (itemIndex >= m_renderItems.size()) || (NULL != m_pCellStreamer))
+	{
+		return;
+	}
+
+	PlaceRenderItem(itemIndex, scaleXYZ,
+		glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees), positionXYZ);
+
+	// the first move takes the item out of the cached shadow
+	// maps, which are drawn again without it
+	RENDER_ITEM& item = m_renderItems[itemIndex];
+	item.stillFrames = 0;
+	if (item.bDynamic == false)
+	{
+		item.bDynamic = true;
+		m_dynamicItems.push_back(itemIndex);
+		m_bStaticShadowsDirty = true;
+	}
+}
+
+/***********************************************************
+ *  PlaceRenderItem()
+ *
+ *  This method is used for giving a render item new
+ *  transformation values.  The baked vertices are where the
+ *  item was, so it is taken out of the static batches and
+ *  drawn on its own from now on.  The item is marked dirty
+ *  and its model matrix is recalculated on the next render.
+ ***********************************************************/
+void SceneManager::PlaceRenderItem(
+	int itemIndex,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	RENDER_ITEM& item = m_renderItems[itemIndex];
+	item.scaleXYZ = scaleXYZ;
+	item.rotationDegrees = rotationDegrees;
+	item.positionXYZ = positionXYZ;
+	if (item.staticObject >= 0)
+	{
+		if (m_bGpuCulling == true)
+		{
+			m_pGpuCuller->DisableObject(item.staticObject);
+			m_movedItems.push_back(itemIndex);
+		}
+		item.staticObject = -1;
+	}
+
+	// only queue the item once no matter how often it changes
+	if (item.bDirty == false)
+	{
+		item.bDirty = true;
+		m_dirtyRenderItems.push_back(itemIndex);
+	}
+}
+
+/***********************************************************
+ *  UpdateRenderItems()
+ *
+ *  This method is used for recalculating the model matrix
+ *  of the render items that were marked dirty.
+ ***********************************************************/
+void SceneManager::UpdateRenderItems()
+{
+	// the items are independent of each other, while the spatial
+	// index is refitted on this thread afterwards
+	UpdateItemTransforms(m_dirtyRenderItems.data(), m_dirtyRenderItems.size());
+
+	for (int i = 0; i < m_dirtyRenderItems.size(); i++)
+	{
+		const RENDER_ITEM& item = m_renderItems[m_dirtyRenderItems[i]];
+		m_spatialIndex.Refit(m_dirtyRenderItems[i], item.boundsMin, item.boundsMax);
+	}
+
+	m_dirtyRenderItems.clear();
+}
+
+/***********************************************************
+ *  RunParallel()
+ *
+ *  This method is used for running a loop over the passed in
+ *  number of items on the job system, or on this thread when
+ *  there is no job system.  The loop body must not make any
+ *  OpenGL calls.
+ ***********************************************************/
+void SceneManager::RunParallel(int itemCount, const JobSystem::RANGE_FUNCTION& body)
+{
+	if (NULL == m_pJobSystem)
+	{
+		if (itemCount > 0)
+		{
+			body(0, itemCount);
+		}
+		return;
+	}
+
+	m_pJobSystem->ParallelFor(itemCount, g_JobRangeSize, body);
+}
+
+/***********************************************************
+ *  UpdateItemTransform()
+ *
+ *  This method is used for calculating the model matrix of
+ *  a render item from its transformation values, and the
+ *  world space box around its mesh used for culling.
+ ***********************************************************/
+void SceneManager::UpdateItemTransform(RENDER_ITEM& item)
+{
+	item.modelMatrix = ComputeModelMatrix(
+		item.scaleXYZ,
+		item.rotationDegrees.x,
+		item.rotationDegrees.y,
+		item.rotationDegrees.z,
+		item.positionXYZ);
+
+	UpdateItemBounds(item);
+}
+
+/***********************************************************
+ *  UpdateItemTransforms()
+ *
+ *  This method is used for calculating the model matrices
+ *  and the bounds of the passed in render items.  Each range
+ *  of the items gathers its transformation values into the
+ *  separate component arrays, builds all of its matrices in
+ *  one batch, and then copies them back to the items.
+ ***********************************************************/
+void SceneManager::UpdateItemTransforms(const int* itemIndices, int itemCount)
+{
+	m_batchTransforms.Resize(itemCount);
+	m_batchMatrices.resize(itemCount);
+
+	RunParallel(itemCount,
+		[this, itemIndices](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				const RENDER_ITEM& item = m_renderItems[itemIndices[i]];
+				m_batchTransforms.Set(i, item.scaleXYZ, item.rotationDegrees, item.positionXYZ);
+			}
+
+			TransformKernel::ComputeModelMatrices(m_batchTransforms,
+				begin, end - begin, &m_batchMatrices[begin]);
+
+			for (int i = begin; i < end; i++)
+			{
+				RENDER_ITEM& item = m_renderItems[itemIndices[i]];
+				item.modelMatrix = m_batchMatrices[i];
+				UpdateItemBounds(item);
+				item.bDirty = false;
+			}
+		});
+}
+
+/***********************************************************
+ *  UpdateItemBounds()
+ *
+ *  This method is used for calculating the world space box
+ *  around the mesh of a render item, which is used for
+ *  culling.
+ ***********************************************************/
+void SceneManager::UpdateItemBounds(RENDER_ITEM& item) const
+{
+	MeshManager::MESH_BOUNDS bounds = GetMeshBounds(item.mesh);
+	Frustum::TransformBox(item.modelMatrix, bounds.minXYZ, bounds.maxXYZ,
+		item.boundsMin, item.boundsMax);
+}
+
+/***********************************************************
+ *  GetMeshBounds()
+ *
+ *  This method is used for getting the bounds of the basic
+ *  mesh associated with the passed in mesh identifier.  The
+ *  single and the instanced draws use the same meshes, so
+ *  their bounds apply to both.
+ ***********************************************************/
+MeshManager::MESH_BOUNDS SceneManager::GetMeshBounds(MESH_TYPE mesh) const
+{
+	switch (mesh)
+	{
+	case MESH_BOX:
+		return(m_instancedMeshes->GetBoxMeshBounds());
+	case MESH_TAPERED_CYLINDER:
+		return(m_instancedMeshes->GetTaperedCylinderMeshBounds());
+	case MESH_PRISM:
+		return(m_instancedMeshes->GetPrismMeshBounds());
+	case MESH_PYRAMID3:
+		return(m_instancedMeshes->GetPyramid3MeshBounds());
+	case MESH_PLANE:
+	default:
+		return(m_instancedMeshes->GetPlaneMeshBounds());
+	}
+}
+
+/***********************************************************
+ *  CullRenderItems()
+ *
+ *  This method is used for building the list of the render
+ *  items inside the view frustum.  The spatial index only
+ *  visits the parts of the scene that can be visible.  The
+ *  found items are put back into their sorted order, with
+ *  the items that share the shader state grouped by their
+ *  level of detail, so that the batches stay together.
+ ***********************************************************/
+void SceneManager::CullRenderItems()
+{
+	// the baked items are culled on the GPU, against the frustum
+	// and the depth pyramid of the last frame, which leaves the
+	// few that have moved since for the CPU
+	int candidateCount = m_drawOrder.size();
+	if (NULL != m_pCellStreamer)
+	{
+		candidateCount = CullStreamedCells();
+	}
+	else if (m_bGpuCulling == true)
+	{
+		candidateCount = m_movedItems.size();
+		m_visibleOrder.clear();
+		for (size_t i = 0; i < m_movedItems.size(); i++)
+		{
+			const RENDER_ITEM& item = m_renderItems[m_movedItems[i]];
+			if ((m_bFrustumCulling == false) ||
+				(m_frustum.IsBoxVisible(item.boundsMin, item.boundsMax) == true))
+			{
+				m_visibleOrder.push_back(m_movedItems[i]);
+			}
+		}
+	}
+	else if (m_bFrustumCulling == false)
+	{
+		m_visibleOrder = m_drawOrder;
+	}
+	else
+	{
+		m_visibleOrder.clear();
+		m_spatialIndex.QueryFrustum(m_frustum, m_visibleOrder);
+	}
+
+	SelectLevelsOfDetail();
+
+	// the items sharing the mesh, texture array and material are
+	// next to each other in the sorted order, so comparing the
+	// positions of items in different groups orders the groups -
+	// the slots of a streamed world have no sorted order, so
+	// their items are compared by their state instead
+	if (NULL != m_pCellStreamer)
+	{
+		std::sort(m_visibleOrder.begin(), m_visibleOrder.end(),
+			[this](int a, int b)
+			{
+				const RENDER_ITEM& itemA = m_renderItems[a];
+				const RENDER_ITEM& itemB = m_renderItems[b];
+
+				if (itemA.mesh != itemB.mesh)
+					return(itemA.mesh < itemB.mesh);
+				if (itemA.textureArray != itemB.textureArray)
+					return(itemA.textureArray < itemB.textureArray);
+				if (itemA.materialIndex != itemB.materialIndex)
+					return(itemA.materialIndex < itemB.materialIndex);
+				if (itemA.lodLevel != itemB.lodLevel)
+					return(itemA.lodLevel < itemB.lodLevel);
+				if (itemA.textureLayer != itemB.textureLayer)
+					return(itemA.textureLayer < itemB.textureLayer);
+				return(a < b);
+			});
+	}
+	else
+	{
+		std::sort(m_visibleOrder.begin(), m_visibleOrder.end(),
+			[this](int a, int b)
+			{
+				const RENDER_ITEM& itemA = m_renderItems[a];
+				const RENDER_ITEM& itemB = m_renderItems[b];
+
+				if ((itemA.mesh == itemB.mesh) &&
+					(itemA.textureArray == itemB.textureArray) &&
+					(itemA.materialIndex == itemB.materialIndex) &&
+					(itemA.lodLevel != itemB.lodLevel))
+				{
+					return(itemA.lodLevel < itemB.lodLevel);
+				}
+				return(m_drawRank[a] < m_drawRank[b]);
+			});
+	}
+
+	// the items hidden at their last occlusion query are not
+	// drawn, but stay in the frustum list to be queried again
+	m_frustumVisible = m_visibleOrder;
+	m_renderStats.occludedItems = 0;
+	if (m_bOcclusionCulling == true)
+	{
+		m_pOcclusionCuller->BeginFrame();
+		m_pOcclusionCuller->ReadResults();
+
+		int visibleCount = 0;
+		for (size_t i = 0; i < m_frustumVisible.size(); i++)
+		{
+			if (m_pOcclusionCuller->CheckOccluded(m_frustumVisible[i]) == false)
+			{
+				m_visibleOrder[visibleCount++] = m_frustumVisible[i];
+			}
+		}
+		m_renderStats.occludedItems = m_visibleOrder.size() - visibleCount;
+		m_visibleOrder.resize(visibleCount);
+	}
+
+	m_renderStats.visibleItems = m_visibleOrder.size();
+	m_renderStats.culledItems = candidateCount - m_frustumVisible.size();
+}
+
+/***********************************************************
+ *  SelectLevelsOfDetail()
+ *
+ *  This method is used for choosing the level of detail of
+ *  each render item in the frustum from the part of the view
+ *  height that its bounding sphere covers.  An item only
+ *  changes level once it is g_LodHysteresis past a screen
+ *  size, so items near a screen size do not switch back and
+ *  forth as the camera moves.
+ ***********************************************************/
+void SceneManager::SelectLevelsOfDetail()
+{
+	std::atomic<int> reducedLodItems(0);
+
+	RunParallel(m_visibleOrder.size(),
+		[this, &reducedLodItems](int begin, int end)
+		{
+			int reducedCount = 0;
+			for (int i = begin; i < end; i++)
+			{
+				if (SelectLevelOfDetail(m_renderItems[m_visibleOrder[i]]) > 0)
+				{
+					reducedCount++;
+				}
+			}
+			reducedLodItems += reducedCount;
+		});
+
+	m_renderStats.reducedLodItems += reducedLodItems.load();
+}
+
+/***********************************************************
+ *  SelectLevelOfDetail()
+ *
+ *  This method is used for choosing the level of detail of
+ *  one render item, which is returned.
+ ***********************************************************/
+int SceneManager::SelectLevelOfDetail(RENDER_ITEM& item) const
+{
+	int maxLevel = std::min(GetMeshLodCount(item.mesh) - 1, g_LodScreenSizeCount);
+	if (maxLevel <= 0)
+	{
+		return(0);
+	}
+
+	glm::vec3 center = (item.boundsMin + item.boundsMax) * 0.5f;
+	float radius = glm::length(item.boundsMax - item.boundsMin) * 0.5f;
+	float distance = std::max(glm::length(center - m_viewPosition), 0.001f);
+	float screenSize = radius * m_lodScale / distance;
+
+	int level = std::min(item.lodLevel, maxLevel);
+	while ((level > 0) && (screenSize > g_LodScreenSizes[level - 1] * (1.0f + g_LodHysteresis)))
+	{
+		level--;
+	}
+	while ((level < maxLevel) && (screenSize < g_LodScreenSizes[level] * (1.0f - g_LodHysteresis)))
+	{
+		level++;
+	}
+	item.lodLevel = level;
+
+	return(level);
+}
+
+/***********************************************************
+ *  GetMeshLodCount()
+ *
+ *  This method is used for getting the number of levels of
+ *  detail of the basic mesh for the mesh identifier.
+ ***********************************************************/
+int SceneManager::GetMeshLodCount(MESH_TYPE mesh) const
+{
+	if (mesh == MESH_TAPERED_CYLINDER)
+	{
+		return(m_instancedMeshes->GetTaperedCylinderLodCount());
+	}
+
+	return(1);
+}
+
+/***********************************************************
+ *  GetMeshGeometry()
+ *
+ *  This method is used for getting the generated geometry of
+ *  the basic mesh for the mesh identifier at a level of
+ *  detail.
+ ***********************************************************/
+const MeshManager::MESH_GEOMETRY& SceneManager::GetMeshGeometry(MESH_TYPE mesh, int lodLevel) const
+{
+	switch (mesh)
+	{
+	case MESH_BOX:
+		return(m_instancedMeshes->GetBoxMeshGeometry());
+	case MESH_TAPERED_CYLINDER:
+		return(m_instancedMeshes->GetTaperedCylinderMeshGeometry(lodLevel));
+	case MESH_PRISM:
+		return(m_instancedMeshes->GetPrismMeshGeometry());
+	case MESH_PYRAMID3:
+		return(m_instancedMeshes->GetPyramid3MeshGeometry());
+	default:
+		return(m_instancedMeshes->GetPlaneMeshGeometry());
+	}
+}
+
+/***********************************************************
+ *  BakeStaticObjects()
+ *
+ *  This method is used for baking every render item into the
+ *  static batches, with all of the levels of detail of its
+ *  mesh.  Each item keeps its own index range in the batches,
+ *  so it is still culled and given a level of detail on its
+ *  own, and an item that moves afterwards is drawn like the
+ *  other moving items instead.  The transparent items are
+ *  never baked.
+ ***********************************************************/
+void SceneManager::BakeStaticObjects()
+{
+	const MeshManager::MESH_GEOMETRY* lodGeometries[8];
+	const int maxLodCount = sizeof(lodGeometries) / sizeof(lodGeometries[0]);
+
+	m_pStaticBatch->Clear();
+	m_movedItems.clear();
+	for (size_t i = 0; i < m_renderItems.size(); i++)
+	{
+		RENDER_ITEM& item = m_renderItems[i];
+
+		// the transparent items need to be drawn in their back to
+		// front order, so they are drawn like the moving items
+		if (item.bTransparent == true)
+		{
+			item.staticObject = -1;
+			m_movedItems.push_back(i);
+			continue;
+		}
+
+		int lodCount = std::min(GetMeshLodCount(item.mesh), maxLodCount);
+
+		for (int lod = 0; lod < lodCount; lod++)
+		{
+			lodGeometries[lod] = &GetMeshGeometry(item.mesh, lod);
+		}
+		item.staticObject = m_pStaticBatch->AddObject(
+			lodGeometries,
+			lodCount,
+			item.modelMatrix,
+			item.color,
+			item.uvScale,
+			(item.textureLayer >= 0) ? (float)item.textureLayer : 0.0f);
+	}
+	m_pStaticBatch->Upload();
+
+	if (m_bGpuCulling == true)
+	{
+		BuildGpuDrawGroups();
+	}
+}
+
+/***********************************************************
+ *  BuildGpuDrawGroups()
+ *
+ *  This method is used for giving the baked items to the GPU
+ *  culling.  The items sharing a texture array and material
+ *  are put in one draw group, which is drawn with a single
+ *  indirect draw.  The GPU culling is turned off when the
+ *  context has no compute shaders or the shader fails, and
+ *  also when the occlusion culling is on but the depth
+ *  pyramid cannot be built, so that the baked items keep the
+ *  occlusion queries of the CPU culling.
+ ***********************************************************/
+void SceneManager::BuildGpuDrawGroups()
+{
+	m_drawGroups.clear();
+	m_pGpuCuller->Clear();
+	m_pDepthPyramid->Invalidate();
+	if ((GpuCuller::IsSupported() == false) ||
+		(m_pGpuCuller->LoadShader(m_pShaderCache, g_CullingShaderFilename) == false))
+	{
+		m_bGpuCulling = false;
+		return;
+	}
+	if ((m_bOcclusionCulling == true) &&
+		((DepthPyramid::IsSupported() == false) ||
+		 (m_pDepthPyramid->LoadShader(m_pShaderCache, g_DepthPyramidShaderFilename) == false)))
+	{
+		std::cout << "The baked items are culled on the CPU, since the depth pyramid is not available" << std::endl;
+		m_bGpuCulling = false;
+		return;
+	}
+
+	std::unordered_map<long long, int> groupIndices;
+	for (size_t i = 0; i < m_renderItems.size(); i++)
+	{
+		const RENDER_ITEM& item = m_renderItems[i];
+		if (item.staticObject < 0)
+		{
+			continue;
+		}
+		long long key = ((long long)(item.textureArray + 1) << 32) | (unsigned int)item.materialIndex;
+
+		std::unordered_map<long long, int>::const_iterator found = groupIndices.find(key);
+		int group = 0;
+		if (found != groupIndices.end())
+		{
+			group = found->second;
+		}
+		else
+		{
+			DRAW_GROUP drawGroup;
+			drawGroup.textureArray = item.textureArray;
+			drawGroup.materialIndex = item.materialIndex;
+			drawGroup.scopeName = GetStaticScopeName(item.textureArray, item.materialIndex);
+			group = m_drawGroups.size();
+			m_drawGroups.push_back(drawGroup);
+			groupIndices[key] = group;
+		}
+
+		m_pGpuCuller->AddObject(*m_pStaticBatch, item.staticObject, item.boundsMin, item.boundsMax, group);
+	}
+	m_pGpuCuller->Upload(*m_pStaticBatch, m_drawGroups.size());
+
+	m_bGpuCulling = m_pGpuCuller->IsReady();
+}
+
+/***********************************************************
+ *  SplitStaticItems()
+ *
+ *  This method is used for moving the visible items that are
+ *  baked into the static batches out of the visible order,
+ *  sorted so the items sharing a texture array and material
+ *  are next to each other whatever their mesh.
+ ***********************************************************/
+void SceneManager::SplitStaticItems()
+{
+	m_staticVisible.clear();
+	if (m_bStaticBatching == false)
+	{
+		return;
+	}
+
+	int dynamicCount = 0;
+	for (size_t i = 0; i < m_visibleOrder.size(); i++)
+	{
+		if (m_renderItems[m_visibleOrder[i]].staticObject >= 0)
+		{
+			m_staticVisible.push_back(m_visibleOrder[i]);
+		}
+		else
+		{
+			m_visibleOrder[dynamicCount++] = m_visibleOrder[i];
+		}
+	}
+	m_visibleOrder.resize(dynamicCount);
+
+	std::sort(m_staticVisible.begin(), m_staticVisible.end(),
+		[this](int a, int b)
+		{
+			const RENDER_ITEM& itemA = m_renderItems[a];
+			const RENDER_ITEM& itemB = m_renderItems[b];
+
+			if (itemA.textureArray != itemB.textureArray)
+				return(itemA.textureArray < itemB.textureArray);
+			if (itemA.materialIndex != itemB.materialIndex)
+				return(itemA.materialIndex < itemB.materialIndex);
+			return(m_drawRank[a] < m_drawRank[b]);
+		});
+	m_renderStats.staticItems = m_staticVisible.size();
+}
+
+/***********************************************************
+ *  UploadStaticCommands()
+ *
+ *  This method is used for writing the draw commands of all
+ *  of the visible baked items at once, which are then drawn
+ *  by both the depth prepass and the opaque pass.  The GPU
+ *  culling writes its own commands.
+ ***********************************************************/
+void SceneManager::UploadStaticCommands()
+{
+	if ((m_bGpuCulling == true) || (m_staticVisible.empty() == true))
+	{
+		return;
+	}
+
+	m_pStaticBatch->ClearCommands();
+	for (size_t i = 0; i < m_staticVisible.size(); i++)
+	{
+		const RENDER_ITEM& item = m_renderItems[m_staticVisible[i]];
+		m_pStaticBatch->AddCommand(item.staticObject, item.lodLevel);
+	}
+	m_pStaticBatch->UploadCommands();
+}
+
+/***********************************************************
+ *  DrawStaticBatches()
+ *
+ *  This method is used for drawing the visible baked items.
+ *  Each run of items sharing a texture array and material is
+ *  drawn with one multi-draw command of the uploaded
+ *  commands.  The depth prepass skips the texture and
+ *  material of the runs, and in the opaque pass each run is
+ *  timed by its texture array and material.
+ ***********************************************************/
+void SceneManager::DrawStaticBatches(bool bProfileGroups)
+{
+	// the culling shader has written the commands of every draw
+	// group, so the CPU only sets the state of each group
+	if (m_bGpuCulling == true)
+	{
+		SetUseInstancing(false);
+		SetUseStaticBatch(true);
+		for (size_t i = 0; i < m_drawGroups.size(); i++)
+		{
+			if (m_bDepthOnlyPass == false)
+			{
+				if (m_drawGroups[i].textureArray >= 0)
+				{
+					SetShaderTextureArray(m_drawGroups[i].textureArray);
+				}
+				else
+				{
+					SetUseTexture(false);
+				}
+				SetShaderMaterial(m_drawGroups[i].materialIndex);
+			}
+
+			if (bProfileGroups == true)
+			{
+				ProfileScope scope(m_pProfiler, m_drawGroups[i].scopeName);
+				m_pGpuCuller->DrawGroup(i);
+			}
+			else
+			{
+				m_pGpuCuller->DrawGroup(i);
+			}
+			m_renderStats.drawCalls++;
+		}
+		SetUseStaticBatch(false);
+		return;
+	}
+
+	if (m_staticVisible.empty() == true)
+	{
+		return;
+	}
+
+	SetUseInstancing(false);
+	SetUseStaticBatch(true);
+
+	int runStart = 0;
+	while (runStart < m_staticVisible.size())
+	{
+		const RENDER_ITEM& firstItem = m_renderItems[m_staticVisible[runStart]];
+		int runEnd = runStart + 1;
+		while ((runEnd < m_staticVisible.size()) &&
+			(m_renderItems[m_staticVisible[runEnd]].textureArray == firstItem.textureArray) &&
+			(m_renderItems[m_staticVisible[runEnd]].materialIndex == firstItem.materialIndex))
+		{
+			runEnd++;
+		}
+
+		if (m_bDepthOnlyPass == false)
+		{
+			if (firstItem.textureArray >= 0)
+			{
+				SetShaderTextureArray(firstItem.textureArray);
+			}
+			else
+			{
+				SetUseTexture(false);
+			}
+			SetShaderMaterial(firstItem.materialIndex);
+		}
+
+		if (bProfileGroups == true)
+		{
+			ProfileScope scope(m_pProfiler,
+				GetStaticScopeName(firstItem.textureArray, firstItem.materialIndex));
+			m_pStaticBatch->DrawCommands(runStart, runEnd - runStart);
+		}
+		else
+		{
+			m_pStaticBatch->DrawCommands(runStart, runEnd - runStart);
+		}
+		m_renderStats.drawCalls++;
+
+		runStart = runEnd;
+	}
+
+	SetUseStaticBatch(false);
+}
+
+/***********************************************************
+ *  GetStaticScopeName()
+ *
+ *  This method is used for getting the name that the draws
+ *  of the baked items sharing a texture array and material
+ *  are timed under, such as "Draw Static wood array 2".  The
+ *  names are kept in a set, so each one stays valid until
+ *  the profiler has read the frames that recorded it.
+ ***********************************************************/
+const char* SceneManager::GetStaticScopeName(int textureArray, int materialIndex)
+{
+	std::string name = "Draw Static";
+	if ((materialIndex >= 0) && (materialIndex < m_objectMaterials.size()))
+	{
+		name += " " + m_objectMaterials[materialIndex].tag;
+	}
+	if (textureArray >= 0)
+	{
+		name += " array " + std::to_string(textureArray);
+	}
+	else
+	{
+		name += " untextured";
+	}
+
+	return(m_scopeNames.insert(name).first->c_str());
+}
+
+/***********************************************************
+ *  SplitTransparentItems()
+ *
+ *  This method is used for moving the visible transparent
+ *  items to the end of the visible order, sorted from the
+ *  farthest to the nearest by the center of their bounds, so
+ *  that each one is blended over the items behind it.  The
+ *  opaque items keep their sorted order in front of them.
+ ***********************************************************/
+void SceneManager::SplitTransparentItems()
+{
+	// the transparent items are set aside in the frame arena while
+	// the opaque ones are moved up in place, which keeps the order
+	// of both without allocating
+	int* pTransparent = m_pFrameArena->Allocate<int>(m_visibleOrder.size());
+	int transparentCount = 0;
+	int opaqueCount = 0;
+	for (size_t i = 0; i < m_visibleOrder.size(); i++)
+	{
+		int itemIndex = m_visibleOrder[i];
+		if (m_renderItems[itemIndex].bTransparent == false)
+		{
+			m_visibleOrder[opaqueCount++] = itemIndex;
+		}
+		else
+		{
+			pTransparent[transparentCount++] = itemIndex;
+		}
+	}
+	std::copy(pTransparent, pTransparent + transparentCount, m_visibleOrder.begin() + opaqueCount);
+
+	m_opaqueCount = opaqueCount;
+
+	std::sort(m_visibleOrder.begin() + opaqueCount, m_visibleOrder.end(),
+		[this](int a, int b)
+		{
+			const RENDER_ITEM& itemA = m_renderItems[a];
+			const RENDER_ITEM& itemB = m_renderItems[b];
+			glm::vec3 offsetA = (itemA.boundsMin + itemA.boundsMax) * 0.5f - m_viewPosition;
+			glm::vec3 offsetB = (itemB.boundsMin + itemB.boundsMax) * 0.5f - m_viewPosition;
+
+			return(glm::dot(offsetA, offsetA) > glm::dot(offsetB, offsetB));
+		});
+}
+
+/***********************************************************
+ *  BeginRenderPass()
+ *
+ *  This method is used for setting the depth, color and blend
+ *  state of a render pass.  The depth prepass only writes the
+ *  depth of the opaque items, with the shading skipped in the
+ *  fragment shader.  The opaque pass then only shades the
+ *  fragments whose depth equals the nearest one, and the
+ *  transparent pass blends without writing any depth.  The
+ *  shadow pass writes the depth of the casters pushed away
+ *  from the light by their slope, with its own program.
+ ***********************************************************/
+void SceneManager::BeginRenderPass(RENDER_PASS pass)
+{
+	switch (pass)
+	{
+	case PASS_DEPTH:
+		glDisable(GL_BLEND);
+		glDisable(GL_POLYGON_OFFSET_FILL);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_LESS);
+		break;
+	case PASS_OPAQUE:
+		glDisable(GL_BLEND);
+		glDisable(GL_POLYGON_OFFSET_FILL);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		if (m_bDepthPrepass == true)
+		{
+			glDepthMask(GL_FALSE);
+			glDepthFunc(GL_EQUAL);
+		}
+		else
+		{
+			glDepthMask(GL_TRUE);
+			glDepthFunc(GL_LESS);
+		}
+		break;
+	case PASS_TRANSPARENT:
+		glEnable(GL_BLEND);
+		glDisable(GL_POLYGON_OFFSET_FILL);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDepthMask(GL_FALSE);
+		glDepthFunc(GL_LESS);
+		break;
+	case PASS_SHADOW:
+		glDisable(GL_BLEND);
+		glEnable(GL_POLYGON_OFFSET_FILL);
+		glPolygonOffset(g_ShadowSlopeOffset, g_ShadowDepthOffset);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_LESS);
+		break;
+	}
+
+	m_bShadowPass = (pass == PASS_SHADOW);
+	m_bDepthOnlyPass = (pass == PASS_DEPTH) || (pass == PASS_SHADOW);
+	m_pUniformCache->SetBoolValue(m_uniforms.bDepthOnly, m_bDepthOnlyPass);
+	SelectShaderVariant();
+}
+
+/***********************************************************
+ *  EndRenderPasses()
+ *
+ *  This method is used for putting back the default depth
+ *  test with depth writes and no blending, which the
+ *  occlusion queries and the next frame start from.
+ ***********************************************************/
+void SceneManager::EndRenderPasses()
+{
+	glDisable(GL_BLEND);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+
+	m_bShadowPass = false;
+	m_bDepthOnlyPass = false;
+	m_pUniformCache->SetBoolValue(m_uniforms.bDepthOnly, false);
+	SelectShaderVariant();
+}
+
+/***********************************************************
+ *  IssueOcclusionQueries()
+ *
+ *  This method is used for drawing the grown bounding box of
+ *  each render item in the frustum that is due for a query,
+ *  against the depth of the drawn visible items, with the
+ *  color and depth writes off.  The results are read in a
+ *  later frame, so a hidden item that comes into view is
+ *  drawn one frame after its box is found to be visible.
+ ***********************************************************/
+void SceneManager::IssueOcclusionQueries()
+{
+	MeshManager::MESH_BOUNDS boxBounds = GetMeshBounds(MESH_BOX);
+	glm::vec3 boxSize = boxBounds.maxXYZ - boxBounds.minXYZ;
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	SetUseInstancing(false);
+	SetUseTexture(false);
+
+	for (size_t i = 0; i < m_frustumVisible.size(); i++)
+	{
+		int itemIndex = m_frustumVisible[i];
+		if (m_pOcclusionCuller->NeedsQuery(itemIndex) == false)
+		{
+			continue;
+		}
+
+		const RENDER_ITEM& item = m_renderItems[itemIndex];
+		glm::vec3 growth = (item.boundsMax - item.boundsMin) * g_OcclusionBoxGrowth + glm::vec3(g_OcclusionBoxMargin);
+		glm::vec3 queryMin = item.boundsMin - growth;
+		glm::vec3 queryMax = item.boundsMax + growth;
+
+		// the box faces cannot be seen from inside of the box
+		if ((m_viewPosition.x >= queryMin.x) && (m_viewPosition.x <= queryMax.x) &&
+			(m_viewPosition.y >= queryMin.y) && (m_viewPosition.y <= queryMax.y) &&
+			(m_viewPosition.z >= queryMin.z) && (m_viewPosition.z <= queryMax.z))
+		{
+			m_pOcclusionCuller->SetVisible(itemIndex);
+			continue;
+		}
+
+		// map the box mesh onto the grown bounding box
+		glm::vec3 scaleXYZ = (queryMax - queryMin) / boxSize;
+		SetTransformations(glm::translate(queryMin - boxBounds.minXYZ * scaleXYZ) * glm::scale(scaleXYZ));
+
+		m_pOcclusionCuller->BeginQuery(itemIndex);
+		DrawMesh(MESH_BOX);
+		m_pOcclusionCuller->EndQuery();
+	}
+
+	glDepthMask(GL_TRUE);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+	m_renderStats.occlusionQueries = m_pOcclusionCuller->GetQueryCount();
+}
+
+/***********************************************************
+ *  SortRenderItems()
+ *
+ *  This method is used for building the order that the render
+ *  items are submitted in.  The items are sorted by mesh, then
+ *  texture, then material so that consecutive draws share as
+ *  much shader state as possible.
+ ***********************************************************/
+void SceneManager::SortRenderItems()
+{
+	m_drawOrder.resize(m_renderItems.size());
+	for (int i = 0; i < m_drawOrder.size(); i++)
+	{
+		m_drawOrder[i] = i;
+	}
+
+	// a stable sort keeps the authoring order for equal state
+	std::stable_sort(m_drawOrder.begin(), m_drawOrder.end(),
+		[this](int a, int b)
+		{
+			const RENDER_ITEM& itemA = m_renderItems[a];
+			const RENDER_ITEM& itemB = m_renderItems[b];
+
+			if (itemA.mesh != itemB.mesh)
+				return(itemA.mesh < itemB.mesh);
+			if (itemA.textureArray != itemB.textureArray)
+				return(itemA.textureArray < itemB.textureArray);
+			if (itemA.materialIndex != itemB.materialIndex)
+				return(itemA.materialIndex < itemB.materialIndex);
+			return(itemA.textureLayer < itemB.textureLayer);
+		});
+
+	// the position of each item in the order, for sorting the
+	// visible items found by the spatial index
+	m_drawRank.resize(m_drawOrder.size());
+	for (int i = 0; i < m_drawOrder.size(); i++)
+	{
+		m_drawRank[m_drawOrder[i]] = i;
+	}
+
+	m_bDrawOrderDirty = false;
+}
+
+/***********************************************************
+ *  BuildSpatialIndex()
+ *
+ *  This method is used for building the bounding volume
+ *  hierarchy over the boxes of all of the render items.
+ *  Items that move afterwards only refit the tree.
+ ***********************************************************/
+void SceneManager::BuildSpatialIndex()
+{
+	std::vector<glm::vec3> itemMins(m_renderItems.size());
+	std::vector<glm::vec3> itemMaxs(m_renderItems.size());
+
+	for (size_t i = 0; i < m_renderItems.size(); i++)
+	{
+		itemMins[i] = m_renderItems[i].boundsMin;
+		itemMaxs[i] = m_renderItems[i].boundsMax;
+	}
+
+	m_spatialIndex.Build(itemMins, itemMaxs);
+	m_pOcclusionCuller->Resize(m_renderItems.size());
+}
+
+/***********************************************************
+ *  IsSameBatch()
+ *
+ *  This method is used for checking whether two render items
+ *  share the mesh, texture array and material, so that they can be
+ *  drawn together in one instanced batch.
+ ***********************************************************/
+bool SceneManager::IsSameBatch(const RENDER_ITEM& itemA, const RENDER_ITEM& itemB)
+{
+	return((itemA.mesh == itemB.mesh) &&
+		(itemA.textureArray == itemB.textureArray) &&
+		(itemA.materialIndex == itemB.materialIndex) &&
+		(itemA.lodLevel == itemB.lodLevel));
+}
+
+/***********************************************************
+ *  UploadVisibleInstances()
+ *
+ *  This method is used for writing the per-instance values of
+ *  all of the visible items drawn on the CPU straight into the
+ *  instance buffer in one pass, in the visible order, so that
+ *  each batch draws its run of the instances without any
+ *  uniforms per object.  The casters of the shadow maps drawn
+ *  in this frame are written after them.
+ ***********************************************************/
+void SceneManager::UploadVisibleInstances()
+{
+	int visibleCount = m_visibleOrder.size();
+	int instanceCount = visibleCount + m_shadowCasters.size();
+	if (instanceCount == 0)
+	{
+		return;
+	}
+
+	MeshManager::INSTANCE_DATA* pInstances = m_instancedMeshes->BeginInstances(instanceCount);
+	if (pInstances == NULL)
+	{
+		return;
+	}
+
+	// every job writes its own range of the mapped buffer, with
+	// the shadow casters after the visible items
+	RunParallel(instanceCount,
+		[this, pInstances, visibleCount](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				int itemIndex = (i < visibleCount) ? m_visibleOrder[i] : m_shadowCasters[i - visibleCount];
+				const RENDER_ITEM& item = m_renderItems[itemIndex];
+				MeshManager::INSTANCE_DATA& instance = pInstances[i];
+
+				instance.model = item.modelMatrix;
+				instance.color = item.color;
+				instance.uvScale = item.uvScale;
+				instance.textureLayer = (item.textureLayer >= 0) ? (float)item.textureLayer : 0.0f;
+			}
+		});
+	m_instancedMeshes->EndInstances();
+}
+
+/***********************************************************
+ *  DrawInstancedBatch()
+ *
+ *  This method is used for drawing the render items between
+ *  the passed in positions of the visible order with one
+ *  instanced draw command.  The batch shares the texture array
+ *  and material, while the model matrix, color, UV scale and
+ *  texture layer of each item were uploaded as per-instance
+ *  values by UploadVisibleInstances().
+ ***********************************************************/
+void SceneManager::DrawInstancedBatch(int firstOrder, int endOrder)
+{
+	const RENDER_ITEM& firstItem = m_renderItems[m_visibleOrder[firstOrder]];
+
+	SetUseInstancing(true);
+	if (m_bDepthOnlyPass == false)
+	{
+		if (firstItem.textureArray >= 0)
+		{
+			SetShaderTextureArray(firstItem.textureArray);
+		}
+		else
+		{
+			SetUseTexture(false);
+		}
+		SetShaderMaterial(firstItem.materialIndex);
+	}
+
+	DrawMeshInstanced(firstItem.mesh, firstOrder, endOrder - firstOrder, firstItem.lodLevel);
+	m_renderStats.drawCalls++;
+	m_renderStats.instancedDrawCalls++;
+}
+
+/***********************************************************
+ *  DrawInstancedBatches()
+ *
+ *  This method is used for drawing the visible render items
+ *  between the passed in positions of the visible order.
+ *  Each run of items that can share a batch is drawn with
+ *  one instanced draw, and in the opaque pass each batch is
+ *  timed by the mesh it draws.
+ ***********************************************************/
+void SceneManager::DrawInstancedBatches(int firstOrder, int endOrder, bool bProfileMeshes)
+{
+	int batchStart = firstOrder;
+	while (batchStart < endOrder)
+	{
+		int batchEnd = batchStart + 1;
+		while ((batchEnd < endOrder) &&
+			(IsSameBatch(m_renderItems[m_visibleOrder[batchStart]], m_renderItems[m_visibleOrder[batchEnd]]) == true))
+		{
+			batchEnd++;
+		}
+
+		// the objects are timed per batch of the same mesh, since
+		// that is how they are submitted - a single item is drawn
+		// as a batch of one, which needs no uniforms per object
+		if (bProfileMeshes == true)
+		{
+			MESH_TYPE mesh = m_renderItems[m_visibleOrder[batchStart]].mesh;
+			ProfileScope scope(m_pProfiler, g_InstancedScopeNames[mesh]);
+			DrawInstancedBatch(batchStart, batchEnd);
+		}
+		else
+		{
+			DrawInstancedBatch(batchStart, batchEnd);
+		}
+
+		batchStart = batchEnd;
+	}
+}
+
+/***********************************************************
+ *  DrawMeshInstanced()
+ *
+ *  This method is used for drawing a run of the uploaded
+ *  instances of the basic mesh for the mesh identifier.
+ ***********************************************************/
+void SceneManager::DrawMeshInstanced(
+	MESH_TYPE mesh,
+	int firstInstance,
+	int instanceCount,
+	int lodLevel)
+{
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		m_instancedMeshes->DrawPlaneMeshInstanced(firstInstance, instanceCount);
+		break;
+	case MESH_BOX:
+		m_instancedMeshes->DrawBoxMeshInstanced(firstInstance, instanceCount);
+		break;
+	case MESH_TAPERED_CYLINDER:
+		m_instancedMeshes->DrawTaperedCylinderMeshInstanced(firstInstance, instanceCount, lodLevel);
+		break;
+	case MESH_PRISM:
+		m_instancedMeshes->DrawPrismMeshInstanced(firstInstance, instanceCount);
+		break;
+	case MESH_PYRAMID3:
+		m_instancedMeshes->DrawPyramid3MeshInstanced(firstInstance, instanceCount);
+		break;
+	}
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing the basic mesh that is
+ *  associated with the passed in mesh identifier.
+ ***********************************************************/
+void SceneManager::DrawMesh(MESH_TYPE mesh)
+{
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		m_instancedMeshes->DrawPlaneMesh();
+		break;
+	case MESH_BOX:
+		m_instancedMeshes->DrawBoxMesh();
+		break;
+	case MESH_TAPERED_CYLINDER:
+		m_instancedMeshes->DrawTaperedCylinderMesh();
+		break;
+	case MESH_PRISM:
+		m_instancedMeshes->DrawPrismMesh();
+		break;
+	case MESH_PYRAMID3:
+		m_instancedMeshes->DrawPyramid3Mesh();
+		break;
+	}
+}
+
+/***********************************************************
+ *  CollectShadowPasses()
+ *
+ *  This method is used for aiming the shadow maps and for
+ *  listing the layers that need to be drawn in this frame.
+ *  The cached maps of the objects that never move are only
+ *  drawn again when those objects change, and the moving
+ *  objects are drawn into their own maps every frame, which
+ *  the shaders combine with the cached ones.  The cascades of
+ *  the sun are split the same way, and their cached maps are
+ *  also drawn again when a cascade moves into another texel
+ *  as the camera moves.
+ *  A scene that holds still draws no shadow maps at all.
+ ***********************************************************/
+void SceneManager::CollectShadowPasses()
+{
+	m_shadowPasses.clear();
+	m_shadowCasters.clear();
+
+	SettleDynamicItems();
+
+	if (m_bStaticShadowsDirty == true)
+	{
+		GetSceneBounds(m_shadowBoundsMin, m_shadowBoundsMax);
+		for (size_t i = 0; i < m_shadowLights.size(); i++)
+		{
+			const LIGHT_BLOCK_ENTRY& light = m_lightSources[m_shadowLights[i]];
+			m_pShadowMaps->AimLight(m_shadowLights[i], light.position, m_shadowBoundsMin, m_shadowBoundsMax);
+			AddShadowPass(ShadowMaps::MAPS_STATIC, i,
+				m_pShadowMaps->GetLightMatrix(m_shadowLights[i]), true, false);
+		}
+	}
+
+	int cascadeCount = m_pShadowMaps->GetLayerCount(ShadowMaps::MAPS_SUN);
+	bool bDynamicShadows = (m_dynamicItems.empty() == false) &&
+		((m_shadowLights.empty() == false) || (cascadeCount > 0));
+	if (bDynamicShadows == true)
+	{
+		for (size_t i = 0; i < m_shadowLights.size(); i++)
+		{
+			AddShadowPass(ShadowMaps::MAPS_DYNAMIC, i,
+				m_pShadowMaps->GetLightMatrix(m_shadowLights[i]), false, true);
+		}
+	}
+	m_pShadowMaps->SetDynamicShadows(bDynamicShadows);
+
+	if (cascadeCount > 0)
+	{
+		bool bMoved = m_pShadowMaps->FitCascades(m_view, m_projection,
+			g_SunShadowDistance, m_shadowBoundsMin, m_shadowBoundsMax);
+		for (int i = 0; i < cascadeCount; i++)
+		{
+			if ((bMoved == true) || (m_bStaticShadowsDirty == true))
+			{
+				AddShadowPass(ShadowMaps::MAPS_SUN, i, m_pShadowMaps->GetCascadeMatrix(i), true, false);
+			}
+			if (bDynamicShadows == true)
+			{
+				AddShadowPass(ShadowMaps::MAPS_SUN_DYNAMIC, i, m_pShadowMaps->GetCascadeMatrix(i), false, true);
+			}
+		}
+	}
+
+	m_bStaticShadowsDirty = false;
+	m_pShadowMaps->Upload();
+}
+
+/***********************************************************
+ *  SettleDynamicItems()
+ *
+ *  This method is used for counting the frames since each
+ *  moving item last moved, and for putting the items that
+ *  have held still for long enough back with the objects that
+ *  never move.  The cached shadow maps are drawn again once
+ *  with them, and the per-frame maps are not drawn at all
+ *  once no item moves anymore.
+ ***********************************************************/
+void SceneManager::SettleDynamicItems()
+{
+	size_t movingCount = 0;
+	for (size_t i = 0; i < m_dynamicItems.size(); i++)
+	{
+		RENDER_ITEM& item = m_renderItems[m_dynamicItems[i]];
+		item.stillFrames++;
+		if (item.stillFrames > g_DynamicSettleFrames)
+		{
+			item.bDynamic = false;
+			m_bStaticShadowsDirty = true;
+		}
+		else
+		{
+			m_dynamicItems[movingCount++] = m_dynamicItems[i];
+		}
+	}
+	m_dynamicItems.resize(movingCount);
+}
+
+/***********************************************************
+ *  AddShadowPass()
+ *
+ *  This method is used for adding a layer of the shadow maps
+ *  to draw, with the opaque render items inside of its light
+ *  space as its casters.  The items that never move are found
+ *  through the spatial index, and the few moving ones are
+ *  tested one by one.  The casters are sorted by their mesh,
+ *  so that each mesh is drawn with one instanced draw.
+ ***********************************************************/
+void SceneManager::AddShadowPass(
+	ShadowMaps::MAP_SET mapSet,
+	int layer,
+	const glm::mat4& lightMatrix,
+	bool bStaticCasters,
+	bool bDynamicCasters)
+{
+	Frustum lightFrustum;
+	lightFrustum.Extract(lightMatrix);
+
+	SHADOW_PASS pass;
+	pass.mapSet = mapSet;
+	pass.layer = layer;
+	pass.lightMatrix = lightMatrix;
+	pass.firstCaster = m_shadowCasters.size();
+
+	if (bStaticCasters == true)
+	{
+		if (NULL != m_pCellStreamer)
+		{
+			const std::vector<int>& residentCells = m_pCellStreamer->GetResidentCells();
+			for (size_t i = 0; i < residentCells.size(); i++)
+			{
+				const CellStreamer::CELL& cell = m_pCellStreamer->GetCell(residentCells[i]);
+				if (lightFrustum.IsBoxVisible(cell.boundsMin, cell.boundsMax) == true)
+				{
+					// the slot index holds the positions in the slot
+					size_t firstFound = m_shadowCasters.size();
+					m_slotIndices[cell.slot].QueryFrustum(lightFrustum, m_shadowCasters);
+					for (size_t j = firstFound; j < m_shadowCasters.size(); j++)
+					{
+						m_shadowCasters[j] += cell.slot * m_slotCapacity;
+					}
+				}
+			}
+		}
+		else
+		{
+			m_spatialIndex.QueryFrustum(lightFrustum, m_shadowCasters);
+		}
+
+		// the see-through items cast no shadows, and the moving
+		// ones are in the maps of the moving items
+		int casterEnd = pass.firstCaster;
+		for (size_t i = pass.firstCaster; i < m_shadowCasters.size(); i++)
+		{
+			const RENDER_ITEM& item = m_renderItems[m_shadowCasters[i]];
+			if ((item.bTransparent == false) && (item.bDynamic == false))
+			{
+				m_shadowCasters[casterEnd++] = m_shadowCasters[i];
+			}
+		}
+		m_shadowCasters.resize(casterEnd);
+	}
+
+	if (bDynamicCasters == true)
+	{
+		for (size_t i = 0; i < m_dynamicItems.size(); i++)
+		{
+			const RENDER_ITEM& item = m_renderItems[m_dynamicItems[i]];
+			if ((item.bTransparent == false) &&
+				(lightFrustum.IsBoxVisible(item.boundsMin, item.boundsMax) == true))
+			{
+				m_shadowCasters.push_back(m_dynamicItems[i]);
+			}
+		}
+	}
+
+	std::sort(m_shadowCasters.begin() + pass.firstCaster, m_shadowCasters.end(),
+		[this](int a, int b)
+		{
+			if (m_renderItems[a].mesh != m_renderItems[b].mesh)
+				return(m_renderItems[a].mesh < m_renderItems[b].mesh);
+			return(a < b);
+		});
+
+	pass.casterCount = m_shadowCasters.size() - pass.firstCaster;
+	m_shadowPasses.push_back(pass);
+}
+
+/***********************************************************
+ *  DrawShadowPasses()
+ *
+ *  This method is used for drawing the casters of each listed
+ *  layer of the shadow maps into it, one instanced draw per
+ *  mesh, with the finest level of detail, and each draw is
+ *  timed by the mesh it draws.  The instances of
+ *  the casters follow the ones of the visible order in the
+ *  instance buffer.  The maps are drawn into their own
+ *  framebuffer, so the framebuffer and viewport of the scene
+ *  are put back afterwards.
+ ***********************************************************/
+void SceneManager::DrawShadowPasses()
+{
+	GLint framebuffer = 0;
+	GLint viewport[4] = { 0, 0, 0, 0 };
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	BeginRenderPass(PASS_SHADOW);
+	SetUseInstancing(true);
+
+	int firstInstance = m_visibleOrder.size();
+	for (size_t i = 0; i < m_shadowPasses.size(); i++)
+	{
+		const SHADOW_PASS& pass = m_shadowPasses[i];
+		m_pShadowMaps->BeginLayer(pass.mapSet, pass.layer);
+		m_pUniformCache->SetMat4Value(m_uniforms.lightViewProjection, pass.lightMatrix);
+
+		int runStart = pass.firstCaster;
+		int passEnd = pass.firstCaster + pass.casterCount;
+		while (runStart < passEnd)
+		{
+			MESH_TYPE mesh = m_renderItems[m_shadowCasters[runStart]].mesh;
+			int runEnd = runStart + 1;
+			while ((runEnd < passEnd) && (m_renderItems[m_shadowCasters[runEnd]].mesh == mesh))
+			{
+				runEnd++;
+			}
+
+			{
+				ProfileScope scope(m_pProfiler, g_ShadowScopeNames[mesh]);
+				DrawMeshInstanced(mesh, firstInstance + runStart, runEnd - runStart, 0);
+			}
+			m_renderStats.drawCalls++;
+			m_renderStats.instancedDrawCalls++;
+			m_renderStats.shadowDrawCalls++;
+			runStart = runEnd;
+		}
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
+
+/***************************************************************
+ * DefineObjectMaterials()
+ *
+ * Method for defining various material settings for all objects
+ * within the 3D scene.
+ ***************************************************************/
+void SceneManager::DefineObjectMaterials() {
+	
+	// shiny material definition
+	OBJECT_MATERIAL shinyMaterial;
+	shinyMaterial.ambientColor = glm::vec3(0.3f, 0.1f, 0.1f);
+	shinyMaterial.ambientStrength = 0.1;
+	shinyMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	shinyMaterial.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	shinyMaterial.shininess = 64.0f;
+	shinyMaterial.tag = "metal";
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	AddObjectMaterial(shinyMaterial);
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+	// dull material definition
+	OBJECT_MATERIAL dullMaterial;
+	dullMaterial.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	dullMaterial.ambientStrength = 0.1;
+	dullMaterial.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	dullMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	dullMaterial.shininess = 16.0f;
+	dullMaterial.tag = "wood";
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	AddObjectMaterial(dullMaterial);
+}
+/*******************************************************
+ * SetupSceneLights()
+ * 
+ * Method for adding and configuring light sources, 4 max
+ *******************************************************/
+void SceneManager::SetupSceneLights() {
 
-	SetShaderColor(0.5, 0.5, 0.5, 1); // grey color
-	SetShaderTexture("grass"); // calling grass texture
-	SetTextureUVScale(1, 1); // mapping texture across entire plane
-	SetShaderMaterial("metal");
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh(); // draw plane
+	// using default OpenGL lighting
+	m_pUniformCache->SetBoolValue(m_uniforms.bUseLighting, true);
+	m_bSceneLighting = true;
 
-	// drawing second plane (behind the house)
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
+	// camera position at (0.0f, 5.0f, 12.0f) making sure all light positions aren't blocked by camera
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f; // x rotation to place plane behind the house
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	// light 1
+	DefineLightSource(0,
+		glm::vec3(-7.0f, 7.0f, 10.0f),
+		glm::vec3(0.8f, 0.8f, 0.7f),
+		glm::vec3(1.0f, 0.95f, 0.85f),
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		32.0f, 0.7f);
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 9.0f, -10.0f); // moving plane 9 y units and -10 z units to align planes, same x value
+	// light 2
+	DefineLightSource(1,
+		glm::vec3(7.0f, -6.0f, 1.0f),
+		glm::vec3(0.8f, 0.8f, 0.7f),
+		glm::vec3(1.0f, 0.95f, 0.85f),
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		32.0f, 0.7f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// light 3
+	DefineLightSource(2,
+		glm::vec3(7.0f, 7.0f, 5.0f),
+		glm::vec3(0.8f, 0.8f, 0.7f),
+		glm::vec3(1.0f, 0.95f, 0.85f),
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		16.0f, 0.7f);
 
-	SetShaderColor(0.55, 0.55, 0.55, 1); // lighter grey color for contrast
-	SetShaderMaterial("metal"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh(); // draw plane
-	/****************************************************************/
+	// light 4
+	DefineLightSource(3,
+		glm::vec3(-7.0f, -6.0f, 1.0f),
+		glm::vec3(0.8f, 0.8f, 0.7f),
+		glm::vec3(1.0f, 0.95f, 0.85f),
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		32.0f, 0.7f);
+
+	// all of the light sources are uploaded with one buffer update
+	m_pLightBuffer->Update(m_lightSources, sizeof(m_lightSources));
+}
+
+/***********************************************************
+ *  ScatterPointLights()
+ *
+ *  This method is used for spreading the requested number
+ *  of point lights in a grid over the bounds of the render
+ *  items, which is used for scaling the lighting in the
+ *  benchmark.
+ ***********************************************************/
+void SceneManager::ScatterPointLights()
+{
+	if (m_scatteredLightCount <= 0)
+	{
+		return;
+	}
+
+	glm::vec3 sceneMin;
+	glm::vec3 sceneMax;
+	GetSceneBounds(sceneMin, sceneMax);
+
+	int columns = (int)ceilf(sqrtf((float)m_scatteredLightCount));
+	int rows = (m_scatteredLightCount + columns - 1) / columns;
+	glm::vec3 cellSize = glm::vec3(
+		(sceneMax.x - sceneMin.x) / columns,
+		0.0f,
+		(sceneMax.z - sceneMin.z) / rows);
+
+	for (int i = 0; i < m_scatteredLightCount; i++)
+	{
+		glm::vec3 position = glm::vec3(
+			sceneMin.x + ((i % columns) + 0.5f) * cellSize.x,
+			sceneMin.y + g_ScatteredLightHeight,
+			sceneMin.z + ((i / columns) + 0.5f) * cellSize.z);
+		AddPointLight(position, g_ScatteredLightRadius, g_ScatteredLightColor, g_ScatteredLightSpecular);
+	}
+}
+
+/***********************************************************
+ *  SetupClusteredLights()
+ *
+ *  This method is used for uploading the point lights and
+ *  loading the shader that bins them into the clusters of
+ *  the view.  The point lights are left out when the context
+ *  has no compute shaders or the shader fails, and the
+ *  fixed light sources light the scene on their own.
+ ***********************************************************/
+void SceneManager::SetupClusteredLights()
+{
+	m_bClusteredLighting = false;
+	if (m_pClusteredLights->GetLightCount() == 0)
+	{
+		return;
+	}
+
+	if ((ClusteredLights::IsSupported() == false) ||
+		(m_pClusteredLights->LoadShader(m_pShaderCache, g_LightClusterShaderFilename) == false))
+	{
+		std::cout << "The " << m_pClusteredLights->GetLightCount()
+			<< " point lights need compute shaders and are not drawn" << std::endl;
+		return;
+	}
+
+	m_pClusteredLights->Upload();
+	m_bClusteredLighting = m_pClusteredLights->IsReady();
+	m_pUniformCache->SetBoolValue(m_uniforms.bUseClusteredLights, m_bClusteredLighting);
+}
+
+/***********************************************************
+ *  BuildShaderVariants()
+ *
+ *  This method is used for building the variants of the
+ *  shader program for the depth prepass, the colored and the
+ *  textured draws.  Each one has the light count, the lighting
+ *  and the clustered lights of the scene built in, so the
+ *  compiler removes the branches and the light loop work that
+ *  the scene never uses.  The uber shader program keeps
+ *  drawing when any of them fails.
+ ***********************************************************/
+void SceneManager::BuildShaderVariants()
+{
+	for (int i = 0; i < VARIANT_COUNT; i++)
+	{
+		m_variantSlots[i] = -1;
+	}
+	if (m_bShaderVariants == false)
+	{
+		return;
+	}
+
+	int variantSlots[VARIANT_COUNT];
+	for (int i = 0; i < VARIANT_COUNT; i++)
+	{
+		bool bDepthOnly = (i == VARIANT_DEPTH);
+		bool bLighting = (bDepthOnly == false) && (m_bSceneLighting == true);
+		bool bClustered = (bLighting == true) && (m_bClusteredLighting == true);
+		bool bShadowed = (bLighting == true) && (m_bShadowMaps == true);
+
+		std::ostringstream defines;
+		defines << "#define SPECIALIZED\n"
+			<< "#define USE_TEXTURE " << ((i == VARIANT_TEXTURE) ? "true" : "false") << "\n"
+			<< "#define USE_LIGHTING " << (bLighting ? "true" : "false") << "\n"
+			<< "#define USE_CLUSTERED_LIGHTS " << (bClustered ? "true" : "false") << "\n"
+			<< "#define DEPTH_ONLY " << (bDepthOnly ? "true" : "false") << "\n"
+			<< "#define USE_SHADOWS " << (bShadowed ? "true" : "false") << "\n"
+			<< "#define LIGHT_COUNT " << (bLighting ? m_lightSourceCount : 0) << "\n";
+
+		GLuint programID = m_pShaderCache->GetProgram(
+			g_VertexShaderFilename, g_FragmentShaderFilename, defines.str());
+		if (programID == 0)
+		{
+			std::cout << "Using the uber shader program instead of its variants" << std::endl;
+			return;
+		}
+
+		UniformBuffer::BindProgramBlocks(programID);
+		ClusteredLights::BindProgramBlocks(programID);
+		variantSlots[i] = m_pUniformCache->LoadProgramUniforms(programID);
+	}
+
+	for (int i = 0; i < VARIANT_COUNT; i++)
+	{
+		m_variantSlots[i] = variantSlots[i];
+	}
+	SelectShaderVariant();
+}
+
+/***********************************************************
+ *  SelectShaderVariant()
+ *
+ *  This method is used for making the variant of the shader
+ *  program for the current pass and texture switch the
+ *  current program.  The uniform cache sets the values that
+ *  the variant missed while another program was current.
+ *  The shadow casters are drawn with their own program, with
+ *  or without the variants.
+ ***********************************************************/
+void SceneManager::SelectShaderVariant()
+{
+	if (m_bShadowPass == true)
+	{
+		m_pUniformCache->UseProgram(m_shadowSlot);
+		return;
+	}
+	if (m_variantSlots[VARIANT_COLOR] < 0)
+	{
+		m_pUniformCache->UseProgram(m_programSlot);
+		return;
+	}
+
+	SHADER_VARIANT variant = VARIANT_COLOR;
+	if (m_bDepthOnlyPass == true)
+	{
+		variant = VARIANT_DEPTH;
+	}
+	else if ((m_stateCache.bUseTextureValid == true) && (m_stateCache.bUseTexture == true))
+	{
+		variant = VARIANT_TEXTURE;
+	}
+
+	m_pUniformCache->UseProgram(m_variantSlots[variant]);
+}
+
+/***********************************************************
+ *  SetupShadowMaps()
+ *
+ *  This method is used for creating the shadow maps of the
+ *  light sources and the sun, and for loading the program
+ *  that draws the casters into them.  A light source below
+ *  the objects lights them from under the ground, which
+ *  would shadow all of them, so it is left without shadows.
+ *  The scene is lit without shadows when the maps or the
+ *  program cannot be created.
+ ***********************************************************/
+void SceneManager::SetupShadowMaps()
+{
+	m_bShadowMaps = false;
+	m_shadowLights.clear();
+	if ((m_bShadows == false) || (m_bSceneLighting == false))
+	{
+		return;
+	}
+
+	glm::vec3 sceneMin;
+	glm::vec3 sceneMax;
+	GetSceneBounds(sceneMin, sceneMax);
+	for (int i = 0; i < m_lightSourceCount; i++)
+	{
+		if ((m_lightSources[i].position.y > sceneMin.y) &&
+			(m_shadowLights.size() < UniformBuffer::TOTAL_LIGHTS))
+		{
+			m_shadowLights.push_back(i);
+		}
+	}
+	int cascadeCount = (m_bSunLight == true) ? g_SunCascadeCount : 0;
+	if ((m_shadowLights.empty() == true) && (cascadeCount == 0))
+	{
+		return;
+	}
+
+	// the casters only need their depth, so the program is built
+	// with everything but the position switched off
+	std::ostringstream defines;
+	defines << "#define SHADOW_PASS\n"
+		<< "#define SPECIALIZED\n"
+		<< "#define USE_TEXTURE false\n"
+		<< "#define USE_LIGHTING false\n"
+		<< "#define USE_CLUSTERED_LIGHTS false\n"
+		<< "#define DEPTH_ONLY true\n"
+		<< "#define USE_SHADOWS false\n"
+		<< "#define LIGHT_COUNT 0\n";
+
+	GLuint programID = m_pShaderCache->GetProgram(
+		g_VertexShaderFilename, g_FragmentShaderFilename, defines.str());
+	if ((programID == 0) ||
+		(m_pShadowMaps->Create(m_shadowLights.size(), g_LightShadowMapSize, cascadeCount, g_SunShadowMapSize) == false))
+	{
+		std::cout << "The 3D scene is lit without shadows" << std::endl;
+		m_shadowLights.clear();
+		return;
+	}
+
+	UniformBuffer::BindProgramBlocks(programID);
+	m_shadowSlot = m_pUniformCache->LoadProgramUniforms(programID);
+
+	// the layer of each light source is read from the light block
+	for (size_t i = 0; i < m_shadowLights.size(); i++)
+	{
+		m_lightSources[m_shadowLights[i]].shadowLayer = (float)i;
+	}
+	m_pLightBuffer->Update(m_lightSources, sizeof(m_lightSources));
+
+	m_bShadowMaps = true;
+	m_bStaticShadowsDirty = true;
+	m_pUniformCache->SetBoolValue(m_uniforms.bUseShadows, true);
+}
+
+/***********************************************************
+ *  DefineLightSource()
+ *
+ *  This method is used for setting the values of the light
+ *  source at the passed in index.  The values are uploaded
+ *  into the light buffer at the end of SetupSceneLights().
+ ***********************************************************/
+void SceneManager::DefineLightSource(
+	int lightIndex,
+	glm::vec3 positionXYZ,
+	glm::vec3 ambientColor,
+	glm::vec3 diffuseColor,
+	glm::vec3 specularColor,
+	float focalStrength,
+	float specularIntensity)
+{
+	if ((lightIndex < 0) || (lightIndex >= UniformBuffer::TOTAL_LIGHTS))
+	{
+		std::cout << "Light source index " << lightIndex << " is out of range" << std::endl;
+		return;
+	}
+
+	LIGHT_BLOCK_ENTRY& light = m_lightSources[lightIndex];
+	light.position = positionXYZ;
+	light.ambientColor = ambientColor;
+	light.diffuseColor = diffuseColor;
+	light.specularColor = specularColor;
+	light.focalStrength = focalStrength;
+	light.specularIntensity = specularIntensity;
+	light.shadowLayer = -1.0f;
+	m_lightSourceCount = std::max(m_lightSourceCount, lightIndex + 1);
+}
+
+/***********************************************************
+ *  UploadObjectMaterials()
+ *
+ *  This method is used for uploading all of the defined
+ *  object materials into the material buffer with one buffer
+ *  update, in the same order as m_objectMaterials so that a
+ *  material index selects the same material in the shader.
+ ***********************************************************/
+void SceneManager::UploadObjectMaterials()
+{
+	int materialCount = m_objectMaterials.size();
+	if (materialCount > g_MaxMaterials)
+	{
+		std::cout << "Only the first " << g_MaxMaterials << " of "
+			<< materialCount << " object materials are used" << std::endl;
+		materialCount = g_MaxMaterials;
+	}
+
+	std::vector<MATERIAL_BLOCK_ENTRY> blockEntries(materialCount);
+	for (int i = 0; i < materialCount; i++)
+	{
+		const OBJECT_MATERIAL& material = m_objectMaterials[i];
+		blockEntries[i].ambientColor = material.ambientColor;
+		blockEntries[i].ambientStrength = material.ambientStrength;
+		blockEntries[i].diffuseColor = material.diffuseColor;
+		blockEntries[i].shininess = material.shininess;
+		blockEntries[i].specularColor = material.specularColor;
+		blockEntries[i].padding = 0.0f;
+	}
+
+	if (materialCount > 0)
+	{
+		m_pMaterialBuffer->Update(blockEntries.data(),
+			sizeof(MATERIAL_BLOCK_ENTRY) * materialCount);
+	}
+}
+
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene 
+ *  rendering
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+	// only one instance of a particular mesh needs to be
+	// loaded in memory no matter how many times it is drawn
+	// in the rendered 3D scene
+
+	// load the meshes, which are drawn both once and as
+	// instanced batches from the same shared buffers
+	m_instancedMeshes->LoadPlaneMesh();
+	m_instancedMeshes->LoadBoxMesh();
+	m_instancedMeshes->LoadTaperedCylinderMesh();
+	m_instancedMeshes->LoadPrismMesh();
+	m_instancedMeshes->LoadPyramid3Mesh();
+
+	// a scene file replaces the built-in textures, materials,
+	// lights and objects, and the built-in scene is used when
+	// the file cannot be opened
+	bool bSceneFile = false;
+	if (m_sceneFilename.empty() == false)
+	{
+		bSceneFile = m_sceneFile.Open(m_sceneFilename.c_str());
+		if (bSceneFile == false)
+		{
+			std::cout << "Using the built-in 3D scene instead of " << m_sceneFilename << std::endl;
+		}
+	}
+
+	// the objects of a streamed world come and go with their
+	// cells, so they are neither tiled nor baked
+	bool bStreaming = (bSceneFile == true) && (m_streamCellSize > 0.0f);
+	if (bStreaming == true)
+	{
+		m_tileCount = 1;
+		m_bStaticBatching = false;
+	}
+
+	// load textures
+	if (bSceneFile == true)
+	{
+		LoadSceneTextures();
+	}
+	else
+	{
+		for (int i = 0; i < g_SceneTextureCount; i++)
+		{
+			CreateGLTexture(g_SceneTextures[i].filename, g_SceneTextures[i].tag);
+		}
+	}
+
+	// binding loaded texture arrays into texture slots
+	BindGLTextures();
+
+	// the materials need to be defined before the scene objects
+	// so that the render items can resolve their material tags
+	if (bSceneFile == true)
+	{
+		LoadSceneMaterials();
+		UploadObjectMaterials();
+		LoadSceneLights();
+	}
+	else
+	{
+		DefineObjectMaterials();
+		UploadObjectMaterials();
+		SetupSceneLights();
+	}
+
+	// build the retained list of render items for the 3D scene,
+	// and keep the scene file mapped while its cells stream
+	if (bStreaming == true)
+	{
+		SetupCellStreaming();
+	}
+	else if (bSceneFile == true)
+	{
+		LoadSceneObjects();
+		if (m_bHotReload == true)
+		{
+			KeepSceneTables();
+		}
+		m_sceneFile.Close();
+	}
+	else
+	{
+		DefineSceneObjects();
+	}
+	TileSceneObjects();
+
+	// the point lights are placed over the tiled objects
+	ScatterPointLights();
+	SetupClusteredLights();
+	SetupShadowMaps();
+
+	// the lights and features are known now, so the variants of
+	// the shader program can have them built in
+	BuildShaderVariants();
 
-	//Support Column #1
-	// set the XYZ scale for the box mesh
-	scaleXYZ = glm::vec3(1.0f, 0.5f, 1.0f); // small box
+	// none of the objects of the 3D scene move once they are
+	// placed, so all of them are baked into the static batches,
+	// which are culled on the GPU when it can
+	if (m_bStaticBatching == true)
+	{
+		BakeStaticObjects();
+	}
+	else
+	{
+		m_bGpuCulling = false;
+	}
+
+	// the files of a streamed world stay mapped while it streams,
+	// so only the objects of a loaded scene file are reloaded
+	WatchAssetFiles((bSceneFile == true) && (bStreaming == false));
+
+	// every resource of the new scene has been taken from the
+	// pool now, so the released ones that are still kept (such
+	// as the buffers replaced while the batches grew) are deleted
+	// to keep the GPU memory from growing over scene loads
+	m_pResourcePool->Trim();
+}
+
+/***********************************************************
+ *  LoadSceneTextures()
+ *
+ *  This method is used for registering the textures of the
+ *  texture table of the scene file.  The handle of each one,
+ *  or -1 when it could not be registered, is kept in the
+ *  order of the table for resolving the object textures.
+ ***********************************************************/
+void SceneManager::LoadSceneTextures()
+{
+	const SceneFile::SCENE_TEXTURE* pTextures = m_sceneFile.GetTextures();
+	m_fileTextureHandles.resize(m_sceneFile.GetTextureCount());
+
+	for (int i = 0; i < m_sceneFile.GetTextureCount(); i++)
+	{
+		std::string filename = SceneFile::GetString(pTextures[i].filename, SceneFile::FILENAME_LENGTH);
+		std::string tag = SceneFile::GetString(pTextures[i].tag, SceneFile::TAG_LENGTH);
+		m_fileTextureHandles[i] = CreateGLTexture(filename.c_str(), tag);
+	}
+}
+
+/***********************************************************
+ *  LoadSceneMaterials()
+ *
+ *  This method is used for defining the materials of the
+ *  material table of the scene file.  The material index of
+ *  each one is kept in the order of the table for resolving
+ *  the object materials.
+ ***********************************************************/
+void SceneManager::LoadSceneMaterials()
+{
+	const SceneFile::SCENE_MATERIAL* pMaterials = m_sceneFile.GetMaterials();
+	m_fileMaterialIndices.resize(m_sceneFile.GetMaterialCount());
+
+	for (int i = 0; i < m_sceneFile.GetMaterialCount(); i++)
+	{
+		const SceneFile::SCENE_MATERIAL& record = pMaterials[i];
+
+		OBJECT_MATERIAL material;
+		material.ambientStrength = record.ambientStrength;
+		material.ambientColor = glm::vec3(record.ambientColor[0], record.ambientColor[1], record.ambientColor[2]);
+		material.diffuseColor = glm::vec3(record.diffuseColor[0], record.diffuseColor[1], record.diffuseColor[2]);
+		material.specularColor = glm::vec3(record.specularColor[0], record.specularColor[1], record.specularColor[2]);
+		material.shininess = record.shininess;
+		material.tag = SceneFile::GetString(record.tag, SceneFile::TAG_LENGTH);
+
+		m_fileMaterialIndices[i] = AddObjectMaterial(material);
+	}
+}
+
+/***********************************************************
+ *  LoadSceneLights()
+ *
+ *  This method is used for setting the light sources from
+ *  the light tables of the scene file and adding its point
+ *  lights.  Only the first 4 light sources are used.
+ ***********************************************************/
+void SceneManager::LoadSceneLights()
+{
+	m_pUniformCache->SetBoolValue(m_uniforms.bUseLighting, true);
+	m_bSceneLighting = true;
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	const SceneFile::SCENE_LIGHT* pLights = m_sceneFile.GetLights();
+	int lightCount = std::min(m_sceneFile.GetLightCount(), (int)UniformBuffer::TOTAL_LIGHTS);
+	for (int i = 0; i < lightCount; i++)
+	{
+		const SceneFile::SCENE_LIGHT& record = pLights[i];
+		DefineLightSource(i,
+			glm::vec3(record.position[0], record.position[1], record.position[2]),
+			glm::vec3(record.ambientColor[0], record.ambientColor[1], record.ambientColor[2]),
+			glm::vec3(record.diffuseColor[0], record.diffuseColor[1], record.diffuseColor[2]),
+			glm::vec3(record.specularColor[0], record.specularColor[1], record.specularColor[2]),
+			record.focalStrength,
+			record.specularIntensity);
+	}
+	m_pLightBuffer->Update(m_lightSources, sizeof(m_lightSources));
+
+	const SceneFile::SCENE_POINT_LIGHT* pPointLights = m_sceneFile.GetPointLights();
+	for (int i = 0; i < m_sceneFile.GetPointLightCount(); i++)
+	{
+		const SceneFile::SCENE_POINT_LIGHT& record = pPointLights[i];
+		AddPointLight(
+			glm::vec3(record.position[0], record.position[1], record.position[2]),
+			record.radius,
+			glm::vec3(record.color[0], record.color[1], record.color[2]),
+			record.specularIntensity);
+	}
+}
+
+/***********************************************************
+ *  LoadSceneObjects()
+ *
+ *  This method is used for building the retained list of
+ *  render items from the object table of the scene file.  The
+ *  list is sized once and filled on the job system straight
+ *  from the mapped table, and the model matrices of all of
+ *  the items are built in one batch.
+ ***********************************************************/
+void SceneManager::LoadSceneObjects()
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	const SceneFile::SCENE_OBJECT* pObjects = m_sceneFile.GetObjects();
+	int objectCount = m_sceneFile.GetObjectCount();
+	std::atomic<int> invalidCount(0);
+
+	m_renderItems.clear();
+	m_dirtyRenderItems.clear();
+	m_renderItems.resize(objectCount);
+
+	RunParallel(objectCount,
+		[this, pObjects, &invalidCount](int begin, int end)
+		{
+			int rangeInvalidCount = 0;
+			for (int i = begin; i < end; i++)
+			{
+				rangeInvalidCount += FillRenderItem(pObjects[i], m_renderItems[i]);
+			}
+
+			if (rangeInvalidCount > 0)
+			{
+				invalidCount += rangeInvalidCount;
+			}
+		});
+
+	// every item is new, so all of their matrices are built
+	std::vector<int> itemIndices(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		itemIndices[i] = i;
+	}
+	UpdateItemTransforms(itemIndices.data(), objectCount);
+	m_bDrawOrderDirty = true;
+
+	std::chrono::duration<float, std::milli> loadTime = std::chrono::steady_clock::now() - startTime;
+	std::cout << "Loaded " << objectCount << " objects from " << m_sceneFilename
+		<< " in " << loadTime.count() << " ms" << std::endl;
+	if (invalidCount > 0)
+	{
+		std::cout << invalidCount << " out of range meshes, textures or materials were replaced" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  KeepSceneTables()
+ *
+ *  This method is used for copying the tables of the mapped
+ *  scene file before it is closed, so an edited scene file
+ *  can be compared with what was loaded from it.
+ ***********************************************************/
+void SceneManager::KeepSceneTables()
+{
+	m_loadedScene.objects.assign(m_sceneFile.GetObjects(),
+		m_sceneFile.GetObjects() + m_sceneFile.GetObjectCount());
+	m_loadedScene.materials.assign(m_sceneFile.GetMaterials(),
+		m_sceneFile.GetMaterials() + m_sceneFile.GetMaterialCount());
+	m_loadedScene.textures.assign(m_sceneFile.GetTextures(),
+		m_sceneFile.GetTextures() + m_sceneFile.GetTextureCount());
+	m_loadedScene.lights.assign(m_sceneFile.GetLights(),
+		m_sceneFile.GetLights() + m_sceneFile.GetLightCount());
+	m_loadedScene.pointLights.assign(m_sceneFile.GetPointLights(),
+		m_sceneFile.GetPointLights() + m_sceneFile.GetPointLightCount());
+}
+
+/***********************************************************
+ *  SetupCellStreaming()
+ *
+ *  This method is used for splitting the objects of the
+ *  scene file into the cells of the world grid and starting
+ *  the streaming of the cells around the camera.  The memory
+ *  budget is split into slots that each hold the largest
+ *  cell, and the render item list is sized for all of the
+ *  slots once, so it never moves while the streaming thread
+ *  writes the loaded cells into it.
+ ***********************************************************/
+void SceneManager::SetupCellStreaming()
+{
+	const SceneFile::SCENE_OBJECT* pObjects = m_sceneFile.GetObjects();
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(6.75f, 0.25f, 3.0f); // furthest column to the right
+	m_pCellStreamer = new CellStreamer();
+	m_slotCapacity = m_pCellStreamer->BuildCells(m_sceneFile.GetObjectCount(), m_streamCellSize,
+		[pObjects](int objectIndex)
+		{
+			const float* position = pObjects[objectIndex].position;
+			return(glm::vec3(position[0], position[1], position[2]));
+		});
+
+	size_t slotBytes = std::max(m_slotCapacity, 1) * g_StreamedItemBytes;
+	int slotCount = (int)std::max(((size_t)m_streamBudgetMegabytes << 20) / slotBytes, (size_t)1);
+
+	m_renderItems.clear();
+	m_dirtyRenderItems.clear();
+	m_renderItems.resize((size_t)slotCount * m_slotCapacity);
+	m_slotIndices.clear();
+	m_slotIndices.resize(slotCount);
+	m_pOcclusionCuller->Resize(m_renderItems.size());
+	// the items are culled through the spatial index of their
+	// slots, so the whole list is never sorted or indexed
+	m_bDrawOrderDirty = false;
+
+	m_pCellStreamer->SetResidency(slotCount, m_streamRadius, g_StreamPrefetchSeconds);
+	m_pCellStreamer->Start(
+		[this](const int* objectIndices, int objectCount, int slot, glm::vec3& boundsMin, glm::vec3& boundsMax)
+		{
+			LoadCellItems(objectIndices, objectCount, slot, boundsMin, boundsMax);
+		});
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	std::cout << "Streaming " << m_sceneFile.GetObjectCount() << " objects from " << m_sceneFilename
+		<< " in " << m_pCellStreamer->GetCellCount() << " cells, with " << slotCount
+		<< " cells of up to " << m_slotCapacity << " objects resident" << std::endl;
+}
 
-	SetShaderColor(0.25, 0.17, 0.07, 1); // dark brown color for the base
-	SetShaderTexture("wood"); // calling wood texture
-	SetTextureUVScale(1, 0.5); // texture stretched across width and compressed vertically
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh(); // draw box
+/***********************************************************
+ *  LoadCellItems()
+ *
+ *  This method is used on the streaming thread for building
+ *  the render items of the passed in objects of the scene
+ *  file into a slot, along with the spatial index of the
+ *  slot.  Only the slot is written, which the render does not
+ *  read until the cell is marked resident.  Out of range
+ *  values are replaced the same way as in LoadSceneObjects().
+ ***********************************************************/
+void SceneManager::LoadCellItems(
+	const int* objectIndices,
+	int objectCount,
+	int slot,
+	glm::vec3& boundsMin,
+	glm::vec3& boundsMax)
+{
+	const SceneFile::SCENE_OBJECT* pObjects = m_sceneFile.GetObjects();
+	RENDER_ITEM* pItems = &m_renderItems[(size_t)slot * m_slotCapacity];
 
+	TransformKernel::SOA_TRANSFORMS transforms;
+	transforms.Resize(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		FillRenderItem(pObjects[objectIndices[i]], pItems[i]);
+		transforms.Set(i, pItems[i].scaleXYZ, pItems[i].rotationDegrees, pItems[i].positionXYZ);
+	}
 
-	// set the XYZ scale for the tapered cylinder mesh
-	scaleXYZ = glm::vec3(0.3f, 3.0f, 0.3f); // thin and tall tapered cylinder
+	std::vector<glm::mat4> matrices(objectCount);
+	TransformKernel::ComputeModelMatrices(transforms, 0, objectCount, matrices.data());
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	std::vector<glm::vec3> itemMins(objectCount);
+	std::vector<glm::vec3> itemMaxs(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		pItems[i].modelMatrix = matrices[i];
+		UpdateItemBounds(pItems[i]);
+		itemMins[i] = pItems[i].boundsMin;
+		itemMaxs[i] = pItems[i].boundsMax;
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(6.75f, 0.5f, 3.0f); // increase Y value to stack tapered cylinder on top of box, matching X and Z values
+		boundsMin = (i == 0) ? itemMins[i] : glm::min(boundsMin, itemMins[i]);
+		boundsMax = (i == 0) ? itemMaxs[i] : glm::max(boundsMax, itemMaxs[i]);
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(0.4, 0.2, 0.1, 1); // medium brown color for the pillar
-	SetShaderTexture("wood"); // calling wood texture
-	SetTextureUVScale(1.8, 3.0); // scale uv based on tapered cylinder dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTaperedCylinderMesh(); // draw tapered cylinder
-	/****************************************************************/
+	m_slotIndices[slot].Build(itemMins, itemMaxs);
+}
 
-	//Support Column #2
-	// set the XYZ scale for the box mesh
-	scaleXYZ = glm::vec3(1.0f, 0.5f, 1.0f); // same sized box
+/***********************************************************
+ *  CullStreamedCells()
+ *
+ *  This method is used for building the list of the render
+ *  items of the resident cells inside the frustum.  The box
+ *  of each cell is checked first, and the spatial index of
+ *  its slot is only searched when the cell is in view.  The
+ *  number of resident items is returned.
+ ***********************************************************/
+int SceneManager::CullStreamedCells()
+{
+	const std::vector<int>& residentCells = m_pCellStreamer->GetResidentCells();
+	int residentCount = 0;
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	m_visibleOrder.clear();
+	for (size_t i = 0; i < residentCells.size(); i++)
+	{
+		const CellStreamer::CELL& cell = m_pCellStreamer->GetCell(residentCells[i]);
+		int firstItem = cell.slot * m_slotCapacity;
+		residentCount += cell.objectCount;
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(4.75f, 0.25f, 3.0f); // reduce X value to move box to the left, matching Y and Z values
+		if (m_bFrustumCulling == false)
+		{
+			for (int j = 0; j < cell.objectCount; j++)
+			{
+				m_visibleOrder.push_back(firstItem + j);
+			}
+		}
+		else if (m_frustum.IsBoxVisible(cell.boundsMin, cell.boundsMax) == true)
+		{
+			// the slot index holds the positions in the slot
+			size_t firstVisible = m_visibleOrder.size();
+			m_slotIndices[cell.slot].QueryFrustum(m_frustum, m_visibleOrder);
+			for (size_t j = firstVisible; j < m_visibleOrder.size(); j++)
+			{
+				m_visibleOrder[j] += firstItem;
+			}
+		}
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	return(residentCount);
+}
 
-	SetShaderColor(0.25, 0.17, 0.07, 1); // dark brown color for the base
-	SetShaderTexture("wood"); // calling wood texture
-	SetTextureUVScale(1, 0.5); // texture stretched across width and compressed vertically
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh(); // draw box
+/***********************************************************
+ *  FillRenderItem()
+ *
+ *  This method is used for setting the values of a render
+ *  item from an object of the scene file, except for its
+ *  model matrix and bounds.  Out of range meshes, textures
+ *  and materials are replaced with a box, no texture and no
+ *  material, and the number replaced is returned.  It makes
+ *  no OpenGL calls, so it runs on any thread.
+ ***********************************************************/
+int SceneManager::FillRenderItem(const SceneFile::SCENE_OBJECT& object, RENDER_ITEM& item) const
+{
+	int invalidCount = 0;
 
+	item.mesh = MESH_BOX;
+	if ((object.mesh >= 0) && (object.mesh < g_MeshTypeCount))
+	{
+		item.mesh = (MESH_TYPE)object.mesh;
+	}
+	else
+	{
+		invalidCount++;
+	}
+	item.scaleXYZ = glm::vec3(object.scale[0], object.scale[1], object.scale[2]);
+	item.rotationDegrees = glm::vec3(
+		object.rotationDegrees[0], object.rotationDegrees[1], object.rotationDegrees[2]);
+	item.positionXYZ = glm::vec3(object.position[0], object.position[1], object.position[2]);
+	item.color = glm::vec4(object.color[0], object.color[1], object.color[2], object.color[3]);
+
+	int textureHandle = -1;
+	if ((object.textureIndex >= 0) && (object.textureIndex < (int)m_fileTextureHandles.size()))
+	{
+		textureHandle = m_fileTextureHandles[object.textureIndex];
+	}
+	else if (object.textureIndex != -1)
+	{
+		invalidCount++;
+	}
+	SetItemTexture(item, textureHandle);
 
-	// set the XYZ scale for the tapered cylinder mesh
-	scaleXYZ = glm::vec3(0.3f, 3.0f, 0.3f); // same sized tapered cylinder
+	item.uvScale = glm::vec2(object.uvScale[0], object.uvScale[1]);
+	item.materialIndex = -1;
+	if ((object.materialIndex >= 0) && (object.materialIndex < (int)m_fileMaterialIndices.size()))
+	{
+		item.materialIndex = m_fileMaterialIndices[object.materialIndex];
+	}
+	else if (object.materialIndex != -1)
+	{
+		invalidCount++;
+	}
+	item.lodLevel = 0;
+	item.staticObject = -1;
+	item.bDirty = false;
+	item.bDynamic = false;
+	item.stillFrames = 0;
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	return(invalidCount);
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(4.75f, 0.5f, 3.0f); // increase Y value to stack tapered cylinder on top of box, matching X and Z values
+/***********************************************************
+ *  DefineSceneObjects()
+ *
+ *  This method is used for building the retained list of
+ *  render items for the 3D scene.  The list is built once
+ *  and only the items marked dirty are re-evaluated when
+ *  the scene is rendered.
+ ***********************************************************/
+void SceneManager::DefineSceneObjects()
+{
+	m_renderItems.clear();
+	m_dirtyRenderItems.clear();
+	m_drawOrder.clear();
+	m_bDrawOrderDirty = true;
+
+	/*** Each render item is defined with the mesh, the XYZ scale,  ***/
+	/*** the XYZ rotation in degrees, the XYZ position, the color,  ***/
+	/*** the texture tag and UV scale, and the material tag.        ***/
+	/*** An empty texture tag means the object is drawn with color. ***/
+	/******************************************************************/
+	// first plane (ground level)
+	AddRenderItem(
+		MESH_PLANE,
+		glm::vec3(20.0f, 1.0f, 10.0f),
+		0.0f, 0.0f, 0.0f, // no rotation
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec4(0.5f, 0.5f, 0.5f, 1.0f), // grey color
+		"grass", glm::vec2(1.0f, 1.0f), // mapping texture across entire plane
+		"metal");
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(0.4, 0.2, 0.1, 1); // medium brown color for the pillar
-	SetShaderTexture("wood"); // calling wood texture
-	SetTextureUVScale(1.8, 3.0); // scale uv based on tapered cylinder dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTaperedCylinderMesh(); // draw tapered cylinder
+	// drawing second plane (behind the house)
+	AddRenderItem(
+		MESH_PLANE,
+		glm::vec3(20.0f, 1.0f, 10.0f),
+		90.0f, 0.0f, 0.0f, // x rotation to place plane behind the house
+		glm::vec3(0.0f, 9.0f, -10.0f), // moving plane 9 y units and -10 z units to align planes, same x value
+		glm::vec4(0.55f, 0.55f, 0.55f, 1.0f), // lighter grey color for contrast
+		"", glm::vec2(1.0f, 1.0f),
+		"metal");
 	/****************************************************************/
 
-	//Support Column #3
-	// set the XYZ scale for the box mesh
-	scaleXYZ = glm::vec3(1.0f, 0.5f, 1.0f); // same sized box
+	// support columns - the box base and the tapered cylinder pillar
+	// for each column share the same size, color, texture and material
+	const float columnPositionsX[] = {
+		6.75f, // furthest column to the right
+		4.75f, // reduce X value to move column to the left
+		0.25f, // decrease X value to move column to the left
+		-2.0f  // decrease X value to move column to the left
+	};
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.25f, 0.25f, 3.0f); // decrease X value to move box to the left, matching Y and Z values
+	for (int i = 0; i < 4; i++)
+	{
+		// column base
+		AddRenderItem(
+			MESH_BOX,
+			glm::vec3(1.0f, 0.5f, 1.0f), // small box
+			0.0f, 0.0f, 0.0f, // no rotation
+			glm::vec3(columnPositionsX[i], 0.25f, 3.0f),
+			glm::vec4(0.25f, 0.17f, 0.07f, 1.0f), // dark brown color for the base
+			"wood", glm::vec2(1.0f, 0.5f), // texture stretched across width and compressed vertically
+			"wood");
+
+		// column pillar
+		AddRenderItem(
+			MESH_TAPERED_CYLINDER,
+			glm::vec3(0.3f, 3.0f, 0.3f), // thin and tall tapered cylinder
+			0.0f, 0.0f, 0.0f, // no rotation
+			glm::vec3(columnPositionsX[i], 0.5f, 3.0f), // increase Y value to stack tapered cylinder on top of box, matching X and Z values
+			glm::vec4(0.4f, 0.2f, 0.1f, 1.0f), // medium brown color for the pillar
+			"wood", glm::vec2(1.8f, 3.0f), // scale uv based on tapered cylinder dimensions
+			"wood");
+	}
+	/****************************************************************/
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// Horizontal Beam
+	AddRenderItem(
+		MESH_BOX,
+		glm::vec3(10.0f, 0.5f, 1.0f), // long rectangular box
+		0.0f, 0.0f, 0.0f, // no rotation
+		glm::vec3(2.25f, 3.75f, 3.0f), // set X value to cover the width of all columns evenly, set Y value to stack on top of all columns, matching Z value
+		glm::vec4(0.8f, 0.5f, 0.3f, 1.0f), // light brown color for the beam
+		"roof", glm::vec2(8.0f, 1.0f), // scale uv based on box dimensions
+		"wood");
 
-	SetShaderColor(0.25, 0.17, 0.07, 1); // dark brown color for the base
-	SetShaderTexture("wood"); // calling wood texture
-	SetTextureUVScale(1, 0.5); // texture stretched across width and compressed vertically
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh(); // draw box
+	// house body (left)
+	AddRenderItem(
+		MESH_BOX,
+		glm::vec3(15.0f, 3.5f, 8.0f), // long and tall rectangular box
+		0.0f, 0.0f, 0.0f, // no rotation
+		glm::vec3(-10.25f, 1.85f, -4.5f),
+		glm::vec4(0.8f, 0.5f, 0.3f, 1.0f),
+		"outergreen", glm::vec2(4.0f, 1.0f), // scale uv based on box dimensions
+		"wood");
+
+	// house body (right)
+	AddRenderItem(
+		MESH_BOX,
+		glm::vec3(7.0f, 3.5f, 8.0f), // long and tall rectangular box
+		0.0f, 0.0f, 0.0f, // no rotation
+		glm::vec3(4.25f, 1.5f, -4.5f),
+		glm::vec4(0.8f, 0.5f, 0.3f, 1.0f),
+		"brick", glm::vec2(8.0f, 1.0f), // scale uv based on shape dimensions
+		"wood");
 
+	// porch walkway
+	AddRenderItem(
+		MESH_BOX,
+		glm::vec3(3.75f, 0.1f, 15.5f),
+		0.0f, 0.0f, 0.0f, // no rotation
+		glm::vec3(-1.0f, 0.0f, 2.20f),
+		glm::vec4(0.8f, 0.5f, 0.3f, 1.0f),
+		"concrete", glm::vec2(1.0f, 1.0f),
+		"wood");
 
-	// set the XYZ scale for the tapered cylinder mesh
-	scaleXYZ = glm::vec3(0.3f, 3.0f, 0.3f); // same sized tapered cylinder
+	// right side of porch area
+	AddRenderItem(
+		MESH_BOX,
+		glm::vec3(9.75f, 0.1f, 5.25f),
+		0.0f, 0.0f, 0.0f, // no rotation
+		glm::vec3(2.90f, 0.0f, 0.95f),
+		glm::vec4(0.8f, 0.5f, 0.3f, 1.0f),
+		"concrete", glm::vec2(1.0f, 1.0f),
+		"wood");
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	// front door
+	AddRenderItem(
+		MESH_BOX,
+		glm::vec3(3.75f, 3.4f, 4.0f),
+		0.0f, 0.0f, 0.0f, // no rotation
+		glm::vec3(-1.0f, 1.95f, -6.45f),
+		glm::vec4(0.8f, 0.5f, 0.3f, 1.0f),
+		"door", glm::vec2(1.0f, 1.0f),
+		"wood");
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.25f, 0.5f, 3.0f); // increase Y value to stack tapered cylinder on top of box, matching X and Z values
+	// upper house body (2nd story)
+	AddRenderItem(
+		MESH_BOX,
+		glm::vec3(25.5f, 3.5f, 5.0f), // long and tall rectangular box
+		0.0f, 0.0f, 0.0f, // no rotation
+		glm::vec3(-5.00f, 5.35f, -6.0f),
+		glm::vec4(0.8f, 0.5f, 0.3f, 1.0f),
+		"wall", glm::vec2(8.0f, 1.0f), // scale uv based on shape dimensions
+		"wood");
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(0.4, 0.2, 0.1, 1); // medium brown color for the pillar
-	SetShaderTexture("wood"); // calling wood texture
-	SetTextureUVScale(1.8, 3.0); // scale uv based on tapered cylinder dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTaperedCylinderMesh(); // draw tapered cylinder
-	/****************************************************************/
+	// upper left house pyramid (2nd story)
+	AddRenderItem(
+		MESH_PRISM,
+		glm::vec3(3.0f, 3.0f, 3.0f),
+		270.0f, 0.0f, 0.0f, // x rotation to align with body of house
+		glm::vec3(-16.25f, 5.0f, -2.0f),
+		glm::vec4(0.8f, 0.5f, 0.3f, 1.0f),
+		"outergreen", glm::vec2(1.0f, 1.0f),
+		"wood");
 
-	//Support Column #4
-	// set the XYZ scale for the box mesh
-	scaleXYZ = glm::vec3(1.0f, 0.5f, 1.0f); // same sized box
+	// upper roof (2nd story)
+	AddRenderItem(
+		MESH_PLANE,
+		glm::vec3(13.0f, 2.5f, 4.0f),
+		0.0f, 0.0f, 0.0f, // no rotation
+		glm::vec3(-5.00f, 7.25f, -6.0f),
+		glm::vec4(0.8f, 0.5f, 0.3f, 1.0f),
+		"roof", glm::vec2(8.0f, 1.0f), // scale uv based on shape dimensions
+		"wood");
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	// second upper left house pyramid (2nd story)
+	AddRenderItem(
+		MESH_PRISM,
+		glm::vec3(3.0f, 3.0f, 3.0f),
+		270.0f, 0.0f, 0.0f, // x rotation for shape to align with house body
+		glm::vec3(-4.25f, 5.0f, -2.0f),
+		glm::vec4(0.8f, 0.5f, 0.3f, 1.0f),
+		"outergreen", glm::vec2(1.0f, 1.0f),
+		"wood");
+
+	// second story window #1 left
+	AddRenderItem(
+		MESH_PLANE,
+		glm::vec3(2.0f, 1.0f, 1.0f),
+		90.0f, 0.0f, 0.0f, // x rotation to align with body of house
+		glm::vec3(-10.0f, 5.25f, -3.0f),
+		glm::vec4(0.5f, 0.5f, 0.5f, 1.0f), // grey color
+		"window", glm::vec2(1.0f, 1.0f), // mapping texture across entire plane
+		"metal");
+
+	// second story window #2 right
+	AddRenderItem(
+		MESH_PLANE,
+		glm::vec3(2.0f, 1.0f, 1.0f),
+		90.0f, 0.0f, 0.0f, // x rotation to align with body of house
+		glm::vec3(3.0f, 5.25f, -3.0f),
+		glm::vec4(0.5f, 0.5f, 0.5f, 1.0f), // grey color
+		"window", glm::vec2(1.0f, 1.0f), // mapping texture across entire plane
+		"metal");
+
+	// first story window #1 right
+	AddRenderItem(
+		MESH_PLANE,
+		glm::vec3(2.0f, 1.0f, 1.0f),
+		90.0f, 0.0f, 0.0f, // x rotation to align with body of house
+		glm::vec3(4.0f, 2.0f, 0.0f),
+		glm::vec4(0.5f, 0.5f, 0.5f, 1.0f), // grey color
+		"window", glm::vec2(1.0f, 1.0f), // mapping texture across entire plane
+		"metal");
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-2.0f, 0.25f, 3.0f); // decrease X value to move box to the left, matching Y and Z values
+	// garage door
+	AddRenderItem(
+		MESH_PLANE,
+		glm::vec3(5.5f, 1.0f, 1.50f),
+		90.0f, 0.0f, 0.0f, // x rotation to align with body of house
+		glm::vec3(-10.0f, 1.75f, 0.0f),
+		glm::vec4(0.5f, 0.5f, 0.5f, 1.0f), // grey color
+		"garage", glm::vec2(0.0f, 1.0f),
+		"metal");
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// first story roof (left)
+	AddRenderItem(
+		MESH_PLANE,
+		glm::vec3(8.0f, 1.0f, 4.0f),
+		0.0f, 0.0f, 0.0f, // no rotation
+		glm::vec3(-10.75f, 3.7f, -4.25f),
+		glm::vec4(0.8f, 0.5f, 0.3f, 1.0f),
+		"roof", glm::vec2(4.0f, 1.0f), // scale uv based on shape dimensions
+		"wood");
 
-	SetShaderColor(0.25, 0.17, 0.07, 1); // dark brown color for the base
-	SetShaderTexture("wood"); // calling wood texture
-	SetTextureUVScale(1, 0.5); // texture stretched across width and compressed vertically
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh(); // draw box
+	// first story roof right side
+	AddRenderItem(
+		MESH_PLANE,
+		glm::vec3(5.0f, 1.0f, 5.0f),
+		0.0f, 0.0f, 0.0f, // no rotation
+		glm::vec3(2.25f, 3.5f, -1.75f),
+		glm::vec4(0.8f, 0.5f, 0.3f, 1.0f),
+		"roof", glm::vec2(8.0f, 1.0f), // scale uv based on shape dimensions
+		"wood");
 
+	// driveway
+	AddRenderItem(
+		MESH_PLANE,
+		glm::vec3(5.5f, 1.0f, 7.0f),
+		0.0f, 0.0f, 0.0f, // no rotation
+		glm::vec3(-10.0f, 0.01f, 3.0f),
+		glm::vec4(0.5f, 0.5f, 0.5f, 1.0f), // grey color
+		"concrete", glm::vec2(1.0f, 1.0f), // mapping texture across entire plane
+		"metal");
+}
 
-	// set the XYZ scale for the tapered cylinder mesh
-	scaleXYZ = glm::vec3(0.3f, 3.0f, 0.3f); // same sized tapered cylinder
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  drawing the retained list of render items.  Only the
+ *  items marked dirty since the last frame have their
+ *  model matrix recalculated.
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	// the lists of the last frame are no longer needed
+	m_pFrameArena->Reset();
+
+	// reset the statistics for this frame
+	m_renderStats.drawCalls = 0;
+	m_renderStats.instancedDrawCalls = 0;
+	m_renderStats.stateChanges = 0;
+	m_renderStats.stateChangesSkipped = 0;
+	m_renderStats.visibleItems = 0;
+	m_renderStats.culledItems = 0;
+	m_renderStats.occludedItems = 0;
+	m_renderStats.occlusionQueries = 0;
+	m_renderStats.reducedLodItems = 0;
+	m_renderStats.staticItems = 0;
+	m_renderStats.shadowDrawCalls = 0;
+
+	// replace the placeholders of the textures whose images have
+	// been decoded since the last frame
+	{
+		ProfileScope scope(m_pProfiler, "Upload Textures");
+		m_pTextureManager->UploadLoadedTextures(g_MaxTextureUploadsPerFrame);
+	}
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	// build the lists of the point lights reaching each cluster
+	// of the view
+	if (m_bClusteredLighting == true)
+	{
+		ProfileScope scope(m_pProfiler, "Light Binning");
+		m_pClusteredLights->Bin(m_projection);
+	}
 
-	// set the XYZ position for the mesh 
-	positionXYZ = glm::vec3(-2.0f, 0.5f, 3.0f); // increase Y value to stack tapered cylinder on top of box, matching X and Z values
+	// load the cells of a streamed world coming into reach of
+	// the camera and unload the ones left behind
+	if (NULL != m_pCellStreamer)
+	{
+		ProfileScope scope(m_pProfiler, "Stream Cells");
+		m_bCellsChanged = m_pCellStreamer->Update(m_viewPosition);
+		if (m_bCellsChanged == true)
+		{
+			m_bStaticShadowsDirty = true;
+		}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	SetShaderColor(0.4, 0.2, 0.1, 1); // medium brown color for the pillar
-	SetShaderTexture("wood"); // calling wood texture
-	SetTextureUVScale(1.8, 3.0); // scale uv based on tapered cylinder dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTaperedCylinderMesh(); // draw tapered cylinder
-	/****************************************************************/
+		// the occlusion results of a slot belong to the cell that
+		// was in it before
+		const std::vector<int>& arrivedCells = m_pCellStreamer->GetArrivedCells();
+		for (size_t i = 0; i < arrivedCells.size(); i++)
+		{
+			const CellStreamer::CELL& cell = m_pCellStreamer->GetCell(arrivedCells[i]);
+			m_pOcclusionCuller->ResetRange(cell.slot * m_slotCapacity, m_slotCapacity);
+		}
+	}
 
-	// Horizontal Beam
-	// set the XYZ scale for the box mesh
-	scaleXYZ = glm::vec3(10.0f, 0.5f, 1.0f); // long rectangular box
+	// re-evaluate the render items that have changed
+	{
+		ProfileScope scope(m_pProfiler, "Update Render Items");
+		UpdateRenderItems();
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+		// the submission order and the spatial index only change
+		// when items are added
+		if (m_bDrawOrderDirty == true)
+		{
+			SortRenderItems();
+			BuildSpatialIndex();
+		}
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(2.25f, 3.75f, 3.0f); // set X value to cover the width of all columns evenly, set Y value to stack on top of all columns, matching Z value
+	// skip the render items outside of the view
+	{
+		ProfileScope scope(m_pProfiler, "Frustum Culling");
+		CullRenderItems();
+		SplitStaticItems();
+		SplitTransparentItems();
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// write the draw commands of the visible baked items
+	if (m_bGpuCulling == true)
+	{
+		ProfileScope scope(m_pProfiler, "GPU Culling");
+		m_pGpuCuller->Cull(m_frustum, m_viewPosition, m_lodScale, m_bFrustumCulling,
+			(m_bOcclusionCulling == true) ? m_pDepthPyramid : NULL);
+	}
 
-	SetShaderColor(0.8, 0.5, 0.3, 1); // light brown color for the beam
-	SetShaderTexture("roof"); // calling roof texture
-	SetTextureUVScale(8, 1); // scale uv based on box dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh(); // draw box
+	// list the layers of the shadow maps that need to be drawn,
+	// which is none in most frames of a scene that holds still
+	if (m_bShadowMaps == true)
+	{
+		ProfileScope scope(m_pProfiler, "Shadow Culling");
+		CollectShadowPasses();
+	}
 
-	// house body (left)
-	scaleXYZ = glm::vec3(15.0f, 3.5f, 8.0f); // long and tall rectangular box
+	// the sorted order places the items that share the mesh,
+	// texture and material next to each other, and the values of
+	// all of them are written to the instance buffer at once -
+	// the commands and instances are drawn by every pass
+	{
+		ProfileScope scope(m_pProfiler, "Upload Instances");
+		UploadStaticCommands();
+		UploadVisibleInstances();
+	}
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	// the shadow maps are drawn before the passes that look them up
+	if (m_shadowPasses.empty() == false)
+	{
+		ProfileScope scope(m_pProfiler, "Shadow Maps");
+		DrawShadowPasses();
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-10.25f, 1.85f, -4.5f); 
+	// the depth of the opaque items is drawn first without any
+	// shading, so the opaque pass only shades the nearest surface
+	// of each pixel
+	if (m_bDepthPrepass == true)
+	{
+		ProfileScope scope(m_pProfiler, "Depth Prepass");
+		BeginRenderPass(PASS_DEPTH);
+		DrawStaticBatches(false);
+		DrawInstancedBatches(0, m_opaqueCount, false);
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// the baked items are drawn with a few commands per texture
+	// array and material
+	BeginRenderPass(PASS_OPAQUE);
+	{
+		ProfileScope scope(m_pProfiler, "Draw Static Batches");
+		DrawStaticBatches(true);
+	}
+	DrawInstancedBatches(0, m_opaqueCount, true);
 
-	SetShaderColor(0.8, 0.5, 0.3, 1); // light brown color for the beam
-	SetShaderTexture("outergreen"); // calling outergreen texture
-	SetTextureUVScale(4, 1); // scale uv based on box dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh(); // draw box
+	// the transparent items are blended from back to front over
+	// the opaque ones
+	if (m_opaqueCount < m_visibleOrder.size())
+	{
+		ProfileScope scope(m_pProfiler, "Transparent Pass");
+		BeginRenderPass(PASS_TRANSPARENT);
+		DrawInstancedBatches(m_opaqueCount, m_visibleOrder.size(), false);
+	}
+	EndRenderPasses();
 
-	// house body(right)
-	// house body
-	scaleXYZ = glm::vec3(7.0f, 3.5f, 8.0f); // long and tall rectangular box
+	// query which of the items in the frustum are hidden, for
+	// the next frames
+	if (m_bOcclusionCulling == true)
+	{
+		ProfileScope scope(m_pProfiler, "Occlusion Queries");
+		IssueOcclusionQueries();
+	}
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	// the baked items are tested against the depth of this frame
+	// in the GPU culling of the next one
+	if ((m_bGpuCulling == true) && (m_bOcclusionCulling == true))
+	{
+		ProfileScope scope(m_pProfiler, "Depth Pyramid");
+		m_pDepthPyramid->Build(m_projection * m_view);
+	}
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(4.25f, 1.5f, -4.5f);
+/***********************************************************
+ *  GetRenderStats()
+ *
+ *  This method is used for getting the draw call and shader
+ *  state change counters from the last rendered frame.
+ ***********************************************************/
+SceneManager::RENDER_STATS SceneManager::GetRenderStats() const
+{
+	return(m_renderStats);
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  ReportMemoryUsage()
+ *
+ *  This method is used for writing the memory of the OpenGL
+ *  buffers and textures in use and kept for reuse, and of the
+ *  frame arena, to the console.  These stay the same from one
+ *  load of the scene to the next.
+ ***********************************************************/
+void SceneManager::ReportMemoryUsage() const
+{
+	const double megabyte = 1024.0 * 1024.0;
+	ResourcePool::POOL_STATS stats = m_pResourcePool->GetStats();
+
+	std::cout << "GPU buffers:   " << stats.liveBuffers << " in use (" << stats.liveBufferBytes / megabyte
+		<< " MB), " << stats.freeBuffers << " pooled (" << stats.freeBufferBytes / megabyte << " MB)\n";
+	std::cout << "GPU textures:  " << stats.liveTextures << " in use (" << stats.liveTextureBytes / megabyte
+		<< " MB), " << stats.freeTextures << " pooled (" << stats.freeTextureBytes / megabyte << " MB)\n";
+	std::cout << "frame arena:   " << m_pFrameArena->GetBlockSize() / 1024 << " KB block, "
+		<< m_pFrameArena->GetHighWater() / 1024 << " KB high water" << std::endl;
+}
 
-	SetShaderColor(0.8, 0.5, 0.3, 1); // light brown color for the beam
-	SetShaderTexture("brick"); // calling brick texture
-	SetTextureUVScale(8, 1); // scale uv based on shape dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh(); // draw box
+/***********************************************************
+ *  SetSceneView()
+ *
+ *  This method is used for setting the camera view and
+ *  projection of the next render, which the render items
+ *  are culled against.
+ ***********************************************************/
+void SceneManager::SetSceneView(const glm::mat4& view, const glm::mat4& projection)
+{
+	m_frustum.Extract(projection * view);
+	m_view = view;
+	m_viewPosition = glm::vec3(glm::inverse(view)[3]);
+	// the projected size of one unit at a distance of one unit,
+	// as a part of the view height
+	m_lodScale = projection[1][1];
+	m_projection = projection;
+}
 
-	// porch walkway
-	scaleXYZ = glm::vec3(3.75f, 0.1f, 15.5f);
+/***********************************************************
+ *  SetFrustumCulling()
+ *
+ *  This method is used for turning the culling of the render
+ *  items outside of the view on or off.
+ ***********************************************************/
+void SceneManager::SetFrustumCulling(bool bEnabled)
+{
+	m_bFrustumCulling = bEnabled;
+}
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  PickRenderItem()
+ *
+ *  This method is used for finding the nearest render item
+ *  whose box is hit by the ray, which returns -1 when none
+ *  is hit.  The boxes are from the last rendered frame.
+ ***********************************************************/
+int SceneManager::PickRenderItem(glm::vec3 origin, glm::vec3 direction, float& distance) const
+{
+	if (NULL == m_pCellStreamer)
+	{
+		return(m_spatialIndex.Raycast(origin, direction, std::numeric_limits<float>::max(), distance));
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-1.0f, 0.0f, 2.20f);
+	// the nearest hit in the spatial indices of the resident cells
+	const std::vector<int>& residentCells = m_pCellStreamer->GetResidentCells();
+	int nearestItem = -1;
+	distance = std::numeric_limits<float>::max();
+	for (size_t i = 0; i < residentCells.size(); i++)
+	{
+		const CellStreamer::CELL& cell = m_pCellStreamer->GetCell(residentCells[i]);
+		float hitDistance = 0.0f;
+		int hitItem = m_slotIndices[cell.slot].Raycast(origin, direction, distance, hitDistance);
+		if (hitItem >= 0)
+		{
+			nearestItem = cell.slot * m_slotCapacity + hitItem;
+			distance = hitDistance;
+		}
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	return(nearestItem);
+}
 
-	SetShaderColor(0.8, 0.5, 0.3, 1); // light brown color for the beam
-	SetShaderTexture("concrete"); // calling concrete texture
-	SetTextureUVScale(1, 1); // scale uv based on shape dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh(); // draw box
+/***********************************************************
+ *  QueryRenderItems()
+ *
+ *  This method is used for finding the render items whose
+ *  boxes overlap the passed in box.
+ ***********************************************************/
+void SceneManager::QueryRenderItems(glm::vec3 boxMin, glm::vec3 boxMax, std::vector<int>& items) const
+{
+	if (NULL == m_pCellStreamer)
+	{
+		m_spatialIndex.QueryBox(boxMin, boxMax, items);
+		return;
+	}
 
-	// right side of porch area
-	// porch walkway
-	scaleXYZ = glm::vec3(9.75f, 0.1f, 5.25f); 
+	const std::vector<int>& residentCells = m_pCellStreamer->GetResidentCells();
+	for (size_t i = 0; i < residentCells.size(); i++)
+	{
+		const CellStreamer::CELL& cell = m_pCellStreamer->GetCell(residentCells[i]);
+		size_t firstFound = items.size();
+		m_slotIndices[cell.slot].QueryBox(boxMin, boxMax, items);
+		for (size_t j = firstFound; j < items.size(); j++)
+		{
+			items[j] += cell.slot * m_slotCapacity;
+		}
+	}
+}
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  GetRenderItem()
+ *
+ *  This method is used for getting a render item by index.
+ ***********************************************************/
+const SceneManager::RENDER_ITEM& SceneManager::GetRenderItem(int itemIndex) const
+{
+	return(m_renderItems[itemIndex]);
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(2.90f, 0.0f, 0.95f);
+/***********************************************************
+ *  SetOcclusionCulling()
+ *
+ *  This method is used for turning the skipping of the
+ *  render items hidden behind other items on or off.
+ ***********************************************************/
+void SceneManager::SetOcclusionCulling(bool bEnabled)
+{
+	if ((bEnabled == true) && (m_bOcclusionCulling == false))
+	{
+		// the results from before are out of date
+		m_pOcclusionCuller->Resize(m_renderItems.size());
+	}
+	m_bOcclusionCulling = bEnabled;
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  SetStaticBatching()
+ *
+ *  This method is used for turning the drawing of the items
+ *  from the baked static batches on or off.  It needs to be
+ *  called before PrepareScene(), which bakes the batches.
+ ***********************************************************/
+void SceneManager::SetStaticBatching(bool bEnabled)
+{
+	m_bStaticBatching = bEnabled;
+}
 
-	SetShaderColor(0.8, 0.5, 0.3, 1); // light brown color for the beam
-	SetShaderTexture("concrete"); // calling concrete texture
-	SetTextureUVScale(1, 1); // scale uv based on shape dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh(); // draw box
+/***********************************************************
+ *  SetGpuCulling()
+ *
+ *  This method is used for turning the culling of the static
+ *  batches on the GPU on or off.  It needs to be called before
+ *  PrepareScene(), and the static batching needs to be on.
+ ***********************************************************/
+void SceneManager::SetGpuCulling(bool bEnabled)
+{
+	m_bGpuCulling = bEnabled;
+}
 
-	// front door
-	scaleXYZ = glm::vec3(3.75f, 3.4f, 4.0f); 
+/***********************************************************
+ *  SetDepthPrepass()
+ *
+ *  This method is used for turning the drawing of the depth
+ *  of the opaque items before they are shaded on or off.
+ *  Without it the opaque items are shaded where they are
+ *  drawn over later.
+ ***********************************************************/
+void SceneManager::SetDepthPrepass(bool bEnabled)
+{
+	m_bDepthPrepass = bEnabled;
+}
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  SetShaderVariants()
+ *
+ *  This method is used for turning the specialized variants
+ *  of the shader program on or off, which needs to be called
+ *  before PrepareScene().  Without them the uber shader
+ *  program draws everything.
+ ***********************************************************/
+void SceneManager::SetShaderVariants(bool bEnabled)
+{
+	m_bShaderVariants = bEnabled;
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-1.0f, 1.95f, -6.45f);
+/***********************************************************
+ *  SetShadows()
+ *
+ *  This method is used for turning the shadows of the light
+ *  sources and the sun on or off.  It needs to be called
+ *  before PrepareScene().
+ ***********************************************************/
+void SceneManager::SetShadows(bool bEnabled)
+{
+	m_bShadows = bEnabled;
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  SetSunLight()
+ *
+ *  This method is used for lighting the scene with a sun,
+ *  which shines on every object from the same direction and
+ *  casts its shadows through cascades that follow the camera.
+ *  It needs to be called before PrepareScene().
+ ***********************************************************/
+void SceneManager::SetSunLight(glm::vec3 direction, glm::vec3 color, float specularIntensity)
+{
+	m_pShadowMaps->SetSunLight(direction, color, specularIntensity);
+	m_pShadowMaps->Upload();
+	m_bSunLight = (glm::length(direction) > 0.0f);
+}
 
-	SetShaderColor(0.8, 0.5, 0.3, 1); // light brown color for the beam
-	SetShaderTexture("door"); // calling door texture
-	SetTextureUVScale(1, 1); // scale uv based on shape dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh(); // draw box
+/***********************************************************
+ *  SetSceneTiling()
+ *
+ *  This method is used for setting how many copies of the
+ *  3D scene are placed in a grid, which is used for scaling
+ *  the scene in the benchmark.  It needs to be called before
+ *  PrepareScene().
+ ***********************************************************/
+void SceneManager::SetSceneTiling(int tileCount)
+{
+	m_tileCount = std::max(tileCount, 1);
+}
 
-	
+/***********************************************************
+ *  SetSceneFile()
+ *
+ *  This method is used for setting a binary scene file that
+ *  is loaded instead of the built-in 3D scene, written by
+ *  ExportScene().  It needs to be called before
+ *  PrepareScene().
+ ***********************************************************/
+void SceneManager::SetSceneFile(const std::string& filename)
+{
+	m_sceneFilename = filename;
+}
 
-	// upper house body (2nd story)
-	scaleXYZ = glm::vec3(25.5f, 3.5f, 5.0f); // long and tall rectangular box
+/***********************************************************
+ *  SetSceneStreaming()
+ *
+ *  This method is used for streaming the objects of the scene
+ *  file in square cells of the passed in size, keeping the
+ *  cells within the load radius of the camera resident in at
+ *  most the passed in megabytes.  A cell size of 0 loads all
+ *  of the objects.  It needs to be called before
+ *  PrepareScene(), and is only used with a scene file.
+ ***********************************************************/
+void SceneManager::SetSceneStreaming(float cellSize, float loadRadius, int budgetMegabytes)
+{
+	m_streamCellSize = std::max(cellSize, 0.0f);
+	m_streamRadius = std::max(loadRadius, 0.0f);
+	m_streamBudgetMegabytes = std::max(budgetMegabytes, 1);
+}
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  ExportScene()
+ *
+ *  This method is used for writing the prepared 3D scene into
+ *  a binary scene file - the render items, including the tiled
+ *  copies, with the defined materials, the registered texture
+ *  files and the light sources and point lights.  A file
+ *  written from a tiled scene is loaded as it is, without
+ *  tiling it again.  A streamed world is not written, since
+ *  only some of its objects are loaded.
+ ***********************************************************/
+bool SceneManager::ExportScene(const std::string& filename)
+{
+	if (NULL != m_pCellStreamer)
+	{
+		std::cout << "A streamed world cannot be exported" << std::endl;
+		return(false);
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-5.00f, 5.35f, -6.0f);
+	SceneFile::SCENE_CONTENTS contents;
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	int itemCount = m_renderItems.size();
+	contents.objects.resize(itemCount);
+	SceneFile::SCENE_OBJECT* pObjects = contents.objects.data();
+	RunParallel(itemCount,
+		[this, pObjects](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				const RENDER_ITEM& item = m_renderItems[i];
+				SceneFile::SCENE_OBJECT& object = pObjects[i];
+
+				object.mesh = item.mesh;
+				object.textureIndex = item.textureHandle;
+				object.materialIndex = item.materialIndex;
+				memcpy(object.scale, glm::value_ptr(item.scaleXYZ), sizeof(object.scale));
+				memcpy(object.rotationDegrees, glm::value_ptr(item.rotationDegrees), sizeof(object.rotationDegrees));
+				memcpy(object.position, glm::value_ptr(item.positionXYZ), sizeof(object.position));
+				memcpy(object.color, glm::value_ptr(item.color), sizeof(object.color));
+				memcpy(object.uvScale, glm::value_ptr(item.uvScale), sizeof(object.uvScale));
+			}
+		});
+
+	for (size_t i = 0; i < m_objectMaterials.size(); i++)
+	{
+		const OBJECT_MATERIAL& material = m_objectMaterials[i];
+
+		SceneFile::SCENE_MATERIAL record;
+		record.ambientStrength = material.ambientStrength;
+		memcpy(record.ambientColor, glm::value_ptr(material.ambientColor), sizeof(record.ambientColor));
+		memcpy(record.diffuseColor, glm::value_ptr(material.diffuseColor), sizeof(record.diffuseColor));
+		memcpy(record.specularColor, glm::value_ptr(material.specularColor), sizeof(record.specularColor));
+		record.shininess = material.shininess;
+		if (SceneFile::SetString(record.tag, SceneFile::TAG_LENGTH, material.tag) == false)
+		{
+			std::cout << "Material tag " << material.tag << " is too long for the scene file" << std::endl;
+		}
+		contents.materials.push_back(record);
+	}
 
-	SetShaderColor(0.8, 0.5, 0.3, 1); // light brown color for the beam
-	SetShaderTexture("wall"); // calling wall texture
-	SetTextureUVScale(8, 1); // scale uv based on shape dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh(); // draw box
+	contents.textures = m_textureFiles;
 
-	// upper left house pyramid (2nd story)
-	scaleXYZ = glm::vec3(3.0f, 3.0f, 3.0f); 
+	for (int i = 0; i < UniformBuffer::TOTAL_LIGHTS; i++)
+	{
+		const LIGHT_BLOCK_ENTRY& light = m_lightSources[i];
+
+		SceneFile::SCENE_LIGHT record;
+		memcpy(record.position, glm::value_ptr(light.position), sizeof(record.position));
+		memcpy(record.ambientColor, glm::value_ptr(light.ambientColor), sizeof(record.ambientColor));
+		memcpy(record.diffuseColor, glm::value_ptr(light.diffuseColor), sizeof(record.diffuseColor));
+		memcpy(record.specularColor, glm::value_ptr(light.specularColor), sizeof(record.specularColor));
+		record.focalStrength = light.focalStrength;
+		record.specularIntensity = light.specularIntensity;
+		contents.lights.push_back(record);
+	}
 
-	// set the XYZ rotation for the mesh 
-	XrotationDegrees = 270.0f; // x rotation to align with body of house
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	for (int i = 0; i < m_pClusteredLights->GetLightCount(); i++)
+	{
+		const ClusteredLights::POINT_LIGHT_ENTRY& light = m_pClusteredLights->GetLight(i);
+
+		SceneFile::SCENE_POINT_LIGHT record;
+		memcpy(record.position, glm::value_ptr(light.position), sizeof(record.position));
+		record.radius = light.radius;
+		memcpy(record.color, glm::value_ptr(light.color), sizeof(record.color));
+		record.specularIntensity = light.specularIntensity;
+		contents.pointLights.push_back(record);
+	}
+
+	if (SceneFile::Write(filename.c_str(), contents) == false)
+	{
+		return(false);
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-16.25f, 5.0f, -2.0f);
+	std::cout << "Exported " << itemCount << " objects to " << filename << std::endl;
+	return(true);
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  AddPointLight()
+ *
+ *  This method is used for adding a point light to the 3D
+ *  scene, which lights the objects within its radius and
+ *  fades out toward it.  It needs to be called before
+ *  PrepareScene().
+ ***********************************************************/
+int SceneManager::AddPointLight(glm::vec3 positionXYZ, float radius, glm::vec3 color, float specularIntensity)
+{
+	ClusteredLights::POINT_LIGHT_ENTRY light;
+	light.position = positionXYZ;
+	light.radius = radius;
+	light.color = color;
+	light.specularIntensity = specularIntensity;
 
-	SetShaderColor(0.8, 0.5, 0.3, 1); // light brown color for the beam
-	SetShaderTexture("outergreen"); // calling outergreen texture
-	SetTextureUVScale(1, 1); // scale uv based on shape dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPrismMesh(); // draw prism
+	return(m_pClusteredLights->AddLight(light));
+}
 
-	// upper roof (2nd story)
-	scaleXYZ = glm::vec3(13.0f, 2.5f, 4.0f); 
+/***********************************************************
+ *  SetScatteredPointLights()
+ *
+ *  This method is used for setting how many point lights are
+ *  spread over the 3D scene, which is used for scaling the
+ *  lighting in the benchmark.  It needs to be called before
+ *  PrepareScene().
+ ***********************************************************/
+void SceneManager::SetScatteredPointLights(int lightCount)
+{
+	m_scatteredLightCount = std::max(lightCount, 0);
+}
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  TileSceneObjects()
+ *
+ *  This method is used for copying the render items of the
+ *  3D scene into the other tiles of the grid.  The original
+ *  items stay in the first tile, so their indices are kept.
+ ***********************************************************/
+void SceneManager::TileSceneObjects()
+{
+	if (m_tileCount <= 1)
+	{
+		return;
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-5.00f, 7.25f, -6.0f);
+	int itemCount = m_renderItems.size();
+	m_renderItems.resize(itemCount * m_tileCount);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// every copy only reads the items of the first tile
+	RunParallel(itemCount * (m_tileCount - 1),
+		[this, itemCount](int begin, int end)
+		{
+			for (int copy = begin; copy < end; copy++)
+			{
+				int tile = (copy / itemCount) + 1;
+
+				RENDER_ITEM& item = m_renderItems[itemCount + copy];
+				item = m_renderItems[copy % itemCount];
+				item.positionXYZ += GetTileOffset(tile);
+			}
+		});
+
+	// the copies are built in one batch, since they all moved
+	std::vector<int> copyIndices(itemCount * (m_tileCount - 1));
+	for (size_t i = 0; i < copyIndices.size(); i++)
+	{
+		copyIndices[i] = itemCount + i;
+	}
+	UpdateItemTransforms(copyIndices.data(), copyIndices.size());
+	m_bDrawOrderDirty = true;
+}
 
-	SetShaderColor(0.8, 0.5, 0.3, 1); // light brown color for the beam
-	SetShaderTexture("roof"); // calling roof texture
-	SetTextureUVScale(8, 1); // scale uv based on shape dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh(); // draw plane
+/***********************************************************
+ *  GetTileOffset()
+ *
+ *  This method is used for getting how far the copies of the
+ *  3D scene in a tile of the grid are moved from the first
+ *  tile, which fills the grid row by row.
+ ***********************************************************/
+glm::vec3 SceneManager::GetTileOffset(int tile) const
+{
+	int columns = (int)ceilf(sqrtf((float)m_tileCount));
 
-	// second upper left house pyramid (2nd story)
-	scaleXYZ = glm::vec3(3.0f, 3.0f, 3.0f); 
+	return(glm::vec3(
+		(tile % columns) * g_TileSpacing.x,
+		0.0f,
+		-(tile / columns) * g_TileSpacing.z));
+}
 
-	// set the XYZ rotation for the mesh 
-	XrotationDegrees = 270.0f; // x rotation for shape to align with house body
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  GetSceneBounds()
+ *
+ *  This method is used for getting a box around the bounds
+ *  of all of the render items.
+ ***********************************************************/
+void SceneManager::GetSceneBounds(glm::vec3& minXYZ, glm::vec3& maxXYZ) const
+{
+	// only some of the objects of a streamed world are loaded
+	if (NULL != m_pCellStreamer)
+	{
+		m_pCellStreamer->GetWorldBounds(minXYZ, maxXYZ);
+		return;
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-4.25f, 5.0f, -2.0f);
+	minXYZ = glm::vec3(0.0f);
+	maxXYZ = glm::vec3(0.0f);
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	for (size_t i = 0; i < m_renderItems.size(); i++)
+	{
+		const RENDER_ITEM& item = m_renderItems[i];
 
-	SetShaderColor(0.8, 0.5, 0.3, 1); // light brown color for the beam
-	SetShaderTexture("outergreen"); // calling outergreen texture
-	SetTextureUVScale(1, 1); // scale uv based on shape dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPrismMesh(); // draw prism
+		if (i == 0)
+		{
+			minXYZ = item.boundsMin;
+			maxXYZ = item.boundsMax;
+		}
+		else
+		{
+			minXYZ = glm::min(minXYZ, item.boundsMin);
+			maxXYZ = glm::max(maxXYZ, item.boundsMax);
+		}
+	}
+}
 
-	// second story window #1 left 
-	scaleXYZ = glm::vec3(2.0f, 1.0f, 1.0f);
+/***********************************************************
+ *  GetRenderItemCount()
+ *
+ *  This method is used for getting the number of objects in
+ *  the 3D scene.
+ ***********************************************************/
+int SceneManager::GetRenderItemCount() const
+{
+	if (NULL == m_pCellStreamer)
+	{
+		return(m_renderItems.size());
+	}
 
-	// set the XYZ rotation for the mesh 
-	XrotationDegrees = 90.0f; // x rotation to align with body of house
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	// the objects of the resident cells of a streamed world
+	const std::vector<int>& residentCells = m_pCellStreamer->GetResidentCells();
+	int itemCount = 0;
+	for (size_t i = 0; i < residentCells.size(); i++)
+	{
+		itemCount += m_pCellStreamer->GetCell(residentCells[i]).objectCount;
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-10.0f, 5.25f, -3.0f);
+	return(itemCount);
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  GetPendingTextureCount()
+ *
+ *  This method is used for getting the number of texture
+ *  images that have not been uploaded yet.
+ ***********************************************************/
+int SceneManager::GetPendingTextureCount()
+{
+	return(m_pTextureManager->GetPendingCount());
+}
 
-	SetShaderColor(0.5, 0.5, 0.5, 1); // grey color
-	SetShaderTexture("window"); // calling grass texture
-	SetTextureUVScale(1, 1); // mapping texture across entire plane
-	SetShaderMaterial("metal"); // calling material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh(); // draw plane
+/***********************************************************
+ *  NeedsRedraw()
+ *
+ *  This method is used for checking whether rendering the 3D
+ *  scene again from the same view would draw anything new,
+ *  which is the case while render items are waiting to be
+ *  updated, texture images are still being uploaded, or the
+ *  streamed cells are still changing.
+ ***********************************************************/
+bool SceneManager::NeedsRedraw()
+{
+	if (m_dirtyRenderItems.empty() == false)
+	{
+		return(true);
+	}
+	if (GetPendingTextureCount() > 0)
+	{
+		return(true);
+	}
+	if ((NULL != m_pCellStreamer) &&
+		((m_bCellsChanged == true) || (m_pCellStreamer->GetPendingCount() > 0)))
+	{
+		return(true);
+	}
 
+	return(false);
+}
 
-	// second story window #2 right 
-	scaleXYZ = glm::vec3(2.0f, 1.0f, 1.0f);
+/***********************************************************
+ *  SetHotReload()
+ *
+ *  This method is used for turning the reloading of the
+ *  edited asset files on or off.  It needs to be called
+ *  before PrepareScene(), which starts watching the files.
+ ***********************************************************/
+void SceneManager::SetHotReload(bool bEnabled)
+{
+	m_bHotReload = bEnabled;
+}
 
-	// set the XYZ rotation for the mesh 
-	XrotationDegrees = 90.0f; // x rotation to align with body of house
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  ReloadChangedAssets()
+ *
+ *  This method is used for reloading the watched asset files
+ *  that were saved since the last call.  Only the changed
+ *  asset is loaded again - a texture image is uploaded into
+ *  the layer it already has, the programs using a shader file
+ *  are built again, and the render items of the objects that
+ *  changed in the scene file are updated.  It is meant to be
+ *  called once per frame, and only reads the status of the
+ *  files a few times per second.
+ ***********************************************************/
+bool SceneManager::ReloadChangedAssets()
+{
+	if (NULL == m_pFileWatcher)
+	{
+		return(false);
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(3.0f, 5.25f, -3.0f);
+	std::vector<int> changedFiles;
+	if (m_pFileWatcher->Poll(changedFiles) == false)
+	{
+		return(false);
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	bool bReloaded = false;
+	for (size_t i = 0; i < changedFiles.size(); i++)
+	{
+		const WATCHED_ASSET& asset = m_watchedAssets[changedFiles[i]];
+		const std::string& filename = m_pFileWatcher->GetFilename(changedFiles[i]);
+		std::cout << "Reloading the edited file " << filename << std::endl;
 
-	SetShaderColor(0.5, 0.5, 0.5, 1); // grey color
-	SetShaderTexture("window"); // calling grass texture
-	SetTextureUVScale(1, 1); // mapping texture across entire plane
-	SetShaderMaterial("metal"); // calling material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh(); // draw plane
+		bool bAssetReloaded = false;
+		if (asset.type == ASSET_TEXTURE)
+		{
+			bAssetReloaded = m_pTextureManager->ReloadTexture(asset.textureHandle);
+		}
+		else if (asset.type == ASSET_SHADER)
+		{
+			bAssetReloaded = ReloadShaderPrograms(filename);
+		}
+		else
+		{
+			bAssetReloaded = ReloadSceneObjects();
+		}
 
-	// first story window #1 right 
-	scaleXYZ = glm::vec3(2.0f, 1.0f, 1.0f);
+		if (bAssetReloaded == true)
+		{
+			bReloaded = true;
+		}
+	}
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 90.0f; // x rotation to align with body of house 
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	return(bReloaded);
+}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(4.0f, 2.0f, 0.0f);
+/***********************************************************
+ *  WatchAssetFiles()
+ *
+ *  This method is used for watching the texture images, the
+ *  shader files of the built programs and the scene file of
+ *  the prepared scene when hot reloading is on.
+ ***********************************************************/
+void SceneManager::WatchAssetFiles(bool bWatchSceneFile)
+{
+	if (m_bHotReload == false)
+	{
+		return;
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	m_pFileWatcher = new FileWatcher();
+	m_watchedAssets.clear();
 
-	SetShaderColor(0.5, 0.5, 0.5, 1); // grey color
-	SetShaderTexture("window"); // calling grass texture
-	SetTextureUVScale(1, 1); // mapping texture across entire plane
-	SetShaderMaterial("metal"); // calling material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh(); // draw plane
+	// the texture files are kept in the order of their handles
+	for (size_t i = 0; i < m_textureFiles.size(); i++)
+	{
+		WatchAsset(SceneFile::GetString(m_textureFiles[i].filename, SceneFile::FILENAME_LENGTH),
+			ASSET_TEXTURE, (int)i);
+	}
 
-	// garage door
-	scaleXYZ = glm::vec3(5.5f, 1.0f, 1.50f);
+	std::vector<std::string> shaderFiles;
+	m_pShaderCache->GetShaderFiles(shaderFiles);
+	for (size_t i = 0; i < shaderFiles.size(); i++)
+	{
+		WatchAsset(shaderFiles[i], ASSET_SHADER, -1);
+	}
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 90.0f; // x rotation to align with body of house 
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	if (bWatchSceneFile == true)
+	{
+		WatchAsset(m_sceneFilename, ASSET_SCENE, -1);
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-10.0f, 1.75f, 0.0f);
+	std::cout << "Watching " << m_pFileWatcher->GetFileCount() << " asset files for changes" << std::endl;
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  WatchAsset()
+ *
+ *  This method is used for adding an asset file to the file
+ *  watcher.  A file that is already watched keeps the asset
+ *  it was first watched for.
+ ***********************************************************/
+void SceneManager::WatchAsset(const std::string& filename, ASSET_TYPE type, int textureHandle)
+{
+	int fileIndex = m_pFileWatcher->WatchFile(filename);
+	if (fileIndex < (int)m_watchedAssets.size())
+	{
+		return;
+	}
 
-	SetShaderColor(0.5, 0.5, 0.5, 1); // grey color
-	SetShaderTexture("garage"); // calling grass texture
-	SetTextureUVScale(0, 1); // mapping texture across entire plane
-	SetShaderMaterial("metal"); // calling material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh(); // draw plane
+	WATCHED_ASSET asset;
+	asset.type = type;
+	asset.textureHandle = textureHandle;
+	m_watchedAssets.push_back(asset);
+}
 
-	// first story roof (left)
-	scaleXYZ = glm::vec3(8.0f, 1.0f, 4.0f);
+/***********************************************************
+ *  ReloadShaderPrograms()
+ *
+ *  This method is used for building the shader programs that
+ *  use an edited shader file again.  A new program has none
+ *  of the block bindings and uniform values of the program it
+ *  replaces, so its blocks are connected to the shared buffers
+ *  again, it takes the uniform cache slot of the old program,
+ *  and the compute shaders read their uniforms again.  The
+ *  cached shadow maps are drawn again with the new programs.
+ ***********************************************************/
+bool SceneManager::ReloadShaderPrograms(const std::string& filename)
+{
+	std::vector<ShaderCache::RELOADED_PROGRAM> reloaded;
+	if (m_pShaderCache->ReloadShaderFile(filename, reloaded) == 0)
+	{
+		return(false);
+	}
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	for (size_t i = 0; i < reloaded.size(); i++)
+	{
+		int programSlot = m_pUniformCache->FindProgram(reloaded[i].oldProgram);
+		if (programSlot < 0)
+		{
+			continue;
+		}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-10.75f, 3.7f, -4.25f);
+		UniformBuffer::BindProgramBlocks(reloaded[i].newProgram);
+		ClusteredLights::BindProgramBlocks(reloaded[i].newProgram);
+		m_pUniformCache->ReplaceProgram(programSlot, reloaded[i].newProgram);
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	if ((filename == g_CullingShaderFilename) && (m_bGpuCulling == true))
+	{
+		m_pGpuCuller->LoadShader(m_pShaderCache, g_CullingShaderFilename);
+	}
+	if ((filename == g_DepthPyramidShaderFilename) && (m_bGpuCulling == true) && (m_bOcclusionCulling == true))
+	{
+		m_pDepthPyramid->LoadShader(m_pShaderCache, g_DepthPyramidShaderFilename);
+	}
+	if ((filename == g_LightClusterShaderFilename) && (m_bClusteredLighting == true))
+	{
+		m_pClusteredLights->LoadShader(m_pShaderCache, g_LightClusterShaderFilename);
+	}
+	m_bStaticShadowsDirty = true;
 
-	SetShaderColor(0.8, 0.5, 0.3, 1); // light brown color for the beam
-	SetShaderTexture("roof");
-	SetTextureUVScale(4, 1); // scale uv based on shape dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh(); // draw plane
+	std::cout << "Reloaded " << reloaded.size() << " shader programs using " << filename << std::endl;
 
-	// first story roof right side
-	scaleXYZ = glm::vec3(5.0f, 1.0f, 5.0f); 
+	return(true);
+}
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  ReloadSceneObjects()
+ *
+ *  This method is used for comparing the edited scene file
+ *  with the tables it was loaded from, and for updating the
+ *  render items of the objects that changed, in every tile.
+ *  The textures, materials and lights were registered and
+ *  uploaded when the scene was prepared, and the number of
+ *  objects sets the layout of the render items, so a file in
+ *  which any of these changed needs the scene to be prepared
+ *  again and is left as it was loaded.
+ ***********************************************************/
+bool SceneManager::ReloadSceneObjects()
+{
+	SceneFile sceneFile;
+	if (sceneFile.Open(m_sceneFilename.c_str()) == false)
+	{
+		return(false);
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(2.25f, 3.5f, -1.75f);
+	if ((IsSameTable(m_loadedScene.textures, sceneFile.GetTextures(), sceneFile.GetTextureCount()) == false) ||
+		(IsSameTable(m_loadedScene.materials, sceneFile.GetMaterials(), sceneFile.GetMaterialCount()) == false) ||
+		(IsSameTable(m_loadedScene.lights, sceneFile.GetLights(), sceneFile.GetLightCount()) == false) ||
+		(IsSameTable(m_loadedScene.pointLights, sceneFile.GetPointLights(), sceneFile.GetPointLightCount()) == false))
+	{
+		std::cout << "The textures, materials or lights of " << m_sceneFilename
+			<< " changed, which needs a restart" << std::endl;
+		return(false);
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	int objectCount = m_loadedScene.objects.size();
+	if (sceneFile.GetObjectCount() != objectCount)
+	{
+		std::cout << "Objects were added to or removed from " << m_sceneFilename
+			<< ", which needs a restart" << std::endl;
+		return(false);
+	}
 
-	SetShaderColor(0.8, 0.5, 0.3, 1); // light brown color for the beam
-	SetShaderTexture("roof"); // calling roof texture
-	SetTextureUVScale(8, 1); // scale uv based on shape dimensions
-	SetShaderMaterial("wood"); // call material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh(); // draw plane
+	const SceneFile::SCENE_OBJECT* pObjects = sceneFile.GetObjects();
+	int changedCount = 0;
+	for (int i = 0; i < objectCount; i++)
+	{
+		if (memcmp(&pObjects[i], &m_loadedScene.objects[i], sizeof(SceneFile::SCENE_OBJECT)) == 0)
+		{
+			continue;
+		}
+		m_loadedScene.objects[i] = pObjects[i];
 
-	// driveway
-	scaleXYZ = glm::vec3(5.5f, 1.0f, 7.0f);
+		RENDER_ITEM loaded;
+		FillRenderItem(pObjects[i], loaded);
+		for (int tile = 0; tile < m_tileCount; tile++)
+		{
+			ReplaceRenderItem((tile * objectCount) + i, loaded, GetTileOffset(tile));
+		}
+		changedCount++;
+	}
 
-	// set the XYZ rotation for the mesh (no rotation)
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	std::cout << "Updated " << changedCount << " of the " << objectCount
+		<< " objects of " << m_sceneFilename << std::endl;
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(-10.0f, 0.01f, 3.0f);
+	return(changedCount > 0);
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  ReplaceRenderItem()
+ *
+ *  This method is used for giving a render item the values
+ *  of a changed object of the scene file.  The item is placed
+ *  again even when only its look changed, which takes it out
+ *  of the static batches that still hold it as it was.  It
+ *  stays a still object, so the cached shadow maps are drawn
+ *  again once with it instead of every frame.
+ ***********************************************************/
+void SceneManager::ReplaceRenderItem(int itemIndex, const RENDER_ITEM& loaded, glm::vec3 offset)
+{
+	RENDER_ITEM& item = m_renderItems[itemIndex];
+	if (item.mesh != loaded.mesh)
+	{
+		item.mesh = loaded.mesh;
+		item.lodLevel = 0;
+	}
+	item.color = loaded.color;
+	item.textureHandle = loaded.textureHandle;
+	item.textureArray = loaded.textureArray;
+	item.textureLayer = loaded.textureLayer;
+	item.bTransparent = loaded.bTransparent;
+	item.uvScale = loaded.uvScale;
+	item.materialIndex = loaded.materialIndex;
+
+	PlaceRenderItem(itemIndex, loaded.scaleXYZ, loaded.rotationDegrees,
+		loaded.positionXYZ + offset);
+
+	// the batches are sorted by mesh, texture and material
+	m_bDrawOrderDirty = true;
+	m_bStaticShadowsDirty = true;
+}
 
-	SetShaderColor(0.5, 0.5, 0.5, 1); // grey color
-	SetShaderTexture("concrete"); // calling grass texture
-	SetTextureUVScale(1, 1); // mapping texture across entire plane
-	SetShaderMaterial("metal"); // calling material definition
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh(); // draw plane
+/***********************************************************
+ *  SetProfiler()
+ *
+ *  This method is used for setting the profiler that times
+ *  the phases and the draws of RenderScene(), which can be
+ *  NULL for no timing.
+ ***********************************************************/
+void SceneManager::SetProfiler(FrameProfiler* pProfiler)
+{
+	m_pProfiler = pProfiler;
+}
 
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used for setting the job system that the
+ *  loops over the render items are spread over, which can be
+ *  NULL for running them on the calling thread.  The OpenGL
+ *  calls stay on the calling thread either way.
+ ***********************************************************/
+void SceneManager::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
 }
@@ -10,9 +10,31 @@
 #pragma once
 
 #include "ShaderManager.h"
-#include "ShapeMeshes.h"
+#include "MeshManager.h"
+#include "UniformBuffer.h"
+#include "UniformCache.h"
+#include "TextureManager.h"
+#include "FrameProfiler.h"
+#include "Frustum.h"
+#include "BvhTree.h"
+#include "OcclusionCuller.h"
+#include "StaticBatch.h"
+#include "GpuCuller.h"
+#include "DepthPyramid.h"
+#include "ClusteredLights.h"
+#include "JobSystem.h"
+#include "TransformKernel.h"
+#include "SceneFile.h"
+#include "CellStreamer.h"
+#include "ResourcePool.h"
+#include "FrameArena.h"
+#include "ShaderCache.h"
+#include "ShadowMaps.h"
+#include "FileWatcher.h"
 
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 /***********************************************************
@@ -25,50 +47,413 @@ class SceneManager
 {
 public:
 	// constructor
-	SceneManager(ShaderManager *pShaderManager);
+	SceneManager(ShaderManager *pShaderManager, ShaderCache* pShaderCache);
 	// destructor
 	~SceneManager();
 
-	struct TEXTURE_INFO
+	struct OBJECT_MATERIAL
 	{
+		float ambientStrength;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
 		std::string tag;
-		uint32_t ID;
 	};
 
-	struct OBJECT_MATERIAL
+	// one object material as laid out in the std140 material
+	// block of the fragment shader - 48 bytes
+	struct MATERIAL_BLOCK_ENTRY
 	{
+		glm::vec3 ambientColor;
 		float ambientStrength;
+		glm::vec3 diffuseColor;
+		float shininess;
+		glm::vec3 specularColor;
+		float padding;
+	};
+
+	// one light source as laid out in the std140 light block
+	// of the fragment shader - 64 bytes
+	struct LIGHT_BLOCK_ENTRY
+	{
+		glm::vec3 position;
+		float focalStrength;
 		glm::vec3 ambientColor;
+		float specularIntensity;
 		glm::vec3 diffuseColor;
+		// layer of the shadow maps of the light, -1 for none
+		float shadowLayer;
 		glm::vec3 specularColor;
-		float shininess;
-		std::string tag;
+		float padding;
+	};
+
+	// identifiers for the basic meshes that can be drawn
+	// by the render items in the 3D scene
+	enum MESH_TYPE
+	{
+		MESH_PLANE = 0,
+		MESH_BOX,
+		MESH_TAPERED_CYLINDER,
+		MESH_PRISM,
+		MESH_PYRAMID3
+	};
+
+	// retained description of one drawn object in the 3D scene
+	struct RENDER_ITEM
+	{
+		MESH_TYPE mesh;
+		glm::vec3 scaleXYZ;
+		glm::vec3 rotationDegrees;
+		glm::vec3 positionXYZ;
+		// calculated from the scale, rotation and position
+		glm::mat4 modelMatrix;
+		// world space box around the mesh, used for culling
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		glm::vec4 color;
+		// -1 when the object is drawn with its color
+		int textureHandle;
+		// texture array and layer resolved from the texture handle
+		int textureArray;
+		int textureLayer;
+		glm::vec2 uvScale;
+		// -1 when the object has no material
+		int materialIndex;
+		// level of detail of the mesh, 0 for the finest
+		int lodLevel;
+		// object index in the static batches, -1 when the item
+		// is not baked or has moved since it was baked
+		int staticObject;
+		// true when the item is blended over the items behind it,
+		// which draws it after all of the opaque items
+		bool bTransparent;
+		// true when the model matrix needs to be recalculated
+		bool bDirty;
+		// true once the item has moved, which casts its shadows
+		// into the per-frame shadow maps instead of the cached ones
+		bool bDynamic;
+		// frames drawn since a moving item last moved, which puts
+		// it back into the cached shadow maps once it holds still
+		int stillFrames;
+	};
+
+	// draw call and shader state change counters for one frame
+	struct RENDER_STATS
+	{
+		int drawCalls;
+		int instancedDrawCalls;
+		int stateChanges;
+		int stateChangesSkipped;
+		// render items inside and outside of the view frustum
+		int visibleItems;
+		int culledItems;
+		// render items in the frustum skipped as hidden, and the
+		// occlusion queries issued
+		int occludedItems;
+		int occlusionQueries;
+		// drawn render items with a coarser level of detail
+		int reducedLodItems;
+		// render items drawn from the static batches
+		int staticItems;
+		// instanced draws into the shadow maps, which are also
+		// counted in the draw calls
+		int shadowDrawCalls;
 	};
 
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
-	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
+	// builds the shader programs, which it owns
+	ShaderCache* m_pShaderCache;
+	// cached uniform locations of the shader programs
+	UniformCache* m_pUniformCache;
+	// handles of the uniforms set by the draw code, resolved
+	// once so that no uniform is looked up by name per draw
+	struct UNIFORM_HANDLES
+	{
+		UniformCache::HANDLE model;
+		UniformCache::HANDLE objectColor;
+		UniformCache::HANDLE objectTexture;
+		UniformCache::HANDLE bUseTexture;
+		UniformCache::HANDLE bUseLighting;
+		UniformCache::HANDLE bUseClusteredLights;
+		UniformCache::HANDLE bUseInstancing;
+		UniformCache::HANDLE bUseStaticBatch;
+		UniformCache::HANDLE bDepthOnly;
+		UniformCache::HANDLE UVscale;
+		UniformCache::HANDLE materialIndex;
+		UniformCache::HANDLE textureLayer;
+		UniformCache::HANDLE lightViewProjection;
+		UniformCache::HANDLE bUseShadows;
+		UniformCache::HANDLE staticShadowMaps;
+		UniformCache::HANDLE dynamicShadowMaps;
+		UniformCache::HANDLE sunShadowMaps;
+		UniformCache::HANDLE dynamicSunShadowMaps;
+	};
+	UNIFORM_HANDLES m_uniforms;
+	// gives out the OpenGL buffers and textures, and keeps the
+	// released ones for the next load
+	ResourcePool* m_pResourcePool;
+	// the short lived lists of each frame
+	FrameArena* m_pFrameArena;
+	// pointer to the basic shape meshes, which share one vertex
+	// and index buffer for the single and the instanced draws
+	MeshManager* m_instancedMeshes;
+	// the loaded textures, stored in texture arrays
+	TextureManager* m_pTextureManager;
+	// the image file and tag of each registered texture, in the
+	// order of their texture handles, kept for exporting the scene
+	std::vector<SceneFile::SCENE_TEXTURE> m_textureFiles;
+	// binary scene file loaded instead of the built-in 3D scene,
+	// empty for the built-in scene
+	std::string m_sceneFilename;
+	// the mapped scene file, which stays open while its cells
+	// are streamed
+	SceneFile m_sceneFile;
+	// the texture handles and material indices of the texture
+	// and material tables of the scene file
+	std::vector<int> m_fileTextureHandles;
+	std::vector<int> m_fileMaterialIndices;
+	// streams the cells of the scene file around the camera, NULL
+	// when all of the objects are loaded
+	CellStreamer* m_pCellStreamer;
+	// true when the resident cells changed in the last render
+	bool m_bCellsChanged;
+	// size of the streamed cells, 0 for no streaming, the radius
+	// around the camera that is loaded and the memory budget
+	float m_streamCellSize;
+	float m_streamRadius;
+	int m_streamBudgetMegabytes;
+	// number of render items in the slot of each resident cell,
+	// which holds the largest cell
+	int m_slotCapacity;
+	// spatial index over the render items of each slot
+	std::vector<BvhTree> m_slotIndices;
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// indices of the defined object materials by tag, only used
+	// while the scene is being prepared
+	std::unordered_map<std::string, int> m_materialIndices;
+	// uniform buffer holding all of the defined object materials
+	UniformBuffer* m_pMaterialBuffer;
+	// light sources for the 3D scene
+	LIGHT_BLOCK_ENTRY m_lightSources[UniformBuffer::TOTAL_LIGHTS];
+	// number of light sources defined, up to the highest index
+	int m_lightSourceCount;
+	// true when the scene turned the lighting on
+	bool m_bSceneLighting;
+	// uniform buffer holding the light sources
+	UniformBuffer* m_pLightBuffer;
+	// point lights of the 3D scene, binned into the clusters of
+	// the view on the GPU
+	ClusteredLights* m_pClusteredLights;
+	// true when the point lights are binned and drawn
+	bool m_bClusteredLighting;
+	// number of point lights spread over the scene when it is
+	// prepared
+	int m_scatteredLightCount;
+	// retained list of the objects in the 3D scene
+	std::vector<RENDER_ITEM> m_renderItems;
+	// indices of the render items that need to be re-evaluated
+	std::vector<int> m_dirtyRenderItems;
+	// transformation values and model matrices of the render items
+	// being recalculated, in the order of their item indices
+	TransformKernel::SOA_TRANSFORMS m_batchTransforms;
+	std::vector<glm::mat4> m_batchMatrices;
+	// indices of the render items in their submission order
+	std::vector<int> m_drawOrder;
+	// true when the submission order needs to be sorted again
+	bool m_bDrawOrderDirty;
+	// indices of the render items inside the view frustum, in
+	// their submission order, with the transparent ones moved to
+	// the end and sorted from back to front
+	std::vector<int> m_visibleOrder;
+	// number of opaque items at the start of the visible order
+	int m_opaqueCount;
+	// true when the depth of the opaque items is drawn before
+	// they are shaded
+	bool m_bDepthPrepass;
+	// true while the depth prepass draws, which skips the
+	// texture and material state of the draws
+	bool m_bDepthOnlyPass;
+	// position of each render item in the submission order
+	std::vector<int> m_drawRank;
+	// bounding volume hierarchy over the render item boxes
+	BvhTree m_spatialIndex;
+	// viewing volume of the camera for the next render
+	Frustum m_frustum;
+	// false when every render item is drawn
+	bool m_bFrustumCulling;
+	// indices of the render items inside the view frustum,
+	// including the ones skipped as hidden
+	std::vector<int> m_frustumVisible;
+	// occlusion query results of the render items
+	OcclusionCuller* m_pOcclusionCuller;
+	// false when the hidden render items are drawn
+	bool m_bOcclusionCulling;
+	// camera position of the next render
+	glm::vec3 m_viewPosition;
+	// projection scale used for the screen size of the items
+	float m_lodScale;
+	// projection of the next render
+	glm::mat4 m_projection;
+	// pre-transformed meshes of the render items that never move
+	StaticBatch* m_pStaticBatch;
+	// false when the static render items are drawn like the
+	// moving ones
+	bool m_bStaticBatching;
+	// indices of the visible render items drawn from the static
+	// batches, sorted by texture array and material
+	std::vector<int> m_staticVisible;
+	// culls the static batches and writes their draw commands on
+	// the GPU
+	GpuCuller* m_pGpuCuller;
+	// true when the static batches are culled on the GPU
+	bool m_bGpuCulling;
+	// farthest depths of the last frame, which the GPU culling
+	// tests the baked items against for the occlusion culling
+	DepthPyramid* m_pDepthPyramid;
+	// the shader state shared by the baked items of a draw group
+	// of the GPU culling
+	struct DRAW_GROUP
+	{
+		int textureArray;
+		int materialIndex;
+		// name of the profiler scope timing the draw of the group
+		const char* scopeName;
+	};
+	std::vector<DRAW_GROUP> m_drawGroups;
+	// indices of the baked render items that have moved since,
+	// which are culled and drawn on the CPU
+	std::vector<int> m_movedItems;
+	// the shadow maps of the light sources and the sun
+	ShadowMaps* m_pShadowMaps;
+	// false when the scene is lit without shadow maps
+	bool m_bShadows;
+	// true when the scene is lit by a sun
+	bool m_bSunLight;
+	// true when the shadow maps were created
+	bool m_bShadowMaps;
+	// indices of the light sources with shadows, in the order of
+	// their layers in the shadow maps
+	std::vector<int> m_shadowLights;
+	// uniform cache slot of the program drawing the shadow maps
+	int m_shadowSlot;
+	// true while the shadow casters are drawn
+	bool m_bShadowPass;
+	// true when the cached shadow maps of the render items that
+	// never move need to be drawn again
+	bool m_bStaticShadowsDirty;
+	// box around the objects when the cached shadow maps were
+	// drawn, which the light sources are aimed at
+	glm::vec3 m_shadowBoundsMin;
+	glm::vec3 m_shadowBoundsMax;
+	// indices of the render items that are moving
+	std::vector<int> m_dynamicItems;
+	// one layer of the shadow maps drawn in this frame, with its
+	// run of the shadow casters
+	struct SHADOW_PASS
+	{
+		ShadowMaps::MAP_SET mapSet;
+		int layer;
+		glm::mat4 lightMatrix;
+		int firstCaster;
+		int casterCount;
+	};
+	std::vector<SHADOW_PASS> m_shadowPasses;
+	// indices of the render items drawn into the shadow maps, in
+	// runs of the same mesh for each pass - their instances follow
+	// the ones of the visible order
+	std::vector<int> m_shadowCasters;
+	// camera view of the next render
+	glm::mat4 m_view;
 
-	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
-	// bind loaded OpenGL textures to slots in memory
+	// last values set into the shader, used for skipping the
+	// shader values that have not changed between draws
+	struct SHADER_STATE_CACHE
+	{
+		bool bUseTexture;
+		bool bUseTextureValid;
+		bool bUseInstancing;
+		bool bUseInstancingValid;
+		bool bUseStaticBatch;
+		bool bUseStaticBatchValid;
+		glm::vec4 color;
+		bool bColorValid;
+		int textureArray;
+		bool bTextureArrayValid;
+		int textureLayer;
+		bool bTextureLayerValid;
+		glm::vec2 uvScale;
+		bool bUVScaleValid;
+		int materialIndex;
+		bool bMaterialValid;
+	};
+	SHADER_STATE_CACHE m_stateCache;
+	// counters for the last rendered frame
+	RENDER_STATS m_renderStats;
+	// times the phases and the draws of the render, can be NULL
+	FrameProfiler* m_pProfiler;
+	// names of the profiler scopes of the baked draws, which are
+	// never removed since the profiler reads them frames later
+	std::set<std::string> m_scopeNames;
+	// runs the loops over the render items, can be NULL
+	JobSystem* m_pJobSystem;
+	// number of copies of the 3D scene placed in a grid
+	int m_tileCount;
+	// true when the asset files are watched and reloaded after
+	// they are edited
+	bool m_bHotReload;
+	// watches the texture, shader and scene files, NULL when
+	// hot reloading is off
+	FileWatcher* m_pFileWatcher;
+	// the kinds of the watched asset files
+	enum ASSET_TYPE
+	{
+		ASSET_TEXTURE = 0,
+		ASSET_SHADER,
+		ASSET_SCENE
+	};
+	// what each watched file is, indexed by its file index in
+	// the file watcher
+	struct WATCHED_ASSET
+	{
+		ASSET_TYPE type;
+		// handle of the texture loaded from the file, -1 for the
+		// other kinds
+		int textureHandle;
+	};
+	std::vector<WATCHED_ASSET> m_watchedAssets;
+	// the tables of the scene file as they were loaded, which an
+	// edited scene file is compared with
+	SceneFile::SCENE_CONTENTS m_loadedScene;
+
+	// load texture images and convert to OpenGL texture data,
+	// returning the handle of the texture
+	int CreateGLTexture(const char* filename, const std::string& tag);
+	// bind the loaded OpenGL texture arrays to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
+	int FindTextureID(const std::string& tag);
+	int FindTextureHandle(const std::string& tag);
 	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	bool FindMaterial(const std::string& tag, OBJECT_MATERIAL& material);
+	int FindMaterialIndex(const std::string& tag);
+	// add a material to the defined materials, returning the
+	// material index as the handle of the material
+	int AddObjectMaterial(const OBJECT_MATERIAL& material);
 	
+	// calculate the model matrix from the transformation values
+	glm::mat4 ComputeModelMatrix(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
 	// set the transformation values 
 	// into the transform buffer
 	void SetTransformations(
@@ -77,6 +462,15 @@ private:
 		float YrotationDegrees,
 		float ZrotationDegrees,
 		glm::vec3 positionXYZ);
+	void SetTransformations(
+		const glm::mat4& modelView);
+
+	// set whether the next draw uses a texture into the shader
+	void SetUseTexture(bool bUseTexture);
+	// set whether the next draw uses the per-instance values
+	void SetUseInstancing(bool bUseInstancing);
+	// set whether the next draw uses the baked static vertices
+	void SetUseStaticBatch(bool bUseStaticBatch);
 
 	// set the color values into the shader
 	void SetShaderColor(
@@ -87,15 +481,221 @@ private:
 
 	// set the texture data into the shader
 	void SetShaderTexture(
-		std::string textureTag);
+		const std::string& textureTag);
+	void SetShaderTexture(
+		int textureHandle);
+	// select the texture array and its layer in the shader
+	void SetShaderTextureArray(
+		int textureArray);
+	void SetShaderTextureLayer(
+		int textureLayer);
 
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
 		float u, float v);
 
+	// upload the defined object materials into the material buffer
+	void UploadObjectMaterials();
+	// set the values of one light source for the light buffer
+	void DefineLightSource(
+		int lightIndex,
+		glm::vec3 positionXYZ,
+		glm::vec3 ambientColor,
+		glm::vec3 diffuseColor,
+		glm::vec3 specularColor,
+		float focalStrength,
+		float specularIntensity);
+	// spread the requested number of point lights over the scene
+	void ScatterPointLights();
+	// upload the point lights and load the light binning shader
+	void SetupClusteredLights();
+	// build the specialized variants of the shader program for
+	// the lights and features of the prepared scene
+	void BuildShaderVariants();
+	// make the variant for the next draw the current program
+	void SelectShaderVariant();
+	// create the shadow maps and load the program drawing them
+	void SetupShadowMaps();
+	// aim the shadow maps and list the layers that need to be
+	// drawn in this frame with their casters
+	void CollectShadowPasses();
+	// put the moving items that have held still for a while back
+	// into the cached shadow maps
+	void SettleDynamicItems();
+	// add a layer of the shadow maps with the casters inside of
+	// its light space, the ones that never move, the moving ones
+	// or both
+	void AddShadowPass(
+		ShadowMaps::MAP_SET mapSet,
+		int layer,
+		const glm::mat4& lightMatrix,
+		bool bStaticCasters,
+		bool bDynamicCasters);
+	// draw the listed layers of the shadow maps
+	void DrawShadowPasses();
+
 	// set the object material into the shader
 	void SetShaderMaterial(
-		std::string materialTag);
+		const std::string& materialTag);
+	void SetShaderMaterial(
+		int materialIndex);
+
+	// load the tables of the binary scene file in place of the
+	// built-in textures, materials, lights and objects
+	void LoadSceneTextures();
+	void LoadSceneMaterials();
+	void LoadSceneLights();
+	void LoadSceneObjects();
+	// set a render item from an object of the scene file,
+	// returning the number of out of range values replaced
+	int FillRenderItem(const SceneFile::SCENE_OBJECT& object, RENDER_ITEM& item) const;
+	// split the objects of the scene file into cells and start
+	// streaming them
+	void SetupCellStreaming();
+	// build the render items of a cell into its slot, on the
+	// streaming thread
+	void LoadCellItems(
+		const int* objectIndices,
+		int objectCount,
+		int slot,
+		glm::vec3& boundsMin,
+		glm::vec3& boundsMax);
+	// build the list of the visible items of the resident cells,
+	// returning the number of resident items
+	int CullStreamedCells();
+	// keep a copy of the tables of the scene file for comparing
+	// it with the file after it is edited
+	void KeepSceneTables();
+
+	// start watching the asset files of the prepared scene
+	void WatchAssetFiles(bool bWatchSceneFile);
+	// add an asset file to the watched files
+	void WatchAsset(const std::string& filename, ASSET_TYPE type, int textureHandle);
+	// build the shader programs using an edited shader file again
+	// and connect them like the ones they replace
+	bool ReloadShaderPrograms(const std::string& filename);
+	// compare the edited scene file with the loaded tables and
+	// update the render items of the objects that changed
+	bool ReloadSceneObjects();
+	// give a render item the values of a changed object, moved by
+	// the offset of the tile that the item is in
+	void ReplaceRenderItem(int itemIndex, const RENDER_ITEM& loaded, glm::vec3 offset);
+	// give a render item new transformation values, taking it out
+	// of the static batches and queueing it to be re-evaluated
+	void PlaceRenderItem(int itemIndex, glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees, glm::vec3 positionXYZ);
+
+	// add an object to the retained list of render items
+	int AddRenderItem(
+		MESH_TYPE mesh,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		glm::vec4 color,
+		const std::string& textureTag,
+		glm::vec2 uvScale,
+		const std::string& materialTag);
+	// set the texture of a render item and whether it is see-through
+	void SetItemTexture(RENDER_ITEM& item, int textureHandle) const;
+	// copy the render items into the other tiles of the grid
+	void TileSceneObjects();
+	// get the distance of a tile of the grid from the first one
+	glm::vec3 GetTileOffset(int tile) const;
+	// calculate the model matrix and the bounds of a render item
+	void UpdateItemTransform(RENDER_ITEM& item);
+	// calculate the model matrices and the bounds of many render
+	// items, building their matrices in one batch
+	void UpdateItemTransforms(const int* itemIndices, int itemCount);
+	// calculate the world space box of a render item from its
+	// model matrix
+	void UpdateItemBounds(RENDER_ITEM& item) const;
+	// get the bounds of the basic mesh for the mesh identifier
+	MeshManager::MESH_BOUNDS GetMeshBounds(MESH_TYPE mesh) const;
+	// build the list of the render items inside the frustum
+	void CullRenderItems();
+	// build the spatial index over the render item boxes
+	void BuildSpatialIndex();
+	// draw the boxes of the render items for occlusion queries
+	void IssueOcclusionQueries();
+	// choose the level of detail of the render items in view
+	void SelectLevelsOfDetail();
+	int SelectLevelOfDetail(RENDER_ITEM& item) const;
+	// run a loop over the render items on the job system
+	void RunParallel(int itemCount, const JobSystem::RANGE_FUNCTION& body);
+	// get the number of levels of detail for the mesh identifier
+	int GetMeshLodCount(MESH_TYPE mesh) const;
+	// get the geometry of the basic mesh for the mesh identifier
+	const MeshManager::MESH_GEOMETRY& GetMeshGeometry(MESH_TYPE mesh, int lodLevel) const;
+	// bake the render items into the static batches
+	void BakeStaticObjects();
+	// move the visible baked items out of the visible order
+	void SplitStaticItems();
+	// write the draw commands of the visible baked items
+	void UploadStaticCommands();
+	// draw the visible baked items grouped by texture and material
+	void DrawStaticBatches(bool bProfileGroups);
+	// get the profiler scope name of the baked draws sharing a
+	// texture array and material
+	const char* GetStaticScopeName(int textureArray, int materialIndex);
+	// move the visible transparent items to the end of the
+	// visible order, sorted from back to front
+	void SplitTransparentItems();
+	// the passes drawing the depth of the opaque items, the
+	// shaded opaque items and the blended transparent items, and
+	// the depth of the shadow casters into the shadow maps
+	enum RENDER_PASS
+	{
+		PASS_DEPTH = 0,
+		PASS_OPAQUE,
+		PASS_TRANSPARENT,
+		PASS_SHADOW
+	};
+	// the specialized variants of the shader program, in which
+	// the texture, lighting and depth switches are constants
+	enum SHADER_VARIANT
+	{
+		VARIANT_DEPTH = 0,
+		VARIANT_COLOR,
+		VARIANT_TEXTURE,
+		VARIANT_COUNT
+	};
+	// uniform cache slot of the uber shader program
+	int m_programSlot;
+	// uniform cache slots of the variants, -1 when the uber
+	// shader program draws everything
+	int m_variantSlots[VARIANT_COUNT];
+	// false when the variants are not built
+	bool m_bShaderVariants;
+	// set the depth, color and blend state of a render pass
+	void BeginRenderPass(RENDER_PASS pass);
+	// put back the state expected outside of the render passes
+	void EndRenderPasses();
+	// give the baked items to the GPU culling, in draw groups
+	void BuildGpuDrawGroups();
+	// recalculate the render items marked dirty
+	void UpdateRenderItems();
+	// sort the render items by mesh, texture array and material
+	void SortRenderItems();
+	// write the per-instance values of the visible items
+	void UploadVisibleInstances();
+	// draw the basic mesh for the mesh identifier
+	void DrawMesh(MESH_TYPE mesh);
+	// check whether two render items can be drawn in one batch
+	bool IsSameBatch(const RENDER_ITEM& itemA, const RENDER_ITEM& itemB);
+	// draw a run of the visible render items as one instanced batch
+	void DrawInstancedBatch(int firstOrder, int endOrder);
+	// draw the visible render items between two positions of the
+	// visible order in instanced batches, timing each batch by its
+	// mesh when asked
+	void DrawInstancedBatches(int firstOrder, int endOrder, bool bProfileMeshes);
+	// draw uploaded instances of the basic mesh for the mesh identifier
+	void DrawMeshInstanced(
+		MESH_TYPE mesh,
+		int firstInstance,
+		int instanceCount,
+		int lodLevel);
 
 public:
 
@@ -107,5 +707,106 @@ public:
 	void DefineObjectMaterials();
 	// pre-define the object materials for lighting
 	void SetupSceneLights();
+	// build the retained list of render items for the 3D scene
+	void DefineSceneObjects();
+
+	// cook the texture images of the 3D scene into compressed
+	// texture files, which needs no OpenGL context
+	static bool CookSceneTextures();
+
+	// forget the shader values cached from the previous draws
+	void InvalidateShaderStateCache();
+	// get the counters from the last rendered frame
+	RENDER_STATS GetRenderStats() const;
+	// write the memory held by the OpenGL resources and the
+	// frame arena to the console
+	void ReportMemoryUsage() const;
+	// set the profiler timing the render, NULL for no timing
+	void SetProfiler(FrameProfiler* pProfiler);
+	// set the job system for the loops over the render items,
+	// NULL for running them on the calling thread
+	void SetJobSystem(JobSystem* pJobSystem);
+
+	// set the camera view and projection of the next render,
+	// which the render items are culled against
+	void SetSceneView(const glm::mat4& view, const glm::mat4& projection);
+	// turn the culling of the render items outside of the view
+	// on or off
+	void SetFrustumCulling(bool bEnabled);
+	// turn the culling of the render items hidden behind other
+	// items on or off
+	void SetOcclusionCulling(bool bEnabled);
+	// turn the drawing of the objects that never move from the
+	// baked static batches on or off, before the scene is prepared
+	void SetStaticBatching(bool bEnabled);
+	// turn the culling of the static batches on the GPU on or
+	// off, before the scene is prepared - it is only used when
+	// the context has compute shaders
+	void SetGpuCulling(bool bEnabled);
+	// turn the drawing of the depth of the opaque items before
+	// shading them on or off
+	void SetDepthPrepass(bool bEnabled);
+	// turn the specialized variants of the shader program on or
+	// off, before the scene is prepared
+	void SetShaderVariants(bool bEnabled);
+	// turn the shadows of the light sources and the sun on or
+	// off, before the scene is prepared
+	void SetShadows(bool bEnabled);
+	// light the scene with a sun shining along the opposite of
+	// the passed in direction, before the scene is prepared
+	void SetSunLight(glm::vec3 direction, glm::vec3 color, float specularIntensity);
+
+	// find the nearest render item hit by a ray, -1 for none
+	int PickRenderItem(glm::vec3 origin, glm::vec3 direction, float& distance) const;
+	// find the render items overlapping a box
+	void QueryRenderItems(glm::vec3 boxMin, glm::vec3 boxMax, std::vector<int>& items) const;
+	// get a render item by index
+	const RENDER_ITEM& GetRenderItem(int itemIndex) const;
+
+	// set the number of copies of the 3D scene placed in a grid,
+	// before the scene is prepared
+	void SetSceneTiling(int tileCount);
+	// set a binary scene file to load instead of the built-in 3D
+	// scene, before the scene is prepared
+	void SetSceneFile(const std::string& filename);
+	// stream the objects of the scene file in cells around the
+	// camera within a memory budget, before the scene is prepared
+	// - a cell size of 0 loads all of the objects
+	void SetSceneStreaming(float cellSize, float loadRadius, int budgetMegabytes);
+	// write the prepared 3D scene into a binary scene file
+	bool ExportScene(const std::string& filename);
+	// add a point light that lights the objects within its radius,
+	// before the scene is prepared - point lights are only drawn
+	// when the context has compute shaders
+	int AddPointLight(glm::vec3 positionXYZ, float radius, glm::vec3 color, float specularIntensity);
+	// set the number of point lights spread in a grid over the
+	// objects, before the scene is prepared
+	void SetScatteredPointLights(int lightCount);
+	// get a box around all of the objects in the 3D scene
+	void GetSceneBounds(glm::vec3& minXYZ, glm::vec3& maxXYZ) const;
+	// get the number of objects in the 3D scene
+	int GetRenderItemCount() const;
+	// get the number of texture images not uploaded yet
+	int GetPendingTextureCount();
+	// check whether the 3D scene looks different from the last
+	// render even with the same view, since items moved or
+	// textures and cells are still loading
+	bool NeedsRedraw();
+	// turn the reloading of the edited texture, shader and scene
+	// files on or off, before the scene is prepared
+	void SetHotReload(bool bEnabled);
+	// reload the asset files that were edited since the last
+	// call, returning true when the 3D scene changed
+	bool ReloadChangedAssets();
+
+	// change the transformation values of a render item, which
+	// marks it dirty to be re-evaluated on the next render
+	void SetRenderItemTransform(
+		int itemIndex,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
 
 };
\ No newline at end of file
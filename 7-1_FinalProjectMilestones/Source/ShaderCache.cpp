@@ -0,0 +1,578 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadercache.cpp
+// ============
+// build the shader programs from their GLSL files with a set of defines, and
+// keep their linked binaries on disk so that later launches skip compiling
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderCache.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// the binaries are written into their own folder, out of the
+	// shader sources, and named by the hash of the shader files
+	// and defines of the program, so each program has one file
+	const char* g_BinaryFolder = "shadercache";
+	const char* g_BinaryFilePrefix = "shadercache/program_";
+	const char* g_BinaryFileSuffix = ".bin";
+
+	// marks the start of a binary file, and the version of its
+	// header, which is changed whenever the header changes
+	const unsigned int g_BinaryMagic = 0x42475250;
+	const unsigned int g_BinaryVersion = 1;
+
+	// the values written before the program binary
+	struct BINARY_HEADER
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned long long hash;
+		GLenum format;
+		GLint length;
+	};
+
+	/***********************************************************
+	 *  HashText()
+	 *
+	 *  This function is used for adding the passed in text to a
+	 *  64 bit FNV-1a hash.
+	 ***********************************************************/
+	unsigned long long HashText(unsigned long long hash, const std::string& text)
+	{
+		for (size_t i = 0; i < text.size(); i++)
+		{
+			hash ^= (unsigned char)text[i];
+			hash *= 1099511628211ULL;
+		}
+		return(hash);
+	}
+
+	/***********************************************************
+	 *  CreateBinaryFolder()
+	 *
+	 *  This function is used for creating the folder of the
+	 *  binary files, which fails quietly when it is there.
+	 ***********************************************************/
+	void CreateBinaryFolder()
+	{
+#ifdef _WIN32
+		_mkdir(g_BinaryFolder);
+#else
+		mkdir(g_BinaryFolder, 0755);
+#endif
+	}
+
+	/***********************************************************
+	 *  ReadSourceFile()
+	 *
+	 *  This function is used for reading a shader file and
+	 *  putting the define lines after its version line, which
+	 *  needs to stay the first line.  The line numbers of the
+	 *  compile errors are kept the same as in the file.
+	 ***********************************************************/
+	bool ReadSourceFile(const char* filename, const std::string& defines, std::string& source)
+	{
+		std::ifstream file(filename);
+		if (file.is_open() == false)
+		{
+			std::cout << "Could not open the shader " << filename << std::endl;
+			return(false);
+		}
+		std::stringstream stream;
+		stream << file.rdbuf();
+		source = stream.str();
+
+		if (defines.empty() == true)
+		{
+			return(true);
+		}
+
+		size_t insertAt = 0;
+		int nextLine = 1;
+		if (source.compare(0, 8, "#version") == 0)
+		{
+			insertAt = source.find('\n');
+			insertAt = (insertAt == std::string::npos) ? source.size() : insertAt + 1;
+			nextLine = 2;
+		}
+
+		std::ostringstream insert;
+		insert << defines;
+		if (defines[defines.size() - 1] != '\n')
+		{
+			insert << "\n";
+		}
+		insert << "#line " << nextLine << "\n";
+		source.insert(insertAt, insert.str());
+
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  ShaderCache()
+ *
+ *  The constructor for the class, which needs the OpenGL
+ *  context to be current.
+ ***********************************************************/
+ShaderCache::ShaderCache()
+{
+	m_stats.compiledPrograms = 0;
+	m_stats.loadedBinaries = 0;
+	m_stats.savedBinaries = 0;
+	m_stats.buildSeconds = 0.0;
+
+	const char* vendor = (const char*)glGetString(GL_VENDOR);
+	const char* renderer = (const char*)glGetString(GL_RENDERER);
+	const char* version = (const char*)glGetString(GL_VERSION);
+	m_driverName = std::string(vendor ? vendor : "") + "|" +
+		(renderer ? renderer : "") + "|" + (version ? version : "");
+
+	GLint formatCount = 0;
+	if ((GLEW_VERSION_4_1 == GL_TRUE) || (GLEW_ARB_get_program_binary == GL_TRUE))
+	{
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	}
+	m_bBinarySupported = (formatCount > 0);
+	m_bBinaryCaching = m_bBinarySupported;
+}
+
+/***********************************************************
+ *  ~ShaderCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderCache::~ShaderCache()
+{
+	for (std::unordered_map<std::string, PROGRAM_ENTRY>::iterator it = m_programs.begin();
+		it != m_programs.end(); ++it)
+	{
+		glDeleteProgram(it->second.program);
+	}
+	m_programs.clear();
+}
+
+/***********************************************************
+ *  SetBinaryCaching()
+ *
+ *  This method is used for turning the program binaries on
+ *  or off.  They stay off when the driver has no binary
+ *  formats.
+ ***********************************************************/
+void ShaderCache::SetBinaryCaching(bool bEnabled)
+{
+	m_bBinaryCaching = (bEnabled == true) && (m_bBinarySupported == true);
+}
+
+/***********************************************************
+ *  GetProgram()
+ *
+ *  This method is used for getting the program of the passed
+ *  in vertex and fragment shader files and defines, which is
+ *  built the first time it is asked for.
+ ***********************************************************/
+GLuint ShaderCache::GetProgram(const char* vertexFilename, const char* fragmentFilename,
+	const std::string& defines)
+{
+	PROGRAM_ENTRY entry;
+	entry.program = 0;
+	entry.stageCount = 2;
+	entry.stageTypes[0] = GL_VERTEX_SHADER;
+	entry.filenames[0] = vertexFilename;
+	entry.stageTypes[1] = GL_FRAGMENT_SHADER;
+	entry.filenames[1] = fragmentFilename;
+	entry.defines = defines;
+
+	return(FindOrBuild(std::string(vertexFilename) + "|" + fragmentFilename + "|" + defines, entry));
+}
+
+/***********************************************************
+ *  GetComputeProgram()
+ *
+ *  This method is used for getting the program of the passed
+ *  in compute shader file and defines, which is built the
+ *  first time it is asked for.
+ ***********************************************************/
+GLuint ShaderCache::GetComputeProgram(const char* filename, const std::string& defines)
+{
+	PROGRAM_ENTRY entry;
+	entry.program = 0;
+	entry.stageCount = 1;
+	entry.stageTypes[0] = GL_COMPUTE_SHADER;
+	entry.filenames[0] = filename;
+	entry.defines = defines;
+
+	return(FindOrBuild(std::string(filename) + "|" + defines, entry));
+}
+
+/***********************************************************
+ *  ReloadShaderFile()
+ *
+ *  This method is used for building the programs that use
+ *  the passed in shader file again after it was edited.  The
+ *  old programs are only deleted once all of the new ones are
+ *  built, so none of the new programs can reuse the name of
+ *  an old one in the list.  A program whose shaders do not
+ *  compile any more keeps drawing with its old program, and
+ *  the compile errors are written to the console.
+ ***********************************************************/
+int ShaderCache::ReloadShaderFile(const std::string& filename, std::vector<RELOADED_PROGRAM>& reloaded)
+{
+	size_t firstReloaded = reloaded.size();
+	int failedCount = 0;
+
+	for (std::unordered_map<std::string, PROGRAM_ENTRY>::iterator it = m_programs.begin();
+		it != m_programs.end(); ++it)
+	{
+		PROGRAM_ENTRY& entry = it->second;
+		bool bUsesFile = false;
+		for (int i = 0; i < entry.stageCount; i++)
+		{
+			if (entry.filenames[i] == filename)
+			{
+				bUsesFile = true;
+			}
+		}
+		if (bUsesFile == false)
+		{
+			continue;
+		}
+
+		GLuint program = BuildEntry(entry);
+		if (program == 0)
+		{
+			failedCount++;
+			continue;
+		}
+
+		RELOADED_PROGRAM replaced;
+		replaced.oldProgram = entry.program;
+		replaced.newProgram = program;
+		reloaded.push_back(replaced);
+		entry.program = program;
+	}
+
+	for (size_t i = firstReloaded; i < reloaded.size(); i++)
+	{
+		glDeleteProgram(reloaded[i].oldProgram);
+	}
+
+	if (failedCount > 0)
+	{
+		std::cout << failedCount << " programs using " << filename
+			<< " did not build and keep their old shaders" << std::endl;
+	}
+
+	return(reloaded.size() - firstReloaded);
+}
+
+/***********************************************************
+ *  GetShaderFiles()
+ *
+ *  This method is used for getting the shader files that the
+ *  built programs are made of, each listed once.
+ ***********************************************************/
+void ShaderCache::GetShaderFiles(std::vector<std::string>& filenames) const
+{
+	for (std::unordered_map<std::string, PROGRAM_ENTRY>::const_iterator it = m_programs.begin();
+		it != m_programs.end(); ++it)
+	{
+		const PROGRAM_ENTRY& entry = it->second;
+		for (int i = 0; i < entry.stageCount; i++)
+		{
+			if (std::find(filenames.begin(), filenames.end(), entry.filenames[i]) == filenames.end())
+			{
+				filenames.push_back(entry.filenames[i]);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  GetStats()
+ *
+ *  This method is used for getting the number of programs
+ *  compiled and binaries used, and the time spent on them.
+ ***********************************************************/
+ShaderCache::CACHE_STATS ShaderCache::GetStats() const
+{
+	return(m_stats);
+}
+
+/***********************************************************
+ *  FindOrBuild()
+ *
+ *  This method is used for getting the program kept under
+ *  the passed in key, which is built from the entry and kept
+ *  the first time it is asked for.
+ ***********************************************************/
+GLuint ShaderCache::FindOrBuild(const std::string& key, const PROGRAM_ENTRY& entry)
+{
+	std::unordered_map<std::string, PROGRAM_ENTRY>::const_iterator found = m_programs.find(key);
+	if (found != m_programs.end())
+	{
+		return(found->second.program);
+	}
+
+	GLuint program = BuildEntry(entry);
+	if (program != 0)
+	{
+		PROGRAM_ENTRY& built = m_programs[key];
+		built = entry;
+		built.program = program;
+	}
+	return(program);
+}
+
+/***********************************************************
+ *  BuildEntry()
+ *
+ *  This method is used for building the program of an entry
+ *  from the shader files and the defines that it names.
+ ***********************************************************/
+GLuint ShaderCache::BuildEntry(const PROGRAM_ENTRY& entry)
+{
+	SHADER_STAGE stages[2];
+	for (int i = 0; i < entry.stageCount; i++)
+	{
+		stages[i].type = entry.stageTypes[i];
+		stages[i].filename = entry.filenames[i].c_str();
+	}
+
+	return(BuildProgram(stages, entry.stageCount, entry.defines));
+}
+
+/***********************************************************
+ *  BuildProgram()
+ *
+ *  This method is used for reading the shader files of a
+ *  program and building it.  The binary file is named by the
+ *  shader files and defines, and its header holds the hash of
+ *  the driver and the final sources, so an edited shader or
+ *  an updated driver never loads a stale binary - its file is
+ *  written over with the new one instead.
+ ***********************************************************/
+GLuint ShaderCache::BuildProgram(SHADER_STAGE* pStages, int stageCount, const std::string& defines)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	unsigned long long hash = HashText(14695981039346656037ULL, m_driverName);
+	unsigned long long nameHash = HashText(14695981039346656037ULL, defines);
+	for (int i = 0; i < stageCount; i++)
+	{
+		if (ReadSourceFile(pStages[i].filename, defines, pStages[i].source) == false)
+		{
+			return(0);
+		}
+		hash = HashText(hash, pStages[i].source);
+		nameHash = HashText(nameHash, pStages[i].filename);
+	}
+
+	char hashText[32];
+	snprintf(hashText, sizeof(hashText), "%016llx", nameHash);
+	std::string binaryFilename = std::string(g_BinaryFilePrefix) + hashText + g_BinaryFileSuffix;
+
+	GLuint program = 0;
+	if (m_bBinaryCaching == true)
+	{
+		program = LoadBinary(binaryFilename, hash);
+	}
+
+	if (program != 0)
+	{
+		m_stats.loadedBinaries++;
+	}
+	else
+	{
+		program = LinkProgram(pStages, stageCount);
+		if (program == 0)
+		{
+			return(0);
+		}
+		m_stats.compiledPrograms++;
+
+		if ((m_bBinaryCaching == true) && (SaveBinary(program, binaryFilename, hash) == true))
+		{
+			m_stats.savedBinaries++;
+		}
+	}
+
+	m_stats.buildSeconds += std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+
+	return(program);
+}
+
+/***********************************************************
+ *  LinkProgram()
+ *
+ *  This method is used for compiling the shaders of a program
+ *  and linking them.  The driver is told that the binary will
+ *  be read back before the program is linked.
+ ***********************************************************/
+GLuint ShaderCache::LinkProgram(const SHADER_STAGE* pStages, int stageCount)
+{
+	GLuint program = glCreateProgram();
+	std::vector<GLuint> shaders;
+	GLint status = GL_FALSE;
+
+	for (int i = 0; i < stageCount; i++)
+	{
+		const char* sourceText = pStages[i].source.c_str();
+		GLuint shader = glCreateShader(pStages[i].type);
+		glShaderSource(shader, 1, &sourceText, NULL);
+		glCompileShader(shader);
+		shaders.push_back(shader);
+
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		if (status == GL_FALSE)
+		{
+			char infoLog[1024];
+			glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+			std::cout << "Could not compile the shader " << pStages[i].filename << std::endl << infoLog << std::endl;
+			break;
+		}
+		glAttachShader(program, shader);
+	}
+
+	if (status == GL_TRUE)
+	{
+		if (m_bBinaryCaching == true)
+		{
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		glLinkProgram(program);
+
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if (status == GL_FALSE)
+		{
+			char infoLog[1024];
+			glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+			std::cout << "Could not link the shaders of " << pStages[0].filename << std::endl << infoLog << std::endl;
+		}
+	}
+
+	// the linked program keeps working without its shaders
+	for (size_t i = 0; i < shaders.size(); i++)
+	{
+		glDeleteShader(shaders[i]);
+	}
+
+	if (status == GL_FALSE)
+	{
+		glDeleteProgram(program);
+		return(0);
+	}
+
+	return(program);
+}
+
+/***********************************************************
+ *  LoadBinary()
+ *
+ *  This method is used for creating a program from its binary
+ *  file.  A missing file, a header that does not match or a
+ *  binary that the driver rejects returns 0, and the program
+ *  is compiled instead.  A file that cannot be used is
+ *  deleted, so no stale binary stays behind when the new one
+ *  is not written.
+ ***********************************************************/
+GLuint ShaderCache::LoadBinary(const std::string& binaryFilename, unsigned long long hash)
+{
+	std::ifstream file(binaryFilename.c_str(), std::ios::binary);
+	if (file.is_open() == false)
+	{
+		return(0);
+	}
+
+	BINARY_HEADER header;
+	std::vector<char> binary;
+	file.read((char*)&header, sizeof(header));
+	bool bValid = (file.good() == true) && (header.magic == g_BinaryMagic) &&
+		(header.version == g_BinaryVersion) && (header.hash == hash) && (header.length > 0);
+	if (bValid == true)
+	{
+		binary.resize(header.length);
+		file.read(binary.data(), header.length);
+		bValid = file.good();
+	}
+	file.close();
+
+	GLuint program = 0;
+	if (bValid == true)
+	{
+		program = glCreateProgram();
+		glProgramBinary(program, header.format, binary.data(), header.length);
+
+		GLint status = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if (status == GL_FALSE)
+		{
+			glDeleteProgram(program);
+			program = 0;
+		}
+	}
+
+	if (program == 0)
+	{
+		std::remove(binaryFilename.c_str());
+	}
+	return(program);
+}
+
+/***********************************************************
+ *  SaveBinary()
+ *
+ *  This method is used for writing the binary of a linked
+ *  program to its file.
+ ***********************************************************/
+bool ShaderCache::SaveBinary(GLuint program, const std::string& binaryFilename, unsigned long long hash)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+	{
+		return(false);
+	}
+
+	BINARY_HEADER header;
+	header.magic = g_BinaryMagic;
+	header.version = g_BinaryVersion;
+	header.hash = hash;
+	header.format = 0;
+	header.length = 0;
+
+	std::vector<char> binary(length);
+	glGetProgramBinary(program, length, &header.length, &header.format, binary.data());
+	if (header.length <= 0)
+	{
+		return(false);
+	}
+
+	CreateBinaryFolder();
+	std::ofstream file(binaryFilename.c_str(), std::ios::binary | std::ios::trunc);
+	if (file.is_open() == false)
+	{
+		std::cout << "Could not write the program binary " << binaryFilename << std::endl;
+		return(false);
+	}
+	file.write((const char*)&header, sizeof(header));
+	file.write(binary.data(), header.length);
+
+	return(file.good());
+}
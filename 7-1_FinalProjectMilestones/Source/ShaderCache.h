@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadercache.h
+// ============
+// build the shader programs from their GLSL files with a set of defines, and
+// keep their linked binaries on disk so that later launches skip compiling
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  ShaderCache
+ *
+ *  This class contains the code for reading the GLSL files
+ *  of a shader program, putting the defines of a specialized
+ *  variant after their version line, and compiling and
+ *  linking them.  Each program is only built once for the
+ *  same files and defines.  When the driver can return the
+ *  linked binaries they are written to a cache folder, one
+ *  file per program that is checked against a hash of the
+ *  sources, the defines and the driver, and loaded instead
+ *  of compiling on the next launch.  The
+ *  programs using an edited shader file can be built again
+ *  while the application runs.
+ ***********************************************************/
+class ShaderCache
+{
+public:
+	// constructor
+	ShaderCache();
+	// destructor
+	~ShaderCache();
+
+	// the work done for the programs since the cache was created
+	struct CACHE_STATS
+	{
+		int compiledPrograms;
+		int loadedBinaries;
+		int savedBinaries;
+		double buildSeconds;
+	};
+
+	// a program built again by ReloadShaderFile(), which replaces
+	// the old program - the old program has been deleted
+	struct RELOADED_PROGRAM
+	{
+		GLuint oldProgram;
+		GLuint newProgram;
+	};
+
+	// turn the reading and writing of the program binaries on or
+	// off - they are only used when the driver supports them
+	void SetBinaryCaching(bool bEnabled);
+
+	// get the program built from the vertex and fragment shader
+	// files with the passed in define lines, 0 when it fails -
+	// the cache owns the program
+	GLuint GetProgram(const char* vertexFilename, const char* fragmentFilename,
+		const std::string& defines);
+	// get the program built from the compute shader file with the
+	// passed in define lines, 0 when it fails
+	GLuint GetComputeProgram(const char* filename, const std::string& defines);
+
+	// build every program using the passed in shader file again,
+	// adding the replaced programs to the passed in list - a
+	// program that fails keeps its old one, and the number of
+	// programs built again is returned
+	int ReloadShaderFile(const std::string& filename, std::vector<RELOADED_PROGRAM>& reloaded);
+	// get the shader files used by the built programs
+	void GetShaderFiles(std::vector<std::string>& filenames) const;
+
+	// get the work done for the programs
+	CACHE_STATS GetStats() const;
+
+private:
+	// one shader of a program
+	struct SHADER_STAGE
+	{
+		GLenum type;
+		const char* filename;
+		std::string source;
+	};
+
+	// one built program and what it was built from
+	struct PROGRAM_ENTRY
+	{
+		GLuint program;
+		int stageCount;
+		GLenum stageTypes[2];
+		std::string filenames[2];
+		std::string defines;
+	};
+
+	// the built programs by their files and defines
+	std::unordered_map<std::string, PROGRAM_ENTRY> m_programs;
+	// the vendor, renderer and version of the driver, which the
+	// binaries are only valid for
+	std::string m_driverName;
+	// true when the driver has at least one binary format
+	bool m_bBinarySupported;
+	bool m_bBinaryCaching;
+	CACHE_STATS m_stats;
+
+	// build the program from its shaders, from the binary file
+	// when there is a valid one
+	GLuint BuildProgram(SHADER_STAGE* pStages, int stageCount, const std::string& defines);
+	// build the program of an entry from its files and defines
+	GLuint BuildEntry(const PROGRAM_ENTRY& entry);
+	// get the program with the passed in key, or build it from
+	// the entry and keep it under that key
+	GLuint FindOrBuild(const std::string& key, const PROGRAM_ENTRY& entry);
+	// compile and link the shaders of a program
+	GLuint LinkProgram(const SHADER_STAGE* pStages, int stageCount);
+	// read the binary of a program from its file
+	GLuint LoadBinary(const std::string& binaryFilename, unsigned long long hash);
+	// write the binary of a linked program to its file
+	bool SaveBinary(GLuint program, const std::string& binaryFilename, unsigned long long hash);
+};
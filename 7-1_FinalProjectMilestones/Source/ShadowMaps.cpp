@@ -0,0 +1,544 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmaps.cpp
+// ============
+// hold the depth maps that the light sources and the sun cast their shadows
+// with, and the light space matrices that the shaders look them up with
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadowMaps.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// nearest distance from a light source that its map holds,
+	// and the widest its map opens when a box is wider than that
+	const float g_LightNearDistance = 0.1f;
+	const float g_MaxLightHalfAngle = glm::radians(60.0f);
+
+	// weight of the logarithmic split of the cascades against the
+	// even split - the logarithmic one gives the slices near the
+	// camera more of the texels
+	const float g_CascadeSplitBlend = 0.75f;
+	// the cascade sizes are rounded up to this step, so that the
+	// texel size does not change as the camera turns
+	const float g_CascadeSizeStep = 1.0f / 16.0f;
+
+	// distance the shadow lookups are moved out along the normal,
+	// which keeps the surfaces from shadowing themselves
+	const float g_NormalOffset = 0.03f;
+}
+
+/***********************************************************
+ *  ShadowMaps()
+ *
+ *  The constructor for the class, which needs the OpenGL
+ *  context to be current.  The shadow block is uploaded at
+ *  once, since the shaders read the sun values from it even
+ *  without any maps.
+ ***********************************************************/
+ShadowMaps::ShadowMaps(ResourcePool* pResourcePool)
+{
+	m_pResourcePool = pResourcePool;
+	m_framebuffer = 0;
+	for (int i = 0; i < MAP_SET_COUNT; i++)
+	{
+		m_textures[i] = 0;
+		m_mapSizes[i] = 0;
+		m_layerCounts[i] = 0;
+	}
+
+	GLint maxTextureUnits = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxTextureUnits);
+	m_firstTextureUnit = std::max((int)maxTextureUnits - MAP_SET_COUNT, 0);
+
+	memset((void*)&m_block, 0, sizeof(m_block));
+	for (int i = 0; i < UniformBuffer::TOTAL_LIGHTS; i++)
+	{
+		m_block.lightMatrices[i] = glm::mat4(1.0f);
+	}
+	for (int i = 0; i < MAX_CASCADES; i++)
+	{
+		m_block.cascadeMatrices[i] = glm::mat4(1.0f);
+	}
+	m_block.normalOffset = g_NormalOffset;
+
+	m_pShadowBuffer = new UniformBuffer(sizeof(SHADOW_BLOCK), UniformBuffer::SHADOW_BINDING, true);
+	m_bBlockChanged = true;
+	Upload();
+}
+
+/***********************************************************
+ *  ~ShadowMaps()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadowMaps::~ShadowMaps()
+{
+	Destroy();
+	if (NULL != m_pShadowBuffer)
+	{
+		delete m_pShadowBuffer;
+		m_pShadowBuffer = NULL;
+	}
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the depth texture arrays
+ *  of the sets and the framebuffer that their layers are
+ *  drawn through, which has no color buffer.
+ ***********************************************************/
+bool ShadowMaps::Create(int lightLayerCount, int lightMapSize, int cascadeCount, int cascadeMapSize)
+{
+	Destroy();
+
+	lightLayerCount = std::min(std::max(lightLayerCount, 0), (int)UniformBuffer::TOTAL_LIGHTS);
+	cascadeCount = std::min(std::max(cascadeCount, 0), (int)MAX_CASCADES);
+
+	bool bCreated = (CreateMapSet(MAPS_STATIC, lightMapSize, lightLayerCount) == true) &&
+		(CreateMapSet(MAPS_DYNAMIC, lightMapSize, lightLayerCount) == true) &&
+		(CreateMapSet(MAPS_SUN, cascadeMapSize, cascadeCount) == true) &&
+		(CreateMapSet(MAPS_SUN_DYNAMIC, cascadeMapSize, cascadeCount) == true);
+
+	GLenum status = GL_FRAMEBUFFER_UNSUPPORTED;
+	if (bCreated == true)
+	{
+		glGenFramebuffers(1, &m_framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+
+		MAP_SET checkedSet = (lightLayerCount > 0) ? MAPS_STATIC : MAPS_SUN;
+		if (m_textures[checkedSet] != 0)
+		{
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_textures[checkedSet], 0, 0);
+			status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Could not create the shadow maps, status:" << status << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_block.cascadeCount = cascadeCount;
+	m_bBlockChanged = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  CreateMapSet()
+ *
+ *  This method is used for getting the depth texture array of
+ *  a set from the resource pool and binding it to the unit of
+ *  the set.  The maps compare the looked up depth in the
+ *  texture unit, with linear filtering blending the results
+ *  of the four nearest texels, and the area outside of a map
+ *  is lit.
+ ***********************************************************/
+bool ShadowMaps::CreateMapSet(MAP_SET mapSet, int size, int layerCount)
+{
+	if (layerCount <= 0)
+	{
+		return(true);
+	}
+	if (size <= 0)
+	{
+		return(false);
+	}
+
+	ResourcePool::TEXTURE_DESC desc;
+	desc.target = GL_TEXTURE_2D_ARRAY;
+	desc.internalFormat = GL_DEPTH_COMPONENT24;
+	desc.width = size;
+	desc.height = size;
+	desc.depth = layerCount;
+	desc.levelCount = 1;
+	desc.byteSize = (GLsizeiptr)size * size * layerCount * 4;
+
+	bool bReused = false;
+	m_textures[mapSet] = m_pResourcePool->AcquireTexture(desc, bReused);
+	if (m_textures[mapSet] == 0)
+	{
+		return(false);
+	}
+
+	glActiveTexture(GL_TEXTURE0 + GetTextureUnit(mapSet));
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textures[mapSet]);
+	if (bReused == false)
+	{
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, size, size, layerCount, 0,
+			GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+	}
+
+	const GLfloat borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glActiveTexture(GL_TEXTURE0);
+
+	m_mapSizes[mapSet] = size;
+	m_layerCounts[mapSet] = layerCount;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for giving the depth texture arrays
+ *  back to the resource pool and freeing the framebuffer.
+ ***********************************************************/
+void ShadowMaps::Destroy()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	for (int i = 0; i < MAP_SET_COUNT; i++)
+	{
+		if (m_textures[i] != 0)
+		{
+			m_pResourcePool->ReleaseTexture(m_textures[i]);
+			m_textures[i] = 0;
+		}
+		m_mapSizes[i] = 0;
+		m_layerCounts[i] = 0;
+	}
+
+	m_block.cascadeCount = 0;
+	m_block.bDynamicShadows = 0;
+	m_bBlockChanged = true;
+}
+
+/***********************************************************
+ *  GetLayerCount()
+ *
+ *  This method is used for getting the number of layers of a
+ *  set, 0 when it was left out.
+ ***********************************************************/
+int ShadowMaps::GetLayerCount(MAP_SET mapSet) const
+{
+	return(m_layerCounts[mapSet]);
+}
+
+/***********************************************************
+ *  GetTextureUnit()
+ *
+ *  This method is used for getting the texture unit that a
+ *  set is bound to, which the sampler of the set in the
+ *  shaders needs to be set to.
+ ***********************************************************/
+int ShadowMaps::GetTextureUnit(MAP_SET mapSet) const
+{
+	return(m_firstTextureUnit + mapSet);
+}
+
+/***********************************************************
+ *  AimLight()
+ *
+ *  This method is used for aiming the map of a light source
+ *  from its position at the center of a box, opening it just
+ *  wide enough to hold the corners of the box and reaching
+ *  from the nearest corner to the farthest.  The depth along
+ *  the light direction is linear, so its smallest value over
+ *  the box is at a corner.  A light source inside of the box
+ *  opens its map to the widest angle, and the objects outside
+ *  of it are lit.
+ ***********************************************************/
+void ShadowMaps::AimLight(int lightIndex, glm::vec3 position, glm::vec3 boxMin, glm::vec3 boxMax)
+{
+	if ((lightIndex < 0) || (lightIndex >= UniformBuffer::TOTAL_LIGHTS))
+	{
+		return;
+	}
+
+	glm::vec3 forward = (boxMin + boxMax) * 0.5f - position;
+	if (glm::length(forward) < 0.001f)
+	{
+		forward = glm::vec3(0.0f, -1.0f, 0.0f);
+	}
+	forward = glm::normalize(forward);
+	glm::vec3 up = (fabsf(forward.y) > 0.99f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::mat4 lightView = glm::lookAt(position, position + forward, up);
+
+	float maxTangent = 0.0f;
+	float nearDepth = FLT_MAX;
+	float farDepth = 0.0f;
+	bool bCornerBehind = false;
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec3 corner = glm::vec3(
+			(i & 1) ? boxMax.x : boxMin.x,
+			(i & 2) ? boxMax.y : boxMin.y,
+			(i & 4) ? boxMax.z : boxMin.z);
+		glm::vec3 viewCorner = glm::vec3(lightView * glm::vec4(corner, 1.0f));
+		float depth = -viewCorner.z;
+
+		farDepth = std::max(farDepth, depth);
+		if (depth <= g_LightNearDistance)
+		{
+			bCornerBehind = true;
+			continue;
+		}
+		nearDepth = std::min(nearDepth, depth);
+		maxTangent = std::max(maxTangent, std::max(fabsf(viewCorner.x), fabsf(viewCorner.y)) / depth);
+	}
+
+	float halfAngle = g_MaxLightHalfAngle;
+	if (bCornerBehind == true)
+	{
+		nearDepth = g_LightNearDistance;
+	}
+	else
+	{
+		halfAngle = std::min(atanf(maxTangent), g_MaxLightHalfAngle);
+	}
+	farDepth = std::max(farDepth, nearDepth + 1.0f);
+
+	glm::mat4 lightProjection = glm::perspective(halfAngle * 2.0f, 1.0f, nearDepth, farDepth);
+	m_block.lightMatrices[lightIndex] = lightProjection * lightView;
+	m_bBlockChanged = true;
+}
+
+/***********************************************************
+ *  GetLightMatrix()
+ *
+ *  This method is used for getting the light space matrix of
+ *  the map of a light source.
+ ***********************************************************/
+const glm::mat4& ShadowMaps::GetLightMatrix(int lightIndex) const
+{
+	return(m_block.lightMatrices[lightIndex]);
+}
+
+/***********************************************************
+ *  SetSunLight()
+ *
+ *  This method is used for setting the sun, which lights the
+ *  3D scene from far away along one direction.
+ ***********************************************************/
+void ShadowMaps::SetSunLight(glm::vec3 direction, glm::vec3 color, float specularIntensity)
+{
+	if (glm::length(direction) < 0.001f)
+	{
+		return;
+	}
+
+	m_block.sunDirection = glm::vec4(glm::normalize(direction), 1.0f);
+	m_block.sunColor = glm::vec4(color, specularIntensity);
+	m_bBlockChanged = true;
+}
+
+/***********************************************************
+ *  FitCascades()
+ *
+ *  This method is used for splitting the view between its
+ *  near plane and the passed in distance into slices, and
+ *  fitting a cascade of the sun around each.  A cascade is a
+ *  square around the bounding sphere of its slice, so it
+ *  keeps its size as the camera turns.  All of the cascades
+ *  share one rotation towards the sun, and their depth spans
+ *  the box, so only the position of the square depends on
+ *  the camera.  The center of the slice is snapped to whole
+ *  texels in light space, so the edges do not crawl, and a
+ *  cascade keeps its matrix until the center crosses into
+ *  another texel.  True is returned when any of the cascades
+ *  moved and needs to be drawn again.
+ ***********************************************************/
+bool ShadowMaps::FitCascades(const glm::mat4& view, const glm::mat4& projection,
+	float shadowDistance, glm::vec3 boxMin, glm::vec3 boxMax)
+{
+	int cascadeCount = m_layerCounts[MAPS_SUN];
+	if ((cascadeCount == 0) || (m_block.sunDirection.w == 0.0f))
+	{
+		return(false);
+	}
+
+	// the near and far distances of a perspective or an
+	// orthographic projection
+	float nearDistance = 0.0f;
+	float farDistance = 0.0f;
+	if (projection[2][3] != 0.0f)
+	{
+		nearDistance = projection[3][2] / (projection[2][2] - 1.0f);
+		farDistance = projection[3][2] / (projection[2][2] + 1.0f);
+	}
+	else
+	{
+		nearDistance = (projection[3][2] + 1.0f) / projection[2][2];
+		farDistance = (projection[3][2] - 1.0f) / projection[2][2];
+	}
+	float endDistance = std::max(std::min(farDistance, shadowDistance), nearDistance + 0.01f);
+
+	// the corners of the view at its near and far planes - the
+	// corners of a slice are between them, since the depth is
+	// linear along each edge
+	glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+	glm::vec3 nearCorners[4];
+	glm::vec3 farCorners[4];
+	for (int i = 0; i < 4; i++)
+	{
+		float cornerX = (i & 1) ? 1.0f : -1.0f;
+		float cornerY = (i & 2) ? 1.0f : -1.0f;
+		glm::vec4 nearCorner = inverseViewProjection * glm::vec4(cornerX, cornerY, -1.0f, 1.0f);
+		glm::vec4 farCorner = inverseViewProjection * glm::vec4(cornerX, cornerY, 1.0f, 1.0f);
+		nearCorners[i] = glm::vec3(nearCorner) / nearCorner.w;
+		farCorners[i] = glm::vec3(farCorner) / farCorner.w;
+	}
+
+	// the cascades look away from the sun out of the world
+	// origin, and their depth reaches from the corner of the box
+	// nearest to the sun to the one farthest from it, so neither
+	// changes as the camera moves
+	glm::vec3 sunDirection = glm::vec3(m_block.sunDirection);
+	glm::vec3 up = (fabsf(sunDirection.y) > 0.99f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), -sunDirection, up);
+	float boxNear = -FLT_MAX;
+	float boxFar = FLT_MAX;
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec3 corner = glm::vec3(
+			(i & 1) ? boxMax.x : boxMin.x,
+			(i & 2) ? boxMax.y : boxMin.y,
+			(i & 4) ? boxMax.z : boxMin.z);
+		float depth = (lightView * glm::vec4(corner, 1.0f)).z;
+		boxNear = std::max(boxNear, depth);
+		boxFar = std::min(boxFar, depth);
+	}
+	float nearPlane = -boxNear - g_CascadeSizeStep;
+	float farPlane = -boxFar + g_CascadeSizeStep;
+	float mapSize = (float)m_mapSizes[MAPS_SUN];
+
+	bool bMoved = false;
+	float sliceStart = nearDistance;
+	for (int cascade = 0; cascade < cascadeCount; cascade++)
+	{
+		float part = (float)(cascade + 1) / cascadeCount;
+		float logSplit = nearDistance * powf(endDistance / nearDistance, part);
+		float evenSplit = nearDistance + (endDistance - nearDistance) * part;
+		float sliceEnd = g_CascadeSplitBlend * logSplit + (1.0f - g_CascadeSplitBlend) * evenSplit;
+
+		float startPart = (sliceStart - nearDistance) / (farDistance - nearDistance);
+		float endPart = (sliceEnd - nearDistance) / (farDistance - nearDistance);
+		glm::vec3 sliceCorners[8];
+		glm::vec3 center = glm::vec3(0.0f);
+		for (int i = 0; i < 4; i++)
+		{
+			sliceCorners[i] = glm::mix(nearCorners[i], farCorners[i], startPart);
+			sliceCorners[i + 4] = glm::mix(nearCorners[i], farCorners[i], endPart);
+			center += sliceCorners[i] + sliceCorners[i + 4];
+		}
+		center /= 8.0f;
+
+		float radius = 0.0f;
+		for (int i = 0; i < 8; i++)
+		{
+			radius = std::max(radius, glm::length(sliceCorners[i] - center));
+		}
+		radius = ceilf(radius / g_CascadeSizeStep) * g_CascadeSizeStep;
+
+		// snap the center of the square to the texels of the
+		// cascade in light space
+		float texelSize = (2.0f * radius) / mapSize;
+		glm::vec4 lightCenter = lightView * glm::vec4(center, 1.0f);
+		float centerX = floorf(lightCenter.x / texelSize + 0.5f) * texelSize;
+		float centerY = floorf(lightCenter.y / texelSize + 0.5f) * texelSize;
+		glm::mat4 lightProjection = glm::ortho(centerX - radius, centerX + radius,
+			centerY - radius, centerY + radius, nearPlane, farPlane);
+
+		glm::mat4 cascadeMatrix = lightProjection * lightView;
+		if ((cascadeMatrix != m_block.cascadeMatrices[cascade]) ||
+			(sliceEnd != m_block.cascadeEnds[cascade]))
+		{
+			m_block.cascadeMatrices[cascade] = cascadeMatrix;
+			m_block.cascadeEnds[cascade] = sliceEnd;
+			bMoved = true;
+		}
+		sliceStart = sliceEnd;
+	}
+
+	if (bMoved == true)
+	{
+		m_bBlockChanged = true;
+	}
+	return(bMoved);
+}
+
+/***********************************************************
+ *  GetCascadeMatrix()
+ *
+ *  This method is used for getting the light space matrix of
+ *  a cascade of the sun.
+ ***********************************************************/
+const glm::mat4& ShadowMaps::GetCascadeMatrix(int cascade) const
+{
+	return(m_block.cascadeMatrices[cascade]);
+}
+
+/***********************************************************
+ *  SetDynamicShadows()
+ *
+ *  This method is used for setting whether the dynamic set
+ *  holds moving objects this frame, which the shaders skip
+ *  looking it up when it does not.
+ ***********************************************************/
+void ShadowMaps::SetDynamicShadows(bool bDynamicShadows)
+{
+	GLint value = bDynamicShadows ? 1 : 0;
+	if (m_block.bDynamicShadows != value)
+	{
+		m_block.bDynamicShadows = value;
+		m_bBlockChanged = true;
+	}
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for uploading the shadow block when
+ *  any of its values changed since the last upload.
+ ***********************************************************/
+void ShadowMaps::Upload()
+{
+	if (m_bBlockChanged == false)
+	{
+		return;
+	}
+
+	m_pShadowBuffer->Update(&m_block, sizeof(m_block));
+	m_bBlockChanged = false;
+}
+
+/***********************************************************
+ *  BeginLayer()
+ *
+ *  This method is used for directing the rendering into a
+ *  layer of a set, with the viewport covering the map, and
+ *  clearing its depth.  The depth writes need to be on.
+ ***********************************************************/
+void ShadowMaps::BeginLayer(MAP_SET mapSet, int layer)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_textures[mapSet], 0, layer);
+	glViewport(0, 0, m_mapSizes[mapSet], m_mapSizes[mapSet]);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
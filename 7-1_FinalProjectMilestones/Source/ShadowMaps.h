@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmaps.h
+// ============
+// hold the depth maps that the light sources and the sun cast their shadows
+// with, and the light space matrices that the shaders look them up with
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ResourcePool.h"
+#include "UniformBuffer.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  ShadowMaps
+ *
+ *  This class contains the code for the four sets of shadow
+ *  maps, which are layers of depth texture arrays.  The
+ *  static set holds the objects that never move as seen by
+ *  each light source, and is only drawn again when they
+ *  change.  The dynamic set holds the moving objects of the
+ *  same light sources for the current frame, and the shaders
+ *  combine both sets.  The sun sets hold the cascades that
+ *  split the view into slices, each fitted around its slice
+ *  so the shadows near the camera get the finest texels, and
+ *  are split the same way into the objects that never move
+ *  and the moving ones.
+ ***********************************************************/
+class ShadowMaps
+{
+public:
+	// constructor
+	ShadowMaps(ResourcePool* pResourcePool);
+	// destructor
+	~ShadowMaps();
+
+	// this needs to match MAX_CASCADES in the fragment shader
+	static const int MAX_CASCADES = 4;
+
+	// the sets of shadow maps, each bound to its own texture unit
+	enum MAP_SET
+	{
+		MAPS_STATIC = 0,
+		MAPS_DYNAMIC,
+		MAPS_SUN,
+		MAPS_SUN_DYNAMIC,
+		MAP_SET_COUNT
+	};
+
+	// the shadow values as laid out in the std140 shadow block of
+	// the fragment shader - 576 bytes
+	struct SHADOW_BLOCK
+	{
+		// light space matrices of the light sources, by their
+		// index in the light block
+		glm::mat4 lightMatrices[UniformBuffer::TOTAL_LIGHTS];
+		// light space matrices of the cascades of the sun
+		glm::mat4 cascadeMatrices[MAX_CASCADES];
+		// view depth of the far end of each cascade
+		glm::vec4 cascadeEnds;
+		// direction towards the sun, with w 1 when there is a sun
+		glm::vec4 sunDirection;
+		// color of the sun, with its specular intensity in w
+		glm::vec4 sunColor;
+		GLint cascadeCount;
+		// 1 when the dynamic set holds moving objects this frame
+		GLint bDynamicShadows;
+		// distance the lookups are moved out along the normal
+		float normalOffset;
+		float padding;
+	};
+
+	// create the maps with a layer in the static and dynamic sets
+	// for each light source with shadows, and a layer in both sun
+	// sets for each cascade of the sun - 0 layers leave a set out
+	bool Create(int lightLayerCount, int lightMapSize, int cascadeCount, int cascadeMapSize);
+	// free the maps
+	void Destroy();
+	// get the number of layers of a set
+	int GetLayerCount(MAP_SET mapSet) const;
+	// get the texture unit that a set is bound to
+	int GetTextureUnit(MAP_SET mapSet) const;
+
+	// aim the map of a light source from its position at a box,
+	// wide enough to hold the box when it can
+	void AimLight(int lightIndex, glm::vec3 position, glm::vec3 boxMin, glm::vec3 boxMax);
+	// get the light space matrix of a light source
+	const glm::mat4& GetLightMatrix(int lightIndex) const;
+
+	// light the 3D scene with a sun shining along the opposite of
+	// the passed in direction
+	void SetSunLight(glm::vec3 direction, glm::vec3 color, float specularIntensity);
+	// fit the cascades around the slices of the view up to the
+	// passed in distance, reaching back towards the sun to the
+	// casters inside of the box, returning true when any of the
+	// cascades moved since the last fit
+	bool FitCascades(const glm::mat4& view, const glm::mat4& projection,
+		float shadowDistance, glm::vec3 boxMin, glm::vec3 boxMax);
+	// get the light space matrix of a cascade
+	const glm::mat4& GetCascadeMatrix(int cascade) const;
+
+	// set whether the dynamic set holds any objects this frame
+	void SetDynamicShadows(bool bDynamicShadows);
+	// upload the shadow block when it has changed
+	void Upload();
+
+	// direct the rendering into a layer of a set and clear it
+	void BeginLayer(MAP_SET mapSet, int layer);
+
+private:
+	// gives out the depth texture arrays
+	ResourcePool* m_pResourcePool;
+	GLuint m_framebuffer;
+	GLuint m_textures[MAP_SET_COUNT];
+	int m_mapSizes[MAP_SET_COUNT];
+	int m_layerCounts[MAP_SET_COUNT];
+	// the sets are bound to the last texture units, since the
+	// texture arrays of the scene are bound from the first one
+	int m_firstTextureUnit;
+	// the shadow values and whether they need to be uploaded
+	SHADOW_BLOCK m_block;
+	bool m_bBlockChanged;
+	UniformBuffer* m_pShadowBuffer;
+
+	// create the depth texture array of a set on its unit
+	bool CreateMapSet(MAP_SET mapSet, int size, int layerCount);
+};
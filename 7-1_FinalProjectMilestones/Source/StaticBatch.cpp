@@ -0,0 +1,361 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticbatch.cpp
+// ============
+// hold the objects of the 3D scene that never move in one pre-transformed
+// vertex and index buffer - used for drawing many of them with one command
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StaticBatch.h"
+
+#include <cstddef>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// number of floats for each interleaved vertex of the meshes
+	const int g_FloatsPerMeshVertex = 8;
+
+	// vertex attribute locations used by the vertex shader
+	const GLuint g_PositionLocation = 0;
+	const GLuint g_NormalLocation = 1;
+	const GLuint g_TextureCoordLocation = 2;
+	const GLuint g_ColorLocation = 7;
+	const GLuint g_UVScaleLocation = 8;
+	const GLuint g_TextureLayerLocation = 9;
+}
+
+/***********************************************************
+ *  StaticBatch()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StaticBatch::StaticBatch(ResourcePool* pResourcePool)
+{
+	m_pResourcePool = pResourcePool;
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_pCommandRing = NULL;
+	m_commandOffset = 0;
+	m_bDrawIndirect = (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect);
+}
+
+/***********************************************************
+ *  ~StaticBatch()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StaticBatch::~StaticBatch()
+{
+	DestroyBuffers();
+}
+
+/***********************************************************
+ *  DestroyBuffers()
+ *
+ *  This method is used for freeing the OpenGL buffers.
+ ***********************************************************/
+void StaticBatch::DestroyBuffers()
+{
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		m_pResourcePool->ReleaseBuffer(m_vertexBuffer);
+		m_pResourcePool->ReleaseBuffer(m_indexBuffer);
+	}
+	if (NULL != m_pCommandRing)
+	{
+		delete m_pCommandRing;
+	}
+
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_pCommandRing = NULL;
+	m_commandOffset = 0;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the baked objects
+ *  and their buffers.
+ ***********************************************************/
+void StaticBatch::Clear()
+{
+	DestroyBuffers();
+	m_vertices.clear();
+	m_indices.clear();
+	m_ranges.clear();
+	m_objects.clear();
+	m_commands.clear();
+}
+
+/***********************************************************
+ *  AddObject()
+ *
+ *  This method is used for baking an object.  The vertices
+ *  of every level of detail of its mesh are transformed into
+ *  world space, and the indices point at the vertices in the
+ *  whole buffer so the draws need no base vertex.
+ ***********************************************************/
+int StaticBatch::AddObject(
+	const MeshManager::MESH_GEOMETRY* const* lodGeometries,
+	int lodCount,
+	const glm::mat4& model,
+	glm::vec4 color,
+	glm::vec2 uvScale,
+	float textureLayer)
+{
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+
+	STATIC_OBJECT object;
+	object.firstRange = m_ranges.size();
+	object.rangeCount = lodCount;
+
+	for (int lod = 0; lod < lodCount; lod++)
+	{
+		const MeshManager::MESH_GEOMETRY& geometry = *lodGeometries[lod];
+		GLuint firstVertex = m_vertices.size();
+
+		for (size_t i = 0; i + g_FloatsPerMeshVertex <= geometry.vertices.size(); i += g_FloatsPerMeshVertex)
+		{
+			const GLfloat* meshVertex = &geometry.vertices[i];
+			STATIC_VERTEX vertex;
+
+			vertex.position = glm::vec3(model * glm::vec4(meshVertex[0], meshVertex[1], meshVertex[2], 1.0f));
+			vertex.normal = glm::normalize(normalMatrix * glm::vec3(meshVertex[3], meshVertex[4], meshVertex[5]));
+			vertex.uv = glm::vec2(meshVertex[6], meshVertex[7]);
+			vertex.color = color;
+			vertex.uvScale = uvScale;
+			vertex.textureLayer = textureLayer;
+			m_vertices.push_back(vertex);
+		}
+
+		INDEX_RANGE range;
+		range.firstIndex = m_indices.size();
+		range.indexCount = geometry.indices.size();
+		for (size_t i = 0; i < geometry.indices.size(); i++)
+		{
+			m_indices.push_back(firstVertex + geometry.indices[i]);
+		}
+		m_ranges.push_back(range);
+	}
+
+	m_objects.push_back(object);
+
+	return(m_objects.size() - 1);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for uploading the baked vertices and
+ *  indices into OpenGL buffers, and recording the vertex
+ *  layout in a vertex array.
+ ***********************************************************/
+void StaticBatch::Upload()
+{
+	const GLsizei stride = sizeof(STATIC_VERTEX);
+
+	DestroyBuffers();
+	if (m_vertices.empty() == true)
+	{
+		return;
+	}
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+
+	// the buffers are reused from the last bake when it was of
+	// a similar size
+	GLsizeiptr vertexBytes = sizeof(STATIC_VERTEX) * m_vertices.size();
+	GLsizeiptr indexBytes = sizeof(GLuint) * m_indices.size();
+	m_vertexBuffer = m_pResourcePool->AcquireBuffer(vertexBytes, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, vertexBytes, m_vertices.data());
+	m_indexBuffer = m_pResourcePool->AcquireBuffer(indexBytes, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indexBytes, m_indices.data());
+
+	glVertexAttribPointer(g_PositionLocation, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(STATIC_VERTEX, position));
+	glEnableVertexAttribArray(g_PositionLocation);
+	glVertexAttribPointer(g_NormalLocation, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(STATIC_VERTEX, normal));
+	glEnableVertexAttribArray(g_NormalLocation);
+	glVertexAttribPointer(g_TextureCoordLocation, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(STATIC_VERTEX, uv));
+	glEnableVertexAttribArray(g_TextureCoordLocation);
+	glVertexAttribPointer(g_ColorLocation, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(STATIC_VERTEX, color));
+	glEnableVertexAttribArray(g_ColorLocation);
+	glVertexAttribPointer(g_UVScaleLocation, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(STATIC_VERTEX, uvScale));
+	glEnableVertexAttribArray(g_UVScaleLocation);
+	glVertexAttribPointer(g_TextureLayerLocation, 1, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(STATIC_VERTEX, textureLayer));
+	glEnableVertexAttribArray(g_TextureLayerLocation);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (m_bDrawIndirect == true)
+	{
+		m_pCommandRing = new RingBuffer(GL_DRAW_INDIRECT_BUFFER, sizeof(DRAW_COMMAND) * m_objects.size());
+	}
+
+	// the vertices stay in the OpenGL buffers only
+	std::vector<STATIC_VERTEX>().swap(m_vertices);
+	std::vector<GLuint>().swap(m_indices);
+}
+
+/***********************************************************
+ *  GetObjectCount()
+ *
+ *  This method is used for getting the number of baked
+ *  objects.
+ ***********************************************************/
+int StaticBatch::GetObjectCount() const
+{
+	return(m_objects.size());
+}
+
+/***********************************************************
+ *  GetObjectLodCount()
+ *
+ *  This method is used for getting the number of levels of
+ *  detail baked for an object.
+ ***********************************************************/
+int StaticBatch::GetObjectLodCount(int objectIndex) const
+{
+	return(m_objects[objectIndex].rangeCount);
+}
+
+/***********************************************************
+ *  GetObjectRange()
+ *
+ *  This method is used for getting the range of the index
+ *  buffer holding a level of detail of a baked object.
+ ***********************************************************/
+void StaticBatch::GetObjectRange(int objectIndex, int lodLevel, GLuint& firstIndex, GLuint& indexCount) const
+{
+	const STATIC_OBJECT& object = m_objects[objectIndex];
+	const INDEX_RANGE& range = m_ranges[object.firstRange + lodLevel];
+
+	firstIndex = range.firstIndex;
+	indexCount = range.indexCount;
+}
+
+/***********************************************************
+ *  GetVertexArray()
+ *
+ *  This method is used for getting the vertex array of the
+ *  baked vertices and indices, 0 before they are uploaded.
+ ***********************************************************/
+GLuint StaticBatch::GetVertexArray() const
+{
+	return(m_vao);
+}
+
+/***********************************************************
+ *  ClearCommands()
+ *
+ *  This method is used for forgetting the draw commands of
+ *  the last frame.
+ ***********************************************************/
+void StaticBatch::ClearCommands()
+{
+	m_commands.clear();
+}
+
+/***********************************************************
+ *  AddCommand()
+ *
+ *  This method is used for adding the command for drawing a
+ *  baked object at a level of detail.
+ ***********************************************************/
+int StaticBatch::AddCommand(int objectIndex, int lodLevel)
+{
+	const STATIC_OBJECT& object = m_objects[objectIndex];
+	if (lodLevel >= object.rangeCount)
+	{
+		lodLevel = object.rangeCount - 1;
+	}
+	const INDEX_RANGE& range = m_ranges[object.firstRange + lodLevel];
+
+	DRAW_COMMAND command;
+	command.count = range.indexCount;
+	command.instanceCount = 1;
+	command.firstIndex = range.firstIndex;
+	command.baseVertex = 0;
+	command.baseInstance = 0;
+	m_commands.push_back(command);
+
+	return(m_commands.size() - 1);
+}
+
+/***********************************************************
+ *  UploadCommands()
+ *
+ *  This method is used for copying all of the commands of the
+ *  frame into the next section of the indirect ring buffer,
+ *  which the GPU is no longer reading.
+ ***********************************************************/
+void StaticBatch::UploadCommands()
+{
+	if ((NULL == m_pCommandRing) || (m_commands.empty() == true))
+	{
+		return;
+	}
+
+	GLsizeiptr dataSize = sizeof(DRAW_COMMAND) * m_commands.size();
+	m_pCommandRing->BeginFrame();
+	void* pCommands = m_pCommandRing->Allocate(dataSize, sizeof(GLuint), m_commandOffset);
+	if (pCommands == NULL)
+	{
+		m_pCommandRing->Reserve(dataSize);
+		pCommands = m_pCommandRing->Allocate(dataSize, sizeof(GLuint), m_commandOffset);
+	}
+	if (pCommands == NULL)
+	{
+		m_commands.clear();
+		return;
+	}
+
+	memcpy(pCommands, m_commands.data(), dataSize);
+	m_pCommandRing->Flush();
+}
+
+/***********************************************************
+ *  DrawCommands()
+ *
+ *  This method is used for drawing a run of the uploaded
+ *  commands with one draw call.  Without the indirect draws
+ *  the same ranges are drawn with glMultiDrawElements.
+ ***********************************************************/
+void StaticBatch::DrawCommands(int firstCommand, int commandCount)
+{
+	if ((m_vao == 0) || (commandCount <= 0) || ((firstCommand + commandCount) > m_commands.size()))
+	{
+		return;
+	}
+
+	glBindVertexArray(m_vao);
+	if (m_bDrawIndirect == true)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_pCommandRing->GetBuffer());
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+			(const void*)(m_commandOffset + (sizeof(DRAW_COMMAND) * firstCommand)), commandCount, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+	else
+	{
+		m_drawCounts.resize(commandCount);
+		m_drawOffsets.resize(commandCount);
+		for (int i = 0; i < commandCount; i++)
+		{
+			const DRAW_COMMAND& command = m_commands[firstCommand + i];
+			m_drawCounts[i] = command.count;
+			m_drawOffsets[i] = (const void*)(sizeof(GLuint) * command.firstIndex);
+		}
+		glMultiDrawElements(GL_TRIANGLES, m_drawCounts.data(), GL_UNSIGNED_INT,
+			m_drawOffsets.data(), commandCount);
+	}
+	glBindVertexArray(0);
+}
@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticbatch.h
+// ============
+// hold the objects of the 3D scene that never move in one pre-transformed
+// vertex and index buffer - used for drawing many of them with one command
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshManager.h"
+#include "ResourcePool.h"
+#include "RingBuffer.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  StaticBatch
+ *
+ *  This class contains the code for baking the meshes of the
+ *  static objects into world space, with their color, UV
+ *  scale and texture layer in every vertex, and for drawing
+ *  any set of the baked objects with one multi-draw command.
+ ***********************************************************/
+class StaticBatch
+{
+public:
+	// constructor
+	StaticBatch(ResourcePool* pResourcePool);
+	// destructor
+	~StaticBatch();
+
+	// one baked vertex - the color, UV scale and texture layer
+	// use the attribute locations of the instance values
+	struct STATIC_VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 uv;
+		glm::vec4 color;
+		glm::vec2 uvScale;
+		float textureLayer;
+	};
+
+	// the draw command layout read by glMultiDrawElementsIndirect
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// remove all of the baked objects
+	void Clear();
+	// bake an object with every level of detail of its mesh,
+	// returning the object index
+	int AddObject(
+		const MeshManager::MESH_GEOMETRY* const* lodGeometries,
+		int lodCount,
+		const glm::mat4& model,
+		glm::vec4 color,
+		glm::vec2 uvScale,
+		float textureLayer);
+	// upload the baked objects into OpenGL buffers
+	void Upload();
+
+	// get the number of baked objects
+	int GetObjectCount() const;
+	// get the number of levels of detail of a baked object
+	int GetObjectLodCount(int objectIndex) const;
+	// get the index range of a level of detail of a baked object
+	void GetObjectRange(int objectIndex, int lodLevel, GLuint& firstIndex, GLuint& indexCount) const;
+	// get the vertex array of the baked vertices, for the draws
+	// with commands written on the GPU
+	GLuint GetVertexArray() const;
+
+	// forget the commands of the last frame
+	void ClearCommands();
+	// add the command for drawing an object at a level of detail,
+	// returning the command index
+	int AddCommand(int objectIndex, int lodLevel);
+	// upload the added commands, before they are drawn
+	void UploadCommands();
+	// draw a run of the uploaded commands
+	void DrawCommands(int firstCommand, int commandCount);
+
+private:
+	// the index range of one level of detail of an object
+	struct INDEX_RANGE
+	{
+		GLuint firstIndex;
+		GLuint indexCount;
+	};
+	// the index ranges of one baked object
+	struct STATIC_OBJECT
+	{
+		int firstRange;
+		int rangeCount;
+	};
+
+	std::vector<STATIC_VERTEX> m_vertices;
+	std::vector<GLuint> m_indices;
+	std::vector<INDEX_RANGE> m_ranges;
+	std::vector<STATIC_OBJECT> m_objects;
+	std::vector<DRAW_COMMAND> m_commands;
+
+	// gives out the vertex and index buffers
+	ResourcePool* m_pResourcePool;
+	GLuint m_vao;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	// sections holding the draw commands of each frame
+	RingBuffer* m_pCommandRing;
+	// offset of the commands uploaded for the current frame
+	GLintptr m_commandOffset;
+	// true when glMultiDrawElementsIndirect can be used
+	bool m_bDrawIndirect;
+
+	// the offsets and counts for glMultiDrawElements, when the
+	// indirect draws are not supported
+	std::vector<GLsizei> m_drawCounts;
+	std::vector<const void*> m_drawOffsets;
+
+	// free the OpenGL buffers
+	void DestroyBuffers();
+};
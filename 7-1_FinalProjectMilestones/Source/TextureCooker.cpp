@@ -0,0 +1,444 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecooker.cpp
+// ============
+// convert texture images into compressed KTX files with precomputed mipmaps
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCooker.h"
+#include "KtxFile.h"
+
+// the stb_image implementation is compiled in scenemanager.cpp
+#include "stb_image.h"
+
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// extension of the cooked texture files
+	const char* g_CookedExtension = ".ktx";
+
+	// pack an 8 bit per channel color into 5:6:5 bits
+	uint16_t PackColor565(const unsigned char* color)
+	{
+		uint16_t red = (color[0] * 31 + 127) / 255;
+		uint16_t green = (color[1] * 63 + 127) / 255;
+		uint16_t blue = (color[2] * 31 + 127) / 255;
+		return((red << 11) | (green << 5) | blue);
+	}
+
+	// expand a 5:6:5 bit color back to 8 bits per channel
+	void UnpackColor565(uint16_t packed, int* color)
+	{
+		int red = (packed >> 11) & 31;
+		int green = (packed >> 5) & 63;
+		int blue = packed & 31;
+		color[0] = (red << 3) | (red >> 2);
+		color[1] = (green << 2) | (green >> 4);
+		color[2] = (blue << 3) | (blue >> 2);
+	}
+
+	// get the modification time of a file, false when missing
+	bool GetFileTime(const std::string& filename, time_t& modifiedTime)
+	{
+		struct stat fileStatus;
+		if (stat(filename.c_str(), &fileStatus) != 0)
+		{
+			return(false);
+		}
+
+		modifiedTime = fileStatus.st_mtime;
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  GetCookedFilename()
+ *
+ *  This method is used for getting the name of the cooked
+ *  file, which replaces the extension of the source image.
+ ***********************************************************/
+std::string TextureCooker::GetCookedFilename(const std::string& sourceFilename)
+{
+	size_t extension = sourceFilename.find_last_of('.');
+	size_t directory = sourceFilename.find_last_of("/\\");
+
+	if ((extension == std::string::npos) ||
+		((directory != std::string::npos) && (extension < directory)))
+	{
+		return(sourceFilename + g_CookedExtension);
+	}
+
+	return(sourceFilename.substr(0, extension) + g_CookedExtension);
+}
+
+/***********************************************************
+ *  IsCookedFileCurrent()
+ *
+ *  This method is used for checking whether the cooked file
+ *  exists and was written after the source image was last
+ *  changed, so that an edited image is not hidden behind its
+ *  old cooked file.
+ ***********************************************************/
+bool TextureCooker::IsCookedFileCurrent(const std::string& sourceFilename)
+{
+	time_t sourceTime = 0;
+	time_t cookedTime = 0;
+
+	if (GetFileTime(GetCookedFilename(sourceFilename), cookedTime) == false)
+	{
+		return(false);
+	}
+
+	// without the source image the cooked file is all there is
+	if (GetFileTime(sourceFilename, sourceTime) == false)
+	{
+		return(true);
+	}
+
+	return(cookedTime >= sourceTime);
+}
+
+/***********************************************************
+ *  CookTexture()
+ *
+ *  This method is used for cooking the passed in source image
+ *  file into a compressed KTX file with the full mip chain.
+ ***********************************************************/
+bool TextureCooker::CookTexture(const std::string& sourceFilename)
+{
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+
+	// the cooked images have the same orientation as the images
+	// decoded at run time
+	stbi_set_flip_vertically_on_load(true);
+
+	unsigned char* image = stbi_load(sourceFilename.c_str(), &width, &height, &colorChannels, 4);
+	if (NULL == image)
+	{
+		std::cout << "Could not load image:" << sourceFilename << std::endl;
+		return(false);
+	}
+
+	std::vector<unsigned char> pixels(image, image + ((size_t)width * height * 4));
+	stbi_image_free(image);
+
+	// images with any transparent texel keep their alpha in BC3
+	bool bHasAlpha = false;
+	for (size_t i = 3; i < pixels.size(); i += 4)
+	{
+		if (pixels[i] != 255)
+		{
+			bHasAlpha = true;
+			break;
+		}
+	}
+	GLenum compressedFormat = bHasAlpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	GLenum baseFormat = bHasAlpha ? GL_RGBA : GL_RGB;
+
+	// compress every level of the mip chain down to 1x1
+	std::vector<std::vector<unsigned char> > levelBlocks;
+	std::vector<KtxFile::KTX_LEVEL> levels;
+	int levelWidth = width;
+	int levelHeight = height;
+
+	while (true)
+	{
+		levelBlocks.push_back(std::vector<unsigned char>());
+		CompressImage(pixels.data(), levelWidth, levelHeight, compressedFormat, levelBlocks.back());
+
+		KtxFile::KTX_LEVEL level;
+		level.width = levelWidth;
+		level.height = levelHeight;
+		level.data = NULL;
+		level.dataSize = levelBlocks.back().size();
+		levels.push_back(level);
+
+		if ((levelWidth == 1) && (levelHeight == 1))
+		{
+			break;
+		}
+
+		std::vector<unsigned char> halfPixels;
+		DownsampleImage(pixels, levelWidth, levelHeight, halfPixels);
+		pixels.swap(halfPixels);
+		levelWidth = (levelWidth > 1) ? (levelWidth / 2) : 1;
+		levelHeight = (levelHeight > 1) ? (levelHeight / 2) : 1;
+	}
+
+	// the block storage is complete, so the level data can be
+	// pointed at without being moved again
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		levels[i].data = levelBlocks[i].data();
+	}
+
+	std::string cookedFilename = GetCookedFilename(sourceFilename);
+	if (KtxFile::Write(cookedFilename.c_str(), compressedFormat, baseFormat, levels) == false)
+	{
+		return(false);
+	}
+
+	size_t cookedSize = 0;
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		cookedSize += levels[i].dataSize;
+	}
+	std::cout << "Cooked texture:" << cookedFilename << ", width:" << width << ", height:" << height
+		<< ", levels:" << levels.size() << ", format:" << (bHasAlpha ? "BC3" : "BC1")
+		<< ", bytes:" << cookedSize << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetCompressedSize()
+ *
+ *  This method is used for getting the size in bytes of an
+ *  image compressed into 4x4 texel blocks.
+ ***********************************************************/
+size_t TextureCooker::GetCompressedSize(int width, int height, GLenum compressedFormat)
+{
+	size_t blockSize = (compressedFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 16 : 8;
+	size_t blocksWide = (width + 3) / 4;
+	size_t blocksHigh = (height + 3) / 4;
+
+	return(blocksWide * blocksHigh * blockSize);
+}
+
+/***********************************************************
+ *  CompressImage()
+ *
+ *  This method is used for compressing an RGBA8 image into
+ *  BC1 or BC3 blocks.  The texels of blocks along the right
+ *  and top edges are repeated for images that are not a
+ *  multiple of 4 texels in size.
+ ***********************************************************/
+void TextureCooker::CompressImage(
+	const unsigned char* pixels,
+	int width,
+	int height,
+	GLenum compressedFormat,
+	std::vector<unsigned char>& blocks)
+{
+	bool bAlphaBlocks = (compressedFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+	unsigned char texels[16][4];
+
+	blocks.resize(GetCompressedSize(width, height, compressedFormat));
+	unsigned char* block = blocks.data();
+
+	for (int blockY = 0; blockY < height; blockY += 4)
+	{
+		for (int blockX = 0; blockX < width; blockX += 4)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				int x = blockX + (i % 4);
+				int y = blockY + (i / 4);
+				x = (x < width) ? x : (width - 1);
+				y = (y < height) ? y : (height - 1);
+				memcpy(texels[i], pixels + (((size_t)y * width + x) * 4), 4);
+			}
+
+			if (bAlphaBlocks == true)
+			{
+				CompressAlphaBlock(texels, block);
+				block += 8;
+			}
+			CompressColorBlock(texels, block);
+			block += 8;
+		}
+	}
+}
+
+/***********************************************************
+ *  CompressColorBlock()
+ *
+ *  This method is used for compressing the colors of a block
+ *  of 16 texels into the 8 byte BC1 color block.  The end
+ *  points are the inset corners of the color bounding box,
+ *  and each texel picks the nearest of the four colors.
+ ***********************************************************/
+void TextureCooker::CompressColorBlock(const unsigned char texels[16][4], unsigned char* block)
+{
+	unsigned char minColor[3] = { 255, 255, 255 };
+	unsigned char maxColor[3] = { 0, 0, 0 };
+
+	for (int i = 0; i < 16; i++)
+	{
+		for (int channel = 0; channel < 3; channel++)
+		{
+			minColor[channel] = (texels[i][channel] < minColor[channel]) ? texels[i][channel] : minColor[channel];
+			maxColor[channel] = (texels[i][channel] > maxColor[channel]) ? texels[i][channel] : maxColor[channel];
+		}
+	}
+
+	// move the end points inwards by 1/16 of the range, which
+	// lowers the error for the texels between them
+	for (int channel = 0; channel < 3; channel++)
+	{
+		int inset = (maxColor[channel] - minColor[channel]) >> 4;
+		minColor[channel] = minColor[channel] + inset;
+		maxColor[channel] = maxColor[channel] - inset;
+	}
+
+	uint16_t color0 = PackColor565(maxColor);
+	uint16_t color1 = PackColor565(minColor);
+	if (color0 < color1)
+	{
+		uint16_t swapColor = color0;
+		color0 = color1;
+		color1 = swapColor;
+	}
+
+	// the four colors of the block - with color0 greater than
+	// color1 the block uses the opaque four color mode
+	int palette[4][3];
+	UnpackColor565(color0, palette[0]);
+	UnpackColor565(color1, palette[1]);
+	for (int channel = 0; channel < 3; channel++)
+	{
+		palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+		palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+	}
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			int bestIndex = 0;
+			int bestDistance = 0x7FFFFFFF;
+
+			for (int index = 0; index < 4; index++)
+			{
+				int distance = 0;
+				for (int channel = 0; channel < 3; channel++)
+				{
+					int difference = texels[i][channel] - palette[index][channel];
+					distance += difference * difference;
+				}
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = index;
+				}
+			}
+
+			indices |= (uint32_t)bestIndex << (i * 2);
+		}
+	}
+
+	block[0] = color0 & 0xFF;
+	block[1] = color0 >> 8;
+	block[2] = color1 & 0xFF;
+	block[3] = color1 >> 8;
+	block[4] = indices & 0xFF;
+	block[5] = (indices >> 8) & 0xFF;
+	block[6] = (indices >> 16) & 0xFF;
+	block[7] = (indices >> 24) & 0xFF;
+}
+
+/***********************************************************
+ *  CompressAlphaBlock()
+ *
+ *  This method is used for compressing the alpha values of a
+ *  block of 16 texels into the 8 byte BC3 alpha block, using
+ *  the eight value mode between the lowest and highest alpha.
+ ***********************************************************/
+void TextureCooker::CompressAlphaBlock(const unsigned char texels[16][4], unsigned char* block)
+{
+	int minAlpha = 255;
+	int maxAlpha = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		minAlpha = (texels[i][3] < minAlpha) ? texels[i][3] : minAlpha;
+		maxAlpha = (texels[i][3] > maxAlpha) ? texels[i][3] : maxAlpha;
+	}
+
+	// with alpha0 greater than alpha1 the block has eight
+	// alpha values spread evenly between them
+	int palette[8];
+	palette[0] = maxAlpha;
+	palette[1] = minAlpha;
+	for (int index = 2; index < 8; index++)
+	{
+		palette[index] = ((8 - index) * maxAlpha + (index - 1) * minAlpha) / 7;
+	}
+
+	uint64_t indices = 0;
+	if (maxAlpha != minAlpha)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			int bestIndex = 0;
+			int bestDistance = 256;
+
+			for (int index = 0; index < 8; index++)
+			{
+				int distance = texels[i][3] - palette[index];
+				distance = (distance < 0) ? -distance : distance;
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = index;
+				}
+			}
+
+			indices |= (uint64_t)bestIndex << (i * 3);
+		}
+	}
+
+	block[0] = (unsigned char)maxAlpha;
+	block[1] = (unsigned char)minAlpha;
+	for (int i = 0; i < 6; i++)
+	{
+		block[2 + i] = (indices >> (i * 8)) & 0xFF;
+	}
+}
+
+/***********************************************************
+ *  DownsampleImage()
+ *
+ *  This method is used for making the next smaller mip level
+ *  of an RGBA8 image by averaging each 2x2 group of texels.
+ ***********************************************************/
+void TextureCooker::DownsampleImage(
+	const std::vector<unsigned char>& pixels,
+	int width,
+	int height,
+	std::vector<unsigned char>& halfPixels)
+{
+	int halfWidth = (width > 1) ? (width / 2) : 1;
+	int halfHeight = (height > 1) ? (height / 2) : 1;
+
+	halfPixels.resize((size_t)halfWidth * halfHeight * 4);
+
+	for (int y = 0; y < halfHeight; y++)
+	{
+		int y0 = (y * 2 < height) ? (y * 2) : (height - 1);
+		int y1 = (y * 2 + 1 < height) ? (y * 2 + 1) : (height - 1);
+
+		for (int x = 0; x < halfWidth; x++)
+		{
+			int x0 = (x * 2 < width) ? (x * 2) : (width - 1);
+			int x1 = (x * 2 + 1 < width) ? (x * 2 + 1) : (width - 1);
+
+			for (int channel = 0; channel < 4; channel++)
+			{
+				int sum = pixels[((size_t)y0 * width + x0) * 4 + channel] +
+					pixels[((size_t)y0 * width + x1) * 4 + channel] +
+					pixels[((size_t)y1 * width + x0) * 4 + channel] +
+					pixels[((size_t)y1 * width + x1) * 4 + channel];
+				halfPixels[((size_t)y * halfWidth + x) * 4 + channel] = (sum + 2) / 4;
+			}
+		}
+	}
+}
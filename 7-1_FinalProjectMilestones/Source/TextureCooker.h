@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecooker.h
+// ============
+// convert texture images into compressed KTX files with precomputed mipmaps
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureCooker
+ *
+ *  This class contains the code for the offline texture
+ *  cooking step.  An image file is decoded, its mip chain is
+ *  made with a box filter, and every level is compressed to
+ *  BC1 (opaque images) or BC3 (images with alpha) and written
+ *  to a KTX file next to the source image.
+ ***********************************************************/
+class TextureCooker
+{
+public:
+	// get the name of the cooked file for a source image file
+	static std::string GetCookedFilename(const std::string& sourceFilename);
+	// check whether the cooked file exists and is not older
+	// than its source image file
+	static bool IsCookedFileCurrent(const std::string& sourceFilename);
+	// cook the passed in source image file
+	static bool CookTexture(const std::string& sourceFilename);
+
+	// compress an RGBA8 image into BC1 or BC3 blocks
+	static void CompressImage(
+		const unsigned char* pixels,
+		int width,
+		int height,
+		GLenum compressedFormat,
+		std::vector<unsigned char>& blocks);
+	// get the size in bytes of a compressed image
+	static size_t GetCompressedSize(int width, int height, GLenum compressedFormat);
+
+private:
+	// make the next smaller mip level with a 2x2 box filter
+	static void DownsampleImage(
+		const std::vector<unsigned char>& pixels,
+		int width,
+		int height,
+		std::vector<unsigned char>& halfPixels);
+	// compress one 4x4 block of RGBA8 texels
+	static void CompressColorBlock(const unsigned char texels[16][4], unsigned char* block);
+	static void CompressAlphaBlock(const unsigned char texels[16][4], unsigned char* block);
+};
@@ -0,0 +1,251 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture image files on worker threads for uploading to OpenGL
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+
+// the stb_image implementation is compiled in scenemanager.cpp
+#include "stb_image.h"
+
+#include <fstream>
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader(int threadCount)
+{
+	m_pendingCount = 0;
+	m_bStopping = false;
+
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency() - 1;
+		if (threadCount < 1)
+		{
+			threadCount = 1;
+		}
+	}
+
+	// the flip setting is global state in stb_image, so it is
+	// set once here before any of the worker threads start
+	stbi_set_flip_vertically_on_load(true);
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_workers.push_back(std::thread(&TextureLoader::WorkerLoop, this));
+	}
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+		m_jobs.clear();
+	}
+	m_jobReady.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	// free the decoded images that were never popped
+	while (m_decodedImages.empty() == false)
+	{
+		FreeImage(m_decodedImages.front());
+		m_decodedImages.pop_front();
+	}
+}
+
+/***********************************************************
+ *  QueueImage()
+ *
+ *  This method is used for queueing an image file to be
+ *  decoded by the next idle worker thread.
+ ***********************************************************/
+void TextureLoader::QueueImage(const std::string& filename, int requestID, int desiredChannels)
+{
+	DECODE_JOB job;
+	job.requestID = requestID;
+	job.filename = filename;
+	job.desiredChannels = desiredChannels;
+	job.bFileData = false;
+
+	QueueJob(job);
+}
+
+/***********************************************************
+ *  QueueFile()
+ *
+ *  This method is used for queueing a file to be read into
+ *  memory by the next idle worker thread, without decoding.
+ ***********************************************************/
+void TextureLoader::QueueFile(const std::string& filename, int requestID)
+{
+	DECODE_JOB job;
+	job.requestID = requestID;
+	job.filename = filename;
+	job.desiredChannels = 0;
+	job.bFileData = true;
+
+	QueueJob(job);
+}
+
+/***********************************************************
+ *  QueueJob()
+ *
+ *  This method is used for adding a job to the queue and
+ *  waking up one of the worker threads.
+ ***********************************************************/
+void TextureLoader::QueueJob(const DECODE_JOB& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(job);
+		m_pendingCount++;
+	}
+	m_jobReady.notify_one();
+}
+
+/***********************************************************
+ *  PopDecodedImage()
+ *
+ *  This method is used for getting the next decoded image
+ *  without waiting.  It returns false when no image is ready.
+ ***********************************************************/
+bool TextureLoader::PopDecodedImage(DECODED_IMAGE& image)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_decodedImages.empty() == true)
+	{
+		return(false);
+	}
+
+	image = m_decodedImages.front();
+	m_decodedImages.pop_front();
+	m_pendingCount--;
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetPendingCount()
+ *
+ *  This method is used for getting the number of queued
+ *  images that have not been popped yet.
+ ***********************************************************/
+int TextureLoader::GetPendingCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return(m_pendingCount);
+}
+
+/***********************************************************
+ *  FreeImage()
+ *
+ *  This method is used for freeing the decoded pixels of a
+ *  popped image.
+ ***********************************************************/
+void TextureLoader::FreeImage(DECODED_IMAGE& image)
+{
+	if (NULL != image.pixels)
+	{
+		if (image.bFileData == true)
+		{
+			delete[] image.pixels;
+		}
+		else
+		{
+			stbi_image_free(image.pixels);
+		}
+		image.pixels = NULL;
+	}
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used as the main loop of each worker
+ *  thread, decoding the queued images until the loader is
+ *  destroyed.
+ ***********************************************************/
+void TextureLoader::WorkerLoop()
+{
+	while (true)
+	{
+		DECODE_JOB job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobReady.wait(lock, [this] { return((m_bStopping == true) || (m_jobs.empty() == false)); });
+
+			if (m_bStopping == true)
+			{
+				return;
+			}
+
+			job = m_jobs.front();
+			m_jobs.pop_front();
+		}
+
+		// decode or read outside of the lock so the workers run in parallel
+		DECODED_IMAGE image;
+		image.requestID = job.requestID;
+		image.filename = job.filename;
+		image.width = 0;
+		image.height = 0;
+		image.colorChannels = 0;
+		image.pixelChannels = 0;
+		image.bFileData = job.bFileData;
+		image.dataSize = 0;
+		image.pixels = NULL;
+
+		if (job.bFileData == true)
+		{
+			std::ifstream file(job.filename, std::ios::binary | std::ios::ate);
+			if (file)
+			{
+				size_t fileSize = (size_t)file.tellg();
+				unsigned char* fileData = new unsigned char[fileSize];
+				file.seekg(0);
+				if (file.read((char*)fileData, fileSize))
+				{
+					image.pixels = fileData;
+					image.dataSize = fileSize;
+				}
+				else
+				{
+					delete[] fileData;
+				}
+			}
+		}
+		else
+		{
+			image.pixels = stbi_load(
+				job.filename.c_str(),
+				&image.width,
+				&image.height,
+				&image.colorChannels,
+				job.desiredChannels);
+			image.pixelChannels = (job.desiredChannels != 0) ? job.desiredChannels : image.colorChannels;
+			image.dataSize = (size_t)image.width * image.height * image.pixelChannels;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_decodedImages.push_back(image);
+		}
+	}
+}
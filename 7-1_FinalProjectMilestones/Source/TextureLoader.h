@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture image files on worker threads for uploading to OpenGL
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class contains the code for decoding texture image
+ *  files on a pool of worker threads.  The decoded pixels are
+ *  handed back to the thread that owns the OpenGL context,
+ *  which uploads them - no OpenGL calls are made here.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// constructor - zero threads uses one thread per core,
+	// leaving one core for the rendering thread
+	TextureLoader(int threadCount = 0);
+	// destructor
+	~TextureLoader();
+
+	// a decoded image that is ready for uploading
+	struct DECODED_IMAGE
+	{
+		// value passed in when the image was queued
+		int requestID;
+		std::string filename;
+		// NULL when the image could not be decoded - must be
+		// freed with FreeImage() after uploading
+		unsigned char* pixels;
+		int width;
+		int height;
+		// channels in the image file
+		int colorChannels;
+		// channels in the decoded pixels
+		int pixelChannels;
+		// true when the pixels hold the unchanged contents of
+		// the file, which were queued with QueueFile()
+		bool bFileData;
+		// size of the pixels in bytes
+		size_t dataSize;
+	};
+
+	// queue an image file for decoding on the worker threads,
+	// converting the pixels to the desired number of channels
+	// (zero keeps the channels of the image file)
+	void QueueImage(const std::string& filename, int requestID, int desiredChannels = 0);
+	// queue a file to be read into memory without decoding,
+	// which is used for the cooked texture files
+	void QueueFile(const std::string& filename, int requestID);
+	// get the next decoded image, false when none is ready
+	bool PopDecodedImage(DECODED_IMAGE& image);
+	// get the number of queued images not yet popped
+	int GetPendingCount();
+	// free the pixels of a popped image
+	static void FreeImage(DECODED_IMAGE& image);
+
+private:
+	// an image file waiting to be decoded
+	struct DECODE_JOB
+	{
+		int requestID;
+		std::string filename;
+		int desiredChannels;
+		// true when the file is read without decoding
+		bool bFileData;
+	};
+
+	std::vector<std::thread> m_workers;
+	// images waiting to be decoded, guarded by m_mutex
+	std::deque<DECODE_JOB> m_jobs;
+	// decoded images waiting to be popped, guarded by m_mutex
+	std::deque<DECODED_IMAGE> m_decodedImages;
+	// number of queued images not yet popped, guarded by m_mutex
+	int m_pendingCount;
+	// true when the worker threads need to exit
+	bool m_bStopping;
+	std::mutex m_mutex;
+	std::condition_variable m_jobReady;
+
+	// main loop of each worker thread
+	void WorkerLoop();
+	// add a job to the queue and wake up a worker thread
+	void QueueJob(const DECODE_JOB& job);
+};
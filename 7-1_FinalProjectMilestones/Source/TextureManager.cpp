@@ -0,0 +1,686 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturemanager.cpp
+// ============
+// manage the scene textures stored as layers of OpenGL texture arrays
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureManager.h"
+#include "TextureCooker.h"
+#include "KtxFile.h"
+
+// the stb_image implementation is compiled in scenemanager.cpp
+#include "stb_image.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// all textures are stored as RGBA so that images with
+	// different channel counts can share a texture array
+	const int g_TextureChannels = 4;
+	// the texel shown by a texture until its image is uploaded
+	const unsigned char g_PlaceholderTexel[4] = { 128, 128, 128, 255 };
+
+	/***********************************************************
+	 *  HasTransparentTexels()
+	 *
+	 *  This function is used for decoding an image with an
+	 *  alpha channel and checking whether any of its texels is
+	 *  not fully opaque, the same way as the texture cooker.
+	 ***********************************************************/
+	bool HasTransparentTexels(const char* filename)
+	{
+		int width = 0;
+		int height = 0;
+		int colorChannels = 0;
+		unsigned char* image = stbi_load(filename, &width, &height, &colorChannels, 4);
+		if (NULL == image)
+		{
+			return(false);
+		}
+
+		bool bHasAlpha = false;
+		size_t byteCount = (size_t)width * height * 4;
+		for (size_t i = 3; i < byteCount; i += 4)
+		{
+			if (image[i] != 255)
+			{
+				bHasAlpha = true;
+				break;
+			}
+		}
+		stbi_image_free(image);
+
+		return(bHasAlpha);
+	}
+}
+
+/***********************************************************
+ *  TextureManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureManager::TextureManager(ResourcePool* pResourcePool)
+{
+	m_pTextureLoader = new TextureLoader();
+	m_pResourcePool = pResourcePool;
+	m_bArraysCreated = false;
+	m_bCompressedFormats = (GLEW_EXT_texture_compression_s3tc == GL_TRUE);
+}
+
+/***********************************************************
+ *  ~TextureManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureManager::~TextureManager()
+{
+	delete m_pTextureLoader;
+	m_pTextureLoader = NULL;
+	DestroyTextures();
+}
+
+/***********************************************************
+ *  RegisterTexture()
+ *
+ *  This method is used for registering an image file as a
+ *  texture.  Only the header of the cooked file or the image
+ *  is read here, to choose the texture array, and the file is
+ *  queued for reading or decoding on the texture loader
+ *  threads.  An uncooked image with an alpha channel is also
+ *  decoded here to check its alpha.  The returned handle is
+ *  -1 when the texture can't be used.
+ ***********************************************************/
+int TextureManager::RegisterTexture(const char* filename, const std::string& tag)
+{
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+
+	if (m_bArraysCreated == true)
+	{
+		std::cout << "Could not load image:" << filename << ", the texture arrays are already created" << std::endl;
+		return(-1);
+	}
+
+	if (m_textureHandles.find(tag) != m_textureHandles.end())
+	{
+		std::cout << "Texture " << tag << " is already registered" << std::endl;
+		return(m_textureHandles[tag]);
+	}
+
+	TEXTURE_ENTRY texture;
+	texture.tag = tag;
+	texture.filename = filename;
+	texture.sourceFilename = filename;
+	texture.bCooked = false;
+
+	// prefer the cooked file when it is up to date with the image
+	KtxFile::KTX_INFO cookedInfo;
+	std::string cookedFilename = TextureCooker::GetCookedFilename(filename);
+	if ((m_bCompressedFormats == true) &&
+		(TextureCooker::IsCookedFileCurrent(filename) == true) &&
+		(KtxFile::ReadHeader(cookedFilename.c_str(), cookedInfo) == true) &&
+		((cookedInfo.internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) ||
+		 (cookedInfo.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)))
+	{
+		texture.filename = cookedFilename;
+		texture.bCooked = true;
+		texture.bHasAlpha = (cookedInfo.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+		texture.arrayIndex = FindTextureArray(
+			cookedInfo.width, cookedInfo.height, cookedInfo.internalFormat, cookedInfo.levelCount);
+	}
+	else
+	{
+		if (stbi_info(filename, &width, &height, &colorChannels) == 0)
+		{
+			std::cout << "Could not load image:" << filename << std::endl;
+			return(-1);
+		}
+
+		if ((colorChannels != 3) && (colorChannels != 4))
+		{
+			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+			return(-1);
+		}
+
+		// an image with an alpha channel is decoded once here, since
+		// the items need to know whether it is blended before its
+		// pixels come back from the loader threads
+		texture.bHasAlpha = (colorChannels == 4) && (HasTransparentTexels(filename) == true);
+		texture.arrayIndex = FindTextureArray(width, height, GL_RGBA8, 0);
+	}
+	texture.layer = m_arrays[texture.arrayIndex].layerCount;
+	m_arrays[texture.arrayIndex].layerCount++;
+
+	int textureHandle = m_textures.size();
+	m_textures.push_back(texture);
+	m_textureHandles[tag] = textureHandle;
+
+	// the decoding or reading starts right away, the upload
+	// waits until the texture arrays are created
+	if (texture.bCooked == true)
+	{
+		m_pTextureLoader->QueueFile(texture.filename, textureHandle);
+	}
+	else
+	{
+		m_pTextureLoader->QueueImage(filename, textureHandle, g_TextureChannels);
+	}
+
+	return(textureHandle);
+}
+
+/***********************************************************
+ *  FindTextureArray()
+ *
+ *  This method is used for finding the texture array for the
+ *  passed in image size, format and number of mip levels,
+ *  adding a new one when there is no such array yet.
+ ***********************************************************/
+int TextureManager::FindTextureArray(int width, int height, GLenum internalFormat, int levelCount)
+{
+	for (size_t i = 0; i < m_arrays.size(); i++)
+	{
+		if ((m_arrays[i].width == width) &&
+			(m_arrays[i].height == height) &&
+			(m_arrays[i].internalFormat == internalFormat) &&
+			(m_arrays[i].levelCount == levelCount))
+		{
+			return((int)i);
+		}
+	}
+
+	TEXTURE_ARRAY textureArray;
+	textureArray.textureID = 0;
+	textureArray.width = width;
+	textureArray.height = height;
+	textureArray.internalFormat = internalFormat;
+	textureArray.levelCount = levelCount;
+	textureArray.layerCount = 0;
+	textureArray.bMipmapsDirty = false;
+	m_arrays.push_back(textureArray);
+
+	return(m_arrays.size() - 1);
+}
+
+/***********************************************************
+ *  CreateTextureArrays()
+ *
+ *  This method is used for allocating the texture arrays for
+ *  all of the registered textures.  Every layer holds the
+ *  placeholder texel until its image is uploaded.  It returns
+ *  false when there are more arrays or layers than OpenGL
+ *  supports.
+ ***********************************************************/
+bool TextureManager::CreateTextureArrays()
+{
+	GLint maxTextureUnits = 0;
+	GLint maxLayers = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxTextureUnits);
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+	if ((int)m_arrays.size() > maxTextureUnits)
+	{
+		std::cout << "The " << m_arrays.size() << " texture arrays need more than the "
+			<< maxTextureUnits << " available texture units" << std::endl;
+		return(false);
+	}
+
+	for (size_t i = 0; i < m_arrays.size(); i++)
+	{
+		TEXTURE_ARRAY& textureArray = m_arrays[i];
+
+		if (textureArray.layerCount > maxLayers)
+		{
+			std::cout << "The " << textureArray.layerCount << " textures of size " << textureArray.width
+				<< "x" << textureArray.height << " are more than the " << maxLayers << " supported layers" << std::endl;
+			return(false);
+		}
+
+		if (textureArray.levelCount > 0)
+		{
+			CreateCompressedTextureArray(textureArray);
+		}
+		else
+		{
+			CreateTextureArray(textureArray);
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	m_bArraysCreated = true;
+	return(true);
+}
+
+/***********************************************************
+ *  AcquireArrayTexture()
+ *
+ *  This method is used for getting the texture of a texture
+ *  array from the pool.  A texture array released by the last
+ *  load with the same size, format and levels is reused, so a
+ *  reloaded scene takes no more texture memory.
+ ***********************************************************/
+void TextureManager::AcquireArrayTexture(TEXTURE_ARRAY& textureArray, bool& bReused)
+{
+	ResourcePool::TEXTURE_DESC desc;
+	desc.target = GL_TEXTURE_2D_ARRAY;
+	desc.internalFormat = textureArray.internalFormat;
+	desc.width = textureArray.width;
+	desc.height = textureArray.height;
+	desc.depth = textureArray.layerCount;
+	desc.levelCount = textureArray.levelCount;
+	desc.byteSize = 0;
+
+	// the generated mipmaps add a third to the first level
+	if (textureArray.levelCount == 0)
+	{
+		desc.byteSize = ((GLsizeiptr)textureArray.width * textureArray.height * g_TextureChannels * 4 / 3) *
+			textureArray.layerCount;
+	}
+	else
+	{
+		GLsizeiptr blockBytes = (textureArray.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 16 : 8;
+		int levelWidth = textureArray.width;
+		int levelHeight = textureArray.height;
+		for (int level = 0; level < textureArray.levelCount; level++)
+		{
+			desc.byteSize += (GLsizeiptr)((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockBytes *
+				textureArray.layerCount;
+			levelWidth = (levelWidth > 1) ? (levelWidth / 2) : 1;
+			levelHeight = (levelHeight > 1) ? (levelHeight / 2) : 1;
+		}
+	}
+
+	textureArray.textureID = m_pResourcePool->AcquireTexture(desc, bReused);
+}
+
+/***********************************************************
+ *  CreateTextureArray()
+ *
+ *  This method is used for allocating an RGBA8 texture array
+ *  for decoded images, filled with the placeholder texel.
+ ***********************************************************/
+void TextureManager::CreateTextureArray(TEXTURE_ARRAY& textureArray)
+{
+	bool bReused = false;
+	AcquireArrayTexture(textureArray, bReused);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.textureID);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	if (bReused == false)
+	{
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, textureArray.width, textureArray.height,
+			textureArray.layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	}
+
+	// fill the layers with the placeholder texel, one layer at a
+	// time so that only a single layer is held in local memory
+	std::vector<unsigned char> placeholder(
+		(size_t)textureArray.width * textureArray.height * g_TextureChannels);
+	for (size_t texel = 0; texel < placeholder.size(); texel += g_TextureChannels)
+	{
+		placeholder[texel + 0] = g_PlaceholderTexel[0];
+		placeholder[texel + 1] = g_PlaceholderTexel[1];
+		placeholder[texel + 2] = g_PlaceholderTexel[2];
+		placeholder[texel + 3] = g_PlaceholderTexel[3];
+	}
+	for (int layer = 0; layer < textureArray.layerCount; layer++)
+	{
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, textureArray.width, textureArray.height, 1,
+			GL_RGBA, GL_UNSIGNED_BYTE, placeholder.data());
+	}
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+}
+
+/***********************************************************
+ *  CreateCompressedTextureArray()
+ *
+ *  This method is used for allocating a compressed texture
+ *  array with the mip levels of the cooked files, filled with
+ *  the compressed placeholder texel.
+ ***********************************************************/
+void TextureManager::CreateCompressedTextureArray(TEXTURE_ARRAY& textureArray)
+{
+	bool bReused = false;
+	AcquireArrayTexture(textureArray, bReused);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.textureID);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	// only the cooked mip levels exist
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, textureArray.levelCount - 1);
+
+	int levelWidth = textureArray.width;
+	int levelHeight = textureArray.height;
+
+	for (int level = 0; level < textureArray.levelCount; level++)
+	{
+		// compress a placeholder layer for the level, which is
+		// copied into every layer of the array
+		std::vector<unsigned char> placeholder((size_t)levelWidth * levelHeight * g_TextureChannels);
+		for (size_t texel = 0; texel < placeholder.size(); texel += g_TextureChannels)
+		{
+			placeholder[texel + 0] = g_PlaceholderTexel[0];
+			placeholder[texel + 1] = g_PlaceholderTexel[1];
+			placeholder[texel + 2] = g_PlaceholderTexel[2];
+			placeholder[texel + 3] = g_PlaceholderTexel[3];
+		}
+		std::vector<unsigned char> placeholderBlocks;
+		TextureCooker::CompressImage(placeholder.data(), levelWidth, levelHeight,
+			textureArray.internalFormat, placeholderBlocks);
+
+		if (bReused == false)
+		{
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, textureArray.internalFormat,
+				levelWidth, levelHeight, textureArray.layerCount, 0,
+				placeholderBlocks.size() * textureArray.layerCount, NULL);
+		}
+		for (int layer = 0; layer < textureArray.layerCount; layer++)
+		{
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer,
+				levelWidth, levelHeight, 1, textureArray.internalFormat,
+				placeholderBlocks.size(), placeholderBlocks.data());
+		}
+
+		levelWidth = (levelWidth > 1) ? (levelWidth / 2) : 1;
+		levelHeight = (levelHeight > 1) ? (levelHeight / 2) : 1;
+	}
+}
+
+/***********************************************************
+ *  BindTextureArrays()
+ *
+ *  This method is used for binding each texture array to the
+ *  texture unit with the same index as the array.
+ ***********************************************************/
+void TextureManager::BindTextureArrays()
+{
+	for (size_t i = 0; i < m_arrays.size(); i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_arrays[i].textureID);
+	}
+}
+
+/***********************************************************
+ *  UploadLoadedTextures()
+ *
+ *  This method is used for uploading the images that have
+ *  been decoded by the texture loader threads into their
+ *  texture array layers.  At most the passed in number of
+ *  images is uploaded, to spread the upload cost over several
+ *  frames, and the mipmaps of each changed array are made
+ *  once afterwards.
+ ***********************************************************/
+void TextureManager::UploadLoadedTextures(int maxUploads)
+{
+	if (m_bArraysCreated == false)
+	{
+		return;
+	}
+
+	TextureLoader::DECODED_IMAGE image;
+	int uploads = 0;
+
+	while ((uploads < maxUploads) && (m_pTextureLoader->PopDecodedImage(image) == true))
+	{
+		UploadTextureImage(image);
+		TextureLoader::FreeImage(image);
+		uploads++;
+	}
+
+	for (size_t i = 0; i < m_arrays.size(); i++)
+	{
+		if (m_arrays[i].bMipmapsDirty == true)
+		{
+			// the array is bound on its own texture unit, which
+			// keeps the binding made by BindTextureArrays() in place
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, m_arrays[i].textureID);
+			glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+			m_arrays[i].bMipmapsDirty = false;
+		}
+	}
+}
+
+/***********************************************************
+ *  ReloadTexture()
+ *
+ *  This method is used for loading a texture again after its
+ *  image file was edited.  A cooked texture is cooked again
+ *  from the edited image first, on this thread.  The upload
+ *  keeps the array and the layer of the texture, so an image
+ *  that changed its size or its alpha channel needs to be
+ *  registered again instead.
+ ***********************************************************/
+bool TextureManager::ReloadTexture(int textureHandle)
+{
+	if ((textureHandle < 0) || (textureHandle >= (int)m_textures.size()))
+	{
+		return(false);
+	}
+
+	const TEXTURE_ENTRY& texture = m_textures[textureHandle];
+	if (texture.bCooked == true)
+	{
+		if (TextureCooker::CookTexture(texture.sourceFilename) == false)
+		{
+			return(false);
+		}
+		m_pTextureLoader->QueueFile(texture.filename, textureHandle);
+	}
+	else
+	{
+		m_pTextureLoader->QueueImage(texture.filename, textureHandle, g_TextureChannels);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetPendingCount()
+ *
+ *  This method is used for getting the number of queued
+ *  images that have not been uploaded into textures yet.
+ ***********************************************************/
+int TextureManager::GetPendingCount()
+{
+	return(m_pTextureLoader->GetPendingCount());
+}
+
+/***********************************************************
+ *  UploadTextureImage()
+ *
+ *  This method is used for replacing the placeholder layer
+ *  of a texture with its decoded image.
+ ***********************************************************/
+void TextureManager::UploadTextureImage(const TextureLoader::DECODED_IMAGE& image)
+{
+	// if the image could not be read from the image file, the
+	// placeholder stays in the texture
+	if (NULL == image.pixels)
+	{
+		std::cout << "Could not load image:" << image.filename << std::endl;
+		return;
+	}
+
+	if (image.bFileData == true)
+	{
+		UploadCookedTexture(image);
+		return;
+	}
+
+	const TEXTURE_ENTRY& texture = m_textures[image.requestID];
+	TEXTURE_ARRAY& textureArray = m_arrays[texture.arrayIndex];
+
+	if ((image.width != textureArray.width) || (image.height != textureArray.height))
+	{
+		std::cout << "Image " << image.filename << " changed size since it was registered" << std::endl;
+		return;
+	}
+
+	std::cout << "Successfully loaded image:" << image.filename << ", width:" << image.width << ", height:" << image.height << ", channels:" << image.colorChannels << std::endl;
+
+	glActiveTexture(GL_TEXTURE0 + texture.arrayIndex);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.textureID);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, texture.layer, image.width, image.height, 1,
+		GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
+	textureArray.bMipmapsDirty = true;
+}
+
+/***********************************************************
+ *  UploadCookedTexture()
+ *
+ *  This method is used for replacing the placeholder layer
+ *  of a texture with all of the compressed mip levels read
+ *  from its cooked file.  The cooked levels are used as they
+ *  are, so no mipmaps are generated for the array.
+ ***********************************************************/
+void TextureManager::UploadCookedTexture(const TextureLoader::DECODED_IMAGE& image)
+{
+	const TEXTURE_ENTRY& texture = m_textures[image.requestID];
+	const TEXTURE_ARRAY& textureArray = m_arrays[texture.arrayIndex];
+	KtxFile::KTX_INFO info;
+	std::vector<KtxFile::KTX_LEVEL> levels;
+
+	if (KtxFile::ParseLevels(image.pixels, image.dataSize, info, levels) == false)
+	{
+		std::cout << "Could not load cooked texture:" << image.filename << std::endl;
+		return;
+	}
+
+	if ((info.width != textureArray.width) ||
+		(info.height != textureArray.height) ||
+		(info.internalFormat != textureArray.internalFormat) ||
+		(info.levelCount != textureArray.levelCount))
+	{
+		std::cout << "Cooked texture " << image.filename << " changed since it was registered" << std::endl;
+		return;
+	}
+
+	std::cout << "Successfully loaded cooked texture:" << image.filename << ", width:" << info.width << ", height:" << info.height << ", levels:" << info.levelCount << std::endl;
+
+	glActiveTexture(GL_TEXTURE0 + texture.arrayIndex);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray.textureID);
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		if (levels[level].dataSize != TextureCooker::GetCompressedSize(
+			levels[level].width, levels[level].height, textureArray.internalFormat))
+		{
+			std::cout << "Cooked texture " << image.filename << " has a damaged mip level " << level << std::endl;
+			return;
+		}
+
+		glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, texture.layer,
+			levels[level].width, levels[level].height, 1, textureArray.internalFormat,
+			levels[level].dataSize, levels[level].data);
+	}
+}
+
+/***********************************************************
+ *  DestroyTextures()
+ *
+ *  This method is used for giving the memory of all of the
+ *  texture arrays back to the pool.
+ ***********************************************************/
+void TextureManager::DestroyTextures()
+{
+	for (size_t i = 0; i < m_arrays.size(); i++)
+	{
+		if (m_arrays[i].textureID != 0)
+		{
+			m_pResourcePool->ReleaseTexture(m_arrays[i].textureID);
+			m_arrays[i].textureID = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  FindTexture()
+ *
+ *  This method is used for getting the handle of the texture
+ *  registered with the passed in tag, or -1.
+ ***********************************************************/
+int TextureManager::FindTexture(const std::string& tag) const
+{
+	std::unordered_map<std::string, int>::const_iterator found = m_textureHandles.find(tag);
+	if (found == m_textureHandles.end())
+	{
+		return(-1);
+	}
+
+	return(found->second);
+}
+
+/***********************************************************
+ *  GetTextureLocation()
+ *
+ *  This method is used for getting the texture array and the
+ *  layer of the texture for the passed in handle.
+ ***********************************************************/
+TextureManager::TEXTURE_LOCATION TextureManager::GetTextureLocation(int textureHandle) const
+{
+	TEXTURE_LOCATION location;
+	location.arrayIndex = -1;
+	location.layer = -1;
+	location.bHasAlpha = false;
+
+	if ((textureHandle >= 0) && (textureHandle < (int)m_textures.size()))
+	{
+		location.arrayIndex = m_textures[textureHandle].arrayIndex;
+		location.layer = m_textures[textureHandle].layer;
+		location.bHasAlpha = m_textures[textureHandle].bHasAlpha;
+	}
+
+	return(location);
+}
+
+/***********************************************************
+ *  GetArrayTextureID()
+ *
+ *  This method is used for getting the OpenGL texture of the
+ *  texture array at the passed in index.
+ ***********************************************************/
+GLuint TextureManager::GetArrayTextureID(int arrayIndex) const
+{
+	if ((arrayIndex < 0) || (arrayIndex >= (int)m_arrays.size()))
+	{
+		return(0);
+	}
+
+	return(m_arrays[arrayIndex].textureID);
+}
+
+/***********************************************************
+ *  GetTextureCount()
+ *
+ *  This method is used for getting the number of registered
+ *  textures.
+ ***********************************************************/
+int TextureManager::GetTextureCount() const
+{
+	return(m_textures.size());
+}
+
+/***********************************************************
+ *  GetArrayCount()
+ *
+ *  This method is used for getting the number of texture
+ *  arrays.
+ ***********************************************************/
+int TextureManager::GetArrayCount() const
+{
+	return(m_arrays.size());
+}
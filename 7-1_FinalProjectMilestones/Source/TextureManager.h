@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturemanager.h
+// ============
+// manage the scene textures stored as layers of OpenGL texture arrays
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ResourcePool.h"
+#include "TextureLoader.h"
+
+#include <GL/glew.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  TextureManager
+ *
+ *  This class contains the code for storing every texture as
+ *  a layer of a GL_TEXTURE_2D_ARRAY, with one array for each
+ *  image size.  Each array stays bound on its own texture
+ *  unit, so a texture is selected in the shader by the unit
+ *  of its array and its layer, and the number of textures is
+ *  not limited by the number of texture units.  Textures that
+ *  have a current cooked file are stored in the compressed
+ *  format and with the mip levels of that file.
+ ***********************************************************/
+class TextureManager
+{
+public:
+	// constructor
+	TextureManager(ResourcePool* pResourcePool);
+	// destructor
+	~TextureManager();
+
+	// where a registered texture is stored
+	struct TEXTURE_LOCATION
+	{
+		// index of the texture array, which is also the texture
+		// unit that the array is bound to - -1 when not found
+		int arrayIndex;
+		// layer of the texture in the texture array
+		int layer;
+		// true when the texture image has an alpha channel, so
+		// the objects drawn with it can be see-through
+		bool bHasAlpha;
+	};
+
+	// register an image file as a texture and queue it for
+	// decoding, returning the texture handle or -1
+	int RegisterTexture(const char* filename, const std::string& tag);
+	// allocate the texture arrays for the registered textures,
+	// filled with placeholder texels until the images arrive
+	bool CreateTextureArrays();
+	// bind each texture array to its texture unit
+	void BindTextureArrays();
+	// upload the decoded images into their texture array layers
+	void UploadLoadedTextures(int maxUploads);
+	// queue the image file of a texture for decoding again after
+	// it was edited, which is uploaded into the layer it has
+	bool ReloadTexture(int textureHandle);
+	// get the number of images waiting to be decoded or uploaded
+	int GetPendingCount();
+	// free the texture arrays
+	void DestroyTextures();
+
+	// find a registered texture by tag
+	int FindTexture(const std::string& tag) const;
+	// get where the texture for the passed in handle is stored
+	TEXTURE_LOCATION GetTextureLocation(int textureHandle) const;
+	// get the OpenGL texture of a texture array
+	GLuint GetArrayTextureID(int arrayIndex) const;
+	// get the numbers of registered textures and texture arrays
+	int GetTextureCount() const;
+	int GetArrayCount() const;
+
+private:
+	// one registered texture
+	struct TEXTURE_ENTRY
+	{
+		std::string tag;
+		// the file that is loaded, which is the cooked file of the
+		// registered image file when there is one
+		std::string filename;
+		std::string sourceFilename;
+		int arrayIndex;
+		int layer;
+		// true when the texture is loaded from its cooked file
+		bool bCooked;
+		// true when the image has an alpha channel
+		bool bHasAlpha;
+	};
+
+	// one texture array holding all of the same size textures
+	struct TEXTURE_ARRAY
+	{
+		GLuint textureID;
+		int width;
+		int height;
+		// GL_RGBA8 for decoded images, or the compressed format
+		// of the cooked files
+		GLenum internalFormat;
+		// mip levels stored in the cooked files - 0 when the
+		// mipmaps are generated by OpenGL
+		int levelCount;
+		int layerCount;
+		// true when layers changed since the mipmaps were made
+		bool bMipmapsDirty;
+	};
+
+	// decodes the image files on worker threads
+	TextureLoader* m_pTextureLoader;
+	// gives out the texture arrays
+	ResourcePool* m_pResourcePool;
+	// registered textures, indexed by their handles
+	std::vector<TEXTURE_ENTRY> m_textures;
+	// handles of the registered textures by tag
+	std::unordered_map<std::string, int> m_textureHandles;
+	// texture arrays, indexed by their texture units
+	std::vector<TEXTURE_ARRAY> m_arrays;
+	// true once the texture arrays have been allocated
+	bool m_bArraysCreated;
+
+	// true when the compressed formats of the cooked files
+	// can be used
+	bool m_bCompressedFormats;
+
+	// find or add the texture array for an image size, format
+	// and number of mip levels
+	int FindTextureArray(int width, int height, GLenum internalFormat, int levelCount);
+	// get the texture of a texture array from the pool, which
+	// already has the storage of the levels when it is reused
+	void AcquireArrayTexture(TEXTURE_ARRAY& textureArray, bool& bReused);
+	// allocate one texture array filled with placeholder texels
+	void CreateTextureArray(TEXTURE_ARRAY& textureArray);
+	void CreateCompressedTextureArray(TEXTURE_ARRAY& textureArray);
+	// upload one decoded image into its texture array layer
+	void UploadTextureImage(const TextureLoader::DECODED_IMAGE& image);
+	void UploadCookedTexture(const TextureLoader::DECODED_IMAGE& image);
+};
@@ -0,0 +1,241 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformkernel.cpp
+// ============
+// build the model matrices of many objects at once from their scale,
+// rotation and position - used for the render items that have moved
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformKernel.h"
+
+#include <cmath>
+#include <cstddef>
+
+// SSE2 is always there on x64, and is the default target of the
+// 32 bit compilers since Visual Studio 2012
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define TRANSFORM_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	const float g_DegreesToRadians = 3.14159265f / 180.0f;
+
+#ifdef TRANSFORM_KERNEL_SSE2
+	// pi / 2 split into three parts, so that the reduction of the
+	// angles into [-pi / 4, pi / 4] keeps its precision
+	const float g_HalfPi1 = 1.5703125f;
+	const float g_HalfPi2 = 4.837512969970703125e-4f;
+	const float g_HalfPi3 = 7.54978995489188216e-8f;
+	const float g_TwoOverPi = 0.636619772367581343f;
+
+	// polynomial coefficients of sine and cosine in [-pi / 4, pi / 4]
+	const float g_Sin1 = -1.6666654611e-1f;
+	const float g_Sin2 = 8.3321608736e-3f;
+	const float g_Sin3 = -1.9515295891e-4f;
+	const float g_Cos1 = 4.166664568298827e-2f;
+	const float g_Cos2 = -1.388731625493765e-3f;
+	const float g_Cos3 = 2.443315711809948e-5f;
+
+	/***********************************************************
+	 *  SinCos4()
+	 *
+	 *  This function is used for calculating the sine and the
+	 *  cosine of four angles in radians.  The angles are moved
+	 *  into [-pi / 4, pi / 4] by a multiple of pi / 2, whose
+	 *  quadrant swaps and negates the two results.
+	 ***********************************************************/
+	void SinCos4(__m128 angles, __m128& sines, __m128& cosines)
+	{
+		__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(angles, _mm_set1_ps(g_TwoOverPi)));
+		__m128 multiple = _mm_cvtepi32_ps(quadrant);
+
+		__m128 r = _mm_sub_ps(angles, _mm_mul_ps(multiple, _mm_set1_ps(g_HalfPi1)));
+		r = _mm_sub_ps(r, _mm_mul_ps(multiple, _mm_set1_ps(g_HalfPi2)));
+		r = _mm_sub_ps(r, _mm_mul_ps(multiple, _mm_set1_ps(g_HalfPi3)));
+		__m128 r2 = _mm_mul_ps(r, r);
+
+		__m128 sinPoly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(g_Sin3), r2), _mm_set1_ps(g_Sin2));
+		sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, r2), _mm_set1_ps(g_Sin1));
+		__m128 sinR = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(sinPoly, r2), r));
+
+		__m128 cosPoly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(g_Cos3), r2), _mm_set1_ps(g_Cos2));
+		cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, r2), _mm_set1_ps(g_Cos1));
+		__m128 cosR = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, _mm_set1_ps(0.5f)));
+		cosR = _mm_add_ps(cosR, _mm_mul_ps(_mm_mul_ps(cosPoly, r2), r2));
+
+		// odd quadrants swap the sine and the cosine
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(
+			_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+		__m128 sinValue = _mm_or_ps(_mm_and_ps(swap, cosR), _mm_andnot_ps(swap, sinR));
+		__m128 cosValue = _mm_or_ps(_mm_and_ps(swap, sinR), _mm_andnot_ps(swap, cosR));
+
+		// the sine is negative in quadrants 2 and 3, the cosine in
+		// quadrants 1 and 2
+		__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(
+			_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+		__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+			_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+		sines = _mm_xor_ps(sinValue, sinSign);
+		cosines = _mm_xor_ps(cosValue, cosSign);
+	}
+
+	/***********************************************************
+	 *  StoreColumns4()
+	 *
+	 *  This function is used for storing one column of four
+	 *  matrices, from the vectors that hold each row of the
+	 *  column for the four objects.
+	 ***********************************************************/
+	void StoreColumns4(glm::mat4* matrices, int column,
+		__m128 row0, __m128 row1, __m128 row2, __m128 row3)
+	{
+		_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+		_mm_storeu_ps(&matrices[0][column][0], row0);
+		_mm_storeu_ps(&matrices[1][column][0], row1);
+		_mm_storeu_ps(&matrices[2][column][0], row2);
+		_mm_storeu_ps(&matrices[3][column][0], row3);
+	}
+#endif
+}
+
+/***********************************************************
+ *  SOA_TRANSFORMS::Resize()
+ *
+ *  This method is used for changing the number of objects in
+ *  each of the arrays.
+ ***********************************************************/
+void TransformKernel::SOA_TRANSFORMS::Resize(size_t count)
+{
+	scaleX.resize(count);
+	scaleY.resize(count);
+	scaleZ.resize(count);
+	rotationX.resize(count);
+	rotationY.resize(count);
+	rotationZ.resize(count);
+	positionX.resize(count);
+	positionY.resize(count);
+	positionZ.resize(count);
+}
+
+/***********************************************************
+ *  SOA_TRANSFORMS::Set()
+ *
+ *  This method is used for setting the transformation values
+ *  of one object.
+ ***********************************************************/
+void TransformKernel::SOA_TRANSFORMS::Set(size_t index, const glm::vec3& scaleXYZ,
+	const glm::vec3& rotationDegrees, const glm::vec3& positionXYZ)
+{
+	scaleX[index] = scaleXYZ.x;
+	scaleY[index] = scaleXYZ.y;
+	scaleZ[index] = scaleXYZ.z;
+	rotationX[index] = rotationDegrees.x;
+	rotationY[index] = rotationDegrees.y;
+	rotationZ[index] = rotationDegrees.z;
+	positionX[index] = positionXYZ.x;
+	positionY[index] = positionXYZ.y;
+	positionZ[index] = positionXYZ.z;
+}
+
+/***********************************************************
+ *  ComputeModelMatrix()
+ *
+ *  This method is used for building the model matrix of one
+ *  object.  The columns of the combined rotation are written
+ *  out directly and multiplied by the scale of their axis,
+ *  and the position is the last column.
+ ***********************************************************/
+glm::mat4 TransformKernel::ComputeModelMatrix(
+	const glm::vec3& scaleXYZ,
+	const glm::vec3& rotationDegrees,
+	const glm::vec3& positionXYZ)
+{
+	float sx = sinf(rotationDegrees.x * g_DegreesToRadians);
+	float cx = cosf(rotationDegrees.x * g_DegreesToRadians);
+	float sy = sinf(rotationDegrees.y * g_DegreesToRadians);
+	float cy = cosf(rotationDegrees.y * g_DegreesToRadians);
+	float sz = sinf(rotationDegrees.z * g_DegreesToRadians);
+	float cz = cosf(rotationDegrees.z * g_DegreesToRadians);
+
+	glm::mat4 model;
+	model[0] = glm::vec4(cy * cz, cy * sz, -sy, 0.0f) * scaleXYZ.x;
+	model[1] = glm::vec4(cz * sy * sx - sz * cx, sz * sy * sx + cz * cx, cy * sx, 0.0f) * scaleXYZ.y;
+	model[2] = glm::vec4(cz * sy * cx + sz * sx, sz * sy * cx - cz * sx, cy * cx, 0.0f) * scaleXYZ.z;
+	model[3] = glm::vec4(positionXYZ, 1.0f);
+
+	return(model);
+}
+
+/***********************************************************
+ *  ComputeModelMatrices()
+ *
+ *  This method is used for building the model matrices of a
+ *  range of objects with the same formula as
+ *  ComputeModelMatrix().  With SSE the sines and cosines and
+ *  the matrix elements are calculated for four objects at a
+ *  time, and the matrices left over at the end are built one
+ *  at a time.
+ ***********************************************************/
+void TransformKernel::ComputeModelMatrices(
+	const SOA_TRANSFORMS& transforms,
+	size_t first,
+	size_t count,
+	glm::mat4* matrices)
+{
+	size_t i = 0;
+
+#ifdef TRANSFORM_KERNEL_SSE2
+	const __m128 toRadians = _mm_set1_ps(g_DegreesToRadians);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		size_t object = first + i;
+		__m128 sx, cx, sy, cy, sz, cz;
+		SinCos4(_mm_mul_ps(_mm_loadu_ps(&transforms.rotationX[object]), toRadians), sx, cx);
+		SinCos4(_mm_mul_ps(_mm_loadu_ps(&transforms.rotationY[object]), toRadians), sy, cy);
+		SinCos4(_mm_mul_ps(_mm_loadu_ps(&transforms.rotationZ[object]), toRadians), sz, cz);
+
+		__m128 scaleX = _mm_loadu_ps(&transforms.scaleX[object]);
+		__m128 scaleY = _mm_loadu_ps(&transforms.scaleY[object]);
+		__m128 scaleZ = _mm_loadu_ps(&transforms.scaleZ[object]);
+
+		// the products shared by the second and third columns
+		__m128 sysx = _mm_mul_ps(sy, sx);
+		__m128 sycx = _mm_mul_ps(sy, cx);
+
+		StoreColumns4(&matrices[i], 0,
+			_mm_mul_ps(_mm_mul_ps(cy, cz), scaleX),
+			_mm_mul_ps(_mm_mul_ps(cy, sz), scaleX),
+			_mm_mul_ps(_mm_sub_ps(zero, sy), scaleX),
+			zero);
+		StoreColumns4(&matrices[i], 1,
+			_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cz, sysx), _mm_mul_ps(sz, cx)), scaleY),
+			_mm_mul_ps(_mm_add_ps(_mm_mul_ps(sz, sysx), _mm_mul_ps(cz, cx)), scaleY),
+			_mm_mul_ps(_mm_mul_ps(cy, sx), scaleY),
+			zero);
+		StoreColumns4(&matrices[i], 2,
+			_mm_mul_ps(_mm_add_ps(_mm_mul_ps(cz, sycx), _mm_mul_ps(sz, sx)), scaleZ),
+			_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sz, sycx), _mm_mul_ps(cz, sx)), scaleZ),
+			_mm_mul_ps(_mm_mul_ps(cy, cx), scaleZ),
+			zero);
+		StoreColumns4(&matrices[i], 3,
+			_mm_loadu_ps(&transforms.positionX[object]),
+			_mm_loadu_ps(&transforms.positionY[object]),
+			_mm_loadu_ps(&transforms.positionZ[object]),
+			one);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		size_t object = first + i;
+		matrices[i] = ComputeModelMatrix(
+			glm::vec3(transforms.scaleX[object], transforms.scaleY[object], transforms.scaleZ[object]),
+			glm::vec3(transforms.rotationX[object], transforms.rotationY[object], transforms.rotationZ[object]),
+			glm::vec3(transforms.positionX[object], transforms.positionY[object], transforms.positionZ[object]));
+	}
+}
@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformkernel.h
+// ============
+// build the model matrices of many objects at once from their scale,
+// rotation and position - used for the render items that have moved
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  TransformKernel
+ *
+ *  This class contains the code for composing model matrices
+ *  directly from the scale, the X, Y and Z rotations and the
+ *  translation, without building and multiplying a matrix for
+ *  each of them.  The batch version works on the transforms
+ *  stored as separate arrays and builds four matrices at a
+ *  time with SSE when the compiler targets it.
+ ***********************************************************/
+class TransformKernel
+{
+public:
+	// the transformation values of many objects, with one array
+	// for each component - the rotations are in degrees
+	struct SOA_TRANSFORMS
+	{
+		std::vector<float> scaleX;
+		std::vector<float> scaleY;
+		std::vector<float> scaleZ;
+		std::vector<float> rotationX;
+		std::vector<float> rotationY;
+		std::vector<float> rotationZ;
+		std::vector<float> positionX;
+		std::vector<float> positionY;
+		std::vector<float> positionZ;
+
+		// change the number of objects in the arrays
+		void Resize(size_t count);
+		// set the values of one object
+		void Set(size_t index, const glm::vec3& scaleXYZ,
+			const glm::vec3& rotationDegrees, const glm::vec3& positionXYZ);
+	};
+
+	// build the matrix translation * rotationZ * rotationY *
+	// rotationX * scale for one object
+	static glm::mat4 ComputeModelMatrix(
+		const glm::vec3& scaleXYZ,
+		const glm::vec3& rotationDegrees,
+		const glm::vec3& positionXYZ);
+
+	// build the matrices of the objects from first up to first
+	// plus count, into the matrices array from its start
+	static void ComputeModelMatrices(
+		const SOA_TRANSFORMS& transforms,
+		size_t first,
+		size_t count,
+		glm::mat4* matrices);
+};
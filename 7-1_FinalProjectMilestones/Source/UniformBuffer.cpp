@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformbuffer.cpp
+// ============
+// manage the uniform buffer objects that are shared between shader programs
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformBuffer.h"
+
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// names of the uniform blocks in the shaders, in the order
+	// of the binding points
+	const char* g_BlockNames[] = {
+		"CameraBlock",
+		"LightBlock",
+		"MaterialBlock",
+		"ClusterBlock",
+		"ShadowBlock" };
+	const int g_BlockCount = 5;
+}
+
+/***********************************************************
+ *  UniformBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformBuffer::UniformBuffer(GLsizeiptr bufferSize, BINDING_POINT bindingPoint, bool bPerFrame)
+{
+	m_bufferSize = bufferSize;
+	m_bindingPoint = bindingPoint;
+	m_bufferID = 0;
+	m_pRingBuffer = NULL;
+	m_offsetAlignment = 1;
+
+	if (bPerFrame == true)
+	{
+		// every section holds one copy of the contents at an
+		// offset that can be bound to the uniform block
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_offsetAlignment);
+		m_offsetAlignment = (m_offsetAlignment > 0) ? m_offsetAlignment : 1;
+		GLsizeiptr sectionSize = ((m_bufferSize + m_offsetAlignment - 1) / m_offsetAlignment) * m_offsetAlignment;
+		m_pRingBuffer = new RingBuffer(GL_UNIFORM_BUFFER, sectionSize);
+		return;
+	}
+
+	glGenBuffers(1, &m_bufferID);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_bufferID);
+	glBufferData(GL_UNIFORM_BUFFER, m_bufferSize, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	// the binding point keeps the buffer attached for all of
+	// the shader programs that use the matching uniform block
+	glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, m_bufferID);
+}
+
+/***********************************************************
+ *  ~UniformBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformBuffer::~UniformBuffer()
+{
+	if (NULL != m_pRingBuffer)
+	{
+		delete m_pRingBuffer;
+		m_pRingBuffer = NULL;
+	}
+	if (m_bufferID != 0)
+	{
+		glDeleteBuffers(1, &m_bufferID);
+	}
+	m_bufferID = 0;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for uploading the passed in data into
+ *  the buffer at the passed in byte offset.  The contents of
+ *  a per-frame buffer are written into the next section of
+ *  its ring buffer, which is then bound to the uniform block.
+ ***********************************************************/
+void UniformBuffer::Update(const void* data, GLsizeiptr dataSize, GLintptr offset)
+{
+	if ((offset + dataSize) > m_bufferSize)
+	{
+		std::cout << "Uniform buffer update of " << dataSize << " bytes at offset " << offset
+			<< " exceeds the buffer size of " << m_bufferSize << " bytes" << std::endl;
+		return;
+	}
+
+	if (NULL != m_pRingBuffer)
+	{
+		GLintptr sectionOffset = 0;
+		m_pRingBuffer->BeginFrame();
+		char* pContents = (char*)m_pRingBuffer->Allocate(m_bufferSize, m_offsetAlignment, sectionOffset);
+		if (pContents != NULL)
+		{
+			memcpy(pContents + offset, data, dataSize);
+			m_pRingBuffer->Flush();
+			glBindBufferRange(GL_UNIFORM_BUFFER, m_bindingPoint, m_pRingBuffer->GetBuffer(), sectionOffset, m_bufferSize);
+		}
+		return;
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_bufferID);
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, dataSize, data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/***********************************************************
+ *  BindProgramBlocks()
+ *
+ *  This method is used for connecting the uniform blocks
+ *  declared in the passed in shader program to the binding
+ *  points of the shared uniform buffers.  Blocks that the
+ *  program does not declare are skipped.
+ ***********************************************************/
+void UniformBuffer::BindProgramBlocks(GLuint programID)
+{
+	for (int i = 0; i < g_BlockCount; i++)
+	{
+		GLuint blockIndex = glGetUniformBlockIndex(programID, g_BlockNames[i]);
+		if (blockIndex != GL_INVALID_INDEX)
+		{
+			glUniformBlockBinding(programID, blockIndex, i);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformbuffer.h
+// ============
+// manage the uniform buffer objects that are shared between shader programs
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RingBuffer.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  UniformBuffer
+ *
+ *  This class contains the code for creating a uniform
+ *  buffer object attached to a fixed binding point, and for
+ *  updating its contents with a single buffer upload.  Any
+ *  shader program with its uniform blocks connected through
+ *  BindProgramBlocks() reads the same buffer contents.  A
+ *  buffer updated every frame streams the contents through a
+ *  ring buffer instead, so the update never waits for the GPU
+ *  to finish reading the previous frame.
+ ***********************************************************/
+class UniformBuffer
+{
+public:
+	// binding points for the uniform blocks in the shaders
+	enum BINDING_POINT
+	{
+		CAMERA_BINDING = 0,
+		LIGHT_BINDING,
+		MATERIAL_BINDING,
+		CLUSTER_BINDING,
+		SHADOW_BINDING
+	};
+
+	// number of light sources in the light and shadow blocks,
+	// which needs to match TOTAL_LIGHTS in the fragment shader
+	static const int TOTAL_LIGHTS = 4;
+
+	// constructor - a per-frame buffer is fully updated once
+	// per frame
+	UniformBuffer(GLsizeiptr bufferSize, BINDING_POINT bindingPoint, bool bPerFrame = false);
+	// destructor
+	~UniformBuffer();
+
+	// upload the passed in data into the buffer
+	void Update(const void* data, GLsizeiptr dataSize, GLintptr offset = 0);
+
+	// connect the uniform blocks of a shader program to the
+	// binding points of the shared uniform buffers
+	static void BindProgramBlocks(GLuint programID);
+
+private:
+	// OpenGL handle of the buffer
+	GLuint m_bufferID;
+	// allocated size of the buffer in bytes
+	GLsizeiptr m_bufferSize;
+	// binding point the buffer is attached to
+	BINDING_POINT m_bindingPoint;
+	// sections of the per-frame contents, NULL for the buffers
+	// that are updated in place
+	RingBuffer* m_pRingBuffer;
+	// alignment of the offsets that can be bound to a uniform block
+	GLint m_offsetAlignment;
+};
@@ -0,0 +1,483 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.cpp
+// ============
+// cache the uniform locations of a shader program for handle based setting
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformCache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+
+/***********************************************************
+ *  UniformCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformCache::UniformCache()
+{
+	m_currentProgram = -1;
+#ifdef _DEBUG
+	m_bDebugReport = true;
+#else
+	m_bDebugReport = false;
+#endif
+}
+
+/***********************************************************
+ *  ~UniformCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformCache::~UniformCache()
+{
+	m_programs.clear();
+	m_uniforms.clear();
+}
+
+/***********************************************************
+ *  LoadProgramUniforms()
+ *
+ *  This method is used for reading the locations of all of
+ *  the active uniforms of the passed in shader program.  The
+ *  handles that were already given out are resolved against
+ *  the program as well.  Reading a program again reads the
+ *  locations of its slot again.
+ ***********************************************************/
+int UniformCache::LoadProgramUniforms(GLuint programID)
+{
+	int programSlot = (int)m_programs.size();
+	for (size_t i = 0; i < m_programs.size(); i++)
+	{
+		if (m_programs[i].programID == programID)
+		{
+			programSlot = (int)i;
+		}
+	}
+	if (programSlot == (int)m_programs.size())
+	{
+		m_programs.push_back(PROGRAM_UNIFORMS());
+	}
+
+	m_programs[programSlot].programID = programID;
+	ReadLocations(m_programs[programSlot]);
+
+	if (m_currentProgram < 0)
+	{
+		m_currentProgram = programSlot;
+	}
+
+	return(programSlot);
+}
+
+/***********************************************************
+ *  FindProgram()
+ *
+ *  This method is used for getting the slot that the passed
+ *  in shader program was read into.
+ ***********************************************************/
+int UniformCache::FindProgram(GLuint programID) const
+{
+	for (size_t i = 0; i < m_programs.size(); i++)
+	{
+		if (m_programs[i].programID == programID)
+		{
+			return((int)i);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  ReplaceProgram()
+ *
+ *  This method is used for putting a shader program that was
+ *  built again in the slot of the program that it replaces,
+ *  so the callers keep using the same slot.  The new program
+ *  starts with the default values of its uniforms, so all of
+ *  the kept values are set into it, right away when the slot
+ *  is the current one.
+ ***********************************************************/
+void UniformCache::ReplaceProgram(int programSlot, GLuint programID)
+{
+	if ((programSlot < 0) || (programSlot >= (int)m_programs.size()))
+	{
+		return;
+	}
+
+	m_programs[programSlot].programID = programID;
+	ReadLocations(m_programs[programSlot]);
+
+	if (programSlot == m_currentProgram)
+	{
+		m_currentProgram = -1;
+		UseProgram(programSlot);
+	}
+}
+
+/***********************************************************
+ *  ReadLocations()
+ *
+ *  This method is used for reading the locations of all of
+ *  the active uniforms of the program in a slot, and the
+ *  locations of the handles that were already given out.
+ ***********************************************************/
+void UniformCache::ReadLocations(PROGRAM_UNIFORMS& program)
+{
+	GLuint programID = program.programID;
+	program.activeUniforms.clear();
+
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<GLchar> nameBuffer(maxNameLength + 1);
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum uniformType = 0;
+
+		glGetActiveUniform(programID, i, (GLsizei)nameBuffer.size(),
+			&nameLength, &arraySize, &uniformType, nameBuffer.data());
+
+		std::string name(nameBuffer.data(), nameLength);
+		GLint location = glGetUniformLocation(programID, name.c_str());
+
+		// the uniforms inside of uniform blocks have no location
+		if (location < 0)
+		{
+			continue;
+		}
+
+		program.activeUniforms[name] = location;
+
+		// arrays are reported with the name of the first element,
+		// so also register the name of the array itself
+		size_t suffix = name.rfind("[0]");
+		if ((suffix != std::string::npos) && (suffix + 3 == name.size()))
+		{
+			program.activeUniforms[name.substr(0, suffix)] = location;
+		}
+	}
+
+	// none of the kept values are in the program yet
+	program.locations.assign(m_uniforms.size(), -1);
+	program.setCounts.assign(m_uniforms.size(), 0);
+	for (size_t i = 0; i < m_uniforms.size(); i++)
+	{
+		std::unordered_map<std::string, GLint>::const_iterator found =
+			program.activeUniforms.find(m_uniforms[i].name);
+		if (found != program.activeUniforms.end())
+		{
+			program.locations[i] = found->second;
+			m_uniforms[i].bPresent = true;
+		}
+	}
+}
+
+/***********************************************************
+ *  UseProgram()
+ *
+ *  This method is used for making the program in the passed
+ *  in slot the current program.  The values set while another
+ *  program was current are set into it, so the callers can
+ *  keep skipping the values that have not changed.
+ ***********************************************************/
+void UniformCache::UseProgram(int programSlot)
+{
+	if ((programSlot < 0) || (programSlot >= (int)m_programs.size()) ||
+		(programSlot == m_currentProgram))
+	{
+		return;
+	}
+
+	m_currentProgram = programSlot;
+	PROGRAM_UNIFORMS& program = m_programs[programSlot];
+	glUseProgram(program.programID);
+
+	for (size_t i = 0; i < m_uniforms.size(); i++)
+	{
+		const UNIFORM_INFO& uniform = m_uniforms[i];
+		if ((uniform.valueType != VALUE_NONE) &&
+			(program.locations[i] >= 0) &&
+			(program.setCounts[i] != uniform.setCount))
+		{
+			UploadValue(uniform, program.locations[i]);
+			program.setCounts[i] = uniform.setCount;
+		}
+	}
+}
+
+/***********************************************************
+ *  GetCurrentProgram()
+ *
+ *  This method is used for getting the slot of the current
+ *  program, or -1 when no program was read.
+ ***********************************************************/
+int UniformCache::GetCurrentProgram() const
+{
+	return(m_currentProgram);
+}
+
+/***********************************************************
+ *  GetHandle()
+ *
+ *  This method is used for getting the handle for the passed
+ *  in uniform name.  Asking for the same name again returns
+ *  the same handle.
+ ***********************************************************/
+UniformCache::HANDLE UniformCache::GetHandle(const std::string& uniformName)
+{
+	for (size_t i = 0; i < m_uniforms.size(); i++)
+	{
+		if (m_uniforms[i].name == uniformName)
+		{
+			return((HANDLE)i);
+		}
+	}
+
+	UNIFORM_INFO uniform;
+	uniform.name = uniformName;
+	uniform.bPresent = false;
+	uniform.missingSetCount = 0;
+	uniform.valueType = VALUE_NONE;
+	uniform.intValue = 0;
+	uniform.setCount = 0;
+
+	for (size_t i = 0; i < m_programs.size(); i++)
+	{
+		PROGRAM_UNIFORMS& program = m_programs[i];
+		std::unordered_map<std::string, GLint>::const_iterator found =
+			program.activeUniforms.find(uniformName);
+		GLint location = (found != program.activeUniforms.end()) ? found->second : -1;
+		program.locations.push_back(location);
+		program.setCounts.push_back(0);
+		if (location >= 0)
+		{
+			uniform.bPresent = true;
+		}
+	}
+
+	m_uniforms.push_back(uniform);
+	return((HANDLE)(m_uniforms.size() - 1));
+}
+
+/***********************************************************
+ *  SetDebugReport()
+ *
+ *  This method is used for turning the reporting of uniforms
+ *  that are set but not present in the program on or off.
+ ***********************************************************/
+void UniformCache::SetDebugReport(bool bDebugReport)
+{
+	m_bDebugReport = bDebugReport;
+}
+
+/***********************************************************
+ *  ReportMissingUniforms()
+ *
+ *  This method is used for outputting the uniforms that were
+ *  set while they are not present in any shader program -
+ *  either misspelled names or uniforms that the shader
+ *  compiler removed because they are unused.  A uniform that
+ *  only some of the programs have, such as a switch that a
+ *  specialized program turned into a constant, is not missing.
+ ***********************************************************/
+void UniformCache::ReportMissingUniforms() const
+{
+	for (size_t i = 0; i < m_uniforms.size(); i++)
+	{
+		if (m_uniforms[i].missingSetCount > 0)
+		{
+			std::cout << "Uniform " << m_uniforms[i].name << " was set "
+				<< m_uniforms[i].missingSetCount << " times but is not present in any of the "
+				<< m_programs.size() << " programs" << std::endl;
+		}
+	}
+}
+
+/***********************************************************
+ *  GetLocation()
+ *
+ *  This method is used for getting the uniform location for
+ *  the passed in handle in the current program.  In debug
+ *  mode the first set of a missing uniform is reported right
+ *  away.
+ ***********************************************************/
+GLint UniformCache::GetLocation(HANDLE handle)
+{
+	if ((handle < 0) || (handle >= (HANDLE)m_uniforms.size()) ||
+		(m_currentProgram < 0))
+	{
+		return(-1);
+	}
+
+	UNIFORM_INFO& uniform = m_uniforms[handle];
+	if ((uniform.bPresent == false) && (m_bDebugReport == true))
+	{
+		if (uniform.missingSetCount == 0)
+		{
+			std::cout << "Uniform " << uniform.name << " is set but is not present in any program"
+				<< std::endl;
+		}
+		uniform.missingSetCount++;
+	}
+
+	return(m_programs[m_currentProgram].locations[handle]);
+}
+
+/***********************************************************
+ *  StoreValue()
+ *
+ *  This method is used for keeping the passed in value of a
+ *  handle for the programs that are not current, and for
+ *  getting its location in the current program, which the
+ *  value is set into by the caller.
+ ***********************************************************/
+GLint UniformCache::StoreValue(HANDLE handle, VALUE_TYPE valueType, int intValue,
+	const float* pFloatValues, int floatCount)
+{
+	GLint location = GetLocation(handle);
+	if ((handle < 0) || (handle >= (HANDLE)m_uniforms.size()))
+	{
+		return(location);
+	}
+
+	UNIFORM_INFO& uniform = m_uniforms[handle];
+	uniform.valueType = valueType;
+	uniform.intValue = intValue;
+	for (int i = 0; i < floatCount; i++)
+	{
+		uniform.floatValues[i] = pFloatValues[i];
+	}
+	uniform.setCount++;
+
+	if (m_currentProgram >= 0)
+	{
+		m_programs[m_currentProgram].setCounts[handle] = uniform.setCount;
+	}
+
+	return(location);
+}
+
+/***********************************************************
+ *  UploadValue()
+ *
+ *  This method is used for setting the kept value of the
+ *  passed in uniform at a location of the current program.
+ ***********************************************************/
+void UniformCache::UploadValue(const UNIFORM_INFO& uniform, GLint location) const
+{
+	switch (uniform.valueType)
+	{
+	case VALUE_INT:
+		glUniform1i(location, uniform.intValue);
+		break;
+	case VALUE_FLOAT:
+		glUniform1f(location, uniform.floatValues[0]);
+		break;
+	case VALUE_VEC2:
+		glUniform2fv(location, 1, uniform.floatValues);
+		break;
+	case VALUE_VEC3:
+		glUniform3fv(location, 1, uniform.floatValues);
+		break;
+	case VALUE_VEC4:
+		glUniform4fv(location, 1, uniform.floatValues);
+		break;
+	case VALUE_MAT4:
+		glUniformMatrix4fv(location, 1, GL_FALSE, uniform.floatValues);
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  SetBoolValue()
+ *
+ *  This method is used for setting a bool uniform value.
+ ***********************************************************/
+void UniformCache::SetBoolValue(HANDLE handle, bool value)
+{
+	glUniform1i(StoreValue(handle, VALUE_INT, (int)value, NULL, 0), (int)value);
+}
+
+/***********************************************************
+ *  SetIntValue()
+ *
+ *  This method is used for setting an int uniform value.
+ ***********************************************************/
+void UniformCache::SetIntValue(HANDLE handle, int value)
+{
+	glUniform1i(StoreValue(handle, VALUE_INT, value, NULL, 0), value);
+}
+
+/***********************************************************
+ *  SetFloatValue()
+ *
+ *  This method is used for setting a float uniform value.
+ ***********************************************************/
+void UniformCache::SetFloatValue(HANDLE handle, float value)
+{
+	glUniform1f(StoreValue(handle, VALUE_FLOAT, 0, &value, 1), value);
+}
+
+/***********************************************************
+ *  SetVec2Value()
+ *
+ *  This method is used for setting a vec2 uniform value.
+ ***********************************************************/
+void UniformCache::SetVec2Value(HANDLE handle, const glm::vec2& value)
+{
+	GLint location = StoreValue(handle, VALUE_VEC2, 0, glm::value_ptr(value), 2);
+	glUniform2fv(location, 1, glm::value_ptr(value));
+}
+
+/***********************************************************
+ *  SetVec3Value()
+ *
+ *  This method is used for setting a vec3 uniform value.
+ ***********************************************************/
+void UniformCache::SetVec3Value(HANDLE handle, const glm::vec3& value)
+{
+	GLint location = StoreValue(handle, VALUE_VEC3, 0, glm::value_ptr(value), 3);
+	glUniform3fv(location, 1, glm::value_ptr(value));
+}
+
+/***********************************************************
+ *  SetVec4Value()
+ *
+ *  This method is used for setting a vec4 uniform value.
+ ***********************************************************/
+void UniformCache::SetVec4Value(HANDLE handle, const glm::vec4& value)
+{
+	GLint location = StoreValue(handle, VALUE_VEC4, 0, glm::value_ptr(value), 4);
+	glUniform4fv(location, 1, glm::value_ptr(value));
+}
+
+/***********************************************************
+ *  SetMat4Value()
+ *
+ *  This method is used for setting a mat4 uniform value.
+ ***********************************************************/
+void UniformCache::SetMat4Value(HANDLE handle, const glm::mat4& value)
+{
+	GLint location = StoreValue(handle, VALUE_MAT4, 0, glm::value_ptr(value), 16);
+	glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+/***********************************************************
+ *  SetSampler2DValue()
+ *
+ *  This method is used for setting the texture unit of a
+ *  sampler2D uniform.
+ ***********************************************************/
+void UniformCache::SetSampler2DValue(HANDLE handle, int textureUnit)
+{
+	glUniform1i(StoreValue(handle, VALUE_INT, textureUnit, NULL, 0), textureUnit);
+}
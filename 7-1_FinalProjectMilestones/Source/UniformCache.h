@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.h
+// ============
+// cache the uniform locations of a shader program for handle based setting
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  UniformCache
+ *
+ *  This class contains the code for resolving all of the
+ *  active uniforms of a shader program once, and for setting
+ *  uniform values through integer handles so that the draw
+ *  code never looks up uniforms by their names.  Several
+ *  programs can share the handles - the last value set
+ *  through each handle is kept, and is set into a program
+ *  when it is switched to and still has an older one.
+ ***********************************************************/
+class UniformCache
+{
+public:
+	// constructor
+	UniformCache();
+	// destructor
+	~UniformCache();
+
+	// handle of a uniform returned by GetHandle()
+	typedef int HANDLE;
+
+	// read the locations of all of the active uniforms of the
+	// passed in shader program, and return its slot - the first
+	// program read is the current program
+	int LoadProgramUniforms(GLuint programID);
+	// make the program in the passed in slot the current program,
+	// setting the values that changed since it was last current
+	void UseProgram(int programSlot);
+	// get the slot of the current program
+	int GetCurrentProgram() const;
+	// get the slot of the passed in shader program, -1 when it
+	// was not read
+	int FindProgram(GLuint programID) const;
+	// put a rebuilt shader program in the slot of the program
+	// it replaces, which gets all of the kept values again
+	void ReplaceProgram(int programSlot, GLuint programID);
+
+	// get the handle for the passed in uniform name - this is
+	// meant to be called once at initialization, not per draw
+	HANDLE GetHandle(const std::string& uniformName);
+
+	// turn the reporting of uniforms that are set but are
+	// not present in the shader program on or off
+	void SetDebugReport(bool bDebugReport);
+	// output the uniforms that were set but are not present
+	void ReportMissingUniforms() const;
+
+	// set the uniform values into the shader program, which
+	// needs to be the current program
+	void SetBoolValue(HANDLE handle, bool value);
+	void SetIntValue(HANDLE handle, int value);
+	void SetFloatValue(HANDLE handle, float value);
+	void SetVec2Value(HANDLE handle, const glm::vec2& value);
+	void SetVec3Value(HANDLE handle, const glm::vec3& value);
+	void SetVec4Value(HANDLE handle, const glm::vec4& value);
+	void SetMat4Value(HANDLE handle, const glm::mat4& value);
+	void SetSampler2DValue(HANDLE handle, int textureUnit);
+
+private:
+	// the kind of the last value set through a handle
+	enum VALUE_TYPE
+	{
+		VALUE_NONE = 0,
+		VALUE_INT,
+		VALUE_FLOAT,
+		VALUE_VEC2,
+		VALUE_VEC3,
+		VALUE_VEC4,
+		VALUE_MAT4
+	};
+
+	// one uniform that was requested through GetHandle()
+	struct UNIFORM_INFO
+	{
+		std::string name;
+		// true when the uniform is present in any of the programs
+		bool bPresent;
+		// number of times the uniform was set while not present
+		int missingSetCount;
+		// the last value set, and the number of values set
+		VALUE_TYPE valueType;
+		int intValue;
+		float floatValues[16];
+		unsigned int setCount;
+	};
+
+	// the uniforms of one shader program
+	struct PROGRAM_UNIFORMS
+	{
+		GLuint programID;
+		// locations of the active uniforms of the program by name
+		std::unordered_map<std::string, GLint> activeUniforms;
+		// location of each requested uniform, -1 when it is not
+		// present, and the set count of the value it holds
+		std::vector<GLint> locations;
+		std::vector<unsigned int> setCounts;
+	};
+
+	// all of the programs read, indexed by their slots
+	std::vector<PROGRAM_UNIFORMS> m_programs;
+	// slot of the current program
+	int m_currentProgram;
+	// requested uniforms, indexed by their handles
+	std::vector<UNIFORM_INFO> m_uniforms;
+	// true when missing uniforms are reported
+	bool m_bDebugReport;
+
+	// get the location in the current program for a handle,
+	// recording the set in debug mode when the uniform is not
+	// present in any program
+	GLint GetLocation(HANDLE handle);
+	// keep the passed in value of a handle, and get its location
+	// in the current program
+	GLint StoreValue(HANDLE handle, VALUE_TYPE valueType, int intValue,
+		const float* pFloatValues, int floatCount);
+	// read the locations of the active uniforms of the program
+	// in a slot, none of which hold the kept values yet
+	void ReadLocations(PROGRAM_UNIFORMS& program);
+	// set the kept value of a uniform at the passed in location
+	void UploadValue(const UNIFORM_INFO& uniform, GLint location) const;
+};
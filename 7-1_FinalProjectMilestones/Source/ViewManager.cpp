@@ -20,8 +20,10 @@ namespace
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
+	// size of the rendered view in pixels, which follows the
+	// framebuffer of the window when it is resized
+	int gViewWidth = WINDOW_WIDTH;
+	int gViewHeight = WINDOW_HEIGHT;
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -35,6 +37,20 @@ namespace
 	// time between current frame and last frame
 	float gDeltaTime = 0.0f; 
 	float gLastFrame = 0.0f;
+	// longest time between frames that moves the camera, so the
+	// first frame after the window was idle does not jump
+	const float MAX_DELTA_TIME = 0.1f;
+
+	// true when the camera has moved or the window contents need
+	// to be drawn again since the last TakeViewChanges() call
+	bool gViewChanged = true;
+	// the keys handled by ProcessKeyboardEvents(), which act on
+	// every frame while they are held
+	const int CAMERA_KEYS[] = {
+		GLFW_KEY_ESCAPE,
+		GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_Q, GLFW_KEY_E,
+		GLFW_KEY_P, GLFW_KEY_O };
+	const int CAMERA_KEY_COUNT = sizeof(CAMERA_KEYS) / sizeof(CAMERA_KEYS[0]);
 
 	// mouse scroll camera movement speed variables
 	float gMovementSpeed = 2.5f;
@@ -57,6 +73,13 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	// the camera buffer is created on the first PrepareSceneView()
+	// call, since OpenGL is not yet initialized at this point
+	m_pCameraBuffer = NULL;
+	m_bProcessInput = true;
+	m_view = glm::mat4(1.0f);
+	m_projection = glm::mat4(1.0f);
+	m_aspectRatio = (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT;
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
@@ -76,6 +99,11 @@ ViewManager::~ViewManager()
 	// free up allocated memory
 	m_pShaderManager = NULL;
 	m_pWindow = NULL;
+	if (NULL != m_pCameraBuffer)
+	{
+		delete m_pCameraBuffer;
+		m_pCameraBuffer = NULL;
+	}
 	if (NULL != g_pCamera)
 	{
 		delete g_pCamera;
@@ -87,11 +115,15 @@ ViewManager::~ViewManager()
  *  CreateDisplayWindow()
  *
  *  This method is used to create the main display window.
+ *  A hidden window is used by the benchmark, which renders
+ *  offscreen and moves the camera itself.
  ***********************************************************/
-GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
+GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle, bool bHidden)
 {
 	GLFWwindow* window = nullptr;
 
+	glfwWindowHint(GLFW_VISIBLE, bHidden ? GLFW_FALSE : GLFW_TRUE);
+
 	// try to create the displayed OpenGL window
 	window = glfwCreateWindow(
 		WINDOW_WIDTH,
@@ -106,15 +138,30 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	}
 	glfwMakeContextCurrent(window);
 
-	// tell GLFW to capture all mouse events
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	// the framebuffer has more pixels than the window size on
+	// high density displays
+	glfwGetFramebufferSize(window, &gViewWidth, &gViewHeight);
 
-	// this callback is used to receive mouse moving events
-	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
+	m_bProcessInput = (bHidden == false);
+	if (m_bProcessInput == true)
+	{
+		// tell GLFW to capture all mouse events
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+		// this callback is used to receive mouse moving events
+		glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
 
-	// enable blending for supporting tranparent rendering
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		// this callback is used to receive the window exposed
+		// and resized events, which need the view drawn again
+		glfwSetWindowRefreshCallback(window, &ViewManager::Window_Refresh_Callback);
+
+		// this callback is used to receive the new size of the
+		// window framebuffer when the window is resized
+		glfwSetFramebufferSizeCallback(window, &ViewManager::Framebuffer_Size_Callback);
+	}
+
+	// blending is only turned on by the transparent pass of the
+	// scene render, so the opaque objects are drawn without it
 
 	m_pWindow = window;
 
@@ -149,6 +196,7 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
 
 	// move the 3D camera according to the calculated offsets
 	g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+	gViewChanged = true;
 }
 /***********************************************************
  *  Mouse_Scroll_Callback()
@@ -174,6 +222,33 @@ void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, doub
 
 	// move camera according to current speed setting
 	g_pCamera->ProcessMouseScroll(gMovementSpeed);
+	gViewChanged = true;
+}
+
+/***********************************************************
+ *  Window_Refresh_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the contents of the window need to be drawn again, such
+ *  as after it was uncovered or resized.
+ ***********************************************************/
+void ViewManager::Window_Refresh_Callback(GLFWwindow* window)
+{
+	gViewChanged = true;
+}
+
+/***********************************************************
+ *  Framebuffer_Size_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the framebuffer of the window changes size.  The size is
+ *  0 while the window is minimized.
+ ***********************************************************/
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow* window, int width, int height)
+{
+	gViewWidth = width;
+	gViewHeight = height;
+	gViewChanged = true;
 }
 
 /***********************************************************
@@ -245,6 +320,129 @@ void ViewManager::ProcessKeyboardEvents()
 
 }
 
+/***********************************************************
+ *  GetViewWidth()
+ *
+ *  This method is used for getting the width of the
+ *  rendered view.
+ ***********************************************************/
+int ViewManager::GetViewWidth() const
+{
+	return(gViewWidth);
+}
+
+/***********************************************************
+ *  GetViewHeight()
+ *
+ *  This method is used for getting the height of the
+ *  rendered view.
+ ***********************************************************/
+int ViewManager::GetViewHeight() const
+{
+	return(gViewHeight);
+}
+
+/***********************************************************
+ *  SetViewSize()
+ *
+ *  This method is used for setting the size of the rendered
+ *  view, which the projection takes its aspect ratio from,
+ *  for the benchmark rendering offscreen at another size
+ *  than the window.
+ ***********************************************************/
+void ViewManager::SetViewSize(int width, int height)
+{
+	gViewWidth = width;
+	gViewHeight = height;
+	gViewChanged = true;
+}
+
+/***********************************************************
+ *  SetCameraPose()
+ *
+ *  This method is used for placing the camera at a position
+ *  and turning it toward a target, as done by the scripted
+ *  camera path of the benchmark.
+ ***********************************************************/
+void ViewManager::SetCameraPose(glm::vec3 position, glm::vec3 target)
+{
+	g_pCamera->Position = position;
+	g_pCamera->Front = glm::normalize(target - position);
+	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+/***********************************************************
+ *  TakeViewChanges()
+ *
+ *  This method is used for checking whether the view needs
+ *  to be drawn again, because the camera was moved by the
+ *  mouse or the window was uncovered since the last call, or
+ *  because a camera key is held down.  The recorded changes
+ *  are cleared.
+ ***********************************************************/
+bool ViewManager::TakeViewChanges()
+{
+	bool bChanged = gViewChanged;
+	gViewChanged = false;
+
+	if (m_bProcessInput == true)
+	{
+		for (int i = 0; i < CAMERA_KEY_COUNT; i++)
+		{
+			if (glfwGetKey(m_pWindow, CAMERA_KEYS[i]) == GLFW_PRESS)
+			{
+				bChanged = true;
+			}
+		}
+	}
+
+	return(bChanged);
+}
+
+/***********************************************************
+ *  GetViewMatrix()
+ *
+ *  This method is used for getting the view matrix of the
+ *  last prepared scene view.
+ ***********************************************************/
+const glm::mat4& ViewManager::GetViewMatrix() const
+{
+	return(m_view);
+}
+
+/***********************************************************
+ *  GetProjectionMatrix()
+ *
+ *  This method is used for getting the projection matrix of
+ *  the last prepared scene view.
+ ***********************************************************/
+const glm::mat4& ViewManager::GetProjectionMatrix() const
+{
+	return(m_projection);
+}
+
+/***********************************************************
+ *  GetPickRay()
+ *
+ *  This method is used for getting the world space ray
+ *  through a point of the view, by unprojecting the point on
+ *  the near and the far planes of the last prepared view.
+ ***********************************************************/
+void ViewManager::GetPickRay(double xPosition, double yPosition, glm::vec3& origin, glm::vec3& direction) const
+{
+	float x = (2.0f * (float)xPosition) / gViewWidth - 1.0f;
+	float y = 1.0f - (2.0f * (float)yPosition) / gViewHeight;
+	glm::mat4 inverseViewProjection = glm::inverse(m_projection * m_view);
+
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(x, y, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(x, y, 1.0f, 1.0f);
+	nearPoint /= nearPoint.w;
+	farPoint /= farPoint.w;
+
+	origin = glm::vec3(nearPoint);
+	direction = glm::normalize(glm::vec3(farPoint) - glm::vec3(nearPoint));
+}
+
 /***********************************************************
  *  PrepareSceneView()
  *
@@ -261,25 +459,44 @@ void ViewManager::PrepareSceneView()
 	float currentFrame = glfwGetTime();
 	gDeltaTime = currentFrame - gLastFrame;
 	gLastFrame = currentFrame;
+	if (gDeltaTime > MAX_DELTA_TIME)
+	{
+		gDeltaTime = MAX_DELTA_TIME;
+	}
 
 	// process any keyboard events that may be waiting in the 
 	// event queue
-	ProcessKeyboardEvents();
+	if (m_bProcessInput == true)
+	{
+		ProcessKeyboardEvents();
+	}
 
 	// get the current view matrix from the camera
 	view = g_pCamera->GetViewMatrix();
 
-	// define the current projection matrix
-	projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+	// define the current projection matrix, keeping the last
+	// aspect ratio while the window is minimized
+	if ((gViewWidth > 0) && (gViewHeight > 0))
+	{
+		m_aspectRatio = (GLfloat)gViewWidth / (GLfloat)gViewHeight;
+	}
+	projection = glm::perspective(glm::radians(g_pCamera->Zoom), m_aspectRatio, 0.1f, 100.0f);
 
-	// if the shader manager object is valid
-	if (NULL != m_pShaderManager)
+	if (NULL == m_pCameraBuffer)
 	{
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		m_pCameraBuffer = new UniformBuffer(sizeof(CAMERA_BLOCK), UniformBuffer::CAMERA_BINDING, true);
 	}
+
+	// set the view matrix, projection matrix and view position
+	// of the camera into the shaders with one buffer update
+	CAMERA_BLOCK cameraBlock;
+	cameraBlock.view = view;
+	cameraBlock.projection = projection;
+	cameraBlock.viewPosition = g_pCamera->Position;
+	cameraBlock.padding = 0.0f;
+	m_pCameraBuffer->Update(&cameraBlock, sizeof(cameraBlock));
+
+	// kept for culling the 3D scene against the view
+	m_view = view;
+	m_projection = projection;
 }
\ No newline at end of file
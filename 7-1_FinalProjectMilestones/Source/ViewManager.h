@@ -11,6 +11,7 @@
 
 #include "ShaderManager.h"
 #include "camera.h"
+#include "UniformBuffer.h"
 
 // GLFW library
 #include "GLFW/glfw3.h" 
@@ -28,19 +29,61 @@ public:
 	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
 	// adding method for mouse scroll functionality to increase/decrease camera speed
 	static void Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset); 
+	// window refresh callback for when the window contents need to be drawn again
+	static void Window_Refresh_Callback(GLFWwindow* window);
+	// framebuffer size callback for when the window is resized
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
+
+	// the per-frame camera values as laid out in the std140
+	// camera block of the shaders - 144 bytes
+	struct CAMERA_BLOCK
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::vec3 viewPosition;
+		float padding;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// uniform buffer holding the per-frame camera values
+	UniformBuffer* m_pCameraBuffer;
+	// false when the camera is only moved by SetCameraPose()
+	bool m_bProcessInput;
+	// view and projection of the last PrepareSceneView() call
+	glm::mat4 m_view;
+	glm::mat4 m_projection;
+	// width over height of the rendered view
+	float m_aspectRatio;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
 
 public:
-	// create the initial OpenGL display window
-	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
-	
+	// create the initial OpenGL display window - a hidden window
+	// takes no input and is only used for its OpenGL context
+	GLFWwindow* CreateDisplayWindow(const char* windowTitle, bool bHidden = false);
+	// get the size of the rendered view
+	int GetViewWidth() const;
+	int GetViewHeight() const;
+	// set the size of the rendered view, which otherwise follows
+	// the window
+	void SetViewSize(int width, int height);
+	// place the camera at a position looking at a target
+	void SetCameraPose(glm::vec3 position, glm::vec3 target);
+	// check whether the camera has moved or the window needs to
+	// be drawn again since the last call, or a camera key is held
+	bool TakeViewChanges();
+	// get the view and projection of the prepared scene view
+	const glm::mat4& GetViewMatrix() const;
+	const glm::mat4& GetProjectionMatrix() const;
+	// get the world space ray through a point of the view, in
+	// pixels from the top left corner
+	void GetPickRay(double xPosition, double yPosition, glm::vec3& origin, glm::vec3& direction) const;
+
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
 };
\ No newline at end of file
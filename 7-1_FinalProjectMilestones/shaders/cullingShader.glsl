@@ -0,0 +1,190 @@
+#version 430 core
+
+// one thread for each object of the static batches
+layout (local_size_x = 64) in;
+
+// these need to match the values in GpuCuller and SceneManager
+const int MAX_LODS = 4;
+const int LOD_SCREEN_SIZE_COUNT = 3;
+
+// one object of the static batches, with its world space box
+// and the index range of each level of detail
+struct ObjectData
+{
+    vec4 boundsMin;
+    vec4 boundsMax;
+    uvec4 firstIndex;
+    uvec4 indexCount;
+    uint drawGroup;
+    uint lodCount;
+    // level of detail of the last frame, for the hysteresis
+    uint lodLevel;
+    // 0 when the object is no longer drawn from the batches
+    uint enabled;
+};
+
+// the command layout read by glMultiDrawElementsIndirect
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 0) buffer ObjectBuffer
+{
+    ObjectData objects[];
+};
+
+// first command of each draw group in the command buffer
+layout (std430, binding = 1) readonly buffer GroupBuffer
+{
+    uint groupFirstCommand[];
+};
+
+// number of commands written for each draw group
+layout (std430, binding = 2) buffer CountBuffer
+{
+    uint drawCounts[];
+};
+
+layout (std430, binding = 3) writeonly buffer CommandBuffer
+{
+    DrawCommand commands[];
+};
+
+uniform uint objectCount;
+uniform bool bFrustumCulling = true;
+// the left, right, bottom, top, near and far planes with the
+// normals pointing inward
+uniform vec4 frustumPlanes[6];
+uniform vec3 viewPosition;
+uniform float lodScale;
+uniform float lodScreenSizes[LOD_SCREEN_SIZE_COUNT];
+uniform float lodHysteresis;
+
+// the farthest depths of the last frame, with the view projection
+// and the size in pixels of the view they were built from - the
+// first level holds 2x2 pixels per texel
+uniform bool bOcclusionCulling = false;
+uniform sampler2D depthPyramid;
+uniform mat4 pyramidViewProjection;
+uniform vec2 pyramidViewSize;
+uniform int pyramidLevelCount;
+
+// check whether a box was behind the depth of the last frame
+// everywhere that it covered - a box reaching behind the camera or
+// out of the last view may show parts that were never drawn, and
+// is never hidden
+bool IsBoxOccluded(vec3 boundsMin, vec3 boundsMax)
+{
+    vec3 ndcMin = vec3(1.0f);
+    vec3 ndcMax = vec3(-1.0f);
+    for (int i = 0; i < 8; i++)
+    {
+        vec3 corner = mix(boundsMin, boundsMax, vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+        vec4 clipCorner = pyramidViewProjection * vec4(corner, 1.0f);
+        if (clipCorner.w <= 0.0f)
+        {
+            return(false);
+        }
+        vec3 ndcCorner = clipCorner.xyz / clipCorner.w;
+        ndcMin = min(ndcMin, ndcCorner);
+        ndcMax = max(ndcMax, ndcCorner);
+    }
+    if (any(lessThan(ndcMin.xy, vec2(-1.0f))) || any(greaterThan(ndcMax.xy, vec2(1.0f))))
+    {
+        return(false);
+    }
+
+    // the level where the box covers at most 2x2 texels
+    vec2 pixelMin = (ndcMin.xy * 0.5f + 0.5f) * pyramidViewSize;
+    vec2 pixelMax = (ndcMax.xy * 0.5f + 0.5f) * pyramidViewSize;
+    vec2 texelExtent = (pixelMax - pixelMin) * 0.5f;
+    int level = int(ceil(log2(max(max(texelExtent.x, texelExtent.y), 1.0f))));
+    level = clamp(level, 0, pyramidLevelCount - 1);
+
+    ivec2 levelSize = textureSize(depthPyramid, level);
+    ivec2 texelMin = min(ivec2(pixelMin * 0.5f) >> level, levelSize - 1);
+    ivec2 texelMax = min(ivec2(pixelMax * 0.5f) >> level, levelSize - 1);
+    float farthest = 0.0f;
+    for (int y = texelMin.y; y <= texelMax.y; y++)
+    {
+        for (int x = texelMin.x; x <= texelMax.x; x++)
+        {
+            farthest = max(farthest, texelFetch(depthPyramid, ivec2(x, y), level).r);
+        }
+    }
+
+    // the nearest depth of the box in the depth range of the window
+    return((ndcMin.z * 0.5f + 0.5f) > farthest);
+}
+
+void main()
+{
+    uint objectIndex = gl_GlobalInvocationID.x;
+    if (objectIndex >= objectCount)
+    {
+        return;
+    }
+
+    ObjectData object = objects[objectIndex];
+    if (object.enabled == 0u)
+    {
+        return;
+    }
+
+    // only the corner furthest along each plane normal is tested
+    vec3 boundsMin = object.boundsMin.xyz;
+    vec3 boundsMax = object.boundsMax.xyz;
+    if (bFrustumCulling == true)
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            vec3 corner = mix(boundsMin, boundsMax, step(0.0f, frustumPlanes[i].xyz));
+            if (dot(frustumPlanes[i].xyz, corner) + frustumPlanes[i].w < 0.0f)
+            {
+                return;
+            }
+        }
+    }
+
+    if ((bOcclusionCulling == true) && (IsBoxOccluded(boundsMin, boundsMax) == true))
+    {
+        return;
+    }
+
+    // the same screen size rules as SceneManager::SelectLevelsOfDetail()
+    int maxLevel = min(int(object.lodCount) - 1, LOD_SCREEN_SIZE_COUNT);
+    int level = 0;
+    if (maxLevel > 0)
+    {
+        vec3 center = (boundsMin + boundsMax) * 0.5f;
+        float radius = length(boundsMax - boundsMin) * 0.5f;
+        float distance = max(length(center - viewPosition), 0.001f);
+        float screenSize = radius * lodScale / distance;
+
+        level = min(int(object.lodLevel), maxLevel);
+        while ((level > 0) && (screenSize > lodScreenSizes[level - 1] * (1.0f + lodHysteresis)))
+        {
+            level--;
+        }
+        while ((level < maxLevel) && (screenSize < lodScreenSizes[level] * (1.0f - lodHysteresis)))
+        {
+            level++;
+        }
+        objects[objectIndex].lodLevel = uint(level);
+    }
+
+    // append the command to the visible commands of its group
+    uint slot = atomicAdd(drawCounts[object.drawGroup], 1u);
+    DrawCommand command;
+    command.count = object.indexCount[level];
+    command.instanceCount = 1u;
+    command.firstIndex = object.firstIndex[level];
+    command.baseVertex = 0;
+    command.baseInstance = 0u;
+    commands[groupFirstCommand[object.drawGroup] + slot] = command;
+}
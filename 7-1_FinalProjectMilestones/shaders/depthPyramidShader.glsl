@@ -0,0 +1,50 @@
+#version 430 core
+
+// one thread for each texel of the level being written
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// the copy of the depth of the view, read for the first level
+uniform sampler2D viewDepth;
+// the level before the one being written, read for the others
+layout (r32f, binding = 0) readonly uniform image2D sourceLevel;
+layout (r32f, binding = 1) writeonly uniform image2D targetLevel;
+
+// true for the first level, which reads the depth of the view
+uniform bool bFromViewDepth = true;
+// size in texels of the depth or level that is read - only the
+// first level can end partway through its last block
+uniform ivec2 sourceSize;
+
+void main()
+{
+    ivec2 target = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(target, imageSize(targetLevel))))
+    {
+        return;
+    }
+
+    // each texel keeps the farthest depth of the 2x2 texels below
+    // it, and the texels past the view hold the far plane
+    float farthest = 0.0f;
+    bool bInside = false;
+    for (int y = 0; y < 2; y++)
+    {
+        for (int x = 0; x < 2; x++)
+        {
+            ivec2 source = target * 2 + ivec2(x, y);
+            if (all(lessThan(source, sourceSize)))
+            {
+                float depth = (bFromViewDepth == true) ?
+                    texelFetch(viewDepth, source, 0).r : imageLoad(sourceLevel, source).r;
+                farthest = max(farthest, depth);
+                bInside = true;
+            }
+        }
+    }
+    if (bInside == false)
+    {
+        farthest = 1.0f;
+    }
+
+    imageStore(targetLevel, target, vec4(farthest));
+}
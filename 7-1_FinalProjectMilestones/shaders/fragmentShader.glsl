@@ -0,0 +1,365 @@
+#version 330 core
+
+// the point lights are binned into clusters of the view when the
+// context has shader storage buffers, otherwise only the fixed
+// light sources are used
+#extension GL_ARB_shader_storage_buffer_object : enable
+
+// the members of the block structs are ordered so that the std140
+// layout matches the structs that are uploaded by the application
+struct Material
+{
+    vec3 ambientColor;
+    float ambientStrength;
+    vec3 diffuseColor;
+    float shininess;
+    vec3 specularColor;
+};
+
+struct LightSource
+{
+    vec3 position;
+    float focalStrength;
+    vec3 ambientColor;
+    float specularIntensity;
+    vec3 diffuseColor;
+    // layer of the shadow maps of the light, -1 for no shadows
+    float shadowLayer;
+    vec3 specularColor;
+};
+
+#define TOTAL_LIGHTS 4
+// the number of light sources that the scene defines, which a
+// specialized variant sets so that the unused ones are not lit
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT TOTAL_LIGHTS
+#endif
+#define MAX_MATERIALS 256
+// the light count of a cluster followed by its light indices, which
+// needs to match the value in ClusteredLights
+#define CLUSTER_STRIDE 64u
+// the most cascades of the sun, which needs to match the value in
+// ShadowMaps
+#define MAX_CASCADES 4
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+flat in vec4 fragmentObjectColor;
+flat in vec2 fragmentUVscale;
+flat in float fragmentTextureLayer;
+
+out vec4 outFragmentColor;
+
+// a specialized variant of the program defines SPECIALIZED and the
+// values of the switches below, which turns them into constants so
+// that the compiler removes the code they switch off - otherwise
+// the switches are uniforms that are tested for every fragment
+#ifdef SPECIALIZED
+const bool bUseTexture = USE_TEXTURE;
+const bool bUseLighting = USE_LIGHTING;
+const bool bUseClusteredLights = USE_CLUSTERED_LIGHTS;
+const bool bDepthOnly = DEPTH_ONLY;
+const bool bUseShadows = USE_SHADOWS;
+#else
+uniform bool bUseTexture = false;
+uniform bool bUseLighting = false;
+// true when the point lights have been binned into the clusters
+uniform bool bUseClusteredLights = false;
+// true for the depth prepass, which only needs the depth of the
+// fragments and skips all of the shading
+uniform bool bDepthOnly = false;
+// true when the shadow maps have been created
+uniform bool bUseShadows = false;
+#endif
+// texture array holding the object texture in one of its layers
+uniform sampler2DArray objectTexture;
+// index of the object material in the material block
+uniform int materialIndex = 0;
+// the shadow maps of the objects that never move and of the moving
+// objects, with a layer for each light source with shadows, and the
+// cascades of the sun split the same way
+uniform sampler2DArrayShadow staticShadowMaps;
+uniform sampler2DArrayShadow dynamicShadowMaps;
+uniform sampler2DArrayShadow sunShadowMaps;
+uniform sampler2DArrayShadow dynamicSunShadowMaps;
+
+// per-frame camera values, shared by all of the shader programs
+layout (std140) uniform CameraBlock
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosition;
+};
+
+// per-scene light sources
+layout (std140) uniform LightBlock
+{
+    LightSource lightSources[TOTAL_LIGHTS];
+};
+
+// all of the defined object materials
+layout (std140) uniform MaterialBlock
+{
+    Material materials[MAX_MATERIALS];
+};
+
+// light space matrices of the shadow maps and the sun
+layout (std140) uniform ShadowBlock
+{
+    mat4 lightMatrices[TOTAL_LIGHTS];
+    mat4 cascadeMatrices[MAX_CASCADES];
+    vec4 cascadeEnds;
+    // direction towards the sun, with w 1 when there is a sun
+    vec4 sunDirection;
+    // color of the sun, with its specular intensity in w
+    vec4 sunColor;
+    int cascadeCount;
+    bool bDynamicShadows;
+    float normalOffset;
+};
+
+#ifdef GL_ARB_shader_storage_buffer_object
+struct PointLight
+{
+    vec3 position;
+    float radius;
+    vec3 color;
+    float specularIntensity;
+};
+
+// per-frame cluster values
+layout (std140) uniform ClusterBlock
+{
+    mat4 inverseProjection;
+    vec2 viewSize;
+    float sliceScale;
+    float sliceBias;
+    float nearDistance;
+    float farDistance;
+    int tileSize;
+    int lightCount;
+    int tilesX;
+    int tilesY;
+    int slices;
+};
+
+// all of the point lights of the 3D scene
+layout (std430) buffer PointLightBlock
+{
+    PointLight pointLights[];
+};
+
+// the lights reaching each cluster, written by the binning shader
+layout (std430) buffer ClusterLightBlock
+{
+    uint clusterLights[];
+};
+
+// function prototypes
+vec3 CalcPointLight(PointLight light, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection);
+#endif
+
+// function prototypes
+vec3 CalcLightSource(LightSource light, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection, float shadow);
+vec3 CalcSunLight(Material material, vec3 lightNormal, vec3 viewDirection);
+float CalcLightShadow(int lightIndex, float layer, vec3 shadowPosition);
+float CalcSunShadow(vec3 shadowPosition);
+
+void main()
+{
+    if (bDepthOnly == true)
+    {
+        outFragmentColor = vec4(0.0f);
+        return;
+    }
+
+    vec4 baseColor = fragmentObjectColor;
+    if (bUseTexture == true)
+    {
+        baseColor = texture(objectTexture, vec3(fragmentTextureCoordinate * fragmentUVscale, fragmentTextureLayer));
+    }
+
+    if (bUseLighting == true)
+    {
+        vec3 lightNormal = normalize(fragmentVertexNormal);
+        vec3 viewDirection = normalize(viewPosition - fragmentPosition);
+        vec3 phongResult = vec3(0.0f);
+        Material material = materials[materialIndex];
+        // the shadow maps are looked up a little way out along the
+        // normal, so that the surfaces do not shadow themselves
+        vec3 shadowPosition = fragmentPosition + lightNormal * normalOffset;
+
+        for (int i = 0; i < LIGHT_COUNT; i++)
+        {
+            float shadow = 1.0f;
+            if ((bUseShadows == true) && (lightSources[i].shadowLayer >= 0.0f))
+            {
+                shadow = CalcLightShadow(i, lightSources[i].shadowLayer, shadowPosition);
+            }
+            phongResult += CalcLightSource(lightSources[i], material, lightNormal, fragmentPosition, viewDirection, shadow);
+        }
+
+        if (sunDirection.w > 0.0f)
+        {
+            float shadow = 1.0f;
+            if ((bUseShadows == true) && (cascadeCount > 0))
+            {
+                shadow = CalcSunShadow(shadowPosition);
+            }
+            phongResult += CalcSunLight(material, lightNormal, viewDirection) * shadow;
+        }
+
+#ifdef GL_ARB_shader_storage_buffer_object
+        // only the point lights binned into the cluster of this
+        // pixel are added, however many lights the scene has
+        if (bUseClusteredLights == true)
+        {
+            float viewDepth = -(view * vec4(fragmentPosition, 1.0f)).z;
+            int tileX = min(int(gl_FragCoord.x) / tileSize, tilesX - 1);
+            int tileY = min(int(gl_FragCoord.y) / tileSize, tilesY - 1);
+            int slice = clamp(int(log(max(viewDepth, nearDistance)) * sliceScale + sliceBias), 0, slices - 1);
+            uint listStart = uint(tileX + (tileY + slice * tilesY) * tilesX) * CLUSTER_STRIDE;
+
+            uint count = clusterLights[listStart];
+            for (uint i = 0u; i < count; i++)
+            {
+                PointLight light = pointLights[clusterLights[listStart + 1u + i]];
+                phongResult += CalcPointLight(light, material, lightNormal, fragmentPosition, viewDirection);
+            }
+        }
+#endif
+
+        outFragmentColor = vec4(phongResult * baseColor.xyz, baseColor.w);
+    }
+    else
+    {
+        outFragmentColor = baseColor;
+    }
+}
+
+// calculate the phong lighting contribution of one light source, with
+// the diffuse and specular lighting darkened by its shadow
+vec3 CalcLightSource(LightSource light, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection, float shadow)
+{
+    // ambient lighting
+    vec3 ambient = light.ambientColor * material.ambientColor * material.ambientStrength;
+
+    // diffuse lighting
+    vec3 lightDirection = normalize(light.position - vertexPosition);
+    float impact = max(dot(lightNormal, lightDirection), 0.0f);
+    vec3 diffuse = impact * light.diffuseColor * material.diffuseColor;
+
+    // specular lighting
+    vec3 reflectDirection = reflect(-lightDirection, lightNormal);
+    float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f), light.focalStrength);
+    vec3 specular = light.specularIntensity * specularComponent * light.specularColor * material.specularColor;
+
+    return(ambient + (diffuse + specular) * shadow);
+}
+
+// calculate the phong lighting contribution of the sun, which shines
+// from the same direction on every fragment and adds no ambient light
+vec3 CalcSunLight(Material material, vec3 lightNormal, vec3 viewDirection)
+{
+    // diffuse lighting
+    vec3 lightDirection = sunDirection.xyz;
+    float impact = max(dot(lightNormal, lightDirection), 0.0f);
+    vec3 diffuse = impact * sunColor.rgb * material.diffuseColor;
+
+    // specular lighting
+    vec3 reflectDirection = reflect(-lightDirection, lightNormal);
+    float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f), material.shininess);
+    vec3 specular = sunColor.w * specularComponent * sunColor.rgb * material.specularColor;
+
+    return(diffuse + specular);
+}
+
+// look up a layer of the shadow maps at a position in light space,
+// 1 for lit and 0 for shadowed - each of the four lookups blends the
+// comparisons of the four nearest texels, and the positions behind
+// the light or past the far end of the map are lit
+float SampleShadow(sampler2DArrayShadow shadowMaps, float layer, vec4 lightPosition)
+{
+    if (lightPosition.w <= 0.0f)
+    {
+        return(1.0f);
+    }
+
+    vec3 mapPosition = (lightPosition.xyz / lightPosition.w) * 0.5f + 0.5f;
+    if (mapPosition.z >= 1.0f)
+    {
+        return(1.0f);
+    }
+
+    vec2 texelSize = 0.5f / vec2(textureSize(shadowMaps, 0).xy);
+    float lit = 0.0f;
+    lit += texture(shadowMaps, vec4(mapPosition.xy + vec2(-texelSize.x, -texelSize.y), layer, mapPosition.z));
+    lit += texture(shadowMaps, vec4(mapPosition.xy + vec2(texelSize.x, -texelSize.y), layer, mapPosition.z));
+    lit += texture(shadowMaps, vec4(mapPosition.xy + vec2(-texelSize.x, texelSize.y), layer, mapPosition.z));
+    lit += texture(shadowMaps, vec4(mapPosition.xy + vec2(texelSize.x, texelSize.y), layer, mapPosition.z));
+
+    return(lit * 0.25f);
+}
+
+// calculate how much of a light source reaches a position, where the
+// objects that never move and the moving objects both cast shadows
+float CalcLightShadow(int lightIndex, float layer, vec3 shadowPosition)
+{
+    vec4 lightPosition = lightMatrices[lightIndex] * vec4(shadowPosition, 1.0f);
+    float lit = SampleShadow(staticShadowMaps, layer, lightPosition);
+    if (bDynamicShadows == true)
+    {
+        lit *= SampleShadow(dynamicShadowMaps, layer, lightPosition);
+    }
+
+    return(lit);
+}
+
+// calculate how much of the sun reaches a position, from the first
+// cascade that reaches past its view depth, where the objects that
+// never move and the moving objects both cast shadows - beyond the
+// last cascade everything is lit
+float CalcSunShadow(vec3 shadowPosition)
+{
+    float viewDepth = -(view * vec4(shadowPosition, 1.0f)).z;
+    for (int i = 0; i < cascadeCount; i++)
+    {
+        if (viewDepth <= cascadeEnds[i])
+        {
+            vec4 lightPosition = cascadeMatrices[i] * vec4(shadowPosition, 1.0f);
+            float lit = SampleShadow(sunShadowMaps, float(i), lightPosition);
+            if (bDynamicShadows == true)
+            {
+                lit *= SampleShadow(dynamicSunShadowMaps, float(i), lightPosition);
+            }
+            return(lit);
+        }
+    }
+
+    return(1.0f);
+}
+
+#ifdef GL_ARB_shader_storage_buffer_object
+// calculate the phong lighting contribution of one point light,
+// which fades out to nothing at the radius of the light
+vec3 CalcPointLight(PointLight light, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection)
+{
+    vec3 toLight = light.position - vertexPosition;
+    float lightDistance = length(toLight);
+    float falloff = clamp(1.0f - (lightDistance * lightDistance) / (light.radius * light.radius), 0.0f, 1.0f);
+    falloff *= falloff;
+
+    // diffuse lighting
+    vec3 lightDirection = toLight / max(lightDistance, 0.0001f);
+    float impact = max(dot(lightNormal, lightDirection), 0.0f);
+    vec3 diffuse = impact * light.color * material.diffuseColor;
+
+    // specular lighting
+    vec3 reflectDirection = reflect(-lightDirection, lightNormal);
+    float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f), material.shininess);
+    vec3 specular = light.specularIntensity * specularComponent * light.color * material.specularColor;
+
+    return((diffuse + specular) * falloff);
+}
+#endif
@@ -0,0 +1,124 @@
+#version 430 core
+
+// one thread for each cluster of the view
+layout (local_size_x = 64) in;
+
+// these need to match the values in ClusteredLights
+const uint WORK_GROUP_SIZE = 64u;
+// the light count of a cluster followed by its light indices
+const uint CLUSTER_STRIDE = 64u;
+const uint MAX_CLUSTER_LIGHTS = CLUSTER_STRIDE - 1u;
+
+struct PointLight
+{
+    vec3 position;
+    float radius;
+    vec3 color;
+    float specularIntensity;
+};
+
+// per-frame camera values, shared by all of the shader programs
+layout (std140) uniform CameraBlock
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosition;
+};
+
+// per-frame cluster values
+layout (std140) uniform ClusterBlock
+{
+    mat4 inverseProjection;
+    vec2 viewSize;
+    float sliceScale;
+    float sliceBias;
+    float nearDistance;
+    float farDistance;
+    int tileSize;
+    int lightCount;
+    int tilesX;
+    int tilesY;
+    int slices;
+};
+
+layout (std430) readonly buffer PointLightBlock
+{
+    PointLight pointLights[];
+};
+
+layout (std430) writeonly buffer ClusterLightBlock
+{
+    uint clusterLights[];
+};
+
+// the view space positions and radii of the lights being tested
+// by the work group
+shared vec4 sharedLights[WORK_GROUP_SIZE];
+
+// the view space point at a depth in front of the camera on
+// the ray through a point of the near plane in NDC
+vec3 PointAtDepth(vec2 ndc, float depth)
+{
+    vec4 nearPoint = inverseProjection * vec4(ndc, -1.0f, 1.0f);
+    vec3 direction = nearPoint.xyz / nearPoint.w;
+    return(direction * (depth / -direction.z));
+}
+
+void main()
+{
+    uint clusterIndex = gl_GlobalInvocationID.x;
+    uint clusterCount = uint(tilesX * tilesY * slices);
+    bool bInside = (clusterIndex < clusterCount);
+
+    // the view space box around the cluster
+    uint tileX = clusterIndex % uint(tilesX);
+    uint tileY = (clusterIndex / uint(tilesX)) % uint(tilesY);
+    uint slice = clusterIndex / uint(tilesX * tilesY);
+
+    vec2 ndcMin = (vec2(tileX, tileY) * float(tileSize) / viewSize) * 2.0f - 1.0f;
+    vec2 ndcMax = min((vec2(tileX + 1u, tileY + 1u) * float(tileSize) / viewSize) * 2.0f - 1.0f, vec2(1.0f));
+    float sliceNear = nearDistance * pow(farDistance / nearDistance, float(slice) / float(slices));
+    float sliceFar = nearDistance * pow(farDistance / nearDistance, float(slice + 1u) / float(slices));
+
+    vec3 corner0 = PointAtDepth(ndcMin, sliceNear);
+    vec3 corner1 = PointAtDepth(ndcMax, sliceNear);
+    vec3 corner2 = PointAtDepth(ndcMin, sliceFar);
+    vec3 corner3 = PointAtDepth(ndcMax, sliceFar);
+    vec3 boxMin = min(min(corner0, corner1), min(corner2, corner3));
+    vec3 boxMax = max(max(corner0, corner1), max(corner2, corner3));
+
+    uint count = 0u;
+    uint listStart = clusterIndex * CLUSTER_STRIDE;
+
+    // the lights are moved into view space a work group at a time,
+    // and every thread tests all of them against its cluster
+    for (int first = 0; first < lightCount; first += int(WORK_GROUP_SIZE))
+    {
+        int lightIndex = first + int(gl_LocalInvocationIndex);
+        if (lightIndex < lightCount)
+        {
+            PointLight light = pointLights[lightIndex];
+            sharedLights[gl_LocalInvocationIndex] = vec4(vec3(view * vec4(light.position, 1.0f)), light.radius);
+        }
+        barrier();
+
+        int batchCount = min(int(WORK_GROUP_SIZE), lightCount - first);
+        for (int i = 0; (i < batchCount) && (bInside == true); i++)
+        {
+            vec4 light = sharedLights[i];
+            vec3 closest = clamp(light.xyz, boxMin, boxMax);
+            vec3 offset = closest - light.xyz;
+            if ((dot(offset, offset) <= light.w * light.w) && (count < MAX_CLUSTER_LIGHTS))
+            {
+                clusterLights[listStart + 1u + count] = uint(first + i);
+                count++;
+            }
+        }
+        barrier();
+    }
+
+    if (bInside == true)
+    {
+        clusterLights[listStart] = count;
+    }
+}
@@ -0,0 +1,81 @@
+#version 330 core
+
+// per-vertex attributes
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+// per-instance attributes, only used for instanced draws - the
+// static batches pass the same values in every vertex instead
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+layout (location = 8) in vec2 inInstanceUVscale;
+layout (location = 9) in float inInstanceTextureLayer;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+flat out vec4 fragmentObjectColor;
+flat out vec2 fragmentUVscale;
+flat out float fragmentTextureLayer;
+
+// the depth prepass and the opaque pass need the exact same depth
+// for the equal depth test
+invariant gl_Position;
+
+// true when the object values come from the instance attributes
+uniform bool bUseInstancing = false;
+// true when the vertices are already in world space and carry the
+// object values, as baked into the static batches
+uniform bool bUseStaticBatch = false;
+
+// per-frame camera values, shared by all of the shader programs
+layout (std140) uniform CameraBlock
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPosition;
+};
+
+uniform mat4 model;
+#ifdef SHADOW_PASS
+// light space matrix of the shadow map being drawn
+uniform mat4 lightViewProjection;
+#endif
+uniform vec4 objectColor = vec4(1.0f);
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+uniform int textureLayer = 0;
+
+void main()
+{
+    mat4 objectModel = model;
+    fragmentObjectColor = objectColor;
+    fragmentUVscale = UVscale;
+    fragmentTextureLayer = float(textureLayer);
+
+    if (bUseInstancing == true)
+    {
+        objectModel = inInstanceModel;
+        fragmentObjectColor = inInstanceColor;
+        fragmentUVscale = inInstanceUVscale;
+        fragmentTextureLayer = inInstanceTextureLayer;
+    }
+    else if (bUseStaticBatch == true)
+    {
+        objectModel = mat4(1.0f);
+        fragmentObjectColor = inInstanceColor;
+        fragmentUVscale = inInstanceUVscale;
+        fragmentTextureLayer = inInstanceTextureLayer;
+    }
+
+    // vertex position and normal in world space for the lighting
+    fragmentPosition = vec3(objectModel * vec4(inVertexPosition, 1.0f));
+    fragmentVertexNormal = mat3(transpose(inverse(objectModel))) * inVertexNormal;
+    fragmentTextureCoordinate = inTextureCoordinate;
+
+#ifdef SHADOW_PASS
+    gl_Position = lightViewProjection * vec4(fragmentPosition, 1.0f);
+#else
+    gl_Position = projection * view * vec4(fragmentPosition, 1.0f);
+#endif
+}